@@ -0,0 +1,155 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	*
+	* \brief Create the descriptor set holding the texture array and the material buffer
+	*
+	* The device must support descriptor indexing, see vh::vhDevQueryDescriptorIndexing().
+	*
+	*/
+	VEBindlessTable::VEBindlessTable() {
+		VkDevice device = getRendererPointer()->getDevice();
+
+		//binding 0 : all textures, unused entries are never read and may be invalid
+		//binding 1 : all materials
+		VECHECKRESULT(vh::vhRenderCreateDescriptorSetLayout(device,
+			{ MAX_BINDLESS_TEXTURES,							1 },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+			{ VK_SHADER_STAGE_FRAGMENT_BIT,						VK_SHADER_STAGE_FRAGMENT_BIT },
+			{ VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT, 0 },
+			&m_descriptorSetLayout), "Failed to create bindless descriptor set layout!");
+
+		VECHECKRESULT(vh::vhRenderCreateDescriptorPool(device,
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+			{ MAX_BINDLESS_TEXTURES, 1 }, 1, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT,
+			&m_descriptorPool), "Failed to create bindless descriptor pool!");
+
+		std::vector<VkDescriptorSet> sets;
+		VECHECKRESULT(vh::vhRenderCreateDescriptorSets(device, 1, m_descriptorSetLayout, m_descriptorPool, sets),
+			"Failed to create bindless descriptor set!");
+		m_descriptorSet = sets[0];
+
+		VkDeviceSize bufferSize = MAX_BINDLESS_MATERIALS * sizeof(veMaterialData_t);
+		VECHECKRESULT(vh::vhBufCreateBuffer(getRendererPointer()->getVmaAllocator(), bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_CPU_TO_GPU, &m_materialBuffer, &m_materialBufferAllocation), "Failed to create material buffer!");
+
+		vh::vhRenderUpdateDescriptorSetBuffer(device, m_descriptorSet, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_materialBuffer, bufferSize);
+
+		//hand out low indices first
+		for (uint32_t i = MAX_BINDLESS_TEXTURES; i > 0; i--) m_freeTextures.push_back(i - 1);
+		for (uint32_t i = MAX_BINDLESS_MATERIALS; i > 0; i--) m_freeMaterials.push_back(i - 1);
+	}
+
+
+	/**
+	* \brief Destroy the descriptor set and the material buffer
+	*/
+	VEBindlessTable::~VEBindlessTable() {
+		VkDevice device = getRendererPointer()->getDevice();
+		vmaDestroyBuffer(getRendererPointer()->getVmaAllocator(), m_materialBuffer, m_materialBufferAllocation);
+		vkDestroyDescriptorPool(device, m_descriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, nullptr);
+	}
+
+
+	/**
+	*
+	* \brief Put a texture into the texture array
+	*
+	* The array can be updated while it is bound, since only unused entries are changed.
+	*
+	* \param[in] pTexture The texture, its image view must be a 2D view
+	* \returns the index of the texture in the array
+	*
+	*/
+	uint32_t VEBindlessTable::addTexture(VETexture *pTexture) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (pTexture->m_bindlessIndex != BINDLESS_INDEX_NONE) return pTexture->m_bindlessIndex;
+		if (m_freeTextures.empty()) throw std::runtime_error("Bindless texture array is full!");
+
+		pTexture->m_bindlessIndex = m_freeTextures.back();
+		m_freeTextures.pop_back();
+
+		vh::vhRenderUpdateDescriptorSetImage(getRendererPointer()->getDevice(), m_descriptorSet, 0, pTexture->m_bindlessIndex,
+											pTexture->m_imageView, pTexture->m_sampler);
+		return pTexture->m_bindlessIndex;
+	}
+
+
+	/**
+	*
+	* \brief Remove a texture from the texture array
+	*
+	* The entry is not overwritten, it is only handed out again for the next texture. Since no material
+	* refers to it anymore, it is not read and may hold a destroyed image view.
+	*
+	* \param[in] pTexture The texture
+	*
+	*/
+	void VEBindlessTable::removeTexture(VETexture *pTexture) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (pTexture->m_bindlessIndex == BINDLESS_INDEX_NONE) return;
+
+		m_freeTextures.push_back(pTexture->m_bindlessIndex);
+		pTexture->m_bindlessIndex = BINDLESS_INDEX_NONE;
+	}
+
+
+	/**
+	*
+	* \brief Put a material into the material buffer, or update its entry if it is there already
+	*
+	* \param[in] pMaterial The material, its textures must have been added to the texture array
+	* \returns the index of the material in the buffer
+	*
+	*/
+	uint32_t VEBindlessTable::addMaterial(VEMaterial *pMaterial) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (pMaterial->m_bindlessIndex == BINDLESS_INDEX_NONE) {
+			if (m_freeMaterials.empty()) throw std::runtime_error("Bindless material buffer is full!");
+			pMaterial->m_bindlessIndex = m_freeMaterials.back();
+			m_freeMaterials.pop_back();
+		}
+
+		veMaterialData_t data = {};
+		data.textures.x = pMaterial->mapDiffuse != nullptr ? pMaterial->mapDiffuse->m_bindlessIndex : BINDLESS_INDEX_NONE;
+		data.textures.y = pMaterial->mapNormal  != nullptr ? pMaterial->mapNormal->m_bindlessIndex  : BINDLESS_INDEX_NONE;
+		data.textures.z = pMaterial->mapBump    != nullptr ? pMaterial->mapBump->m_bindlessIndex    : BINDLESS_INDEX_NONE;
+		data.textures.w = pMaterial->mapHeight  != nullptr ? pMaterial->mapHeight->m_bindlessIndex  : BINDLESS_INDEX_NONE;
+
+		void *pData = nullptr;
+		vmaMapMemory(getRendererPointer()->getVmaAllocator(), m_materialBufferAllocation, &pData);
+		memcpy((veMaterialData_t*)pData + pMaterial->m_bindlessIndex, &data, sizeof(veMaterialData_t));
+		vmaUnmapMemory(getRendererPointer()->getVmaAllocator(), m_materialBufferAllocation);
+
+		return pMaterial->m_bindlessIndex;
+	}
+
+
+	/**
+	*
+	* \brief Remove a material from the material buffer
+	*
+	* \param[in] pMaterial The material
+	*
+	*/
+	void VEBindlessTable::removeMaterial(VEMaterial *pMaterial) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (pMaterial->m_bindlessIndex == BINDLESS_INDEX_NONE) return;
+
+		m_freeMaterials.push_back(pMaterial->m_bindlessIndex);
+		pMaterial->m_bindlessIndex = BINDLESS_INDEX_NONE;
+	}
+
+}
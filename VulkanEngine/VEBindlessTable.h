@@ -0,0 +1,63 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+const uint32_t MAX_BINDLESS_TEXTURES = 4096;						///<Length of the bindless texture array, must match the material shader
+const uint32_t MAX_BINDLESS_MATERIALS = 4096;						///<Max number of materials in the material buffer
+const uint32_t BINDLESS_INDEX_NONE = 0xFFFFFFFF;					///<Index of a texture or material that is not in the table
+
+namespace ve {
+
+	struct VETexture;
+	class VEMaterial;
+
+	/**
+	*
+	* \brief One table of all textures and materials, which shaders reach by index
+	*
+	* All 2D textures are put into one large array of combined image samplers, which is updated when a texture is
+	* loaded or destroyed. Materials are entries of a storage buffer, holding the array indices of their textures.
+	* Both are bound once per frame as descriptor set 4, so drawing an entity only needs its per object UBO, which
+	* holds the index of its material. The texture array is partially bound and can be updated after it has been bound,
+	* which needs VK_EXT_descriptor_indexing. The functions may be called from several threads at the same time.
+	*
+	*/
+	class VEBindlessTable {
+
+	public:
+		///One entry of the material buffer, must match materialData_t of the material shader
+		struct veMaterialData_t {
+			glm::uvec4 textures;		///<Texture array indices: x...diffuse, y...normal, z...bump, w...height map
+		};
+
+	protected:
+		VkDescriptorSetLayout	m_descriptorSetLayout = VK_NULL_HANDLE;		///<binding 0: texture array, binding 1: material buffer
+		VkDescriptorPool		m_descriptorPool = VK_NULL_HANDLE;			///<Update after bind pool holding the only set
+		VkDescriptorSet			m_descriptorSet = VK_NULL_HANDLE;			///<The set bound as set 4
+		VkBuffer				m_materialBuffer = VK_NULL_HANDLE;			///<Storage buffer holding all veMaterialData_t entries
+		VmaAllocation			m_materialBufferAllocation = nullptr;		///<VMA information for the material buffer
+		std::vector<uint32_t>	m_freeTextures;								///<Unused indices of the texture array
+		std::vector<uint32_t>	m_freeMaterials;							///<Unused indices of the material buffer
+		std::mutex				m_mutex;									///<Guards the free lists and descriptor updates
+
+	public:
+		VEBindlessTable();
+		virtual ~VEBindlessTable();
+
+		uint32_t addTexture(VETexture *pTexture);
+		void	 removeTexture(VETexture *pTexture);
+		uint32_t addMaterial(VEMaterial *pMaterial);
+		void	 removeMaterial(VEMaterial *pMaterial);
+
+		///\returns the layout of set 4 of the bindless material PSOs
+		VkDescriptorSetLayout	getDescriptorSetLayout() { return m_descriptorSetLayout; };
+		///\returns the set holding all textures and materials
+		VkDescriptorSet			getDescriptorSet() { return m_descriptorSet; };
+	};
+
+}
@@ -0,0 +1,219 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	*
+	* \brief Create the first persistent pool
+	*
+	* \param[in] numFrames Number of frames in flight, each gets its own transient pools
+	*
+	*/
+	VEDescriptorAllocator::VEDescriptorAllocator(uint32_t numFrames) : m_numFrames(numFrames) {
+		m_pools.push_back(createPool(m_poolSets));
+		m_transientPools.resize(numFrames, { {}, 0 });
+	}
+
+
+	/**
+	* \brief Destroy all pools, together with all sets allocated from them
+	*/
+	VEDescriptorAllocator::~VEDescriptorAllocator() {
+		VkDevice device = getRendererPointer()->getDevice();
+		for (auto pool : m_pools) vkDestroyDescriptorPool(device, pool, nullptr);
+		for (auto &slot : m_transientPools) {
+			for (auto pool : slot.pools) vkDestroyDescriptorPool(device, pool, nullptr);
+		}
+	}
+
+
+	/**
+	*
+	* \brief Create a pool for the descriptor types the engine uses
+	*
+	* \param[in] maxSets Max number of sets allocated from the pool
+	* \returns the new pool
+	*
+	*/
+	VkDescriptorPool VEDescriptorAllocator::createPool(uint32_t maxSets) {
+		VkDescriptorPool pool;
+		VECHECKRESULT(vh::vhRenderCreateDescriptorPool(getRendererPointer()->getDevice(),
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,	VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER },
+			{ maxSets,								maxSets * DESCRIPTOR_POOL_SAMPLERS_PER_SET,			std::max(maxSets / DESCRIPTOR_POOL_STORAGE_BUFFERS_DIVISOR, 1u) },
+			maxSets, 0, &pool), "Failed to create descriptor pool!");
+		return pool;
+	}
+
+
+	/**
+	*
+	* \brief Allocate sets of one layout from a pool
+	*
+	* \param[in] pool The pool
+	* \param[in] layout Layout of the sets
+	* \param[in] number Number of sets
+	* \param[out] pSets Receives the sets
+	* \returns VK_SUCCESS, VK_ERROR_OUT_OF_POOL_MEMORY or VK_ERROR_FRAGMENTED_POOL if the pool is exhausted, or another error code
+	*
+	*/
+	VkResult VEDescriptorAllocator::allocateFromPool(VkDescriptorPool pool, VkDescriptorSetLayout layout, uint32_t number, VkDescriptorSet *pSets) {
+		std::vector<VkDescriptorSetLayout> layouts(number, layout);
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = pool;
+		allocInfo.descriptorSetCount = number;
+		allocInfo.pSetLayouts = layouts.data();
+		return vkAllocateDescriptorSets(getRendererPointer()->getDevice(), &allocInfo, pSets);
+	}
+
+
+	/**
+	*
+	* \brief Allocate persistent descriptor sets
+	*
+	* Recycled sets of the layout are handed out first, the rest comes from the current pool. If the pool
+	* is exhausted, a new pool is created. Recycled sets keep their old contents, so all sets must be updated.
+	*
+	* \param[in] layout Layout of the sets
+	* \param[in] number Number of sets, usually one per swapchain image
+	* \param[out] sets Receives the sets
+	*
+	*/
+	void VEDescriptorAllocator::allocateDescriptorSets(VkDescriptorSetLayout layout, uint32_t number, std::vector<VkDescriptorSet> &sets) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		sets.resize(number);
+
+		uint32_t numRecycled = 0;
+		auto it = m_freeSets.find(layout);
+		if (it != m_freeSets.end()) {
+			while (numRecycled < number && !it->second.empty()) {
+				sets[numRecycled++] = it->second.back();
+				it->second.pop_back();
+			}
+		}
+		if (numRecycled == number) return;
+
+		VkResult result = allocateFromPool(m_pools.back(), layout, number - numRecycled, &sets[numRecycled]);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+			m_poolSets = std::min(2 * m_poolSets, DESCRIPTOR_POOL_MAX_SETS);
+			m_pools.push_back(createPool(std::max(m_poolSets, number)));
+			result = allocateFromPool(m_pools.back(), layout, number - numRecycled, &sets[numRecycled]);
+		}
+		VECHECKRESULT(result, "Failed to allocate descriptor sets!");
+	}
+
+
+	/**
+	*
+	* \brief Give persistent descriptor sets back for recycling
+	*
+	* The sets are handed out again for the same layout, or for a layout that is identically defined, once
+	* all submissions made so far are done.
+	*
+	* \param[in] layout Layout the sets will be allocated with again
+	* \param[in,out] sets The sets, the list is cleared
+	*
+	*/
+	void VEDescriptorAllocator::freeDescriptorSets(VkDescriptorSetLayout layout, std::vector<VkDescriptorSet> &sets) {
+		if (sets.empty()) return;
+
+		uint64_t value = getRendererPointer()->getTimeline()->getLastSubmitted();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_retiredSets.push_back({ layout, sets, value });
+		sets.clear();
+	}
+
+
+	/**
+	*
+	* \brief Hand the recyclable sets of a layout that is going to be destroyed over to its replacement, or forget them
+	*
+	* If the layout is replaced by an identically defined one, e.g. when a subrenderer is recreated, the sets are
+	* recycled for the new layout. Otherwise they stay in their pools until the allocator is destroyed.
+	*
+	* \param[in] layout The layout
+	* \param[in] newLayout An identically defined layout replacing it, or VK_NULL_HANDLE
+	*
+	*/
+	void VEDescriptorAllocator::releaseLayout(VkDescriptorSetLayout layout, VkDescriptorSetLayout newLayout) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (newLayout != VK_NULL_HANDLE) {
+			auto it = m_freeSets.find(layout);
+			if (it != m_freeSets.end()) {
+				auto &freeSets = m_freeSets[newLayout];
+				freeSets.insert(freeSets.end(), it->second.begin(), it->second.end());
+			}
+			for (auto &retired : m_retiredSets) {
+				if (retired.layout == layout) retired.layout = newLayout;
+			}
+		}
+		m_freeSets.erase(layout);
+		m_retiredSets.erase(std::remove_if(m_retiredSets.begin(), m_retiredSets.end(),
+			[layout](const veRetiredSets_t &retired) { return retired.layout == layout; }), m_retiredSets.end());
+	}
+
+
+	/**
+	*
+	* \brief Allocate a descriptor set that is only valid for the current frame
+	*
+	* \param[in] layout Layout of the set
+	* \returns the set, it is recycled when its frame slot is used again
+	*
+	*/
+	VkDescriptorSet VEDescriptorAllocator::allocateTransientDescriptorSet(VkDescriptorSetLayout layout) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		veTransientPools_t &slot = m_transientPools[m_frameSlot];
+
+		VkDescriptorSet set;
+		while (true) {
+			if (slot.current == slot.pools.size()) slot.pools.push_back(createPool(DESCRIPTOR_TRANSIENT_POOL_SETS));
+
+			VkResult result = allocateFromPool(slot.pools[slot.current], layout, 1, &set);
+			if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+				VECHECKRESULT(result, "Failed to allocate transient descriptor set!");
+				return set;
+			}
+			slot.current++;
+		}
+	}
+
+
+	/**
+	*
+	* \brief Start the next frame
+	*
+	* Must be called once per frame, after waiting for the last submission of the frame slot that is used next.
+	* Freed sets whose submissions are done become recyclable, and the transient pools of the slot are reset.
+	*
+	*/
+	void VEDescriptorAllocator::nextFrame() {
+		VETimeline *pTimeline = getRendererPointer()->getTimeline();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_frameSlot = (m_frameSlot + 1) % m_numFrames;
+
+		auto firstInFlight = std::partition(m_retiredSets.begin(), m_retiredSets.end(),
+			[pTimeline](const veRetiredSets_t &retired) { return pTimeline->isComplete(retired.value); });
+		for (auto it = m_retiredSets.begin(); it != firstInFlight; ++it) {
+			auto &freeSets = m_freeSets[it->layout];
+			freeSets.insert(freeSets.end(), it->sets.begin(), it->sets.end());
+		}
+		m_retiredSets.erase(m_retiredSets.begin(), firstInFlight);
+
+		veTransientPools_t &slot = m_transientPools[m_frameSlot];
+		for (auto pool : slot.pools) vkResetDescriptorPool(getRendererPointer()->getDevice(), pool, 0);
+		slot.current = 0;
+	}
+
+}
@@ -0,0 +1,75 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+const uint32_t DESCRIPTOR_POOL_SETS = 1024;								///<Number of sets of the first pool, each further pool is twice as large
+const uint32_t DESCRIPTOR_POOL_MAX_SETS = 16384;						///<Pools do not grow beyond this number of sets
+const uint32_t DESCRIPTOR_POOL_SAMPLERS_PER_SET = 2;					///<Combined image samplers per set in a pool
+const uint32_t DESCRIPTOR_POOL_STORAGE_BUFFERS_DIVISOR = 8;				///<One storage buffer per this many sets in a pool
+const uint32_t DESCRIPTOR_TRANSIENT_POOL_SETS = 256;					///<Number of sets of a transient pool
+
+namespace ve {
+
+	/**
+	*
+	* \brief Hands out descriptor sets from a growing list of pools
+	*
+	* Long lived sets, e.g. the UBO sets of scene objects, come from the persistent pools. If the current pool is
+	* exhausted, a new and larger one is created, so the number of sets is only limited by the device memory.
+	* Sets are never freed back to their pool, so pools do not fragment. Instead, freed sets are put into a free list
+	* of their layout, and are handed out again for the next set of this layout. Since a freed set might still be used
+	* by a submission in flight, it is recycled only after the timeline of the renderer has passed the last submission
+	* made before it was freed.
+	*
+	* Transient sets are only valid for the current frame. They come from per frame pools, which are all reset at once
+	* when the frame slot is used again. The functions may be called from several threads at the same time.
+	*
+	*/
+	class VEDescriptorAllocator {
+
+	protected:
+		///Sets that have been freed, and the timeline value they wait for
+		struct veRetiredSets_t {
+			VkDescriptorSetLayout			layout;		///<Layout the sets have been allocated with
+			std::vector<VkDescriptorSet>	sets;		///<The freed sets
+			uint64_t						value;		///<Last submission when the sets were freed, see VETimeline
+		};
+
+		///Transient pools of one frame slot
+		struct veTransientPools_t {
+			std::vector<VkDescriptorPool>	pools;		///<All pools of the slot, reused after each reset
+			uint32_t						current;	///<Index of the pool sets are taken from
+		};
+
+		std::vector<VkDescriptorPool>	m_pools;									///<Persistent pools, the last one is the current one
+		uint32_t						m_poolSets = DESCRIPTOR_POOL_SETS;			///<Number of sets of the next persistent pool
+		std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> m_freeSets;	///<Recyclable sets by layout
+		std::vector<veRetiredSets_t>	m_retiredSets;								///<Freed sets that might still be in flight
+		std::vector<veTransientPools_t>	m_transientPools;							///<Transient pools of each frame slot
+		uint32_t						m_numFrames;								///<Number of frames in flight
+		uint32_t						m_frameSlot = 0;							///<Frame slot of the current frame
+		std::mutex						m_mutex;									///<Guards all members
+
+		VkDescriptorPool createPool(uint32_t maxSets);
+		VkResult		 allocateFromPool(VkDescriptorPool pool, VkDescriptorSetLayout layout, uint32_t number, VkDescriptorSet *pSets);
+
+	public:
+		VEDescriptorAllocator(uint32_t numFrames);
+		virtual ~VEDescriptorAllocator();
+
+		void			allocateDescriptorSets(VkDescriptorSetLayout layout, uint32_t number, std::vector<VkDescriptorSet> &sets);
+		void			freeDescriptorSets(VkDescriptorSetLayout layout, std::vector<VkDescriptorSet> &sets);
+		void			releaseLayout(VkDescriptorSetLayout layout, VkDescriptorSetLayout newLayout = VK_NULL_HANDLE);
+		VkDescriptorSet	allocateTransientDescriptorSet(VkDescriptorSetLayout layout);
+		void			nextFrame();
+
+		///\returns the number of persistent pools that have been created
+		uint32_t		getNumberPools() { std::lock_guard<std::mutex> lock(m_mutex); return (uint32_t)m_pools.size(); };
+	};
+
+}
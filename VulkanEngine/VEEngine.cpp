@@ -23,9 +23,13 @@ namespace ve {
 	/**
 	* \brief Constructor of my VEEngine
 	* \param[in] debug Switch debuggin on or off
+	* \param[in] rendererType The renderer to be created
+	* \param[in] framesInFlight Number of frames the CPU may prepare ahead of the GPU, clamped to 1..MAX_FRAMES_IN_FLIGHT.
+	* 1 means no overlap of CPU and GPU work, but also the lowest latency.
 	*/ 
-	VEEngine::VEEngine(bool debug) : m_debug(debug) {
+	VEEngine::VEEngine(bool debug, veRendererType rendererType, uint32_t framesInFlight) : m_debug(debug), m_rendererType(rendererType) {
 		g_pVEEngineSingleton = this; 
+		m_framesInFlight = std::max(std::min(framesInFlight, MAX_FRAMES_IN_FLIGHT), 1u);
 	}
 
 	//-------------------------------------------------------------------------------------------------------
@@ -77,11 +81,20 @@ namespace ve {
 	* \brief Create the only VERenderer instance and store a pointer to it.
 	*
 	* VERenderer is a base class only and should not be created itself. Instead, a derived class should be
-	* instanciated, being tailored to one specific windowing system.
+	* instanciated, being tailored to one specific windowing system. Which one is chosen by the renderer type
+	* given to the constructor.
 	*
 	*/
 	void VEEngine::createRenderer() {
-		m_pRenderer = new VERendererForward();
+		switch (m_rendererType) {
+		case VE_RENDERER_TYPE_DEFERRED:
+			m_pRenderer = new VERendererDeferred();
+			break;
+		default:
+			m_pRenderer = new VERendererForward();
+			break;
+		}
+		m_pRenderer->m_framesInFlight = m_framesInFlight;
 	}
 
 	/**
@@ -438,14 +451,20 @@ namespace ve {
 			
 			processEvents(m_dt);				//process all current events, including pressed keys
 
+			VEFrameArena::beginFrame();			//temporaries of the render loop come from the frame arenas
+
+			m_pRenderer->beginFrame();			//wait until the UBOs and buffers of the next frame in flight are free
+
 			t_now = vh::vhTimeNow();
-				getSceneManagerPointer()->updateSceneNodes( getRendererPointer()->getImageIndex());
+				getSceneManagerPointer()->updateSceneNodes( getRendererPointer()->getFrameIndex());
 			m_AvgUpdateTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgUpdateTime);
 
 			t_now = vh::vhTimeNow();
 				m_pRenderer->drawFrame();			//draw the next frame
 			m_AvgDrawTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgDrawTime);
 
+			VEFrameArena::endFrame();
+
 			m_pRenderer->prepareOverlay();
 
 			event.type = VE_EVENT_FRAME_ENDED;	//notify all listeners that the frame ended
@@ -46,6 +46,15 @@ namespace ve {
 		friend VEEventListener;
 		friend VESceneManager;
 
+	public:
+		/**
+		* \brief enums the renderers that can be created by createRenderer()
+		*/
+		enum veRendererType {
+			VE_RENDERER_TYPE_FORWARD,					///<Forward renderer, draws all objects once per light
+			VE_RENDERER_TYPE_DEFERRED					///<Deferred renderer, draws objects once into a G-buffer, then lights in screen space
+		};
+
 	protected:
 		VkInstance m_instance = VK_NULL_HANDLE;			///<Vulkan app instance
 		VEWindow * m_pWindow = nullptr;					///<Pointer to the only Window instance
@@ -67,6 +76,8 @@ namespace ve {
 		bool m_framebufferResized = false;				///<Flag indicating whether the window size has changed.
 		bool m_end_running = false;						///<Flag indicating that the engine should leave the render loop
 		bool m_debug = true;							///<Flag indicating whether debugging is enabled or not
+		veRendererType m_rendererType = VE_RENDERER_TYPE_FORWARD;	///<The renderer to be created by createRenderer()
+		uint32_t m_framesInFlight = 2;					///<Number of frames in flight of the renderer, 1 to MAX_FRAMES_IN_FLIGHT
 
 		virtual std::vector<const char*> getRequiredInstanceExtensions(); //Return a list of required Vulkan instance extensions
 		virtual std::vector<const char*> getValidationLayers();	//Returns a list of required Vulkan validation layers
@@ -85,7 +96,7 @@ namespace ve {
 	public:
 		ThreadPool *m_threadPool;				///<A threadpool for parallel processing
 
-		VEEngine( bool debug = false );								//Only create ONE instance of the engine!
+		VEEngine( bool debug = false, veRendererType rendererType = VE_RENDERER_TYPE_FORWARD, uint32_t framesInFlight = 2 );	//Only create ONE instance of the engine!
 		~VEEngine() {};
 
 		virtual void initEngine();							//Create all engine components
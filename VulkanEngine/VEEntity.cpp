@@ -185,7 +185,7 @@ namespace ve {
 	* If there is a parent, get the parent's world matrix. If not, set the parent matrix to identity.
 	* Then call update(parentWorldMatrix) to do the job.
 	*
-	* \param[in] imageIndex The index of the swapchain image that is currently used
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VESceneNode::update(uint32_t imageIndex) {
@@ -204,7 +204,7 @@ namespace ve {
 	* Then copy the struct content into the UBO. Then call all children to do the same.
 	*
 	* \param[in] parentWorldMatrix The parent's world matrix or an identity matrix.
-	* \param[in] imageIndex The index of the swapchain image that is currently used
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VESceneNode::update(glm::mat4 parentWorldMatrix, uint32_t imageIndex ) {
@@ -300,7 +300,7 @@ namespace ve {
 	*
 	* \brief Constructor of the scene object class.
 	*
-	* If the object needs UBOs, then first the UBOs are created (one for each swap chain image), 
+	* If the object needs UBOs, then first the UBOs are created (one for each frame in flight), 
 	* then the descriptor sets, then the UBOs and sets are connected.
 	*
 	* \param[in] name Name of the new scene object.
@@ -314,13 +314,12 @@ namespace ve {
 
 		if (sizeUBO > 0) {
 			vh::vhBufCreateUniformBuffers(	getRendererPointer()->getVmaAllocator(),
-											(uint32_t)getRendererPointer()->getSwapChainNumber(),
+											(uint32_t)getRendererPointer()->getFramesInFlight(),
 											sizeUBO, m_uniformBuffers, m_uniformBuffersAllocation);
 
-			vh::vhRenderCreateDescriptorSets(getRendererForwardPointer()->getDevice(),
-				(uint32_t)getRendererForwardPointer()->getSwapChainNumber(),
+			getRendererPointer()->getDescriptorAllocator()->allocateDescriptorSets(
 				getRendererForwardPointer()->getDescriptorSetLayoutPerObject(),
-				getRendererForwardPointer()->getDescriptorPool(),
+				(uint32_t)getRendererForwardPointer()->getFramesInFlight(),
 				m_descriptorSetsUBO);
 
 			for (uint32_t i = 0; i < m_descriptorSetsUBO.size(); i++) {
@@ -340,13 +339,17 @@ namespace ve {
 	*
 	* \brief Destructor of the scene object class.
 	*
-	* Destructs all UBOs that this objects owns.
+	* Destructs all UBOs that this objects owns, and gives its descriptor sets back for recycling.
 	*
 	*/
 	VESceneObject::~VESceneObject() {
 		for (uint32_t i = 0; i < m_uniformBuffers.size(); i++) {
 			vmaDestroyBuffer(getRendererPointer()->getVmaAllocator(), m_uniformBuffers[i], m_uniformBuffersAllocation[i]);
 		}
+		if (getRendererPointer()->getDescriptorAllocator() != nullptr) {
+			getRendererPointer()->getDescriptorAllocator()->freeDescriptorSets(
+				getRendererForwardPointer()->getDescriptorSetLayoutPerObject(), m_descriptorSetsUBO);
+		}
 	}
 
 	/**
@@ -355,7 +358,7 @@ namespace ve {
 	*
 	* \param[in] pUBO Pointer to the UBO that should be copied to the GPU.
 	* \param[in] sizeUBO Size od the UBO.
-	* \param[in] imageIndex Index of the swap chain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VESceneObject::updateUBO(void *pUBO, uint32_t sizeUBO, uint32_t imageIndex ) {
@@ -401,6 +404,9 @@ namespace ve {
 	}
 
 
+	uint64_t VEEntity::s_boundsVersion = 0;
+
+
 	/**
 	*
 	* \brief VEEntity destructor.
@@ -423,25 +429,118 @@ namespace ve {
 	}
 
 
+	/**
+	* \brief Switch drawing of this entity on or off.
+	*
+	* The command buffers of the entity's subrenderer are recorded again the next time they are used.
+	*
+	* \param[in] drawEntity If true the entity is drawn
+	*/
+	void VEEntity::setDrawEntity(bool drawEntity) {
+		if (m_drawEntity == drawEntity) return;
+		m_drawEntity = drawEntity;
+		m_boundsVersion = ++s_boundsVersion;
+		if (m_pSubrenderer != nullptr) getRendererPointer()->invalidateCmdBuffers(m_pSubrenderer);
+		if (m_staticShadow) getRendererPointer()->invalidateShadowCache();
+	}
+
+
+	/**
+	* \brief Switch drawing of this entity in the shadow pass on or off.
+	*
+	* \param[in] castsShadow If true the entity is drawn into the shadow maps
+	*/
+	void VEEntity::setCastsShadow(bool castsShadow) {
+		if (m_castsShadow == castsShadow) return;
+		m_castsShadow = castsShadow;
+		if (m_pSubrenderer != nullptr) getRendererPointer()->invalidateCmdBuffers(m_pSubrenderer);
+		if (m_staticShadow) getRendererPointer()->invalidateShadowCache();
+	}
+
+
+	/**
+	* \brief Mark this entity as a static or dynamic shadow caster.
+	*
+	* Static casters are drawn only once into cached shadow maps, which are copied into the shadow maps
+	* each frame before the dynamic casters are drawn. Moving a static caster is allowed, but causes the
+	* cached maps to be drawn again.
+	*
+	* \param[in] staticShadow If true the entity is a static shadow caster
+	*/
+	void VEEntity::setStaticShadow(bool staticShadow) {
+		if (m_staticShadow == staticShadow) return;
+		m_staticShadow = staticShadow;
+		if (m_pSubrenderer != nullptr) getRendererPointer()->invalidateCmdBuffers(m_pSubrenderer);
+		getRendererPointer()->invalidateShadowCache();
+	}
+
+
+	/**
+	* \brief Exchange the material of this entity.
+	*
+	* The entity is removed from its subrenderer and added again, since the new material might need
+	* another subrenderer and other descriptor sets. Both subrenderers record their command buffers again.
+	*
+	* \param[in] pMat Pointer to the new material
+	*/
+	void VEEntity::setMaterial(VEMaterial *pMat) {
+		if (m_pMaterial == pMat) return;
+
+		if (m_pSubrenderer != nullptr) {
+			getRendererPointer()->removeEntityFromSubrenderers(this);
+			m_pSubrenderer = nullptr;
+		}
+		m_descriptorSetsResources.clear();
+		m_pMaterial = pMat;
+
+		if (m_pMesh != nullptr && m_pMaterial != nullptr) {
+			getRendererPointer()->addEntityToSubrenderer(this);
+		}
+	}
+
+
 	/**
 	*
 	* \brief Update the entity's UBO.
 	*
+	* Also updates the per object push constants, i.e. the material index. These are recorded into the cached secondary
+	* command buffers, so if the entity gets another material, the buffers of its subrenderer must be recorded again.
+	* Moving the entity changes only the UBO and keeps the buffers. If the entity has moved,
+	* its bounds version is increased, so the light passes test it against the lights again.
+	*
 	* \param[in] worldMatrix The new world matrix of the entity
-	* \param[in] imageIndex The Index of the swapchain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VEEntity::updateUBO( glm::mat4 worldMatrix, uint32_t imageIndex) {
+		if (m_staticShadow && m_castsShadow && worldMatrix != m_ubo.model) {	//a static caster has moved
+			getRendererPointer()->invalidateShadowCache();
+		}
+		if (worldMatrix != m_ubo.model) m_boundsVersion = ++s_boundsVersion;
+
 		m_ubo = {};
 
 		m_ubo.model = worldMatrix;
 		m_ubo.modelInvTrans = glm::transpose(glm::inverse(worldMatrix));
 		m_ubo.param = m_param;
+		m_ubo.material.x = BINDLESS_INDEX_NONE;
 		if (m_pMaterial != nullptr) {
 			m_ubo.color = m_pMaterial->color;
+			m_ubo.material.x = m_pMaterial->m_bindlessIndex;
 		};
+		if (m_pMesh != nullptr) {		//used for culling against the faces of a cube shadow map
+			m_ubo.boundingSphere = glm::vec4(m_pMesh->m_boundingSphereCenter, m_pMesh->m_boundingSphereRadius);
+		}
 
 		VESceneObject::updateUBO( (void*)&m_ubo, (uint32_t)sizeof(veUBOPerObject_t), imageIndex);
+
+		//pushed values are recorded into the command buffers, they change only if the entity gets another material
+		if (m_pushConstants.material != m_ubo.material) {
+			m_pushConstants.material = m_ubo.material;
+			if (m_pSubrenderer != nullptr && m_pSubrenderer->getPushConstants()) {
+				m_pSubrenderer->invalidateCmdBuffers();
+			}
+		}
 	}
 
 
@@ -508,7 +607,7 @@ namespace ve {
 	* \brief Update the UBO of this camera.
 	*
 	* \param[in] worldMatrix The new world matrix of this camera
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VECamera::updateUBO(glm::mat4 worldMatrix, uint32_t imageIndex) {
@@ -791,13 +890,14 @@ namespace ve {
 	* cameras of this light.
 	*
 	* \param[in] worldMatrix The new world matrix of this light
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VELight::updateUBO(glm::mat4 worldMatrix, uint32_t imageIndex) {
 		m_ubo = {};
 
 		m_ubo.type[0] = getLightType();
+		m_ubo.type[1] = getLightType() == VE_LIGHT_TYPE_POINT && getRendererPointer()->getCubeShadows() ? 1 : 0;	//1...shadow in cube shadow map
 		m_ubo.model = worldMatrix;
 		m_ubo.col_ambient = m_col_ambient;
 		m_ubo.col_diffuse = m_col_diffuse;
@@ -807,14 +907,168 @@ namespace ve {
 		VECamera *pCam = getSceneManagerPointer()->getCamera();
 
 		updateShadowCameras(pCam, imageIndex);						//copy shadow cam UBOs to GPU
+		packShadowTiles(pCam);
 		for (uint32_t i = 0; i < m_shadowCameras.size(); i++ ) {	//copy shadow cam UBOs to light UBO
 			m_ubo.shadowCameras[i] = m_shadowCameras[i]->m_ubo;
+
+			VkRect2D &tile = m_shadowTiles[i];
+			m_ubo.shadowTiles[i] = glm::vec4(	(float)tile.offset.x / SHADOW_ATLAS_WIDTH, (float)tile.offset.y / SHADOW_ATLAS_HEIGHT,
+												(float)tile.extent.width / SHADOW_ATLAS_WIDTH, (float)tile.extent.height / SHADOW_ATLAS_HEIGHT);
 		}
 
 		VESceneObject::updateUBO((void*)&m_ubo, (uint32_t)sizeof(veUBOPerLight_t), imageIndex);
 	}
 
 
+	/**
+	*
+	* \brief Get a bounding sphere of the space the light can reach
+	*
+	* \param[out] center Center of the sphere in world space, this is the light position
+	* \param[out] radius Radius of the sphere, this is the reach of the light
+	* \returns true if the light has a limited reach
+	*
+	*/
+	bool VELight::getLightVolume(glm::vec3 *center, float *radius) {
+		glm::vec4 pos = getWorldTransform()[3];
+		*center = glm::vec3(pos.x, pos.y, pos.z);
+		*radius = m_param[0];
+		return true;
+	}
+
+
+	/**
+	*
+	* \brief Find out whether the light can reach into a sphere
+	*
+	* \param[in] center Center of the sphere in world space
+	* \param[in] radius Radius of the sphere
+	* \returns true if the sphere intersects the light volume
+	*
+	*/
+	bool VELight::lightsSphere(glm::vec3 center, float radius) {
+		glm::vec3 lightCenter;
+		float lightRadius;
+		if (!getLightVolume(&lightCenter, &lightRadius)) return true;
+
+		return glm::length(center - lightCenter) < radius + lightRadius;
+	}
+
+
+	/**
+	*
+	* \brief Find out whether the light can reach an entity
+	*
+	* The bounding sphere of the entity's mesh is transformed with the model matrix of the last update.
+	*
+	* \param[in] pEntity Pointer to the entity
+	* \returns true if the bounding sphere of the entity intersects the light volume
+	*
+	*/
+	bool VELight::lightsEntity(VEEntity *pEntity) {
+		if (pEntity->m_pMesh == nullptr) return true;
+
+		glm::mat4 &model = pEntity->m_ubo.model;
+		glm::vec4 center = model * glm::vec4(pEntity->m_pMesh->m_boundingSphereCenter, 1.0f);
+		float scale = std::max(glm::length(model[0]), std::max(glm::length(model[1]), glm::length(model[2])));
+
+		return lightsSphere(glm::vec3(center.x, center.y, center.z), pEntity->m_pMesh->m_boundingSphereRadius * scale);
+	}
+
+
+	/**
+	*
+	* \brief Get the wanted tile size of a shadow camera in the shadow atlas
+	*
+	* The size follows the screen coverage of the light: if the camera is inside the reach of the light,
+	* the largest size is used, otherwise the size falls off with the distance of the light.
+	*
+	* \param[in] pCamera Pointer to the currently used light camera.
+	* \param[in] idx Index of the shadow camera
+	* \returns the wanted tile size in texels
+	*
+	*/
+	uint32_t VELight::getShadowTileSize(VECamera *pCamera, uint32_t idx) {
+		glm::vec3 lightPos = glm::vec3(getWorldTransform()[3]);
+		glm::vec3 camPos = glm::vec3(pCamera->getWorldTransform()[3]);
+		float distance = glm::length(lightPos - camPos);
+		float reach = m_param[0];
+
+		if (distance <= reach) return getMaxShadowTileSize(idx);
+		return (uint32_t)(getMaxShadowTileSize(idx) * reach / distance);
+	}
+
+
+	/**
+	*
+	* \brief Place the shadow cameras of this light in the shadow atlas
+	*
+	* Tile sizes are rounded down to powers of two, and a tile keeps its current size as long as the wanted size
+	* stays within a factor of two, so the tiles and the recorded command buffers rarely change.
+	* The tiles are sorted by size and put into shelves from left to right. If they do not fit into the atlas,
+	* all tiles are halved until they do. Since shadow maps are drawn light by light, each light can use the whole atlas.
+	* Maps that are kept for later frames, i.e. cached static casters and time sliced cameras, are copied into tiles
+	* of the same size in the renderer's cache atlas. So all shadow maps of all lights together use the two atlases,
+	* SHADOW_ATLAS_WIDTH x SHADOW_ATLAS_HEIGHT and SHADOW_CACHE_ATLAS_WIDTH x SHADOW_CACHE_ATLAS_HEIGHT texels.
+	*
+	* \param[in] pCamera Pointer to the currently used light camera.
+	*
+	*/
+	void VELight::packShadowTiles(VECamera *pCamera) {
+		std::vector<uint32_t> dims(m_shadowCameras.size());
+		for (uint32_t i = 0; i < dims.size(); i++) {
+			uint32_t dim = std::min(getShadowTileSize(pCamera, i), getMaxShadowTileSize(i));
+			if (i < m_shadowTiles.size()) {
+				uint32_t current = m_shadowTiles[i].extent.width;
+				if (dim >= current / 2 && dim < 2 * current) dim = current;
+			}
+
+			dims[i] = 1;
+			while (2 * dims[i] <= std::max(dim, SHADOW_TILE_MIN_DIM)) dims[i] *= 2;
+			dims[i] = std::min(dims[i], getMaxShadowTileSize(i));
+		}
+
+		std::vector<uint32_t> order(dims.size());
+		for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return dims[a] > dims[b]; });
+
+		std::vector<VkRect2D> tiles(dims.size());
+		bool fits = false;
+		while (!fits) {
+			fits = true;
+			uint32_t x = 0, y = 0, shelfHeight = 0;
+			for (auto i : order) {
+				if (x + dims[i] > SHADOW_ATLAS_WIDTH) {		//start a new shelf
+					x = 0;
+					y += shelfHeight;
+					shelfHeight = 0;
+				}
+				if (y + dims[i] > SHADOW_ATLAS_HEIGHT) {
+					fits = false;
+					break;
+				}
+				tiles[i].offset = { (int32_t)x, (int32_t)y };
+				tiles[i].extent = { dims[i], dims[i] };
+				x += dims[i];
+				shelfHeight = std::max(shelfHeight, dims[i]);
+			}
+			if (!fits) {
+				for (auto &dim : dims) dim = std::max(dim / 2, 1u);
+			}
+		}
+
+		bool changed = tiles.size() != m_shadowTiles.size();
+		for (uint32_t i = 0; !changed && i < tiles.size(); i++) {
+			changed =	tiles[i].offset.x != m_shadowTiles[i].offset.x || tiles[i].offset.y != m_shadowTiles[i].offset.y ||
+						tiles[i].extent.width != m_shadowTiles[i].extent.width;
+		}
+		if (changed) {
+			m_shadowTiles = tiles;
+			m_shadowTilesVersion++;
+		}
+	}
+
+
 	/**
 	*
 	* \brief Destructor of the light class.
@@ -843,7 +1097,7 @@ namespace ve {
 	VEDirectionalLight::VEDirectionalLight(std::string name, glm::mat4 transf, VESceneNode *parent) :
 					VELight(name, transf, parent) {
 
-		for (uint32_t i = 0; i < 4; i++) {
+		for (uint32_t i = 0; i < NUM_DIRECTIONAL_CASCADE; i++) {
 			m_shadowCameras.push_back(new VECameraOrtho("ShadowCamDirOrtho") );	//no parent - > transform is also world matrix
 		}
 	};
@@ -853,32 +1107,92 @@ namespace ve {
 	*
 	* \brief Update all shadow cameras of this light.
 	*
+	* Each cascade is fit to an OBB of its segment of the view frustum, and its center is moved only in whole
+	* texels of its shadow map. This reduces shimmering of the shadow edges when the camera moves. A cascade may be
+	* refit only every few frames, see setCascadeIntervals().
+	*
 	* \param[in] pCamera Pointer to the currently used light camera.
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VEDirectionalLight::updateShadowCameras(VECamera *pCamera, uint32_t imageIndex) {
 
-		std::vector<float> limits = { 0.0f, 0.05f, 0.15f, 0.50f, 1.0f };	//the frustum is split into 4 segments
+		static const float limits[] = { 0.0f, 0.05f, 0.15f, 0.50f, 1.0f };	//the frustum is split into 4 segments
+
+		glm::mat4 W = getWorldTransform();
+		glm::vec3 xaxis = glm::normalize(glm::vec3(W[0].x, W[0].y, W[0].z));
+		glm::vec3 yaxis = glm::normalize(glm::vec3(W[1].x, W[1].y, W[1].z));
+		glm::vec3 zaxis = glm::normalize(glm::vec3(W[2].x, W[2].y, W[2].z));
+
+		bool turned = glm::mat3(W) != glm::mat3(m_cascadeTransform);		//a turned light needs new maps for all cascades
+		m_cascadeTransform = W;
+		m_cascadeStale.resize(m_shadowCameras.size(), false);
 
 		for (uint32_t i = 0; i < m_shadowCameras.size(); i++) {
 			VECameraOrtho *pShadowCamera = (VECameraOrtho *)m_shadowCameras[i];
 
-			std::vector<glm::vec4> pointsW;
-			pCamera->getFrustumPoints(pointsW, limits[i], limits[i+1]);		//get the ith frustum segment
+			//refit the cascade only in its own frames, the frames of the cascades are staggered
+			uint32_t interval = getShadowCameraInterval(i);
+			m_cascadeStale[i] = !turned && m_cascadeFrame % interval != i % interval;
+
+			if (!m_cascadeStale[i]) {
+				std::vector<glm::vec4> pointsW;
+				pCamera->getFrustumPoints(pointsW, limits[i], limits[i+1]);		//get the ith frustum segment
+
+				glm::vec3 center;
+				getOBB(pointsW, 0.0f, 1.0f, center, pShadowCamera->m_width, pShadowCamera->m_height, pShadowCamera->m_farPlane);
+				pShadowCamera->m_farPlane *= 5.0f;			//TODO - do NOT set too high or else shadow maps wont get drawn!
+
+				//move the cascade only in whole texels of its current tile, so the shadow edges shimmer less
+				float dim = (float)(i < m_shadowTiles.size() ? m_shadowTiles[i].extent.width : getMaxShadowTileSize(i));
+				float texelX = pShadowCamera->m_width / dim;
+				float texelY = pShadowCamera->m_height / dim;
+				float cx = glm::dot(center, xaxis);
+				float cy = glm::dot(center, yaxis);
+				center += (std::floor(cx / texelX) * texelX - cx) * xaxis + (std::floor(cy / texelY) * texelY - cy) * yaxis;
+
+				pShadowCamera->setTransform(W);
+				pShadowCamera->setPosition(center - pShadowCamera->m_farPlane*0.9f * zaxis);
+				pShadowCamera->m_nearPlaneFraction = limits[i];
+				pShadowCamera->m_farPlaneFraction = limits[i+1];
+			}
 
-			glm::vec3 center;
-			getOBB(pointsW, 0.0f, 1.0f, center, pShadowCamera->m_width, pShadowCamera->m_height, pShadowCamera->m_farPlane);
-			pShadowCamera->m_farPlane *= 5.0f;			//TODO - do NOT set too high or else shadow maps wont get drawn!
+			pShadowCamera->update( imageIndex );		//a stale cascade keeps the matrices its last map was drawn with
+		}
+		m_cascadeFrame++;
+	}
 
-			glm::mat4 W = getWorldTransform();
-			pShadowCamera->setTransform(W);
-			pShadowCamera->setPosition(center - pShadowCamera->m_farPlane*0.9f * glm::vec3(W[2].x, W[2].y, W[2].z));
-			pShadowCamera->m_nearPlaneFraction = limits[i];
-			pShadowCamera->m_farPlaneFraction = limits[i+1];
 
-			pShadowCamera->update( imageIndex );
-		}
+	/**
+	*
+	* \brief Set how often the cascades are refit
+	*
+	* Far cascades change little between frames, so they can be refit and drawn less often. A cascade that is
+	* not refit keeps its camera, and the renderer reuses its last shadow map, so moving objects are not
+	* updated in it until it is drawn again. All cascades are refit whenever the light turns. By default, all cascades
+	* are refit every frame.
+	*
+	* \param[in] intervals Cascade i is refit every intervals[i]-th frame, e.g. { 1, 2, 4, 4 }. Missing entries mean every frame.
+	*
+	*/
+	void VEDirectionalLight::setCascadeIntervals(std::vector<uint32_t> intervals) {
+		m_cascadeIntervals = intervals;
+		m_cascadeTransform = glm::mat4(0.0f);		//refit all cascades in the next frame
+		m_shadowTilesVersion++;						//the renderer gives the time sliced cascades their tiles in the cache atlas
+	}
+
+
+	/**
+	*
+	* \brief Get how often a cascade is refit
+	*
+	* \param[in] idx Index of the cascade
+	* \returns n if the cascade is refit every n-th frame
+	*
+	*/
+	uint32_t VEDirectionalLight::getShadowCameraInterval(uint32_t idx) {
+		if (idx >= m_cascadeIntervals.size()) return 1;
+		return std::max(m_cascadeIntervals[idx], 1u);
 	}
 
 
@@ -905,7 +1219,7 @@ namespace ve {
 	* \brief Update all shadow cameras of this light.
 	*
 	* \param[in] pCamera Pointer to the currently used light camera.
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 
@@ -916,6 +1230,25 @@ namespace ve {
 		glm::vec4 pos4 = getWorldTransform()[3];
 		glm::vec3 pos = glm::vec3(pos4.x, pos4.y, pos4.z);
 
+		static const glm::vec3 zaxis[] =
+		{
+			glm::vec3(1.0f,  0.0f,  0.0f),
+			glm::vec3(-1.0f,  0.0f,  0.0f),
+			glm::vec3(0.0f,  1.0f,  0.0f),
+			glm::vec3(0.0f, -1.0f,  0.0f),
+			glm::vec3(0.0f,  0.0f,  1.0f),
+			glm::vec3(0.0f,  0.0f, -1.0f)
+		};
+		static const glm::vec3 up[] =
+		{
+			glm::vec3(0.0f,  1.0f,  0.0f),
+			glm::vec3(0.0f,  1.0f,  0.0f),
+			glm::vec3(0.0f,  0.0f, -1.0f),
+			glm::vec3(0.0f,  0.0f,  1.0f),
+			glm::vec3(0.0f,  1.0f,  0.0f),
+			glm::vec3(0.0f,  1.0f,  0.0f)
+		};
+
 		for (uint32_t i = 0; i < m_shadowCameras.size(); i++) {
 
 			VECameraProjective * pShadowCamera = (VECameraProjective *)m_shadowCameras[i];
@@ -927,24 +1260,6 @@ namespace ve {
 			pShadowCamera->m_nearPlaneFraction = 0.0f;
 			pShadowCamera->m_farPlaneFraction =  1.0f;
 
-			std::vector<glm::vec3> zaxis =
-			{
-				glm::vec3(1.0f,  0.0f,  0.0f),
-				glm::vec3(-1.0f,  0.0f,  0.0f),
-				glm::vec3(0.0f,  1.0f,  0.0f),
-				glm::vec3(0.0f, -1.0f,  0.0f),
-				glm::vec3(0.0f,  0.0f,  1.0f),
-				glm::vec3(0.0f,  0.0f, -1.0f)
-			};
-			std::vector<glm::vec3> up =
-			{
-				glm::vec3(0.0f,  1.0f,  0.0f),
-				glm::vec3(0.0f,  1.0f,  0.0f),
-				glm::vec3(0.0f,  0.0f, -1.0f),
-				glm::vec3(0.0f,  0.0f,  1.0f),
-				glm::vec3(0.0f,  1.0f,  0.0f),
-				glm::vec3(0.0f,  1.0f,  0.0f)
-			};
 			pShadowCamera->lookAt( pos, pos + zaxis[i], up[i]);
 			pShadowCamera->update(imageIndex);
 		}
@@ -973,13 +1288,13 @@ namespace ve {
 	* \brief Update all shadow cameras of this light.
 	*
 	* \param[in] pCamera Pointer to the currently used light camera.
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VESpotLight::updateShadowCameras(VECamera *pCamera, uint32_t imageIndex) {
 
 		//std::vector<float> limits = { 0.0f, 0.05f, 0.15f, 0.50f, 1.0f };	//the frustum is split into 4 segments
-		std::vector<float> limits = { 0.0f, 1.0f };		//the frustum is split into 1 segment
+		static const float limits[] = { 0.0f, 1.0f };		//the frustum is split into 1 segment
 
 		for (uint32_t i = 0; i < m_shadowCameras.size(); i++) {
 
@@ -1001,6 +1316,38 @@ namespace ve {
 		}
 	}
 
+
+	/**
+	*
+	* \brief Find out whether the spot light can reach into a sphere
+	*
+	* The light shines into a cone up to its reach. The cone ends at the angle where the falloff
+	* pow(cos(angle), SPOT_LIGHT_EXPONENT) drops below SPOT_LIGHT_MIN_FACTOR. The sphere is tested against the cone
+	* by its distance from the closest cone side.
+	*
+	* \param[in] center Center of the sphere in world space
+	* \param[in] radius Radius of the sphere
+	* \returns true if the sphere intersects the light volume
+	*
+	*/
+	bool VESpotLight::lightsSphere(glm::vec3 center, float radius) {
+		if (!VELight::lightsSphere(center, radius)) return false;
+
+		static const float cosAngle = pow(SPOT_LIGHT_MIN_FACTOR, 1.0f / SPOT_LIGHT_EXPONENT);
+		static const float sinAngle = sqrt(1.0f - cosAngle * cosAngle);
+
+		glm::mat4 W = getWorldTransform();
+		glm::vec3 pos = glm::vec3(W[3].x, W[3].y, W[3].z);
+		glm::vec3 dir = glm::normalize(glm::vec3(W[2].x, W[2].y, W[2].z));
+
+		glm::vec3 v = center - pos;
+		float along = glm::dot(v, dir);										//distance along the axis
+		float across = sqrt(std::max(glm::dot(v, v) - along * along, 0.0f));	//distance from the axis
+		if (along < -radius) return false;									//behind the light
+
+		return cosAngle * across - sinAngle * along <= radius;				//distance from the cone side
+	}
+
 }
 
 
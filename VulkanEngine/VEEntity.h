@@ -8,6 +8,15 @@
 
 #pragma once
 
+const uint32_t SHADOW_MAP_DIM = 4096;			///<Largest tile size of a shadow camera in the shadow atlas
+const uint32_t SHADOW_TILE_MIN_DIM = 256;		///<Smallest wanted tile size of a shadow camera
+const uint32_t SHADOW_ATLAS_WIDTH = 8192;		///<Width of the shadow atlas holding the shadow maps of a light
+const uint32_t SHADOW_ATLAS_HEIGHT = 4096;		///<Height of the shadow atlas
+const uint32_t SHADOW_CACHE_ATLAS_WIDTH = 8192;		///<Width of the atlas keeping shadow maps between frames, shared by all lights, a multiple of SHADOW_MAP_DIM
+const uint32_t SHADOW_CACHE_ATLAS_HEIGHT = 4096;	///<Height of the cache atlas, a multiple of SHADOW_MAP_DIM
+const float SPOT_LIGHT_EXPONENT = 10.0f;		///<Exponent of the spot light falloff, must match spotlight() in light.glsl
+const float SPOT_LIGHT_MIN_FACTOR = 1.0f / 256.0f;	///<Falloff below which a spot light is invisible, this is where its cone ends
+
 namespace ve {
 
 	//----------------------------------------------------------------------------------------------
@@ -162,20 +171,32 @@ namespace ve {
 			glm::mat4 modelInvTrans;	///<Inverse transpose
 			glm::vec4 color;			///<Uniform color if needed by shader
 			glm::vec4 param;			///<Texture scaling and animation
+			glm::vec4 boundingSphere;	///<xyz: center of the mesh bounding sphere in local space, w: its radius
+			glm::uvec4 material;		///<x: index of the material in the bindless table
+		};
+
+		///Per object data pushed for each draw call, must match objectPushData_t of the material shaders
+		struct vePushConstantsPerObject_t {
+			glm::uvec4 material;		///<x: index of the material in the bindless table
 		};
 
 	protected:
 		veEntityType				m_entityType = VE_ENTITY_TYPE_NORMAL;			///<Entity type
 		glm::vec4					m_param = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);	///<Free parameter, e.g. for texture animation
+		bool						m_drawEntity = false;			///<should it be drawn at all?
+		bool						m_castsShadow = true;			///<draw in the shadow pass?
+		bool						m_staticShadow = false;			///<static shadow caster, drawn only into the cached shadow maps
 
 	public:
 		struct veUBOPerObject_t		m_ubo;							///<UBO to be copied to the GPU
+		vePushConstantsPerObject_t	m_pushConstants = {};			///<Per object data pushed if the subrenderer uses push constants
 		VEMesh *					m_pMesh = nullptr;				///<Pointer to entity mesh
 		VEMaterial *				m_pMaterial = nullptr;			///<Pointer to entity material
 
 		VESubrender *				m_pSubrenderer = nullptr;		///<subrenderer this entity is registered with / replace with a set
-		bool						m_drawEntity = false;			///<should it be drawn at all?
-		bool						m_castsShadow = true;			///<draw in the shadow pass?
+		uint64_t					m_boundsVersion = 0;			///<Value of s_boundsVersion when this entity last moved or was switched on or off
+
+		static uint64_t				s_boundsVersion;				///<Increased whenever any entity moves or is switched on or off
 
 		std::vector<VkDescriptorSet> m_descriptorSetsResources;		///<Per subrenderer descriptor sets for other resources
 
@@ -199,6 +220,20 @@ namespace ve {
 		virtual void updateUBO( glm::mat4 worldMatrix, uint32_t imageIndex );	//update the UBO of this node using its current world matrix
 		void		 setParam(glm::vec4 param);		//set the free parameter
 
+		//-------------------------------------------------------------------------------------
+		//Drawing state - changes are reported to the renderer
+
+		void		 setDrawEntity(bool drawEntity);		//switch drawing on or off
+		void		 setCastsShadow(bool castsShadow);		//switch drawing in the shadow pass on or off
+		void		 setStaticShadow(bool staticShadow);	//mark the entity as a static shadow caster
+		void		 setMaterial(VEMaterial *pMat);			//exchange the material, might move the entity to another subrenderer
+		///\returns true if the entity is drawn
+		bool		 getDrawEntity() { return m_drawEntity; };
+		///\returns true if the entity is drawn into the shadow maps
+		bool		 getCastsShadow() { return m_castsShadow; };
+		///\returns true if the entity is a static shadow caster
+		bool		 getStaticShadow() { return m_staticShadow; };
+
 		//-------------------------------------------------------------------------------------
 		//Bounding volume
 
@@ -412,11 +447,14 @@ namespace ve {
 			glm::vec4	col_specular;						///<Specular color
 			glm::vec4	param;								///<Light parameters
 			VECamera::veUBOPerCamera_t shadowCameras[6];	///<Up to 6 different shadows, each having its own camera and shadow map
+			glm::vec4	shadowTiles[6];						///<Shadow atlas tile of each shadow camera: xy...uv offset, zw...uv scale
 		};
 
 	public:
 		struct veUBOPerLight_t	m_ubo;						///<The UBO that is copied to the GPU
 		std::vector<VECamera*>	m_shadowCameras;			///<Up to 6 shadow cameras for this light
+		std::vector<VkRect2D>	m_shadowTiles;				///<Tile of each shadow camera in the shadow atlas
+		uint64_t				m_shadowTilesVersion = 0;	///<Increased whenever the tiles change
 
 		glm::vec4 m_col_ambient  = 0.3f * glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);	///<Ambient color
 		glm::vec4 m_col_diffuse  = 0.5f * glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);	///<Diffuse color
@@ -431,6 +469,17 @@ namespace ve {
 
 		///Update all shadow cameras of this light - pure virtual for the light base class
 		virtual void updateShadowCameras(VECamera *pCamera, uint32_t imageIndex )=0;
+		virtual uint32_t getShadowTileSize(VECamera *pCamera, uint32_t idx);	//wanted tile size of a shadow camera
+		///\returns the largest tile size a shadow camera can get in the shadow atlas
+		virtual uint32_t getMaxShadowTileSize(uint32_t idx) { return SHADOW_MAP_DIM; };
+		virtual void packShadowTiles(VECamera *pCamera);						//place the shadow cameras in the shadow atlas
+		///\returns n if the shadow camera is refit only every n-th frame
+		virtual uint32_t getShadowCameraInterval(uint32_t idx) { return 1; };
+		///\returns true if the shadow camera was not refit in this frame, so its last shadow map can be reused
+		virtual bool isShadowCameraStale(uint32_t idx) { return false; };
+		virtual bool getLightVolume(glm::vec3 *center, float *radius);	//bounding sphere of the space the light can reach
+		virtual bool lightsSphere(glm::vec3 center, float radius);		//true if the light can reach into a sphere
+		virtual bool lightsEntity(VEEntity *pEntity);					//true if the light can reach an entity
 
 		///\returns the scene node type
 		virtual veNodeType	getNodeType() { return VE_OBJECT_TYPE_LIGHT; };
@@ -460,6 +509,12 @@ namespace ve {
 	*/
 
 	class VEDirectionalLight : public VELight {
+	protected:
+		std::vector<uint32_t>	m_cascadeIntervals;						///<Cascade i is refit only every m_cascadeIntervals[i]-th frame, empty by default
+		std::vector<bool>		m_cascadeStale;							///<Cascade i was not refit in the current frame
+		glm::mat4				m_cascadeTransform = glm::mat4(0.0f);	///<Light orientation the cascades were fit for
+		uint64_t				m_cascadeFrame = 0;						///<Number of frames the cascades have been updated
+
 	public:
 
 		//-------------------------------------------------------------------------------------
@@ -471,6 +526,17 @@ namespace ve {
 		virtual ~VEDirectionalLight() {};
 
 		virtual void updateShadowCameras(VECamera *pCamera, uint32_t imageIndex);
+		virtual void setCascadeIntervals(std::vector<uint32_t> intervals);
+		virtual uint32_t getShadowCameraInterval(uint32_t idx);
+		///\returns true if the cascade was not refit in this frame
+		virtual bool isShadowCameraStale(uint32_t idx) { return idx < m_cascadeStale.size() && m_cascadeStale[idx]; };
+		///\returns false, since a directional light reaches the whole scene
+		virtual bool getLightVolume(glm::vec3 *center, float *radius) { return false; };
+
+		///\returns the tile size of a cascade, each cascade gets half the size of the previous one
+		virtual uint32_t getShadowTileSize(VECamera *pCamera, uint32_t idx) { return getMaxShadowTileSize(idx); };
+		///\returns the largest tile size of a cascade
+		virtual uint32_t getMaxShadowTileSize(uint32_t idx) { return SHADOW_MAP_DIM >> idx; };
 
 		///\returns the light type
 		virtual veLightType getLightType() { return VE_LIGHT_TYPE_DIRECTIONAL; };
@@ -501,6 +567,9 @@ namespace ve {
 
 		virtual void updateShadowCameras(VECamera *pCamera, uint32_t imageIndex);
 
+		///\returns the largest tile size of a cube face, six faces must fit into the shadow atlas
+		virtual uint32_t getMaxShadowTileSize(uint32_t idx) { return SHADOW_MAP_DIM / 2; };
+
 		///\returns the light type
 		virtual veLightType getLightType() { return VE_LIGHT_TYPE_POINT; };
 	};
@@ -527,6 +596,7 @@ namespace ve {
 		virtual ~VESpotLight() {};
 
 		virtual void updateShadowCameras(VECamera *pCamera, uint32_t imageIndex);
+		virtual bool lightsSphere(glm::vec3 center, float radius);
 
 		///\returns the light type
 		virtual veLightType getLightType() { return VE_LIGHT_TYPE_SPOT; };
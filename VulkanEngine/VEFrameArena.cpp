@@ -0,0 +1,195 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+#ifdef VE_COUNT_FRAME_ALLOCATIONS
+
+/**
+*
+* \brief Global operator new, counts the heap allocations made inside a frame
+*
+*/
+void *operator new(size_t size) {
+	if (ve::VEFrameArena::inFrame()) ve::VEFrameArena::countHeapAllocation();
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+///Global array operator new, counts like the operator new above
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+///Global operator delete, matches the operator new above
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+///Global array operator delete, matches the array operator new above
+void operator delete[](void *p) noexcept {
+	free(p);
+}
+
+#ifdef __cpp_aligned_new
+
+/**
+*
+* \brief Global operator new for over-aligned types, counts the heap allocations made inside a frame
+*
+*/
+void *operator new(size_t size, std::align_val_t alignment) {
+	if (ve::VEFrameArena::inFrame()) ve::VEFrameArena::countHeapAllocation();
+	void *p = nullptr;
+#ifdef _WIN32
+	p = _aligned_malloc(size > 0 ? size : 1, (size_t)alignment);
+#else
+	if (posix_memalign(&p, std::max((size_t)alignment, sizeof(void*)), size > 0 ? size : 1) != 0) p = nullptr;
+#endif
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+///Global array operator new for over-aligned types, counts like the operator new above
+void *operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+///Global operator delete for over-aligned types, matches the operator new above
+void operator delete(void *p, std::align_val_t alignment) noexcept {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+///Global array operator delete for over-aligned types, matches the array operator new above
+void operator delete[](void *p, std::align_val_t alignment) noexcept {
+	operator delete(p, alignment);
+}
+
+#endif
+
+#endif
+
+
+namespace ve {
+
+	std::atomic<uint64_t>	VEFrameArena::s_frame(1);
+	std::atomic<bool>		VEFrameArena::s_inFrame(false);
+	std::atomic<uint64_t>	VEFrameArena::s_heapAllocations(0);
+	uint64_t				VEFrameArena::s_heapAllocationsBegin = 0;
+	uint64_t				VEFrameArena::s_heapAllocationsFrame = 0;
+
+
+	/**
+	* \brief Free all blocks of the arena
+	*/
+	VEFrameArena::~VEFrameArena() {
+		for (auto &block : m_blocks) delete[] block.first;
+	}
+
+
+	/**
+	*
+	* \brief Get the frame arena of the calling thread
+	*
+	* The arena is reset the first time it is used in a new frame.
+	*
+	* \returns the arena of the calling thread
+	*
+	*/
+	VEFrameArena &VEFrameArena::get() {
+		static thread_local VEFrameArena arena;
+		if (arena.m_frame != s_frame) {
+			arena.reset();
+			arena.m_frame = s_frame;
+		}
+		return arena;
+	}
+
+
+	/**
+	* \brief Give all memory back to the arena, the blocks are kept for the next frame
+	*/
+	void VEFrameArena::reset() {
+		m_block = 0;
+		m_offset = 0;
+	}
+
+
+	/**
+	*
+	* \brief Take memory from the arena
+	*
+	* If the current block is full, the next block is used. If there is none, or if it is too small,
+	* a new block is allocated. This happens only in the first frames.
+	*
+	* \param[in] size Number of bytes
+	* \param[in] alignment Alignment of the memory, a power of 2
+	* \returns the memory
+	*
+	*/
+	void *VEFrameArena::allocate(size_t size, size_t alignment) {
+		while (m_block < m_blocks.size()) {
+			size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+			if (offset + size <= m_blocks[m_block].second) {
+				m_offset = offset + size;
+				return m_blocks[m_block].first + offset;
+			}
+			m_block++;
+			m_offset = 0;
+		}
+
+		size_t blockSize = std::max(FRAME_ARENA_BLOCK_SIZE, size + alignment);
+		char *block = new char[blockSize];
+		m_blocks.push_back({ block, blockSize });
+
+		size_t offset = (size_t)(((uintptr_t)block + alignment - 1) & ~(uintptr_t)(alignment - 1)) - (size_t)(uintptr_t)block;
+		m_offset = offset + size;
+		return block + offset;
+	}
+
+
+	/**
+	*
+	* \brief Start a new frame of the render loop
+	*
+	* All arenas are reset the next time their thread uses them, so memory from the last frame becomes invalid.
+	*
+	*/
+	void VEFrameArena::beginFrame() {
+		s_frame++;
+		s_heapAllocationsBegin = s_heapAllocations;
+		s_inFrame = true;
+	}
+
+
+	/**
+	*
+	* \brief End the frame, and remember how many heap allocations it made
+	*
+	* If the engine is compiled with VE_COUNT_FRAME_ALLOCATIONS, a frame that touched the heap is reported on the console.
+	* The first frames are expected to do so, until the arenas and the reused vectors have reached their sizes.
+	*
+	*/
+	void VEFrameArena::endFrame() {
+		s_inFrame = false;
+		s_heapAllocationsFrame = s_heapAllocations - s_heapAllocationsBegin;
+
+#ifdef VE_COUNT_FRAME_ALLOCATIONS
+		if (s_heapAllocationsFrame > 0) {
+			std::cout << "Frame " << s_frame << " made " << s_heapAllocationsFrame << " heap allocations\n";
+		}
+#endif
+	}
+
+}
@@ -0,0 +1,93 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+const size_t FRAME_ARENA_BLOCK_SIZE = 64 * 1024;						///<Size of a memory block of a frame arena, larger allocations get their own block
+
+namespace ve {
+
+	/**
+	*
+	* \brief Linear allocator for temporaries of the render loop
+	*
+	* Memory is taken from large blocks by bumping an offset, and is never freed individually. Instead, the whole
+	* arena is reset at the start of the next frame, keeping its blocks. So after the first frames, the render loop
+	* does not touch the heap for its temporaries. Each thread has its own arena, see get(), so allocating needs
+	* no lock. Memory from the arena must not be used after the frame it was allocated in.
+	*
+	* If the engine is compiled with VE_COUNT_FRAME_ALLOCATIONS, all heap allocations made between beginFrame()
+	* and endFrame() are counted, see getHeapAllocations(), and endFrame() reports each frame that made any.
+	*
+	*/
+	class VEFrameArena {
+
+	protected:
+		std::vector<std::pair<char*, size_t>>	m_blocks;		///<Memory blocks and their sizes
+		uint32_t								m_block = 0;	///<Block that memory is taken from
+		size_t									m_offset = 0;	///<First free byte of the current block
+		uint64_t								m_frame = 0;	///<Frame the arena was last reset in
+
+		static std::atomic<uint64_t>	s_frame;				///<Counts the frames
+		static std::atomic<bool>		s_inFrame;				///<True between beginFrame() and endFrame()
+		static std::atomic<uint64_t>	s_heapAllocations;		///<Heap allocations made inside all frames so far
+		static uint64_t					s_heapAllocationsBegin;	///<Value of s_heapAllocations at beginFrame()
+		static uint64_t					s_heapAllocationsFrame;	///<Heap allocations of the last frame
+
+		void reset();
+
+	public:
+		///Constructor of class VEFrameArena
+		VEFrameArena() {};
+		virtual ~VEFrameArena();
+
+		void *allocate(size_t size, size_t alignment);
+
+		static VEFrameArena &get();
+		static void		beginFrame();
+		static void		endFrame();
+		///\returns true if the render loop is inside a frame
+		static bool		inFrame() { return s_inFrame; };
+		///Count one heap allocation, called by the global operator new
+		static void		countHeapAllocation() { s_heapAllocations++; };
+		///\returns the number of heap allocations made inside the last frame, always 0 without VE_COUNT_FRAME_ALLOCATIONS
+		static uint64_t	getHeapAllocations() { return s_heapAllocationsFrame; };
+	};
+
+
+	/**
+	*
+	* \brief STL allocator taking its memory from the frame arena of the thread that created it
+	*
+	* Containers using it must not outlive the frame, and must be changed only by the thread that created them.
+	*
+	*/
+	template<typename T> class VEFrameAllocator {
+
+	public:
+		typedef T value_type;
+
+		VEFrameArena *m_pArena;			///<Arena of the creating thread
+
+		///Constructor of class VEFrameAllocator, uses the arena of the calling thread
+		VEFrameAllocator() : m_pArena(&VEFrameArena::get()) {};
+		///Copy constructor for other value types, used by the containers internally
+		template<typename U> VEFrameAllocator(const VEFrameAllocator<U> &other) : m_pArena(other.m_pArena) {};
+
+		///\returns memory for n objects of type T
+		T *allocate(size_t n) { return (T*)m_pArena->allocate(n * sizeof(T), alignof(T)); };
+		///Does nothing, the memory is released when the arena is reset
+		void deallocate(T *p, size_t n) {};
+
+		template<typename U> bool operator==(const VEFrameAllocator<U> &other) const { return m_pArena == other.m_pArena; };
+		template<typename U> bool operator!=(const VEFrameAllocator<U> &other) const { return m_pArena != other.m_pArena; };
+	};
+
+	///A vector living in the frame arena
+	template<typename T> using veFrameVector = std::vector<T, VEFrameAllocator<T>>;
+
+}
@@ -15,9 +15,17 @@
 #include "VEWindow.h"
 #include "VEWindowGLFW.h"
 #include "VEEngine.h"
+#include "VEBindlessTable.h"
+#include "VEDescriptorAllocator.h"
+#include "VEFrameArena.h"
+#include "VETimeline.h"
+#include "VELayoutTracker.h"
+#include "VERenderGraph.h"
+#include "VEUploadManager.h"
 #include "VEMaterial.h"
 #include "VEEntity.h"
 #include "VESceneManager.h"
+#include "VEPipelineRegistry.h"
 #include "VESubrender.h"
 #include "VESubrenderFW_C1.h"
 #include "VESubrenderFW_Cubemap.h"
@@ -26,6 +34,10 @@
 #include "VESubrenderFW_D.h"
 #include "VESubrenderFW_DN.h"
 #include "VESubrenderFW_Shadow.h"
+#include "VESubrenderDF_D.h"
+#include "VESubrenderDF_DN.h"
+#include "VESubrenderDF_Light.h"
 #include "VERenderer.h"
 #include "VERendererForward.h"
+#include "VERendererDeferred.h"
 
@@ -0,0 +1,148 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	///All access flags that write to an image
+	const VkAccessFlags VE_WRITE_ACCESS =	VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+											VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+											VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+
+	/**
+	*
+	* \brief Register an image, or tell the tracker about a layout change it did not do itself
+	*
+	* Used for new images, and after render passes, blits or submissions that leave the image in a known layout.
+	*
+	* \param[in] image The image
+	* \param[in] aspect Aspect of the image, used for all its barriers
+	* \param[in] layout The layout the image is in now
+	* \param[in] access The last access to the image, or 0
+	* \param[in] stage The pipeline stage of the last access, or 0
+	*
+	*/
+	void VELayoutTracker::setState(	VkImage image, VkImageAspectFlags aspect, VkImageLayout layout,
+									VkAccessFlags access, VkPipelineStageFlags stage) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_images[image] = { aspect, layout, access, stage };
+	}
+
+
+	/**
+	*
+	* \brief Tell the tracker about a layout change of a registered image, its aspect stays the same
+	*
+	* \param[in] image The image, nothing happens if it has not been registered
+	* \param[in] layout The layout the image is in now
+	* \param[in] access The last access to the image, or 0
+	* \param[in] stage The pipeline stage of the last access, or 0
+	*
+	*/
+	void VELayoutTracker::setState(VkImage image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_images.find(image);
+		if (it == m_images.end()) return;
+		it->second = { it->second.aspect, layout, access, stage };
+	}
+
+
+	/**
+	*
+	* \param[in] image The image
+	* \returns the layout of the image after the commands recorded so far, VK_IMAGE_LAYOUT_UNDEFINED if it is unknown
+	*
+	*/
+	VkImageLayout VELayoutTracker::getLayout(VkImage image) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_images.find(image);
+		if (it == m_images.end()) return VK_IMAGE_LAYOUT_UNDEFINED;
+		return it->second.layout;
+	}
+
+
+	/**
+	*
+	* \brief Collect a barrier that brings an image into a new layout
+	*
+	* The barrier is recorded by the next call to flush(). If the image is in the layout already, has not been
+	* written since its last barrier, and is only read afterwards, nothing is collected.
+	*
+	* \param[in] image The image, must have been registered with setState()
+	* \param[in] layout The new layout
+	* \param[in] access The access that follows the barrier, or 0
+	* \param[in] stage The pipeline stage of this access, or 0 if nothing waits for the barrier
+	*
+	*/
+	void VELayoutTracker::transition(VkImage image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_images.find(image);
+		if (it == m_images.end()) return;
+
+		veImageState_t &state = it->second;
+		if (state.layout == layout && (state.access & VE_WRITE_ACCESS) == 0 && (access & VE_WRITE_ACCESS) == 0) {
+			state.access |= access;
+			state.stage |= stage;
+			return;
+		}
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = state.layout;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { state.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+		barrier.srcAccessMask = state.access & VE_WRITE_ACCESS;		//only writes must be made available
+		barrier.dstAccessMask = access;
+		m_barriers.push_back(barrier);
+
+		m_srcStages |= state.stage != 0 ? state.stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		m_dstStages |= stage != 0 ? stage : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		state = { state.aspect, layout, access, stage };
+	}
+
+
+	/**
+	*
+	* \brief Record all collected barriers into a command buffer
+	*
+	* \param[in] commandBuffer The command buffer, it must not be inside a render pass
+	*
+	*/
+	void VELayoutTracker::flush(VkCommandBuffer commandBuffer) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_barriers.empty()) return;
+
+		vkCmdPipelineBarrier(	commandBuffer, m_srcStages, m_dstStages, 0,
+								0, nullptr, 0, nullptr, (uint32_t)m_barriers.size(), m_barriers.data());
+
+		m_barriers.clear();
+		m_srcStages = 0;
+		m_dstStages = 0;
+	}
+
+
+	/**
+	*
+	* \brief Forget an image that is going to be destroyed
+	*
+	* \param[in] image The image
+	*
+	*/
+	void VELayoutTracker::forget(VkImage image) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_images.erase(image);
+	}
+
+}
@@ -0,0 +1,58 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+namespace ve {
+
+	/**
+	*
+	* \brief Remembers the layout of images, and batches the barriers that change it
+	*
+	* For each registered image, the tracker knows the layout it will have after the commands recorded so far,
+	* and which access and pipeline stage last touched it. Render passes change the layout by their final layout,
+	* this is told to the tracker with setState(). Other changes are requested with transition(), which only
+	* collects a barrier. All collected barriers are then recorded by flush() into the command buffer with a single
+	* vkCmdPipelineBarrier(), so no extra command buffer or submission is needed. Transitions into the layout an image
+	* already has are left out, unless earlier writes must be made visible, or a write must wait for earlier reads.
+	*
+	* The functions may be called from several threads at the same time.
+	*
+	*/
+	class VELayoutTracker {
+
+	protected:
+		///What the tracker knows about an image
+		struct veImageState_t {
+			VkImageAspectFlags		aspect;		///<Aspect of all barriers of the image
+			VkImageLayout			layout;		///<Layout after the commands recorded so far
+			VkAccessFlags			access;		///<Last access to the image
+			VkPipelineStageFlags	stage;		///<Pipeline stage of the last access
+		};
+
+		std::unordered_map<VkImage, veImageState_t> m_images;	///<All registered images
+		std::vector<VkImageMemoryBarrier> m_barriers;			///<Barriers waiting for flush()
+		VkPipelineStageFlags	m_srcStages = 0;				///<Stages the collected barriers wait for
+		VkPipelineStageFlags	m_dstStages = 0;				///<Stages waiting for the collected barriers
+		std::mutex				m_mutex;						///<Guards all members
+
+	public:
+		///Constructor of class VELayoutTracker
+		VELayoutTracker() {};
+		///Destructor of class VELayoutTracker
+		virtual ~VELayoutTracker() {};
+
+		void			setState(	VkImage image, VkImageAspectFlags aspect, VkImageLayout layout,
+									VkAccessFlags access, VkPipelineStageFlags stage);
+		void			setState(VkImage image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage);
+		VkImageLayout	getLayout(VkImage image);
+		void			transition(VkImage image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage);
+		void			flush(VkCommandBuffer commandBuffer);
+		void			forget(VkImage image);
+	};
+
+}
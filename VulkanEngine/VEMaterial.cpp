@@ -74,18 +74,7 @@ namespace ve {
 			}
 		}
 
-		//create the vertex buffer
-		VECHECKRESULT(vh::vhBufCreateVertexBuffer(	getRendererPointer()->getDevice(), getRendererPointer()->getVmaAllocator(),
-													getRendererPointer()->getGraphicsQueue(), getRendererPointer()->getCommandPool(),
-													vertices, &m_vertexBuffer, &m_vertexBufferAllocation),
-					"Could not create vertex buffer for " + name );
-
-		//create the index buffer
-		VECHECKRESULT( vh::vhBufCreateIndexBuffer(	getRendererPointer()->getDevice(), getRendererPointer()->getVmaAllocator(),
-													getRendererPointer()->getGraphicsQueue(), getRendererPointer()->getCommandPool(),
-													indices, &m_indexBuffer, &m_indexBufferAllocation),
-					"Could not create index buffer for " + name);
-
+		createBuffers(vertices, indices, name);
 	}
 
 
@@ -114,17 +103,41 @@ namespace ve {
 		}
 		m_boundingSphereRadius = sqrt(m_boundingSphereRadius);
 
+		createBuffers(vertices, indices, name);
+	}
+
+
+	/**
+	*
+	* \brief Create the vertex and index buffers, their data is copied by the upload manager
+	*
+	* The copies are submitted with the next frame, no queue is waited for.
+	*
+	* \param[in] vertices A list of vertices to be used
+	* \param[in] indices A list of indices to be used
+	* \param[in] name The name of the mesh, for error messages
+	*
+	*/
+	void VEMesh::createBuffers(std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices, std::string &name) {
+		VEUploadManager *pUploads = getRendererPointer()->getUploadManager();
+
 		//create the vertex buffer
-		VECHECKRESULT( vh::vhBufCreateVertexBuffer(	getRendererPointer()->getDevice(), getRendererPointer()->getVmaAllocator(),
-													getRendererPointer()->getGraphicsQueue(), getRendererPointer()->getCommandPool(),
-													vertices, &m_vertexBuffer, &m_vertexBufferAllocation),
+		VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+		VECHECKRESULT( vh::vhBufCreateBuffer(	getRendererPointer()->getVmaAllocator(), bufferSize,
+												VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+												VMA_MEMORY_USAGE_GPU_ONLY, &m_vertexBuffer, &m_vertexBufferAllocation),
 						"Could not create vertex buffer for " + name);
+		pUploads->uploadBuffer(	m_vertexBuffer, 0, vertices.data(), bufferSize,
+								VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 
 		//create the index buffer
-		VECHECKRESULT( vh::vhBufCreateIndexBuffer(	getRendererPointer()->getDevice(), getRendererPointer()->getVmaAllocator(),
-													getRendererPointer()->getGraphicsQueue(), getRendererPointer()->getCommandPool(),
-													indices, &m_indexBuffer, &m_indexBufferAllocation),
+		bufferSize = sizeof(indices[0]) * indices.size();
+		VECHECKRESULT( vh::vhBufCreateBuffer(	getRendererPointer()->getVmaAllocator(), bufferSize,
+												VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+												VMA_MEMORY_USAGE_GPU_ONLY, &m_indexBuffer, &m_indexBufferAllocation),
 						"Could not create index buffer for " + name);
+		pUploads->uploadBuffer(	m_indexBuffer, 0, indices.data(), bufferSize,
+								VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 	}
 
 
@@ -145,6 +158,7 @@ namespace ve {
 	* \brief Destroy the material textures
 	*/
 	VEMaterial::~VEMaterial() {
+		if (getRendererPointer()->getBindlessTable() != nullptr) getRendererPointer()->getBindlessTable()->removeMaterial(this);
 		if (mapDiffuse != nullptr) delete mapDiffuse;
 		if (mapBump != nullptr) delete mapBump;
 		if (mapNormal != nullptr) delete mapNormal;
@@ -160,7 +174,7 @@ namespace ve {
 	* \brief VETexture constructor from a list of textures.
 	*
 	* Create a VETexture from a list of textures. The textures must lie in the same directory and are stored in a texture array.
-	* This can be used also as a cube map.
+	* This can be used also as a cube map. If the renderer has a bindless table, a 2D texture is also put into its texture array.
 	*
 	* \param[in] name The name of the mesh.
 	* \param[in] basedir Name of the directory the files are in.
@@ -174,18 +188,30 @@ namespace ve {
 							VkImageCreateFlags flags, VkImageViewType viewType) : VENamedClass(name) {
 		if (texNames.size() == 0) return;
 
-		VECHECKRESULT(vh::vhBufCreateTextureImage(getRendererPointer()->getDevice(), getRendererPointer()->getVmaAllocator(),
-							getRendererPointer()->getGraphicsQueue(), getRendererPointer()->getCommandPool(),
-							basedir, texNames, flags, &m_image, &m_deviceAllocation, &m_extent),
-					"Could not create texture image for " + basedir + "/" + texNames[0] );
+		//the pixels are copied by the upload manager with the next frame
+		std::vector<uint8_t> pixels;
+		std::vector<VkBufferImageCopy> regions;
+		VECHECKRESULT(vh::vhBufLoadTextureImage(basedir, texNames, pixels, regions, &m_extent),
+					"Could not load texture image " + basedir + "/" + texNames[0] );
 
 		m_format = VK_FORMAT_R8G8B8A8_UNORM;
+		VECHECKRESULT(vh::vhBufCreateImage(	getRendererPointer()->getVmaAllocator(), m_extent.width, m_extent.height, 1,
+											(uint32_t)texNames.size(), m_format, VK_IMAGE_TILING_OPTIMAL,
+											VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+											flags, &m_image, &m_deviceAllocation),
+					"Could not create texture image for " + basedir + "/" + texNames[0] );
+
+		getRendererPointer()->getUploadManager()->uploadImage(m_image, 1, (uint32_t)texNames.size(), pixels.data(), pixels.size(), regions);
 		VECHECKRESULT(vh::vhBufCreateImageView(getRendererPointer()->getDevice(), m_image,
 							m_format, viewType, (uint32_t)texNames.size(), VK_IMAGE_ASPECT_COLOR_BIT, &m_imageView),
 					"Could not create image view for " + basedir + "/" + texNames[0]);
 
 		VECHECKRESULT(vh::vhBufCreateTextureSampler(getRendererPointer()->getDevice(), &m_sampler),
 					"Could not create texture sampler for " + basedir + "/" + texNames[0]);
+
+		if (viewType == VK_IMAGE_VIEW_TYPE_2D && getRendererPointer()->getBindlessTable() != nullptr) {
+			getRendererPointer()->getBindlessTable()->addTexture(this);
+		}
 	}
 
 	/**
@@ -203,13 +229,22 @@ namespace ve {
 	VETexture::VETexture(std::string name, gli::texture_cube &texCube,
 		VkImageCreateFlags flags, VkImageViewType viewType) : VENamedClass(name) {
 
-		VECHECKRESULT(vh::vhBufCreateTexturecubeImage(getRendererPointer()->getDevice(), getRendererPointer()->getVmaAllocator(),
-							getRendererPointer()->getGraphicsQueue(), getRendererPointer()->getCommandPool(),
-							texCube, &m_image, &m_deviceAllocation, &m_format),
-					"Could not create texture cubemap for " + name);
+		//the faces are copied by the upload manager with the next frame
+		std::vector<VkBufferImageCopy> regions;
+		VECHECKRESULT(vh::vhBufGetTexturecubeRegions(texCube, regions, &m_format),
+					"Could not load texture cubemap for " + name);
 
 		m_extent.width = texCube.extent().x;
 		m_extent.height = texCube.extent().y;
+		uint32_t mipLevels = (uint32_t)texCube.levels();
+
+		VECHECKRESULT(vh::vhBufCreateImage(	getRendererPointer()->getVmaAllocator(), m_extent.width, m_extent.height, mipLevels, 6,
+											m_format, VK_IMAGE_TILING_OPTIMAL,
+											VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+											VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT, &m_image, &m_deviceAllocation),
+					"Could not create texture cubemap for " + name);
+
+		getRendererPointer()->getUploadManager()->uploadImage(m_image, mipLevels, 6, texCube.data(), texCube.size(), regions);
 
 		VECHECKRESULT(vh::vhBufCreateImageView(getRendererPointer()->getDevice(), m_image,
 							m_format, VK_IMAGE_VIEW_TYPE_CUBE, 6, VK_IMAGE_ASPECT_COLOR_BIT, &m_imageView),
@@ -220,9 +255,10 @@ namespace ve {
 	}
 
 	/**
-	* \brief VETexture destructor - destroy the sampler, image view and image
+	* \brief VETexture destructor - remove it from the bindless table, destroy the sampler, image view and image
 	*/
 	VETexture::~VETexture() {
+		if (getRendererPointer()->getBindlessTable() != nullptr) getRendererPointer()->getBindlessTable()->removeTexture(this);
 		if (m_sampler != VK_NULL_HANDLE) vkDestroySampler(getRendererPointer()->getDevice(), m_sampler, nullptr);
 		if (m_imageView != VK_NULL_HANDLE) vkDestroyImageView(getRendererPointer()->getDevice(), m_imageView, nullptr);
 		if (m_image != VK_NULL_HANDLE) vmaDestroyImage(getRendererPointer()->getVmaAllocator(), m_image, m_deviceAllocation);
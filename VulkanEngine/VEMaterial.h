@@ -26,6 +26,7 @@ namespace ve {
 		VkSampler		m_sampler = VK_NULL_HANDLE;				///<image sampler
 		VkExtent2D		m_extent = { 0,0 };						///<map extent
 		VkFormat		m_format;								///<texture format
+		uint32_t		m_bindlessIndex = BINDLESS_INDEX_NONE;	///<index in the bindless texture array
 
 		VETexture(std::string name, gli::texture_cube &texCube, VkImageCreateFlags flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_CUBE);
 		VETexture(std::string name, std::string &basedir, std::vector<std::string> texNames, VkImageCreateFlags flags = 0, VkImageViewType viewtype = VK_IMAGE_VIEW_TYPE_2D);
@@ -51,6 +52,7 @@ namespace ve {
 		VETexture *mapNormal = nullptr;					///<Normal map
 		VETexture *mapHeight = nullptr;					///<Height map
 		glm::vec4 color = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);	///<General color of the entity
+		uint32_t m_bindlessIndex = BINDLESS_INDEX_NONE;			///<Index in the bindless material buffer
 
 																///Constructor
 		VEMaterial(std::string name) : VENamedClass(name), mapDiffuse(nullptr), mapBump(nullptr), mapNormal(nullptr), mapHeight(nullptr), color(glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)) {};
@@ -68,6 +70,9 @@ namespace ve {
 	*/
 
 	class VEMesh : public VENamedClass {
+	protected:
+		void createBuffers(std::vector<vh::vhVertex> &vertices, std::vector<uint32_t> &indices, std::string &name);
+
 	public:
 		uint32_t		m_vertexCount = 0;					///<Number of vertices in the vertex buffer
 		uint32_t		m_indexCount = 0;					///<Number of indices in the index buffer
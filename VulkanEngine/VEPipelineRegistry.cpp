@@ -0,0 +1,272 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	*
+	* \brief Mix a value into a hash, like boost::hash_combine
+	*
+	* \param[in,out] seed The hash so far
+	* \param[in] value The value to mix into the hash
+	*
+	*/
+	template<typename T> void hashCombine(size_t &seed, const T &value) {
+		seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+
+	/**
+	* \returns true if both keys describe the same PSO
+	*/
+	bool vePipelineKey_t::operator==(const vePipelineKey_t &other) const {
+		return	type == other.type && shaderFileNames == other.shaderFileNames &&
+				pipelineLayout == other.pipelineLayout && renderPass == other.renderPass &&
+				dynamicStates == other.dynamicStates &&
+				depthCompareOp == other.depthCompareOp && depthWriteEnable == other.depthWriteEnable &&
+				cullMode == other.cullMode && polygonMode == other.polygonMode &&
+				numColorAttachments == other.numColorAttachments &&
+				specializationConstants == other.specializationConstants;
+	}
+
+
+	/**
+	* \returns the hash of a PSO key
+	*/
+	size_t vePipelineKeyHash::operator()(const vePipelineKey_t &key) const {
+		size_t seed = 0;
+		hashCombine(seed, (uint32_t)key.type);
+		for (auto &name : key.shaderFileNames) hashCombine(seed, name);
+		hashCombine(seed, key.pipelineLayout);
+		hashCombine(seed, key.renderPass);
+		for (auto state : key.dynamicStates) hashCombine(seed, (uint32_t)state);
+		hashCombine(seed, (uint32_t)key.depthCompareOp);
+		hashCombine(seed, (uint32_t)key.depthWriteEnable);
+		hashCombine(seed, (uint32_t)key.cullMode);
+		hashCombine(seed, (uint32_t)key.polygonMode);
+		hashCombine(seed, key.numColorAttachments);
+		for (auto value : key.specializationConstants) hashCombine(seed, value);
+		return seed;
+	}
+
+
+	/**
+	* \returns true if both keys describe the same pipeline layout
+	*/
+	bool vePipelineLayoutKey_t::operator==(const vePipelineLayoutKey_t &other) const {
+		if (descriptorSetLayouts != other.descriptorSetLayouts) return false;
+		if (pushConstantRanges.size() != other.pushConstantRanges.size()) return false;
+		for (uint32_t i = 0; i < pushConstantRanges.size(); i++) {
+			if (pushConstantRanges[i].stageFlags != other.pushConstantRanges[i].stageFlags ||
+				pushConstantRanges[i].offset != other.pushConstantRanges[i].offset ||
+				pushConstantRanges[i].size != other.pushConstantRanges[i].size) return false;
+		}
+		return true;
+	}
+
+
+	/**
+	* \returns the hash of a pipeline layout key
+	*/
+	size_t vePipelineLayoutKeyHash::operator()(const vePipelineLayoutKey_t &key) const {
+		size_t seed = 0;
+		for (auto layout : key.descriptorSetLayouts) hashCombine(seed, layout);
+		for (auto &range : key.pushConstantRanges) {
+			hashCombine(seed, (uint32_t)range.stageFlags);
+			hashCombine(seed, range.offset);
+			hashCombine(seed, range.size);
+		}
+		return seed;
+	}
+
+
+	/**
+	*
+	* \brief Create a new PSO with the vh function that belongs to its type
+	*
+	* \param[in] key The state of the PSO
+	* \returns the new PSO
+	*
+	*/
+	VkPipeline VEPipelineRegistry::createPipeline(const vePipelineKey_t &key) {
+		VkDevice device = getRendererPointer()->getDevice();
+		VkPipelineCache pipelineCache = getRendererPointer()->getPipelineCache();
+		VkPipeline pipeline = VK_NULL_HANDLE;
+
+		switch (key.type) {
+		case VE_PIPELINE_TYPE_LIGHT_PASS:
+			VECHECKRESULT(vh::vhPipeCreateGraphicsPipeline(	device, pipelineCache, key.shaderFileNames, key.pipelineLayout, key.renderPass,
+															key.dynamicStates, key.depthCompareOp, key.depthWriteEnable,
+															key.cullMode, key.polygonMode, key.specializationConstants, &pipeline), "Failed to create light pass PSO!");
+			break;
+		case VE_PIPELINE_TYPE_SHADOW:
+			VECHECKRESULT(vh::vhPipeCreateGraphicsShadowPipeline(	device, pipelineCache, key.shaderFileNames[0], key.pipelineLayout,
+																	key.renderPass, key.dynamicStates, &pipeline), "Failed to create shadow PSO!");
+			break;
+		case VE_PIPELINE_TYPE_GBUFFER:
+			VECHECKRESULT(vh::vhPipeCreateGraphicsGBufferPipeline(	device, pipelineCache, key.shaderFileNames, key.pipelineLayout, key.renderPass,
+																	key.numColorAttachments, key.cullMode, key.polygonMode, &pipeline), "Failed to create G-buffer PSO!");
+			break;
+		case VE_PIPELINE_TYPE_DEFERRED_LIGHT:
+			VECHECKRESULT(vh::vhPipeCreateGraphicsLightPipeline(	device, pipelineCache, key.shaderFileNames, key.pipelineLayout,
+																	key.renderPass, &pipeline), "Failed to create deferred light PSO!");
+			break;
+		}
+		return pipeline;
+	}
+
+
+	/**
+	*
+	* \brief Get the PSO for a given state, create it if it does not exist yet
+	*
+	* The dynamic states of the key are sorted and completed with viewport and scissor, so equal states
+	* always give equal keys. If another thread is creating the same PSO, this waits until it is done.
+	* Each call must be matched by a call to releasePipeline().
+	*
+	* \param[in] key The state of the PSO
+	* \returns the PSO
+	*
+	*/
+	VkPipeline VEPipelineRegistry::acquirePipeline(vePipelineKey_t key) {
+		key.dynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+		key.dynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR);
+		std::sort(key.dynamicStates.begin(), key.dynamicStates.end());
+		key.dynamicStates.erase(std::unique(key.dynamicStates.begin(), key.dynamicStates.end()), key.dynamicStates.end());
+
+		std::promise<VkPipeline> promise;
+		std::shared_future<VkPipeline> existing;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_pipelines.find(key);
+			if (it != m_pipelines.end()) {
+				it->second.refCount++;
+				existing = it->second.pipeline;
+			}
+			else {
+				m_pipelines[key] = { promise.get_future().share(), 1 };
+			}
+		}
+		if (existing.valid()) return existing.get();		//created before or by another thread
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		try {
+			pipeline = createPipeline(key);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pipelines.erase(key);
+			promise.set_exception(std::current_exception());
+			throw;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pipelineKeys[pipeline] = key;
+		}
+		promise.set_value(pipeline);
+		return pipeline;
+	}
+
+
+	/**
+	*
+	* \brief Release a PSO that was returned by acquirePipeline()
+	*
+	* The PSO is destroyed when the last user has released it.
+	*
+	* \param[in] pipeline The PSO, VK_NULL_HANDLE is ignored
+	*
+	*/
+	void VEPipelineRegistry::releasePipeline(VkPipeline pipeline) {
+		if (pipeline == VK_NULL_HANDLE) return;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto itKey = m_pipelineKeys.find(pipeline);
+		if (itKey == m_pipelineKeys.end()) return;
+
+		auto it = m_pipelines.find(itKey->second);
+		if (--it->second.refCount > 0) return;
+
+		vkDestroyPipeline(getRendererPointer()->getDevice(), pipeline, nullptr);
+		m_pipelines.erase(it);
+		m_pipelineKeys.erase(itKey);
+	}
+
+
+	/**
+	*
+	* \brief Get the pipeline layout for a list of descriptor set layouts, create it if it does not exist yet
+	*
+	* Each call must be matched by a call to releasePipelineLayout().
+	*
+	* \param[in] descriptorSetLayouts The descriptor set layouts of sets 0, 1, ...
+	* \param[in] pushConstantRanges Push constant ranges of the layout, empty if the PSOs use no push constants
+	* \returns the pipeline layout
+	*
+	*/
+	VkPipelineLayout VEPipelineRegistry::acquirePipelineLayout(	std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+																std::vector<VkPushConstantRange> pushConstantRanges) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		vePipelineLayoutKey_t key = { descriptorSetLayouts, pushConstantRanges };
+		auto it = m_pipelineLayouts.find(key);
+		if (it != m_pipelineLayouts.end()) {
+			it->second.refCount++;
+			return it->second.pipelineLayout;
+		}
+
+		VkPipelineLayout pipelineLayout;
+		VECHECKRESULT(vh::vhPipeCreateGraphicsPipelineLayout(	getRendererPointer()->getDevice(), descriptorSetLayouts, pushConstantRanges,
+																&pipelineLayout), "Failed to create pipeline layout!");
+		m_pipelineLayouts[key] = { pipelineLayout, 1 };
+		return pipelineLayout;
+	}
+
+
+	/**
+	*
+	* \brief Release a pipeline layout that was returned by acquirePipelineLayout()
+	*
+	* The layout is destroyed when the last user has released it. There are only a few layouts, so they are searched linearly.
+	*
+	* \param[in] pipelineLayout The pipeline layout, VK_NULL_HANDLE is ignored
+	*
+	*/
+	void VEPipelineRegistry::releasePipelineLayout(VkPipelineLayout pipelineLayout) {
+		if (pipelineLayout == VK_NULL_HANDLE) return;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto it = m_pipelineLayouts.begin(); it != m_pipelineLayouts.end(); ++it) {
+			if (it->second.pipelineLayout != pipelineLayout) continue;
+			if (--it->second.refCount > 0) return;
+
+			vkDestroyPipelineLayout(getRendererPointer()->getDevice(), pipelineLayout, nullptr);
+			m_pipelineLayouts.erase(it);
+			return;
+		}
+	}
+
+
+	/**
+	* \brief Destroy all PSOs and pipeline layouts that have not been released
+	*/
+	void VEPipelineRegistry::clear() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto &entry : m_pipelineKeys) vkDestroyPipeline(getRendererPointer()->getDevice(), entry.first, nullptr);
+		for (auto &entry : m_pipelineLayouts) vkDestroyPipelineLayout(getRendererPointer()->getDevice(), entry.second.pipelineLayout, nullptr);
+		m_pipelines.clear();
+		m_pipelineKeys.clear();
+		m_pipelineLayouts.clear();
+	}
+
+}
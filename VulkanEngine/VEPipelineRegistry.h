@@ -0,0 +1,114 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+namespace ve {
+
+	/**
+	* \brief enums the vh functions that can create a PSO
+	*/
+	enum vePipelineType {
+		VE_PIPELINE_TYPE_LIGHT_PASS,			///<Forward light pass, vhPipeCreateGraphicsPipeline
+		VE_PIPELINE_TYPE_SHADOW,				///<Depth only shadow or depth pre-pass, vhPipeCreateGraphicsShadowPipeline
+		VE_PIPELINE_TYPE_GBUFFER,				///<Deferred geometry pass, vhPipeCreateGraphicsGBufferPipeline
+		VE_PIPELINE_TYPE_DEFERRED_LIGHT			///<Deferred screen space light pass, vhPipeCreateGraphicsLightPipeline
+	};
+
+	/**
+	*
+	* \brief Describes all state of a PSO
+	*
+	* Two PSOs with equal keys are identical, so they are created only once. All PSOs use the vertex layout of vh::vhVertex.
+	* The render pass stands for all render passes that are compatible with it. Members that the creating
+	* function of a type does not use should be left at their defaults.
+	*
+	*/
+	struct vePipelineKey_t {
+		vePipelineType				type = VE_PIPELINE_TYPE_LIGHT_PASS;				///<The vh function that creates the PSO
+		std::vector<std::string>	shaderFileNames;								///<Shader files, shadow PSOs only have a vertex shader
+		VkPipelineLayout			pipelineLayout = VK_NULL_HANDLE;				///<Pipeline layout
+		VkRenderPass				renderPass = VK_NULL_HANDLE;					///<A render pass the PSO is compatible with
+		std::vector<VkDynamicState>	dynamicStates;									///<Dynamic states, viewport and scissor are always added
+		VkCompareOp					depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;	///<Depth test of light passes, VK_COMPARE_OP_EQUAL after a depth pre-pass
+		VkBool32					depthWriteEnable = VK_TRUE;						///<Light passes write depth values
+		VkCullModeFlags				cullMode = VK_CULL_MODE_BACK_BIT;				///<VK_CULL_MODE_NONE for two-sided geometry
+		VkPolygonMode				polygonMode = VK_POLYGON_MODE_FILL;				///<VK_POLYGON_MODE_LINE for wireframes
+		uint32_t					numColorAttachments = 1;						///<Number of G-buffer maps
+		std::vector<uint32_t>		specializationConstants;						///<Value i is the specialization constant with constant_id i, light passes only
+
+		bool operator==(const vePipelineKey_t &other) const;
+	};
+
+	///Hash function of a PSO key, for looking up PSOs in O(1)
+	struct vePipelineKeyHash {
+		size_t operator()(const vePipelineKey_t &key) const;
+	};
+
+	///Describes a pipeline layout
+	struct vePipelineLayoutKey_t {
+		std::vector<VkDescriptorSetLayout>	descriptorSetLayouts;		///<The descriptor set layouts of sets 0, 1, ...
+		std::vector<VkPushConstantRange>	pushConstantRanges;			///<Push constant ranges, empty if the PSOs use no push constants
+
+		bool operator==(const vePipelineLayoutKey_t &other) const;
+	};
+
+	///Hash function of a pipeline layout key
+	struct vePipelineLayoutKeyHash {
+		size_t operator()(const vePipelineLayoutKey_t &key) const;
+	};
+
+
+	/**
+	*
+	* \brief Central registry of all PSOs and pipeline layouts of the subrenderers
+	*
+	* Subrenderers request PSOs by describing their state with a vePipelineKey_t. Each PSO is created only once and
+	* is shared by all subrenderers requesting the same key, it is destroyed when the last of them releases it. Pipeline
+	* layouts are shared the same way. The functions may be called from jobs of the thread pool at the same time. A PSO
+	* is compiled outside the lock, other threads requesting the same key wait for it.
+	*
+	*/
+	class VEPipelineRegistry {
+
+	protected:
+		///A shared PSO
+		struct vePipelineEntry_t {
+			std::shared_future<VkPipeline>	pipeline;		///<The PSO, ready when the creating thread is done
+			uint32_t						refCount;		///<Number of subrenderers using the PSO
+		};
+
+		///A shared pipeline layout
+		struct vePipelineLayoutEntry_t {
+			VkPipelineLayout	pipelineLayout;				///<The pipeline layout
+			uint32_t			refCount;					///<Number of subrenderers using the layout
+		};
+
+		std::unordered_map<vePipelineKey_t, vePipelineEntry_t, vePipelineKeyHash> m_pipelines;	///<All PSOs by their state
+		std::unordered_map<VkPipeline, vePipelineKey_t>	m_pipelineKeys;							///<The key of each created PSO, for releasing it
+		std::unordered_map<vePipelineLayoutKey_t, vePipelineLayoutEntry_t, vePipelineLayoutKeyHash> m_pipelineLayouts;	///<All layouts by their set layouts and push constants
+		std::mutex										m_mutex;									///<Guards the maps
+
+		VkPipeline createPipeline(const vePipelineKey_t &key);	//create a new PSO with the vh function of its type
+
+	public:
+		///Constructor of class VEPipelineRegistry
+		VEPipelineRegistry() {};
+		///Destructor of class VEPipelineRegistry
+		virtual ~VEPipelineRegistry() {};
+
+		VkPipeline			acquirePipeline(vePipelineKey_t key);
+		void				releasePipeline(VkPipeline pipeline);
+		VkPipelineLayout	acquirePipelineLayout(	std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+													std::vector<VkPushConstantRange> pushConstantRanges = {});
+		void				releasePipelineLayout(VkPipelineLayout pipelineLayout);
+		void				clear();
+		///\returns the number of different PSOs that currently exist
+		uint32_t			getNumberPipelines() { std::lock_guard<std::mutex> lock(m_mutex); return (uint32_t)m_pipelines.size(); };
+	};
+
+}
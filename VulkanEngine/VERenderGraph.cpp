@@ -0,0 +1,225 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	* \brief Remove all passes and images, so the graph can be declared again
+	*/
+	void VERenderGraph::reset() {
+		m_images.clear();
+		m_order.clear();
+		m_numPasses = 0;
+	}
+
+
+	/**
+	*
+	* \brief Add an image to the graph
+	*
+	* \param[in] image The image, it must be registered with the layout tracker
+	* \param[in] output If true, the content is used after the graph, e.g. a swapchain image
+	* \returns the index of the image in the graph, adding the same image again returns the same index
+	*
+	*/
+	uint32_t VERenderGraph::addImage(VkImage image, bool output) {
+		for (uint32_t i = 0; i < m_images.size(); i++) {
+			if (m_images[i].image == image) {
+				m_images[i].output = m_images[i].output || output;
+				return i;
+			}
+		}
+		m_images.push_back({ image, output });
+		return (uint32_t)m_images.size() - 1;
+	}
+
+
+	/**
+	*
+	* \brief Add a pass to the graph
+	*
+	* \param[in] name Name of the pass, must stay valid until the graph is reset
+	* \param[in] record Function recording the commands of the pass into the given command buffer
+	* \param[in] context Pointer that is passed to the function, must stay valid until the graph is executed
+	* \returns the index of the pass
+	*
+	*/
+	uint32_t VERenderGraph::addPass(const char *name, void (*record)(void *context, VkCommandBuffer commandBuffer), void *context) {
+		if (m_numPasses == m_passes.size()) m_passes.push_back({});
+
+		vePass_t &pass = m_passes[m_numPasses];
+		pass.name = name;
+		pass.record = record;
+		pass.context = context;
+		pass.uses.clear();
+		pass.level = 0;
+		pass.culled = false;
+		return m_numPasses++;
+	}
+
+
+	/**
+	*
+	* \brief Declare that a pass reads an image
+	*
+	* \param[in] pass Index of the pass
+	* \param[in] image Index of the image
+	* \param[in] layout Layout the pass reads the image in
+	* \param[in] access Access of the pass, e.g. VK_ACCESS_SHADER_READ_BIT
+	* \param[in] stage Pipeline stages of the access
+	*
+	*/
+	void VERenderGraph::read(uint32_t pass, uint32_t image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage) {
+		m_passes[pass].uses.push_back({ image, layout, layout, access, stage, false });
+	}
+
+
+	/**
+	*
+	* \brief Declare that a pass writes an image
+	*
+	* \param[in] pass Index of the pass
+	* \param[in] image Index of the image
+	* \param[in] layout Layout the pass needs, VK_IMAGE_LAYOUT_UNDEFINED if the content is discarded, e.g. cleared
+	* \param[in] finalLayout Layout the pass leaves the image in, e.g. the final layout of its render pass
+	* \param[in] access Access of the pass, e.g. VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+	* \param[in] stage Pipeline stages of the access
+	*
+	*/
+	void VERenderGraph::write(	uint32_t pass, uint32_t image, VkImageLayout layout, VkImageLayout finalLayout,
+								VkAccessFlags access, VkPipelineStageFlags stage) {
+		m_passes[pass].uses.push_back({ image, layout, finalLayout, access, stage, true });
+	}
+
+
+	/**
+	*
+	* \brief Cull the passes that are not needed, and order the others
+	*
+	* Going backwards, an image is needed if it is an output, or if a later pass reads its content. A pass writing
+	* only images that are not needed is culled. Then each pass gets the lowest level that is higher than the levels
+	* of the passes it depends on: a reader depends on the last writer, a writer on the last writer and all readers
+	* since. Reading an image in another layout counts as writing, since the layout transition changes it.
+	*
+	*/
+	void VERenderGraph::compile() {
+		m_order.clear();
+
+		//cull passes, going backwards from the outputs
+		veFrameVector<uint8_t> needed;
+		for (auto &image : m_images) needed.push_back(image.output ? 1 : 0);
+
+		for (uint32_t p = m_numPasses; p-- > 0; ) {
+			vePass_t &pass = m_passes[p];
+
+			bool writes = false, live = false;
+			for (auto &use : pass.uses) {
+				if (!use.write) continue;
+				writes = true;
+				if (needed[use.image]) live = true;
+			}
+			pass.culled = writes && !live;
+			if (pass.culled) continue;
+
+			for (auto &use : pass.uses) {
+				if (use.write && use.layout == VK_IMAGE_LAYOUT_UNDEFINED) needed[use.image] = 0;	//earlier content is discarded
+			}
+			for (auto &use : pass.uses) {
+				if (!use.write || use.layout != VK_IMAGE_LAYOUT_UNDEFINED) needed[use.image] = 1;	//earlier content is used
+			}
+		}
+
+		//give each pass the lowest level after all passes it depends on
+		veFrameVector<uint32_t> writeLevel(m_images.size(), 0);		//passes using the image must have at least this level
+		veFrameVector<uint32_t> readLevel(m_images.size(), 0);		//passes writing the image must have at least this level
+		veFrameVector<VkImageLayout> layouts;						//layout of the image after the passes so far
+		for (auto &image : m_images) layouts.push_back(m_pTracker->getLayout(image.image));
+
+		uint32_t minLevel = 0;		//raised by passes without images
+		uint32_t maxLevel = 0;
+		for (uint32_t p = 0; p < m_numPasses; p++) {
+			vePass_t &pass = m_passes[p];
+			if (pass.culled) continue;
+
+			uint32_t level = minLevel;
+			if (pass.uses.empty()) {
+				level = m_order.empty() ? minLevel : std::max(minLevel, maxLevel + 1);
+				minLevel = level + 1;
+			}
+			for (auto &use : pass.uses) {
+				bool changes = use.write || (use.layout != VK_IMAGE_LAYOUT_UNDEFINED && use.layout != layouts[use.image]);
+				level = std::max(level, writeLevel[use.image]);
+				if (changes) level = std::max(level, readLevel[use.image]);
+			}
+
+			for (auto &use : pass.uses) {
+				bool changes = use.write || (use.layout != VK_IMAGE_LAYOUT_UNDEFINED && use.layout != layouts[use.image]);
+				if (changes) {
+					writeLevel[use.image] = level + 1;
+					readLevel[use.image] = level + 1;
+					layouts[use.image] = use.finalLayout;
+				}
+				else {
+					readLevel[use.image] = std::max(readLevel[use.image], level + 1);
+				}
+			}
+
+			pass.level = level;
+			maxLevel = std::max(maxLevel, level);
+			m_order.push_back(p);
+		}
+
+		std::stable_sort(m_order.begin(), m_order.end(),
+			[this](uint32_t a, uint32_t b) { return m_passes[a].level < m_passes[b].level; });
+	}
+
+
+	/**
+	*
+	* \brief Record the passes that have not been culled into a command buffer
+	*
+	* The barriers of all passes of a level are recorded in one batch before the first pass of the level.
+	* Afterwards, the layout tracker knows the layouts the passes leave their images in.
+	*
+	* \param[in] commandBuffer The command buffer, it must not be inside a render pass
+	*
+	*/
+	void VERenderGraph::execute(VkCommandBuffer commandBuffer) {
+		uint32_t first = 0;
+		while (first < m_order.size()) {
+			uint32_t level = m_passes[m_order[first]].level;
+			uint32_t last = first;
+			while (last < m_order.size() && m_passes[m_order[last]].level == level) last++;
+
+			for (uint32_t k = first; k < last; k++) {
+				for (auto &use : m_passes[m_order[k]].uses) {
+					VkImage image = m_images[use.image].image;
+
+					//a pass discarding the content takes the image in any layout, but must wait for earlier accesses
+					VkImageLayout layout = use.layout != VK_IMAGE_LAYOUT_UNDEFINED ? use.layout : m_pTracker->getLayout(image);
+					if (layout != VK_IMAGE_LAYOUT_UNDEFINED) m_pTracker->transition(image, layout, use.access, use.stage);
+				}
+			}
+			m_pTracker->flush(commandBuffer);
+
+			for (uint32_t k = first; k < last; k++) {
+				vePass_t &pass = m_passes[m_order[k]];
+				pass.record(pass.context, commandBuffer);
+
+				for (auto &use : pass.uses) {
+					if (use.write) m_pTracker->setState(m_images[use.image].image, use.finalLayout, use.access, use.stage);
+				}
+			}
+			first = last;
+		}
+	}
+
+}
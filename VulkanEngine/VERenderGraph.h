@@ -0,0 +1,107 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+namespace ve {
+
+	/**
+	*
+	* \brief Schedules the passes of a frame and derives the barriers between them
+	*
+	* Each pass declares the images it reads and writes, together with the layout it needs, the layout it leaves the
+	* image in, and the access and pipeline stages it uses. A write with layout VK_IMAGE_LAYOUT_UNDEFINED discards
+	* the content, e.g. a render pass clearing its attachment. The pass itself is a callback recording its commands,
+	* a function pointer with a context pointer. Lambdas are copied into the frame arena, so they do not touch the heap.
+	*
+	* compile() then
+	* - culls passes whose writes are never read before they are discarded, unless they write an output image
+	* - puts the remaining passes into levels, a pass only depends on passes of lower levels, and orders them by level
+	*
+	* execute() records the passes level by level. Before each level, the barriers of all its passes are collected by
+	* the layout tracker and recorded in one batch, so the passes of a level can overlap on the GPU. The images must be
+	* registered with the layout tracker, which also remembers their layouts between frames.
+	*
+	* A pass without images is a full barrier, all earlier passes come before it, all later passes after it.
+	* The graph is declared again whenever the command buffer is recorded, its vectors keep their memory.
+	*
+	*/
+	class VERenderGraph {
+
+	protected:
+		///How a pass uses an image
+		struct veImageUse_t {
+			uint32_t				image;			///<Index of the image in the graph
+			VkImageLayout			layout;			///<Layout the pass needs, VK_IMAGE_LAYOUT_UNDEFINED if it discards the content
+			VkImageLayout			finalLayout;	///<Layout the pass leaves the image in
+			VkAccessFlags			access;			///<Access of the pass to the image
+			VkPipelineStageFlags	stage;			///<Pipeline stages of the access
+			bool					write;			///<The pass changes the image
+		};
+
+		///A pass of the graph
+		struct vePass_t {
+			const char *						name;		///<Name of the pass, for debugging
+			void (*record)(void *, VkCommandBuffer);		///<Records the commands of the pass
+			void *								context;	///<Passed to record
+			std::vector<veImageUse_t>			uses;		///<Images the pass reads or writes
+			uint32_t							level;		///<The pass only depends on passes of lower levels
+			bool								culled;		///<The pass is not recorded
+		};
+
+		///An image used by the passes
+		struct veImage_t {
+			VkImage		image;		///<The Vulkan image
+			bool		output;		///<The content is used after the graph, so its writers are never culled
+		};
+
+		VELayoutTracker *		m_pTracker;		///<Knows the layouts of the images and batches the barriers
+		std::vector<veImage_t>	m_images;		///<All images of the graph
+		std::vector<vePass_t>	m_passes;		///<All passes in the order they were added
+		std::vector<uint32_t>	m_order;		///<Indices of the passes that are not culled, ordered by level
+		uint32_t				m_numPasses = 0;	///<Number of passes in use, m_passes may hold more from earlier frames
+
+	public:
+		///Constructor of class VERenderGraph
+		VERenderGraph(VELayoutTracker *pTracker) : m_pTracker(pTracker) {};
+		///Destructor of class VERenderGraph
+		virtual ~VERenderGraph() {};
+
+		void		reset();
+		uint32_t	addImage(VkImage image, bool output = false);
+		uint32_t	addPass(const char *name, void (*record)(void *context, VkCommandBuffer commandBuffer), void *context);
+
+		/**
+		*
+		* \brief Add a pass recorded by a lambda
+		*
+		* The lambda is copied into the frame arena of the calling thread and never destroyed, so it must be
+		* trivially destructible, i.e. capture only pointers, references and plain values.
+		*
+		* \param[in] name Name of the pass, must stay valid until the graph is reset
+		* \param[in] record Lambda recording the commands of the pass into the given command buffer
+		* \returns the index of the pass
+		*
+		*/
+		template<typename F> uint32_t addPass(const char *name, const F &record) {
+			static_assert(std::is_trivially_destructible<F>::value, "the lambda of a pass is never destroyed");
+			void *context = new (VEFrameArena::get().allocate(sizeof(F), alignof(F))) F(record);
+			return addPass(name, [](void *context, VkCommandBuffer commandBuffer) { (*(F*)context)(commandBuffer); }, context);
+		};
+		void		read(uint32_t pass, uint32_t image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage);
+		void		write(	uint32_t pass, uint32_t image, VkImageLayout layout, VkImageLayout finalLayout,
+							VkAccessFlags access, VkPipelineStageFlags stage);
+		void		compile();
+		void		execute(VkCommandBuffer commandBuffer);
+
+		///\returns the number of passes that are recorded by execute()
+		uint32_t	getNumberPasses() { return (uint32_t)m_order.size(); };
+		///\returns the number of passes that have been culled
+		uint32_t	getNumberCulledPasses() { return m_numPasses - (uint32_t)m_order.size(); };
+	};
+
+}
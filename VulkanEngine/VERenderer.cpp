@@ -25,11 +25,15 @@ namespace ve {
 	*
 	* \brief Initialize and register a subrenderer
 	*
+	* Only the layouts are created here. The PSOs of subrenderers that are always needed are built concurrently by the
+	* thread pool, all others are built when the first entity is added to them.
+	*
 	* \param[in] pSub Pointer to the subrenderer to be initialized and registered
 	*
 	*/
 	void VERenderer::addSubrenderer(VESubrender *pSub) {
 		pSub->initSubrenderer();
+		if (pSub->pipelinesNeededAtStartup()) pSub->requestPipelines();
 		if (pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_SHADOW) {
 			m_subrenderShadow = pSub;
 			return;
@@ -72,6 +76,9 @@ namespace ve {
 			m_subrenderOverlay->closeSubrenderer();
 			delete m_subrenderOverlay;
 		}
+		m_subrenderers.clear();
+		m_subrenderShadow = nullptr;
+		m_subrenderOverlay = nullptr;
 	}
 
 	/**
@@ -116,8 +123,11 @@ namespace ve {
 		default: return;
 		}
 
+		if (pEntity->getStaticShadow()) invalidateShadowCache();
+
 		for (uint32_t i = 0; i < m_subrenderers.size(); i++) {
 			if (m_subrenderers[i]->getType() == type) {
+				m_subrenderers[i]->requestPipelines();		//the first entity starts building the PSOs
 				m_subrenderers[i]->addEntity(pEntity);
 				return;
 			}
@@ -139,6 +149,30 @@ namespace ve {
 		if (pEntity->m_pSubrenderer != nullptr) {
 			pEntity->m_pSubrenderer->removeEntity(pEntity);
 		}
+		if (pEntity->getStaticShadow()) invalidateShadowCache();
+	}
+
+
+	/**
+	*
+	* \brief Tell the renderer that the draw list of a subrenderer has changed
+	*
+	* Only the command buffers of the given subrenderer and of the shadow subrenderer are recorded again,
+	* since the set of shadow casters might have changed as well. Changes that affect all passes,
+	* like switching lights on or off, should pass nullptr.
+	*
+	* \param[in] pSub Pointer to the subrenderer whose entities changed, or nullptr to invalidate all subrenderers
+	*
+	*/
+	void VERenderer::invalidateCmdBuffers(VESubrender *pSub) {
+		if (pSub != nullptr) {
+			pSub->invalidateCmdBuffers();
+			if (m_subrenderShadow != nullptr && pSub != m_subrenderShadow) m_subrenderShadow->invalidateCmdBuffers();
+			return;
+		}
+
+		for (auto pS : m_subrenderers) pS->invalidateCmdBuffers();
+		if (m_subrenderShadow != nullptr) m_subrenderShadow->invalidateCmdBuffers();
 	}
 }
 
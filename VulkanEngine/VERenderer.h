@@ -7,6 +7,8 @@
 
 #pragma once
 
+const uint32_t MAX_FRAMES_IN_FLIGHT = 3;							///<Upper limit for the number of frames in flight
+
 #ifndef getRendererPointer
 #define getRendererPointer() g_pVERendererSingleton
 #endif
@@ -35,8 +37,16 @@ namespace ve {
 		VkDevice m_device;										///<Vulkan logical device handle
 		VkQueue m_graphicsQueue;								///<Vulkan graphics queue
 		VkQueue m_presentQueue;									///<Vulkan present queue
+		VkQueue m_transferQueue = VK_NULL_HANDLE;				///<Vulkan queue of a family without graphics, VK_NULL_HANDLE if there is none
 		VmaAllocator m_vmaAllocator;							///<VMA allocator
 		VkCommandPool m_commandPool;							///<Command pool of this thread
+		VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;		///<Pipeline cache used for creating all PSOs, kept on disk between runs
+		VEPipelineRegistry *m_pipelineRegistry = nullptr;		///<Shares the PSOs and pipeline layouts of all subrenderers
+		VEBindlessTable *m_bindlessTable = nullptr;				///<All textures and materials, nullptr if the device has no descriptor indexing
+		VEDescriptorAllocator *m_descriptorAllocator = nullptr;	///<Hands out all descriptor sets except the bindless one
+		VETimeline *m_timeline = nullptr;						///<Gives each submission to the graphics queue a value that the CPU can wait for
+		VELayoutTracker *m_layoutTracker = nullptr;				///<Knows the layouts of the swapchain images and batches their transitions
+		VEUploadManager *m_uploadManager = nullptr;				///<Copies mesh and texture data to the device in batches
 
 		//surface
 		VkSurfaceKHR m_surface;									///<Vulkan KHR surface
@@ -50,6 +60,8 @@ namespace ve {
 		VkExtent2D m_swapChainExtent;							///<Image extent of the swap chain images
 		std::vector<VkImageView> m_swapChainImageViews;			///<Image views of the swap chain images
 		uint32_t imageIndex = 0;								///<Index of the current swapchain image
+		uint32_t m_framesInFlight = 2;							///<Number of frames the CPU may prepare while the GPU still draws older ones
+		uint32_t m_frameIndex = 0;								///<Index of the current frame in flight, selects the per frame resources
 
 		//subrenderers
 		std::vector<VESubrender*> m_subrenderers;				///<Subrenderers for lit objects
@@ -65,6 +77,8 @@ namespace ve {
 		virtual void addSubrenderer( VESubrender *pSub);
 		virtual VESubrender * getSubrenderer( VESubrender::veSubrenderType );
 		virtual void destroySubrenderers();
+		///Wait until the resources of the next frame in flight are free - does nothing for the base class
+		virtual void beginFrame() {};
 		///Draw one frame
 		virtual void drawFrame() {};
 		///Draw the overlay (GUI)
@@ -93,6 +107,20 @@ namespace ve {
 		virtual VkQueue					getGraphicsQueue() { return m_graphicsQueue; };
 		///\returns the thread command pool
 		virtual VkCommandPool			getCommandPool() { return m_commandPool;  };
+		///\returns the pipeline cache for creating PSOs
+		virtual VkPipelineCache			getPipelineCache() { return m_pipelineCache; };
+		///\returns the registry of all PSOs
+		virtual VEPipelineRegistry *	getPipelineRegistry() { return m_pipelineRegistry; };
+		///\returns the table of all textures and materials, or nullptr
+		virtual VEBindlessTable *		getBindlessTable() { return m_bindlessTable; };
+		///\returns the allocator of all descriptor sets
+		virtual VEDescriptorAllocator *	getDescriptorAllocator() { return m_descriptorAllocator; };
+		///\returns the timeline tracking all submissions to the graphics queue
+		virtual VETimeline *			getTimeline() { return m_timeline; };
+		///\returns the tracker of the image layouts
+		virtual VELayoutTracker *		getLayoutTracker() { return m_layoutTracker; };
+		///\returns the manager of all mesh and texture uploads
+		virtual VEUploadManager *		getUploadManager() { return m_uploadManager; };
 		///\returns the swap chain image format
 		virtual VkFormat				getSwapChainImageFormat() { return m_swapChainImageFormat; };
 		///\returns the swap chain image extent
@@ -101,12 +129,27 @@ namespace ve {
 		virtual uint32_t				getSwapChainNumber() { return (uint32_t)m_swapChainImages.size();  };
 		///\returns the index of the swap chain image that is current prepared for drawing
 		virtual uint32_t				getImageIndex() { return imageIndex;  };
+		///\returns the number of frames in flight, each has its own UBOs, descriptor sets and command buffers
+		virtual uint32_t				getFramesInFlight() { return m_framesInFlight; };
+		///\returns the index of the frame in flight that is currently prepared, selects the per frame resources
+		virtual uint32_t				getFrameIndex() { return m_frameIndex; };
 		///\returns the current swap chain image
 		virtual VkImage					getSwapChainImage() { return m_swapChainImages[imageIndex]; };
 		///\returns the overlay (GUI) subrenderer
 		virtual VESubrender *			getOverlay() { return m_subrenderOverlay; };
+		///\returns true if all lights are rendered in a single clustered light pass
+		virtual bool					getClusteredLighting() { return false; };
+		///\returns true if the depth map is filled by a depth pre-pass before the light passes
+		virtual bool					getDepthPrepass() { return false; };
+		///\returns true if point light shadows are drawn into a cube shadow map in a single multiview pass
+		virtual bool					getCubeShadows() { return false; };
 		virtual void					addEntityToSubrenderer(VEEntity *pEntity);
 		virtual void					removeEntityFromSubrenderers(VEEntity *pEntity);
+		virtual void					invalidateCmdBuffers(VESubrender *pSub = nullptr);
+		///Tell the renderer that a static shadow caster has changed - does nothing for the base class
+		virtual void					invalidateShadowCache() {};
+		///\returns true if a light pass draws an entity - the base class draws all entities in all passes
+		virtual bool					passLightsEntity(uint32_t numPass, VEEntity *pEntity) { return true; };
 	};
 
 }
@@ -0,0 +1,480 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	VERendererDeferred * g_pVERendererDeferredSingleton = nullptr;	///<Singleton pointer to the only VERendererDeferred instance
+
+	//albedo, normal, material parameters (x...specular strength), world position (w...1 if there is geometry)
+	const std::vector<VkFormat> GBUFFER_FORMATS = {	VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT,
+													VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R32G32B32A32_SFLOAT };
+
+	VERendererDeferred::VERendererDeferred() : VERendererForward() {
+		g_pVERendererDeferredSingleton = this;
+	}
+
+
+	/**
+	*
+	* \brief Create all resources that depend on the swapchain
+	*
+	* Additionally to the forward resources, create the G-buffer maps and their framebuffer.
+	*
+	*/
+	void VERendererDeferred::createSwapchainResources() {
+		VERendererForward::createSwapchainResources();
+
+		std::vector<VkImageView> attachments;
+		for (uint32_t i = 0; i < NUM_GBUFFER_MAPS; i++) {
+			VETexture *pMap = new VETexture("GBufferMap");
+			pMap->m_format = GBUFFER_FORMATS[i];
+			pMap->m_extent = m_swapChainExtent;
+
+			VECHECKRESULT(vh::vhBufCreateImage(	m_vmaAllocator, m_swapChainExtent.width, m_swapChainExtent.height, 1, 1,
+												pMap->m_format, VK_IMAGE_TILING_OPTIMAL,
+												VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 0,
+												&pMap->m_image, &pMap->m_deviceAllocation), "Failed to create G-buffer map!");
+
+			VECHECKRESULT(vh::vhBufCreateImageView(	m_device, pMap->m_image, pMap->m_format, VK_IMAGE_VIEW_TYPE_2D, 1,
+													VK_IMAGE_ASPECT_COLOR_BIT, &pMap->m_imageView), "Failed to create G-buffer map view!");
+
+			VECHECKRESULT(vh::vhBufCreateTextureSampler(m_device, VK_FILTER_NEAREST, &pMap->m_sampler), "Failed to create G-buffer sampler!");
+
+			m_layoutTracker->setState(pMap->m_image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0);
+
+			m_gBufferMaps.push_back(pMap);
+			attachments.push_back(pMap->m_imageView);
+		}
+		attachments.push_back(m_depthMap->m_imageView);
+
+		VECHECKRESULT(vh::vhBufCreateFramebuffer(m_device, attachments, m_renderPassGeometry, m_swapChainExtent, &m_gBufferFramebuffer), "Failed to create G-buffer framebuffer!");
+
+		if (m_descriptorSetsGBuffer.size() > 0) updateDescriptorSetsGBuffer();
+	}
+
+
+	/**
+	* \brief Create the forward render passes and the geometry render pass writing the G-buffer
+	*/
+	void VERendererDeferred::createRenderPasses() {
+		VERendererForward::createRenderPasses();
+
+		VECHECKRESULT(vh::vhRenderCreateRenderPassGBuffer(	m_device, GBUFFER_FORMATS, vh::vhDevFindDepthFormat(m_physicalDevice),
+															&m_renderPassGeometry), "Failed to create geometry render pass!");
+	}
+
+
+	/**
+	* \brief Destroy the geometry render pass and the forward render passes
+	*/
+	void VERendererDeferred::destroyRenderPasses() {
+		vkDestroyRenderPass(m_device, m_renderPassGeometry, nullptr);
+
+		VERendererForward::destroyRenderPasses();
+	}
+
+
+	/**
+	* \brief Write the current G-buffer maps into the G-buffer descriptor sets of all frames in flight
+	*/
+	void VERendererDeferred::updateDescriptorSetsGBuffer() {
+		std::vector<VkBuffer> buffers;
+		std::vector<uint32_t> ranges;
+		std::vector<std::vector<VkImageView>> imageViews;
+		std::vector<std::vector<VkSampler>> samplers;
+
+		for (auto pMap : m_gBufferMaps) {
+			buffers.push_back(VK_NULL_HANDLE);
+			ranges.push_back(0);
+			imageViews.push_back({ pMap->m_imageView });
+			samplers.push_back({ pMap->m_sampler });
+		}
+
+		for (uint32_t i = 0; i < m_descriptorSetsGBuffer.size(); i++) {
+			vh::vhRenderUpdateDescriptorSet(m_device, m_descriptorSetsGBuffer[i], buffers, ranges, imageViews, samplers);
+		}
+	}
+
+
+	/**
+	*
+	* \brief Create and register all known subrenderers for this VERenderer
+	*
+	* Textured objects are drawn into the G-buffer, all other subrenderers are the forward ones.
+	* Since the light subrenderer needs the G-buffer descriptor set layout, it is created here.
+	*
+	*/
+	void VERendererDeferred::createSubrenderers() {
+		std::vector<uint32_t> counts(NUM_GBUFFER_MAPS, 1);
+		std::vector<VkDescriptorType> types(NUM_GBUFFER_MAPS, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		std::vector<VkShaderStageFlags> stages(NUM_GBUFFER_MAPS, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+		vh::vhRenderCreateDescriptorSetLayout(m_device, counts, types, stages, &m_descriptorSetLayoutGBuffer);
+		m_descriptorAllocator->allocateDescriptorSets(m_descriptorSetLayoutGBuffer, m_framesInFlight, m_descriptorSetsGBuffer);
+		updateDescriptorSetsGBuffer();
+
+		addSubrenderer(new VESubrenderFW_C1());
+		addSubrenderer(new VESubrenderDF_D());
+		addSubrenderer(new VESubrenderDF_DN());
+		addSubrenderer(new VESubrenderFW_Cubemap());
+		addSubrenderer(new VESubrenderFW_Cubemap2());
+		addSubrenderer(new VESubrenderFW_Skyplane());
+		addSubrenderer(new VESubrenderDF_Light());
+		addSubrenderer(new VESubrenderFW_Shadow());
+	}
+
+
+	/**
+	* \brief Destroy the G-buffer and the swapchain because window resize or close down
+	*/
+	void VERendererDeferred::cleanupSwapChain() {
+		vkDestroyFramebuffer(m_device, m_gBufferFramebuffer, nullptr);
+
+		for (auto pMap : m_gBufferMaps) {
+			m_layoutTracker->forget(pMap->m_image);
+			delete pMap;
+		}
+		m_gBufferMaps.clear();
+
+		VERendererForward::cleanupSwapChain();
+	}
+
+
+	/**
+	* \brief Close the renderer, destroy all local resources
+	*/
+	void VERendererDeferred::closeRenderer() {
+		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutGBuffer, nullptr);
+
+		VERendererForward::closeRenderer();
+	}
+
+
+	/**
+	* \brief Clustered lighting is a forward technique, the deferred renderer always draws one light pass per light
+	*
+	* \param[in] clustered Ignored
+	*
+	*/
+	void VERendererDeferred::setClusteredLighting(bool clustered) {
+	}
+
+
+	/**
+	* \brief The geometry pass already fills the depth map once, so the deferred renderer needs no depth pre-pass
+	*
+	* \param[in] prepass Ignored
+	*
+	*/
+	void VERendererDeferred::setDepthPrepass(bool prepass) {
+	}
+
+
+	/**
+	* \returns one light pass for each light
+	*/
+	uint32_t VERendererDeferred::getNumLightPasses() {
+		return (uint32_t)getSceneManagerPointer()->getLights().size();
+	}
+
+
+	/**
+	*
+	* \brief Record the secondary command buffers of a subrenderer for the current frame
+	*
+	* Geometry subrenderers are recorded once into the geometry render pass, cut into chunks of ENTITIES_PER_CMD_BUFFER
+	* entities. The light subrenderer is recorded once for each light. All other (forward) subrenderers are recorded
+	* once as if they were drawn in the first light pass, and executed after the last light, so they overwrite lit pixels
+	* just like in the forward renderer. Each buffer is recorded by a job of the engine's thread pool.
+	* Nothing is done if the cached buffers are still up to date.
+	*
+	* \param[in] pSub Pointer to the subrenderer to record
+	* \param[out] futures The futures of the submitted jobs are appended to this list
+	*
+	*/
+	void VERendererDeferred::recordCmdBuffersLight(VESubrender *pSub, veFrameVector<std::future<void>> &futures) {
+		if (!pSub->cmdBuffersDirty(m_frameIndex)) return;
+		pSub->waitForPipelines();
+
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+		std::vector<VESubrender::veSecondaryBuffer_t> &buffers = pSub->getSecondaryBuffers(m_frameIndex);
+
+		uint32_t numLightPasses = getNumLightPasses();
+		if (numLightPasses == 0) {
+			pSub->setCmdBuffersRecorded(m_frameIndex);
+			return;
+		}
+
+		uint32_t idx = m_frameIndex;
+		VESubrender::veSubrenderClass subClass = pSub->getClass();
+
+		if (subClass == VESubrender::VE_SUBRENDERER_CLASS_LIGHT) {
+			for (uint32_t i = 0; i < numLightPasses; i++) {
+				buffers.push_back({ i, VK_NULL_HANDLE, VK_NULL_HANDLE });
+			}
+			pSub->prepareDraw();
+
+			for (uint32_t i = 0; i < numLightPasses; i++) {
+				VELight * pLight = lights[i];
+				VESubrender::veSecondaryBuffer_t *pBuffer = &buffers[i];
+
+				futures.push_back(getEnginePointer()->m_threadPool->submit([this, idx, pSub, pCamera, pLight, i, pBuffer]() {
+					VkCommandPool commandPool = getThreadCommandPool(idx);
+
+					//the light render passes are compatible with the forward clear render pass, the swapchain framebuffer is unknown here
+					VkCommandBuffer commandBuffer = createSecondaryCmdBuffer(commandPool, m_renderPassClear, VK_NULL_HANDLE);
+
+					pSub->draw(commandBuffer, idx, i, pCamera, pLight, m_descriptorSetsShadow, 0, 1);
+
+					vkEndCommandBuffer(commandBuffer);
+					pBuffer->pool = commandPool;
+					pBuffer->buffer = commandBuffer;
+				}));
+			}
+
+			pSub->setCmdBuffersRecorded(m_frameIndex);
+			return;
+		}
+
+		bool geometry = subClass == VESubrender::VE_SUBRENDERER_CLASS_GEOMETRY;
+		uint32_t numPass = geometry ? 0 : numLightPasses - 1;
+		VELight *pLight = geometry ? nullptr : lights[numLightPasses - 1];
+		VkRenderPass renderPass = geometry ? m_renderPassGeometry : m_renderPassClear;
+
+		uint32_t numEntities = pSub->getNumberEntities();
+		uint32_t numChunks = (numEntities + ENTITIES_PER_CMD_BUFFER - 1) / ENTITIES_PER_CMD_BUFFER;
+
+		for (uint32_t c = 0; c < numChunks; c++) {
+			buffers.push_back({ numPass, VK_NULL_HANDLE, VK_NULL_HANDLE });
+		}
+		if (buffers.size() > 0) pSub->prepareDraw();
+
+		for (uint32_t c = 0; c < numChunks; c++) {
+			VESubrender::veSecondaryBuffer_t *pBuffer = &buffers[c];
+			uint32_t startIdx = c * ENTITIES_PER_CMD_BUFFER;
+
+			futures.push_back(getEnginePointer()->m_threadPool->submit([this, idx, pSub, pCamera, pLight, geometry, renderPass, startIdx, pBuffer]() {
+				VkCommandPool commandPool = getThreadCommandPool(idx);
+				VkFramebuffer frameBuffer = geometry ? m_gBufferFramebuffer : VK_NULL_HANDLE;
+				VkCommandBuffer commandBuffer = createSecondaryCmdBuffer(commandPool, renderPass, frameBuffer);
+
+				//forward subrenderers are drawn like in the first pass, overwriting the lit pixels
+				const std::vector<VkDescriptorSet> noDescriptorSets;		//an empty vector does not allocate
+				pSub->draw(	commandBuffer, idx, 0, pCamera, pLight, geometry ? noDescriptorSets : m_descriptorSetsShadow,
+							startIdx, startIdx + ENTITIES_PER_CMD_BUFFER);
+
+				vkEndCommandBuffer(commandBuffer);
+				pBuffer->pool = commandPool;
+				pBuffer->buffer = commandBuffer;
+			}));
+		}
+
+		pSub->setCmdBuffersRecorded(m_frameIndex);
+	}
+
+
+	/**
+	*
+	* \brief The light passes of the deferred renderer are not culled
+	*
+	* Each light is drawn as a full screen quad, and the forward subrenderers are drawn in a single pass.
+	* Thus all light passes keep the full screen, and the buffers are never recorded again because of them.
+	*
+	*/
+	void VERendererDeferred::updateLightPasses() {
+		m_lightPasses.clear();
+	}
+
+
+	/**
+	*
+	* \brief Dynamic resolution is not available for the deferred renderer
+	*
+	* The G-buffer and light passes always cover the whole swapchain, so the deferred renderer draws at full resolution.
+	*
+	* \param[in] dynamicResolution Ignored
+	*
+	*/
+	void VERendererDeferred::setDynamicResolution(bool dynamicResolution) {
+	}
+
+
+	/**
+	*
+	* \brief Create a new primary command buffer that executes the cached secondary buffers, then end it
+	*
+	* The primary buffer first draws the G-buffer. Then for each light, the shadow maps are drawn,
+	* and the light is added to the framebuffer in a screen space pass. The forward subrenderers are
+	* executed in the last light pass. The passes are declared to the render graph, which culls the
+	* geometry pass if there is no light, and records the barriers between the passes.
+	*
+	*/
+	void VERendererDeferred::recordCmdBuffers() {
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		pCamera->setExtent(getWindowPointer()->getExtent());
+
+		if (m_commandBuffers[m_frameIndex] != VK_NULL_HANDLE) {
+			vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffers[m_frameIndex]);
+			m_commandBuffers[m_frameIndex] = VK_NULL_HANDLE;
+		}
+		m_renderExtentRecorded[m_frameIndex] = m_renderExtent;	//always the swapchain extent, changes only with the swapchain
+
+		//-----------------------------------------------------------------------------------------
+		//record outdated secondary buffers
+
+		std::chrono::high_resolution_clock::time_point t_now;
+		veFrameVector<std::future<void>> futures;
+
+		t_now = vh::vhTimeNow();
+		recordCmdBuffersShadow(futures);
+		for (auto &f : futures) f.get();
+		m_AvgCmdShadowTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdShadowTime);
+
+		t_now = vh::vhTimeNow();
+		futures.clear();
+		freeOutdatedCmdBuffers();
+		for (auto pSub : m_subrenderers) recordCmdBuffersLight(pSub, futures);
+		for (auto &f : futures) f.get();
+		m_AvgCmdLightTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdLightTime);
+
+		//-----------------------------------------------------------------------------------------
+		//record the primary buffer
+
+		vh::vhCmdCreateCommandBuffers(	m_device, m_commandPool,
+										VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+										1, &m_commandBuffers[m_frameIndex]);
+
+		vh::vhCmdBeginCommandBuffer(m_device, m_commandBuffers[m_frameIndex], VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+
+		//the first light pass clears the swapchain image, so its content from the last frame is not needed
+		m_layoutTracker->setState(m_swapChainImages[imageIndex], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0);
+
+		//-----------------------------------------------------------------------------------------
+		//declare the passes and the images they use, the render graph orders them and adds the barriers
+
+		m_renderGraph->reset();
+		uint32_t swapChainImage = m_renderGraph->addImage(m_swapChainImages[imageIndex], true);
+		uint32_t depthImage = m_renderGraph->addImage(m_depthMap->m_image);
+		veFrameVector<uint32_t> gBufferImages;
+		for (auto pMap : m_gBufferMaps) gBufferImages.push_back(m_renderGraph->addImage(pMap->m_image));
+
+		//-----------------------------------------------------------------------------------------
+		//geometry pass, it is culled if there is no light pass reading the G-buffer
+
+		uint32_t pass = m_renderGraph->addPass("Geometry", [this](VkCommandBuffer commandBuffer) {
+			VkClearValue clearValuesGeometry[NUM_GBUFFER_MAPS + 1];	//empty G-buffer pixels have w = 0
+			for (uint32_t i = 0; i < NUM_GBUFFER_MAPS; i++) {
+				clearValuesGeometry[i].color = { 0.0f, 0.0f, 0.0f, 0.0f };
+			}
+			clearValuesGeometry[NUM_GBUFFER_MAPS].depthStencil = { 1.0f, 0 };
+
+			vh::vhRenderBeginRenderPass(commandBuffer,
+				m_renderPassGeometry,
+				m_gBufferFramebuffer,
+				NUM_GBUFFER_MAPS + 1, clearValuesGeometry,
+				m_swapChainExtent,
+				VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+			veFrameVector<VkCommandBuffer> geometryBuffers;
+			for (auto pSub : m_subrenderers) {
+				if (pSub->getClass() != VESubrender::VE_SUBRENDERER_CLASS_GEOMETRY) continue;
+				for (auto &sb : pSub->getSecondaryBuffers(m_frameIndex)) {
+					if (sb.buffer != VK_NULL_HANDLE) geometryBuffers.push_back(sb.buffer);
+				}
+			}
+			if (geometryBuffers.size() > 0)
+				vkCmdExecuteCommands(commandBuffer, (uint32_t)geometryBuffers.size(), geometryBuffers.data());
+
+			vkCmdEndRenderPass(commandBuffer);
+		});
+		for (auto image : gBufferImages) {
+			m_renderGraph->write(	pass, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+									VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+		m_renderGraph->write(	pass, depthImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+								VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+								VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+
+		//-----------------------------------------------------------------------------------------
+		//set clear values for light passes, the depth of the geometry pass is kept
+
+		VkClearValue clearValuesLight[2];		//render target should be cleared only first time
+		clearValuesLight[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+		clearValuesLight[1].depthStencil = { 1.0f, 0 };
+
+		//go through all active lights in the scene
+
+		for (uint32_t i = 0; i < getNumLightPasses(); i++) {
+
+			//-----------------------------------------------------------------------------------------
+			//shadow passes
+
+			addShadowPass(i);
+
+			//-----------------------------------------------------------------------------------------
+			//light pass, first the light itself, then the forward subrenderers of this pass
+
+			pass = m_renderGraph->addPass("Light", [this, i, &clearValuesLight](VkCommandBuffer commandBuffer) {
+				vh::vhRenderBeginRenderPass(commandBuffer,
+					i == 0 ? m_renderPassLightClear : m_renderPassLoad,
+					m_swapChainFramebuffers[imageIndex],
+					i == 0 ? 2 : 0, clearValuesLight,		//since we blend the lights onto each other, do not clear them for passes 2 and further
+					m_swapChainExtent,
+					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+				veFrameVector<VkCommandBuffer> lightBuffers;
+				for (auto pSub : m_subrenderers) {
+					if (pSub->getClass() != VESubrender::VE_SUBRENDERER_CLASS_LIGHT) continue;
+					for (auto &sb : pSub->getSecondaryBuffers(m_frameIndex)) {
+						if (sb.numPass == i && sb.buffer != VK_NULL_HANDLE) lightBuffers.push_back(sb.buffer);
+					}
+				}
+				for (auto pSub : m_subrenderers) {
+					if (pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_LIGHT || pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_GEOMETRY) continue;
+					for (auto &sb : pSub->getSecondaryBuffers(m_frameIndex)) {
+						if (sb.numPass == i && sb.buffer != VK_NULL_HANDLE) lightBuffers.push_back(sb.buffer);
+					}
+				}
+				if (lightBuffers.size() > 0)
+					vkCmdExecuteCommands(commandBuffer, (uint32_t)lightBuffers.size(), lightBuffers.data());
+
+				vkCmdEndRenderPass(commandBuffer);
+			});
+			readShadowMaps(pass);
+			for (auto image : gBufferImages) {
+				m_renderGraph->read(pass, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+			}
+			m_renderGraph->write(	pass, depthImage, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+									VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+									VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+			m_renderGraph->write(	pass, swapChainImage,
+									i > 0 ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+									VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+									VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+									VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		//record the passes
+
+		m_renderGraph->compile();
+		m_renderGraph->execute(m_commandBuffers[m_frameIndex]);
+
+		handOverSwapChainImage();
+
+		vkEndCommandBuffer(m_commandBuffers[m_frameIndex]);
+		m_commandBufferImages[m_frameIndex] = imageIndex;
+	}
+
+}
+
+
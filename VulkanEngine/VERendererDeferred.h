@@ -0,0 +1,70 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+#ifndef getRendererDeferredPointer
+#define getRendererDeferredPointer() g_pVERendererDeferredSingleton
+#endif
+
+const uint32_t NUM_GBUFFER_MAPS = 4;		///<Number of G-buffer color maps: albedo, normal, material parameters, position
+
+namespace ve {
+
+	class VERendererDeferred;
+
+	extern VERendererDeferred* g_pVERendererDeferredSingleton;	///<Pointer to the only class instance 
+
+	/**
+	*
+	* \brief A deferred renderer
+	*
+	* This renderer first draws all objects once into a G-buffer. Then for each light, the shadow maps are drawn,
+	* and the light is applied to the G-buffer pixels inside a screen space quad that covers the light's volume.
+	* The cost of a light is thus its fill rate, not a re-render of the scene. Sky boxes and unlit objects are drawn
+	* with the forward subrenderers after the last light.
+	*
+	*/
+	class VERendererDeferred : public VERendererForward {
+
+	protected:
+		std::vector<VETexture *>	m_gBufferMaps;						///<G-buffer maps: albedo, normal, material parameters, world position
+		VkRenderPass				m_renderPassGeometry;				///<The render pass writing the G-buffer
+		VkFramebuffer				m_gBufferFramebuffer;				///<Framebuffer holding the G-buffer maps and the depth map
+		VkDescriptorSetLayout		m_descriptorSetLayoutGBuffer;		///<Descriptor set layout for reading the G-buffer in the light passes
+		std::vector<VkDescriptorSet> m_descriptorSetsGBuffer;			///<per frame in flight: descriptor set for reading the G-buffer in the light passes
+
+		virtual void createRenderPasses();			//create the light render passes and the geometry render pass
+		virtual void destroyRenderPasses();			//destroy all render passes
+		virtual void cleanupSwapChain();			//delete the swapchain and the G-buffer
+		virtual void createSwapchainResources();	//create the light pass resources and the G-buffer
+		virtual void updateDescriptorSetsGBuffer();	//write the G-buffer maps into the descriptor sets
+
+		virtual void createSubrenderers();			//create the subrenderers
+		virtual void recordCmdBuffers();			//record the command buffers
+		virtual void recordCmdBuffersLight(VESubrender *pSub, veFrameVector<std::future<void>> &futures);	//record a geometry or light subrenderer in parallel
+		virtual uint32_t getNumLightPasses();		//number of light passes (with shadow passes) to record
+		virtual void updateLightPasses();			//no culled light passes, the lights are drawn as full screen quads
+		virtual void closeRenderer();				//close the renderer
+
+	public:
+		///Constructor of class VERendererDeferred
+		VERendererDeferred();
+		///Destructor of class VERendererDeferred
+		virtual ~VERendererDeferred() {};
+		virtual void setClusteredLighting(bool clustered);
+		virtual void setDepthPrepass(bool prepass);
+		virtual void setDynamicResolution(bool dynamicResolution);
+		///\returns the render pass writing the G-buffer
+		virtual VkRenderPass			getRenderPassGeometry() { return m_renderPassGeometry; };
+		///\returns the descriptor set layout of the G-buffer
+		virtual VkDescriptorSetLayout	getDescriptorSetLayoutGBuffer() { return m_descriptorSetLayoutGBuffer; };
+		///\returns the descriptor sets of the G-buffer
+		virtual std::vector<VkDescriptorSet> &getDescriptorSetsGBuffer() { return m_descriptorSetsGBuffer; };
+	};
+
+}
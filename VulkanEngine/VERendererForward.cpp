@@ -9,8 +9,7 @@
 #include "VEInclude.h"
 
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
-const uint32_t SHADOW_MAP_DIM = 4096;
+const std::string PIPELINE_CACHE_FILE = "pipelinecache.bin";	///<File keeping the pipeline cache between runs
 
 
 namespace ve {
@@ -41,10 +40,91 @@ namespace ve {
 		};
 
 		vh::vhDevPickPhysicalDevice(getEnginePointer()->getInstance(), m_surface, requiredDeviceExtensions, &m_physicalDevice);
-		vh::vhDevCreateLogicalDevice(m_physicalDevice, m_surface, requiredDeviceExtensions, requiredValidationLayers,
-									&m_device, &m_graphicsQueue, &m_presentQueue);
+
+		//enable multiview for single pass cube shadow maps, if the device has it
+		//the cube shadows themselves stay off until setCubeShadows() turns them on
+		VkBool32 multiview = VK_FALSE;
+		vh::vhDevQueryMultiview(m_physicalDevice, &multiview);
+		m_multiviewSupported = multiview == VK_TRUE;
+
+		VkPhysicalDeviceMultiviewFeatures multiviewFeatures = {};
+		multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+		multiviewFeatures.multiview = VK_TRUE;
+
+		//enable descriptor indexing for bindless textures, if the device has it
+		VkBool32 descriptorIndexing = VK_FALSE;
+		vh::vhDevQueryDescriptorIndexing(m_physicalDevice, MAX_BINDLESS_TEXTURES, &descriptorIndexing);
+		m_bindlessSupported = descriptorIndexing == VK_TRUE;
+		m_bindlessTextures = m_bindlessSupported;
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
+		//submissions are tracked by a timeline semaphore, if the device has it, otherwise by fences
+		VkBool32 timelineSemaphore = VK_FALSE;
+		vh::vhDevQueryTimelineSemaphore(m_physicalDevice, &timelineSemaphore);
+		m_timelineSupported = timelineSemaphore == VK_TRUE;
+
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+		timelineFeatures.timelineSemaphore = VK_TRUE;
+
+		std::vector<const char*> deviceExtensions = requiredDeviceExtensions;
+		void *pNextFeatures = nullptr;
+		if (m_multiviewSupported) {
+			multiviewFeatures.pNext = pNextFeatures;
+			pNextFeatures = &multiviewFeatures;
+		}
+		if (m_bindlessSupported) {
+			indexingFeatures.pNext = pNextFeatures;
+			pNextFeatures = &indexingFeatures;
+			deviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		}
+		if (m_timelineSupported) {
+			timelineFeatures.pNext = pNextFeatures;
+			pNextFeatures = &timelineFeatures;
+			deviceExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+		}
+
+		//the depth bounds test is enabled by the logical device if the device has it
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+		m_depthBoundsSupported = supportedFeatures.depthBounds == VK_TRUE;
+		m_wireframeSupported = supportedFeatures.fillModeNonSolid == VK_TRUE;
+
+		//timestamps measure the GPU time of a frame for dynamic resolution, if the device has them
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_physicalDevice, &deviceProperties);
+		if (deviceProperties.limits.timestampComputeAndGraphics == VK_TRUE) m_timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+		//the per object push constants are on by default, if the device has enough push constant space for them
+		m_pushConstantsSupported = deviceProperties.limits.maxPushConstantsSize >= sizeof(VEEntity::vePushConstantsPerObject_t);
+		m_pushConstants = m_pushConstantsSupported;
+
+		VECHECKRESULT(vh::vhDevCreateLogicalDevice(	m_physicalDevice, m_surface, deviceExtensions, requiredValidationLayers,
+													pNextFeatures, &m_device, &m_graphicsQueue, &m_presentQueue, &m_transferQueue),
+					"Failed to create logical device!");
 
 		vh::vhMemCreateVMAAllocator(m_physicalDevice, m_device, m_vmaAllocator);
+		m_timeline = new VETimeline(m_device, m_timelineSupported);
+
+		//meshes and textures are copied by the DMA engine, if the device has a transfer family
+		vh::QueueFamilyIndices queueFamilies = vh::vhDevFindQueueFamilies(m_physicalDevice, m_surface);
+		m_uploadManager = new VEUploadManager(	m_device, m_vmaAllocator, m_timeline,
+												m_graphicsQueue, (uint32_t)queueFamilies.graphicsFamily,
+												m_transferQueue, (uint32_t)queueFamilies.transferFamily);
+
+		m_layoutTracker = new VELayoutTracker();
+		m_renderGraph = new VERenderGraph(m_layoutTracker);
+
+		//all textures loaded from now on go into the bindless texture array
+		if (m_bindlessSupported) m_bindlessTable = new VEBindlessTable();
+
+		//PSOs compiled in earlier runs are taken from the pipeline cache file
+		VECHECKRESULT(vh::vhPipeCreatePipelineCache(m_physicalDevice, m_device, PIPELINE_CACHE_FILE, &m_pipelineCache), "Failed to create pipeline cache!");
+		m_pipelineRegistry = new VEPipelineRegistry();
 
 		vh::vhSwapCreateSwapChain(	m_physicalDevice, m_surface, m_device, getWindowPointer()->getExtent(),
 									&m_swapChain, m_swapChainImages, m_swapChainImageViews,
@@ -55,73 +135,108 @@ namespace ve {
 
 		vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface, &m_commandPool);
 
-		m_commandBuffers.resize(m_swapChainImages.size() );
-		for (uint32_t i = 0; i < m_swapChainImages.size(); i++) m_commandBuffers[i] = VK_NULL_HANDLE;
+		//command buffers and their bookkeeping belong to the frames in flight, not to the swapchain images
+		m_commandBuffers.resize(m_framesInFlight, VK_NULL_HANDLE);
+		m_commandBufferImages.resize(m_framesInFlight, 0);
+		m_frameValues.resize(m_framesInFlight, 0);
+		m_imageValues.resize(m_swapChainImages.size(), 0);
+		m_shadowCacheTilesRecorded.resize(m_framesInFlight, 0);
+		m_shadowCacheCmdBuffers.resize(m_framesInFlight, VK_NULL_HANDLE);
+		m_shadowTilesRecorded.resize(m_framesInFlight);
+		m_lightPassesRecorded.resize(m_framesInFlight);
+		m_renderExtentRecorded.resize(m_framesInFlight, { 0, 0 });
+		m_timestampsWritten.resize(m_framesInFlight, false);
 
 
 		//------------------------------------------------------------------------------------------------------------
 		//create resources for light pass
 
-		m_depthMap = new VETexture("DepthMap");
-		m_depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
-		m_depthMap->m_extent = m_swapChainExtent;
-
-		//light render pass
-		vh::vhRenderCreateRenderPass( m_device, m_swapChainImageFormat, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_CLEAR, &m_renderPassClear);
-		vh::vhRenderCreateRenderPass( m_device, m_swapChainImageFormat, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_LOAD,  &m_renderPassLoad);
-
-		//depth map for light pass
-		vh::vhBufCreateDepthResources(	m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool, 
-										m_swapChainExtent, m_depthMap->m_format, &m_depthMap->m_image, &m_depthMap->m_deviceAllocation, &m_depthMap->m_imageView);
-
-		//frame buffers for light pass
-		std::vector<VkImageView> depthMaps;
-		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++) depthMaps.push_back(m_depthMap->m_imageView);
-		vh::vhBufCreateFramebuffers(m_device, m_swapChainImageViews, depthMaps, m_renderPassClear, m_swapChainExtent, m_swapChainFramebuffers);
+		createRenderPasses();
+		createSwapchainResources();
 
 		//------------------------------------------------------------------------------------------------------------
 		//create resources for shadow pass
 
-		//shadow render pass
-		vh::vhRenderCreateRenderPassShadow( m_device, m_depthMap->m_format, &m_renderPassShadow);
-
-		//shadow maps
-		m_shadowMaps.resize(m_swapChainImageViews.size());
-		m_shadowFramebuffers.resize(m_swapChainImageViews.size());
-		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++) {
-			for (uint32_t j = 0; j < NUM_SHADOW_CASCADE; j++) {						//point light has 6 shadow maps, thats the max
-				VkExtent2D extent = { SHADOW_MAP_DIM, SHADOW_MAP_DIM };
-
-				VETexture *pShadowMap = new VETexture("ShadowMap");
-				pShadowMap->m_extent = extent;
-				pShadowMap->m_format = m_depthMap->m_format;
-
-				//create the depth images
-				vh::vhBufCreateDepthResources(m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
-					extent, pShadowMap->m_format,
-					&pShadowMap->m_image, &pShadowMap->m_deviceAllocation, &pShadowMap->m_imageView);
-
-				vh::vhBufCreateTextureSampler(getRendererPointer()->getDevice(), &pShadowMap->m_sampler);
-
-				m_shadowMaps[i].push_back(pShadowMap);
-
-				//create the framebuffers holding only the depth images for the shadow maps
-				std::vector<VkFramebuffer> frameBuffers;
-				vh::vhBufCreateFramebuffers(m_device, { VK_NULL_HANDLE }, { pShadowMap->m_imageView },
-											m_renderPassShadow, extent, frameBuffers);
-
-				m_shadowFramebuffers[i].push_back(frameBuffers[0]);
+		//shadow render pass, clears and draws only the tile of a shadow camera and keeps the rest of the atlas
+		vh::vhRenderCreateRenderPassShadow( m_device, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_CLEAR,
+											VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &m_renderPassShadow);
+
+		//shadow render pass drawing on top of cached static casters that were copied into the tile
+		vh::vhRenderCreateRenderPassShadow(	m_device, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_LOAD,
+											VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, &m_renderPassShadowLoad);
+
+		//shadow atlas, one fixed size depth image for all shadow cameras and swapchain images
+		//the shadow passes of a light wait for all previous work on the queue, so the lights can reuse the atlas
+		VkExtent2D extent = { SHADOW_ATLAS_WIDTH, SHADOW_ATLAS_HEIGHT };
+		m_shadowAtlas = new VETexture("ShadowAtlas");
+		m_shadowAtlas->m_extent = extent;
+		m_shadowAtlas->m_format = m_depthMap->m_format;
+
+		VECHECKRESULT(vh::vhBufCreateDepthResources(m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
+													extent, m_shadowAtlas->m_format,
+													&m_shadowAtlas->m_image, &m_shadowAtlas->m_deviceAllocation, &m_shadowAtlas->m_imageView), "Failed to create shadow atlas!");
+
+		vh::vhBufCreateTextureSampler(m_device, &m_shadowAtlas->m_sampler);
+
+		//the shadow render pass keeps the atlas content, so it must start in a defined layout
+		VECHECKRESULT(vh::vhBufTransitionImageLayout(	m_device, m_graphicsQueue, m_commandPool, m_shadowAtlas->m_image, m_shadowAtlas->m_format,
+														VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1,
+														VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL), "Failed to transition shadow atlas!");
+		registerDepthImage(m_shadowAtlas->m_image, m_shadowAtlas->m_format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		VECHECKRESULT(vh::vhBufCreateFramebuffer(	m_device, { m_shadowAtlas->m_imageView }, m_renderPassShadow,
+													extent, &m_shadowAtlasFramebuffer), "Failed to create shadow atlas framebuffer!");
+
+		//cache atlas, keeping the cached maps of all lights between frames, so its size is the memory budget of all caches
+		//the maps are drawn into the atlas and copied into tiles of the same size, so the cache atlas is only a transfer source and destination
+		m_shadowCacheAtlas = new VETexture("ShadowCacheAtlas");
+		m_shadowCacheAtlas->m_extent = { SHADOW_CACHE_ATLAS_WIDTH, SHADOW_CACHE_ATLAS_HEIGHT };
+		m_shadowCacheAtlas->m_format = m_depthMap->m_format;
+
+		VECHECKRESULT(vh::vhBufCreateDepthResources(m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
+													m_shadowCacheAtlas->m_extent, m_shadowCacheAtlas->m_format,
+													&m_shadowCacheAtlas->m_image, &m_shadowCacheAtlas->m_deviceAllocation, &m_shadowCacheAtlas->m_imageView), "Failed to create shadow cache atlas!");
+
+		VECHECKRESULT(vh::vhBufTransitionImageLayout(	m_device, m_graphicsQueue, m_commandPool, m_shadowCacheAtlas->m_image, m_shadowCacheAtlas->m_format,
+														VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1,
+														VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL), "Failed to transition shadow cache atlas!");
+
+		for (uint32_t y = 0; y < SHADOW_CACHE_ATLAS_HEIGHT; y += SHADOW_MAP_DIM) {
+			for (uint32_t x = 0; x < SHADOW_CACHE_ATLAS_WIDTH; x += SHADOW_MAP_DIM) {
+				m_shadowCacheFreeTiles[SHADOW_MAP_DIM].push_back({ (int32_t)x, (int32_t)y });
 			}
 		}
 
+		//cube shadow map, one layer for each face, drawn by a single multiview pass
+		//without multiview a tiny map is created anyway, since the light pass descriptor sets always hold it
+		uint32_t cubeDim = m_multiviewSupported ? SHADOW_MAP_DIM / 2 : 1;
+		m_cubeShadowMap = new VETexture("CubeShadowMap");
+		m_cubeShadowMap->m_extent = { cubeDim, cubeDim };
+		m_cubeShadowMap->m_format = m_depthMap->m_format;
+
+		VECHECKRESULT(vh::vhBufCreateDepthResources(m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool,
+													m_cubeShadowMap->m_extent, m_cubeShadowMap->m_format, 6,
+													&m_cubeShadowMap->m_image, &m_cubeShadowMap->m_deviceAllocation, &m_cubeShadowMap->m_imageView), "Failed to create cube shadow map!");
+
+		vh::vhBufCreateTextureSampler(m_device, &m_cubeShadowMap->m_sampler);
+
+		VECHECKRESULT(vh::vhBufTransitionImageLayout(	m_device, m_graphicsQueue, m_commandPool, m_cubeShadowMap->m_image, m_cubeShadowMap->m_format,
+														VK_IMAGE_ASPECT_DEPTH_BIT, 1, 6,
+														VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL), "Failed to transition cube shadow map!");
+		registerDepthImage(m_cubeShadowMap->m_image, m_cubeShadowMap->m_format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		m_renderPassCubeShadow = VK_NULL_HANDLE;
+		m_cubeShadowFramebuffer = VK_NULL_HANDLE;
+		if (m_multiviewSupported) {
+			VECHECKRESULT(vh::vhRenderCreateRenderPassShadowMultiview(m_device, m_cubeShadowMap->m_format, 0x3F, &m_renderPassCubeShadow), "Failed to create cube shadow render pass!");
+			VECHECKRESULT(vh::vhBufCreateFramebuffer(	m_device, { m_cubeShadowMap->m_imageView }, m_renderPassCubeShadow,
+														m_cubeShadowMap->m_extent, &m_cubeShadowFramebuffer), "Failed to create cube shadow framebuffer!");
+		}
+
 		//------------------------------------------------------------------------------------------------------------
-		//create descriptor pool, layout and sets
+		//create descriptor allocator, layout and sets
 
-		uint32_t maxobjects = 10000;
-		vh::vhRenderCreateDescriptorPool(m_device,
-										{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-										{ maxobjects, maxobjects },
-										&m_descriptorPool);
+		m_descriptorAllocator = new VEDescriptorAllocator(m_framesInFlight);
 
 		//set 0...cam UBO
 		//set 1...light UBO
@@ -129,11 +244,13 @@ namespace ve {
 		//set 3...per object UBO
 		//set 4...additional per object resources
 
-		//set 2, binding 0 : shadow map + sampler
+		//set 2, binding 0 : shadow atlas + sampler
+		//set 2, binding 1 : light clusters (only used by clustered lighting)
+		//set 2, binding 2 : cube shadow map + sampler (only used by point lights with cube shadows)
 		vh::vhRenderCreateDescriptorSetLayout(m_device,
-											{ NUM_SHADOW_CASCADE },
-											{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
-											{ VK_SHADER_STAGE_FRAGMENT_BIT },
+											{ 1, 1, 1 },
+											{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
+											{ VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_FRAGMENT_BIT },
 											&m_descriptorSetLayoutShadow);
 
 		//set 3, binding 0 : UBO per scene object: camera, light, entity
@@ -147,27 +264,36 @@ namespace ve {
 
 		//vh::vhRenderCreateDescriptorSets(m_device, (uint32_t)m_swapChainImages.size(),	m_descriptorSetLayoutPerFrame, getDescriptorPool(), m_descriptorSetsPerFrame);
 
-		vh::vhRenderCreateDescriptorSets(m_device, (uint32_t)m_swapChainImages.size(), m_descriptorSetLayoutShadow,   getDescriptorPool(), m_descriptorSetsShadow);
-
-		//update the descriptor set for light pass - array of shadow maps
-		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++) {
-
-			std::vector<std::vector<VkImageView>>	imageViews;
-			std::vector<std::vector<VkSampler>>		samplers;
-			imageViews.resize(1);
-			samplers.resize(1);
-			
-			for (uint32_t j = 0; j < NUM_SHADOW_CASCADE; j++) {
-				imageViews[0].push_back(m_shadowMaps[i][j]->m_imageView);
-				samplers[0].push_back(m_shadowMaps[i][j]->m_sampler);
-			}
+		m_descriptorAllocator->allocateDescriptorSets(m_descriptorSetLayoutShadow, m_framesInFlight, m_descriptorSetsShadow);
 
+		//update the descriptor set for light pass - the shadow atlas
+		for (uint32_t i = 0; i < m_descriptorSetsShadow.size(); i++) {
 			vh::vhRenderUpdateDescriptorSet(m_device, m_descriptorSetsShadow[i],
-											{ VK_NULL_HANDLE },		//UBOs
-											{ 0 },					//UBO sizes
-											{ imageViews },			//textureImageViews
-											{ samplers }			//samplers
+											{ VK_NULL_HANDLE },							//UBOs
+											{ 0 },										//UBO sizes
+											{ { m_shadowAtlas->m_imageView } },			//textureImageViews
+											{ { m_shadowAtlas->m_sampler } }			//samplers
 			);
+
+			vh::vhRenderUpdateDescriptorSetImage(	m_device, m_descriptorSetsShadow[i], 2,
+													m_cubeShadowMap->m_imageView, m_cubeShadowMap->m_sampler);
+		}
+
+		//------------------------------------------------------------------------------------------------------------
+		//create the cluster buffers for clustered lighting
+
+		VkDeviceSize clusterBufferSize =	2 * sizeof(glm::vec4) + MAX_CLUSTER_LIGHTS * sizeof(veClusterLight_t) +
+											NUM_CLUSTERS * sizeof(glm::uvec2) + MAX_CLUSTER_LIGHT_INDICES * sizeof(uint32_t);
+
+		m_clusterBuffers.resize(m_framesInFlight);
+		m_clusterBuffersAllocation.resize(m_framesInFlight);
+		m_clusterLightLists.resize(NUM_CLUSTERS);
+		for (uint32_t i = 0; i < m_framesInFlight; i++) {
+			vh::vhBufCreateBuffer(	m_vmaAllocator, clusterBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+									VMA_MEMORY_USAGE_CPU_TO_GPU, &m_clusterBuffers[i], &m_clusterBuffersAllocation[i]);
+
+			vh::vhRenderUpdateDescriptorSetBuffer(	m_device, m_descriptorSetsShadow[i], 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+													m_clusterBuffers[i], clusterBufferSize);
 		}
 
 
@@ -178,6 +304,105 @@ namespace ve {
 		createSubrenderers();
 	}
 
+	/**
+	*
+	* \brief Create all resources that depend on the swapchain
+	*
+	* These are the depth map, the framebuffers of the light passes and the depth pre-pass,
+	* the color map for dynamic resolution and the timestamp queries. They are created again whenever the swapchain is recreated.
+	* The render passes and PSOs only depend on the formats, so they survive a resize.
+	*
+	*/
+	void VERendererForward::createSwapchainResources() {
+		m_depthMap = new VETexture("DepthMap");
+		m_depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
+		m_depthMap->m_extent = m_swapChainExtent;
+
+		//depth map for light pass
+		vh::vhBufCreateDepthResources(	m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool, 
+										m_swapChainExtent, m_depthMap->m_format, &m_depthMap->m_image, &m_depthMap->m_deviceAllocation, &m_depthMap->m_imageView);
+		registerDepthImage(m_depthMap->m_image, m_depthMap->m_format, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+		//frame buffers for light pass
+		std::vector<VkImageView> depthMaps;
+		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++) depthMaps.push_back(m_depthMap->m_imageView);
+		vh::vhBufCreateFramebuffers(m_device, m_swapChainImageViews, depthMaps, m_renderPassClear, m_swapChainExtent, m_swapChainFramebuffers);
+
+		//color map for dynamic resolution, the light passes draw into its upper left corner and it is then upscaled
+		m_colorMap = new VETexture("ColorMap");
+		m_colorMap->m_format = m_swapChainImageFormat;
+		m_colorMap->m_extent = m_swapChainExtent;
+
+		VECHECKRESULT(vh::vhBufCreateImage(	m_vmaAllocator, m_swapChainExtent.width, m_swapChainExtent.height, 1, 1,
+											m_colorMap->m_format, VK_IMAGE_TILING_OPTIMAL,
+											VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0,
+											&m_colorMap->m_image, &m_colorMap->m_deviceAllocation), "Failed to create color map!");
+
+		VECHECKRESULT(vh::vhBufCreateImageView(	m_device, m_colorMap->m_image, m_colorMap->m_format, VK_IMAGE_VIEW_TYPE_2D, 1,
+												VK_IMAGE_ASPECT_COLOR_BIT, &m_colorMap->m_imageView), "Failed to create color map view!");
+		m_layoutTracker->setState(m_colorMap->m_image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0);
+
+		VECHECKRESULT(vh::vhBufCreateFramebuffer(	m_device, { m_colorMap->m_imageView, m_depthMap->m_imageView }, m_renderPassClear,
+													m_swapChainExtent, &m_colorMapFramebuffer), "Failed to create color map framebuffer!");
+
+		//the render area keeps its scale when the window size changes
+		m_renderExtent = {	std::max((uint32_t)std::round(m_swapChainExtent.width * m_renderScale), 1u),
+							std::max((uint32_t)std::round(m_swapChainExtent.height * m_renderScale), 1u) };
+
+		//two timestamps per frame in flight, at the start and the end of its command buffer
+		m_timestampPool = VK_NULL_HANDLE;
+		if (m_timestampPeriod > 0.0f) {
+			VkQueryPoolCreateInfo queryPoolInfo = {};
+			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolInfo.queryCount = 2 * m_framesInFlight;
+			VECHECKRESULT(vkCreateQueryPool(m_device, &queryPoolInfo, nullptr, &m_timestampPool), "Failed to create timestamp query pool!");
+		}
+
+		//depth pre-pass, shares the depth map with the light passes
+		VECHECKRESULT(vh::vhBufCreateFramebuffer(	m_device, { m_depthMap->m_imageView }, m_renderPassDepthPrepass,
+													m_swapChainExtent, &m_depthPrepassFramebuffer), "Failed to create depth pre-pass framebuffer!");
+
+		//new swapchain images have no content yet
+		for (auto image : m_swapChainImages) {
+			m_layoutTracker->setState(image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0);
+		}
+	}
+
+
+	/**
+	*
+	* \brief Create the render passes of the light passes and the depth pre-pass
+	*
+	* They only depend on the swapchain image format and the depth format, so all PSOs created with them
+	* stay valid when the window is resized.
+	*
+	*/
+	void VERendererForward::createRenderPasses() {
+		VkFormat depthFormat = vh::vhDevFindDepthFormat(m_physicalDevice);
+
+		//light render pass
+		vh::vhRenderCreateRenderPass( m_device, m_swapChainImageFormat, depthFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, &m_renderPassClear);
+		vh::vhRenderCreateRenderPass( m_device, m_swapChainImageFormat, depthFormat, VK_ATTACHMENT_LOAD_OP_LOAD,  &m_renderPassLoad);
+		vh::vhRenderCreateRenderPass( m_device, m_swapChainImageFormat, depthFormat,
+									  VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_LOAD_OP_LOAD, &m_renderPassLightClear);
+
+		//depth pre-pass
+		VECHECKRESULT(vh::vhRenderCreateRenderPassDepth(m_device, depthFormat, &m_renderPassDepthPrepass), "Failed to create depth pre-pass render pass!");
+	}
+
+
+	/**
+	* \brief Destroy the render passes of the light passes and the depth pre-pass
+	*/
+	void VERendererForward::destroyRenderPasses() {
+		vkDestroyRenderPass(m_device, m_renderPassClear, nullptr);
+		vkDestroyRenderPass(m_device, m_renderPassLoad, nullptr);
+		vkDestroyRenderPass(m_device, m_renderPassLightClear, nullptr);
+		vkDestroyRenderPass(m_device, m_renderPassDepthPrepass, nullptr);
+	}
+
+
 	/**
 	* \brief Create and register all known subrenderers for this VERenderer
 	*/
@@ -197,19 +422,24 @@ namespace ve {
 	* \brief Destroy the swapchain because window resize or close down
 	*/
 	void VERendererForward::cleanupSwapChain() {
+		m_layoutTracker->forget(m_depthMap->m_image);
+		m_layoutTracker->forget(m_colorMap->m_image);
 		delete m_depthMap;
+		delete m_colorMap;
+		vkDestroyFramebuffer(m_device, m_colorMapFramebuffer, nullptr);
+		if (m_timestampPool != VK_NULL_HANDLE) vkDestroyQueryPool(m_device, m_timestampPool, nullptr);
 
 		for (auto framebuffer : m_swapChainFramebuffers) {
 			vkDestroyFramebuffer(m_device, framebuffer, nullptr);
 		}
-
-		vkDestroyRenderPass(m_device, m_renderPassClear, nullptr);
-		vkDestroyRenderPass(m_device, m_renderPassLoad, nullptr);
+		vkDestroyFramebuffer(m_device, m_depthPrepassFramebuffer, nullptr);
 
 		for (auto imageView : m_swapChainImageViews) {
 			vkDestroyImageView(m_device, imageView, nullptr);
 		}
 
+		for (auto image : m_swapChainImages) m_layoutTracker->forget(image);
+
 		vkDestroySwapchainKHR(m_device, m_swapChain, nullptr);
 	}
 
@@ -218,39 +448,80 @@ namespace ve {
 	* \brief Close the renderer, destroy all local resources
 	*/
 	void VERendererForward::closeRenderer() {
-		destroySubrenderers();
-
+		vkDeviceWaitIdle(m_device);		//no submission of the timeline may be in flight anymore
 		deleteCmdBuffers();
 
+		destroySubrenderers();
+
 		cleanupSwapChain();
+		destroyRenderPasses();
 
-		for (auto framebufferList : m_shadowFramebuffers) {
-			for (auto fb : framebufferList) {
-				vkDestroyFramebuffer(m_device, fb, nullptr);
-			}
-		}
+		//destroy shadow atlas
+		vkDestroyFramebuffer(m_device, m_shadowAtlasFramebuffer, nullptr);
+		delete m_shadowAtlas;
+		vkDestroyRenderPass(m_device, m_renderPassShadow, nullptr);
 
-		//destroy shadow maps
-		for (auto pShadowMapList : m_shadowMaps) {
-			for (auto pS : pShadowMapList) {
-				delete pS;
-			}
+		//destroy cube shadow map
+		if (m_cubeShadowFramebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(m_device, m_cubeShadowFramebuffer, nullptr);
+		if (m_renderPassCubeShadow != VK_NULL_HANDLE) vkDestroyRenderPass(m_device, m_renderPassCubeShadow, nullptr);
+		delete m_cubeShadowMap;
+
+		//destroy the cache atlas, holding the cached static casters and the time sliced maps
+		delete m_shadowCacheAtlas;
+		m_shadowCacheFreeTiles.clear();
+		m_shadowCaches.clear();
+		m_shadowSlices.clear();
+
+		vkDestroyRenderPass(m_device, m_renderPassShadowLoad, nullptr);
+
+		//destroy cluster buffers
+		for (uint32_t i = 0; i < m_clusterBuffers.size(); i++) {
+			vmaDestroyBuffer(m_vmaAllocator, m_clusterBuffers[i], m_clusterBuffersAllocation[i]);
 		}
-		vkDestroyRenderPass(m_device, m_renderPassShadow, nullptr);
 
 		//destroy per frame resources
-		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
 		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutPerObject, nullptr);
 		vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutShadow, nullptr);
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		for (uint32_t i = 0; i < m_framesInFlight; i++) {
 			vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(m_device, m_imageAvailableSemaphores[i], nullptr);
-			vkDestroyFence(m_device, m_inFlightFences[i], nullptr);
+		}
+
+		delete m_uploadManager;
+		m_uploadManager = nullptr;
+
+		delete m_timeline;		//frees the remaining single time command buffers
+		m_timeline = nullptr;
+
+		delete m_renderGraph;
+		m_renderGraph = nullptr;
+
+		delete m_layoutTracker;
+		m_layoutTracker = nullptr;
+
+		for (auto &pools : m_commandPoolsThread) {
+			for (auto pool : pools) {
+				if (pool != VK_NULL_HANDLE) vkDestroyCommandPool(m_device, pool, nullptr);
+			}
 		}
 
 		vkDestroyCommandPool(m_device, m_commandPool, nullptr);
 
+		m_pipelineRegistry->clear();
+		delete m_pipelineRegistry;
+		m_pipelineRegistry = nullptr;
+
+		if (m_bindlessTable != nullptr) delete m_bindlessTable;
+		m_bindlessTable = nullptr;
+
+		delete m_descriptorAllocator;
+		m_descriptorAllocator = nullptr;
+
+		//keep the compiled PSOs for the next run, if this fails the next start just takes longer
+		vh::vhPipeSavePipelineCache(m_physicalDevice, m_device, m_pipelineCache, PIPELINE_CACHE_FILE);
+		vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+
 		vmaDestroyAllocator(m_vmaAllocator);
 
 		vkDestroyDevice(m_device, nullptr);
@@ -258,7 +529,12 @@ namespace ve {
 
 
 	/**
+	*
 	* \brief recreate the swapchain because the window size has changed
+	*
+	* All PSOs use dynamic viewports and scissors, so only the size dependent resources are created again.
+	* Only if the surface format changes, the render passes and the PSOs must be rebuilt as well.
+	*
 	*/
 	void VERendererForward::recreateSwapchain() {
 
@@ -266,50 +542,46 @@ namespace ve {
 
 		cleanupSwapChain();
 
+		VkFormat oldFormat = m_swapChainImageFormat;
 		vh::vhSwapCreateSwapChain(m_physicalDevice, m_surface, m_device, getWindowPointer()->getExtent(),
 			&m_swapChain, m_swapChainImages, m_swapChainImageViews,
 			&m_swapChainImageFormat, &m_swapChainExtent);
 
-		m_depthMap = new VETexture("DepthMap");
-		m_depthMap->m_format = vh::vhDevFindDepthFormat(m_physicalDevice);
-		m_depthMap->m_extent = m_swapChainExtent;
-
-		vh::vhRenderCreateRenderPass( m_device, m_swapChainImageFormat, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_CLEAR, &m_renderPassClear);
-		vh::vhRenderCreateRenderPass(m_device, m_swapChainImageFormat, m_depthMap->m_format, VK_ATTACHMENT_LOAD_OP_LOAD, &m_renderPassLoad);
-
-		vh::vhBufCreateDepthResources(	m_device, m_vmaAllocator, m_graphicsQueue, m_commandPool, m_swapChainExtent,
-										m_depthMap->m_format, &m_depthMap->m_image, &m_depthMap->m_deviceAllocation, &m_depthMap->m_imageView);
+		if (m_swapChainImageFormat != oldFormat) {
+			destroyRenderPasses();
+			createRenderPasses();
+		}
 
-		std::vector<VkImageView> depthMaps;
-		for (uint32_t i = 0; i < m_swapChainImageViews.size(); i++) depthMaps.push_back(m_depthMap->m_imageView);
-		vh::vhBufCreateFramebuffers(m_device, m_swapChainImageViews, depthMaps, m_renderPassClear, m_swapChainExtent, m_swapChainFramebuffers);
+		createSwapchainResources();
 
-		for (auto pSub : m_subrenderers) pSub->recreateResources();
+		if (m_swapChainImageFormat != oldFormat) {
+			for (auto pSub : m_subrenderers) pSub->recreateResources();
+			if (m_subrenderShadow != nullptr) m_subrenderShadow->recreateResources();
+		}
 
 		deleteCmdBuffers();
+		m_imageValues.assign(m_swapChainImages.size(), 0);
+		m_shadowCacheTilesRecorded.assign(m_framesInFlight, 0);
+		m_shadowTilesRecorded.assign(m_framesInFlight, {});
+		m_renderExtentRecorded.assign(m_framesInFlight, { 0, 0 });
+		m_timestampsWritten.assign(m_framesInFlight, false);
 	}
 	
 
 	/**
-	* \brief Create the semaphores and fences for syncing command buffers and swapchain
+	* \brief Create the semaphores for syncing command buffers and swapchain, the CPU waits on the timeline values instead of fences
 	*/
 	void VERendererForward::createSyncObjects() {
-		m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT); //for wait for the next swap chain image
-		m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT); //for wait for render finished
-		m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);		   //for wait for at least one image in the swap chain
+		m_imageAvailableSemaphores.resize(m_framesInFlight); //for wait for the next swap chain image
+		m_renderFinishedSemaphores.resize(m_framesInFlight); //for wait for render finished
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		VkFenceCreateInfo fenceInfo = {};
-		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-		m_overlaySemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		m_overlaySemaphores.resize(m_framesInFlight);
+		for (uint32_t i = 0; i < m_framesInFlight; i++) {
 			if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
-				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-				vkCreateFence(m_device, &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS ) {
+				vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ) {
 				getEnginePointer()->fatalError("Failed to create synchronization objects for a frame!");
 			}
 		}
@@ -319,7 +591,7 @@ namespace ve {
 
 	/**
 	* \brief Delete all command buffers and set them to VK_NULL_HANDLE, so next time they have to be 
-	* created and recorded again
+	* created and recorded again. This includes the cached secondary buffers of all subrenderers.
 	*/
 	void VERendererForward::deleteCmdBuffers() {
 		for (uint32_t i = 0; i < m_commandBuffers.size(); i++) {
@@ -328,161 +600,1730 @@ namespace ve {
 				m_commandBuffers[i] = VK_NULL_HANDLE;
 			}
 		}
+		for (uint32_t i = 0; i < m_shadowCacheCmdBuffers.size(); i++) {
+			if (m_shadowCacheCmdBuffers[i] != VK_NULL_HANDLE) {
+				vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_shadowCacheCmdBuffers[i]);
+				m_shadowCacheCmdBuffers[i] = VK_NULL_HANDLE;
+			}
+		}
+
+		for (auto pSub : m_subrenderers) pSub->deleteCmdBuffers();
+		if (m_subrenderShadow != nullptr) m_subrenderShadow->deleteCmdBuffers();
 	}
 
 
 	/**
-	* \brief Create a new command buffer and record the whole scene into it, then end it
+	*
+	* \brief Switch clustered lighting on or off
+	*
+	* With clustered lighting, all objects are drawn only once. The first light is drawn including its shadow,
+	* all other lights are assigned to view space clusters and looked up by the fragment shaders.
+	* Since the subrenderers need other PSOs, they are recreated.
+	*
+	* \param[in] clustered If true then use clustered lighting, else draw one light pass per light
+	*
 	*/
-	void VERendererForward::recordCmdBuffers() {
-		VECamera *pCamera = getSceneManagerPointer()->getCamera();
-		pCamera->setExtent(getWindowPointer()->getExtent());
+	void VERendererForward::setClusteredLighting(bool clustered) {
+		if (m_clusteredLighting == clustered) return;
 
-		vh::vhCmdCreateCommandBuffers(	m_device, m_commandPool,
-										VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-										1, &m_commandBuffers[imageIndex]);
-
-		vh::vhCmdBeginCommandBuffer(m_device, m_commandBuffers[imageIndex], VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+		vkDeviceWaitIdle(m_device);
 
-		//-----------------------------------------------------------------------------------------
-		//set clear values for shadow and light passes
+		m_clusteredLighting = clustered;
+		for (auto pSub : m_subrenderers) pSub->recreateResources();
 
-		std::vector<VkClearValue> clearValuesShadow = {};	//shadow map should be cleared every time
-		VkClearValue cv;
-		cv.depthStencil = { 1.0f, 0 };
-		clearValuesShadow.push_back(cv);
+		deleteCmdBuffers();
+	}
 
-		std::vector<VkClearValue> clearValuesLight = {};	//render target and depth buffer should be cleared only first time
-		VkClearValue cv1, cv2;
-		cv1.color = { 0.0f, 0.0f, 0.0f, 1.0f };
-		clearValuesLight.push_back(cv1);
-		cv2.depthStencil = { 1.0f, 0 };
-		clearValuesLight.push_back(cv2);
 
-		//go through all active lights in the scene
+	/**
+	*
+	* \brief Switch the depth pre-pass on or off
+	*
+	* With the depth pre-pass, all objects are first drawn into the depth map with the position only shadow PSO.
+	* The light passes then test with VK_COMPARE_OP_EQUAL and do not write depth, so each pixel is shaded only once
+	* per light. Since the subrenderers need other PSOs, they are recreated.
+	*
+	* \param[in] prepass If true then draw a depth pre-pass before the light passes
+	*
+	*/
+	void VERendererForward::setDepthPrepass(bool prepass) {
+		if (m_depthPrepass == prepass) return;
 
-		std::chrono::high_resolution_clock::time_point t_now;
+		vkDeviceWaitIdle(m_device);
 
-		for (uint32_t i = 0; i < getSceneManagerPointer()->getLights().size(); i++) {
+		m_depthPrepass = prepass;
+		for (auto pSub : m_subrenderers) pSub->recreateResources();
+		if (m_subrenderShadow != nullptr) m_subrenderShadow->recreateResources();
 
-			VELight * pLight = getSceneManagerPointer()->getLights()[i];
+		deleteCmdBuffers();
+	}
 
-			//-----------------------------------------------------------------------------------------
-			//shadow passes
 
-			t_now = vh::vhTimeNow();
-			{
-				for (unsigned i = 0; i < pLight->m_shadowCameras.size(); i++) {
+	/**
+	*
+	* \brief Switch wireframe drawing of objects on or off
+	*
+	* The object subrenderers request the line variants of their PSOs from the PSO registry, so they are recreated.
+	* Nothing happens if the device cannot draw lines.
+	*
+	* \param[in] wireframe If true then objects are drawn as wireframes
+	*
+	*/
+	void VERendererForward::setWireframe(bool wireframe) {
+		wireframe = wireframe && m_wireframeSupported;
+		if (m_wireframe == wireframe) return;
 
-					vh::vhRenderBeginRenderPass(m_commandBuffers[imageIndex],
-						m_renderPassShadow,
-						m_shadowFramebuffers[imageIndex][i],
-						clearValuesShadow,
-						m_shadowMaps[0][i]->m_extent);	//all shadow maps have the same extent
+		vkDeviceWaitIdle(m_device);
 
-					m_subrenderShadow->draw(m_commandBuffers[imageIndex], imageIndex, i, pLight->m_shadowCameras[i], pLight, {});
+		m_wireframe = wireframe;
+		for (auto pSub : m_subrenderers) pSub->recreateResources();
 
-					vkCmdEndRenderPass(m_commandBuffers[imageIndex]);
-				}
-			}
-			m_AvgCmdShadowTime = vh::vhAverage( vh::vhTimeDuration(t_now), m_AvgCmdShadowTime );
+		deleteCmdBuffers();
+	}
 
-			//-----------------------------------------------------------------------------------------
-			//light pass
 
-			t_now = vh::vhTimeNow();
-			{
-				vh::vhRenderBeginRenderPass(m_commandBuffers[imageIndex],
-					i == 0 ? m_renderPassClear : m_renderPassLoad,
-					m_swapChainFramebuffers[imageIndex],
-					clearValuesLight,
-					m_swapChainExtent);
+	/**
+	*
+	* \brief Describe the PSO of an object subrenderer for the light passes
+	*
+	* After a depth pre-pass, light passes only shade the visible surface and keep the depth map. Light passes draw into
+	* the render area, limited to the screen area and depth range of the light volume. Subrenderers can change the
+	* returned key to get their own variants from the PSO registry.
+	*
+	* \param[in] shaderFileNames The vertex and fragment shader files
+	* \param[in] pipelineLayout The pipeline layout of the subrenderer
+	* \returns the key describing the PSO
+	*
+	*/
+	vePipelineKey_t VERendererForward::getLightPassPipelineKey(std::vector<std::string> shaderFileNames, VkPipelineLayout pipelineLayout) {
+		vePipelineKey_t key;
+		key.type = VE_PIPELINE_TYPE_LIGHT_PASS;
+		key.shaderFileNames = shaderFileNames;
+		key.pipelineLayout = pipelineLayout;
+		key.renderPass = m_renderPassClear;
+		key.depthCompareOp = m_depthPrepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS_OR_EQUAL;
+		key.depthWriteEnable = m_depthPrepass ? VK_FALSE : VK_TRUE;
+		key.polygonMode = m_wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+		if (m_depthBoundsSupported) key.dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_BOUNDS);
+		return key;
+	}
 
-				for (auto pSub : m_subrenderers) {
-					if (i == 0 || pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_OBJECT) {
-						pSub->prepareDraw();
-						pSub->draw(m_commandBuffers[imageIndex], imageIndex, i, pCamera, pLight, m_descriptorSetsShadow);
-					}
-				}
 
-				vkCmdEndRenderPass(m_commandBuffers[imageIndex]);
+	/**
+	*
+	* \brief Get the light pass PSOs of the material uber shader
+	*
+	* All textured objects are drawn by shader/Forward/Material, whose features are specialization constants:
+	* 0 normal map, 1 light type, 2 number of cascades, 3 clustered lighting. Each light type gets a PSO that contains
+	* only the code of this type, so the fragment shader does not branch on the light. If the renderer uses clustered
+	* lighting, the clustered variants follow. All PSOs come from the same SPIR-V module and the pipeline cache.
+	* With bindless textures, the fragment shader reads its textures from the bindless table in set 4.
+	* With push constants, the fragment shader reads the material index from the push constant block instead of set 3.
+	* The PSOs must be released through the registry.
+	*
+	* \param[in] normalMap If true then the material has a normal map in binding 1 of its resource set
+	* \param[in] pipelineLayout The pipeline layout of the subrenderer
+	* \returns the PSOs, use getMaterialPipelineIndex() to choose one for a light
+	*
+	*/
+	std::vector<VkPipeline> VERendererForward::acquireMaterialPipelines(bool normalMap, VkPipelineLayout pipelineLayout) {
+		std::string suffix = m_pushConstants ? "_push.spv" : ".spv";
+		vePipelineKey_t key = getLightPassPipelineKey(
+			{ "shader/Forward/Material/vert.spv", (m_bindlessTextures ? "shader/Forward/Material/frag_bindless" : "shader/Forward/Material/frag") + suffix },
+			pipelineLayout);
+		key.dynamicStates.push_back(VK_DYNAMIC_STATE_BLEND_CONSTANTS);
+
+		std::vector<VkPipeline> pipelines;
+		uint32_t numVariants = m_clusteredLighting ? 2 : 1;
+		for (uint32_t clustered = 0; clustered < numVariants; clustered++) {
+			for (uint32_t lightType = 0; lightType < NUM_LIGHT_TYPES; lightType++) {
+				key.specializationConstants = { normalMap ? 1u : 0u, lightType, NUM_DIRECTIONAL_CASCADE, clustered };
+				pipelines.push_back(m_pipelineRegistry->acquirePipeline(key));
 			}
-			m_AvgCmdLightTime = vh::vhAverage( vh::vhTimeDuration(t_now), m_AvgCmdLightTime );
-
-			clearValuesLight.clear();		//since we blend the images onto each other, do not clear them for passes 2 and further
 		}
+		return pipelines;
+	}
 
-		vkEndCommandBuffer(m_commandBuffers[imageIndex]);
 
-		m_overlaySemaphores[m_currentFrame] = m_renderFinishedSemaphores[m_currentFrame];
+	/**
+	*
+	* \brief Choose the material PSO for a light pass
+	*
+	* \param[in] pLight The light of the light pass, or nullptr
+	* \returns the index into the PSOs returned by acquireMaterialPipelines()
+	*
+	*/
+	uint32_t VERendererForward::getMaterialPipelineIndex(VELight *pLight) {
+		uint32_t idx = pLight != nullptr ? (uint32_t)pLight->getLightType() : (uint32_t)VELight::VE_LIGHT_TYPE_DIRECTIONAL;
+		if (m_clusteredLighting) idx += NUM_LIGHT_TYPES;
+		return idx;
 	}
 
 
 	/**
-	* \brief Draw the frame.
 	*
-	*- wait for draw completion using a fence, so there is at least one frame in the swapchain
-	*- acquire the next image from the swap chain
-	*- if there is no command buffer yet, record one with the current scene
-	*- submit it to the queue
+	* \brief Switch single pass cube shadow maps for point lights on or off
+	*
+	* If on, the shadow subrenderer draws each shadow caster only once into a layered cube shadow map, using
+	* a multiview render pass that broadcasts the draw to all 6 faces. Casters outside of a face are culled
+	* per face in the vertex shader. If off, or if the device does not support multiview, point lights draw
+	* 6 separate passes into the shadow atlas. Since the shadow subrenderer needs another PSO, it is recreated.
+	*
+	* \param[in] cubeShadows If true then point lights use the cube shadow map
+	*
 	*/
-	void VERendererForward::drawFrame() {
-		vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+	void VERendererForward::setCubeShadows(bool cubeShadows) {
+		cubeShadows = cubeShadows && m_multiviewSupported;
+		if (m_cubeShadows == cubeShadows) return;
 
-		//acquire the next image
-		VkResult result = vkAcquireNextImageKHR(m_device, m_swapChain, std::numeric_limits<uint64_t>::max(),
-												m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
-
-		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-			recreateSwapchain();
-			return;
-		}
-		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-			getEnginePointer()->fatalError("Failed to acquire swap chain image!");
-		}
+		vkDeviceWaitIdle(m_device);
 
-		if (m_commandBuffers[imageIndex] == VK_NULL_HANDLE ) {
-			recordCmdBuffers();
-		}
+		m_cubeShadows = cubeShadows;
+		if (m_subrenderShadow != nullptr) m_subrenderShadow->recreateResources();
 
-		//submit the command buffers
-		vh::vhCmdSubmitCommandBuffer(	m_device, m_graphicsQueue, m_commandBuffers[imageIndex],
-										m_imageAvailableSemaphores[m_currentFrame],
-										m_renderFinishedSemaphores[m_currentFrame],
-										m_inFlightFences[m_currentFrame]);
+		deleteCmdBuffers();
 	}
 
 
 	/**
-	* \brief Prepare to creat an overlay, e.g. initialize the next frame
+	*
+	* \brief Switch bindless textures on or off
+	*
+	* If on, the material subrenderers bind the bindless table once per frame as set 4 and find the textures of an entity
+	* through the material index in its UBO, so entities do not have descriptor sets for their textures. If off, or if
+	* the device does not support descriptor indexing, each entity binds its own texture descriptor set.
+	* The subrenderers need other PSOs and descriptor sets, so they are recreated.
+	*
+	* \param[in] bindless If true then the material subrenderers use the bindless table
+	*
 	*/
-	void VERendererForward::prepareOverlay() {
-		if (m_subrenderOverlay == nullptr) return;
-		m_subrenderOverlay->prepareDraw();
+	void VERendererForward::setBindlessTextures(bool bindless) {
+		bindless = bindless && m_bindlessSupported;
+		if (m_bindlessTextures == bindless) return;
+
+		vkDeviceWaitIdle(m_device);
+
+		m_bindlessTextures = bindless;
+		for (auto pSub : m_subrenderers) pSub->recreateResources();
+
+		deleteCmdBuffers();
 	}
 
 
 	/**
-	* \brief Draw the overlay into the current frame buffer
+	*
+	* \brief Switch the push constant path for the per object data on or off
+	*
+	* If on, the material subrenderers push the material index of each entity with vkCmdPushConstants, so the fragment
+	* shader does not have to read it from the UBO in set 3. The transforms, color and parameters stay in the UBO, which
+	* is still bound for each draw call. Since pushed values are recorded into the command buffers, only an entity that
+	* gets another material invalidates the buffers of its subrenderer, moving entities do not. If off, or if the push
+	* constant limit of the device is too small, the UBO is used. The subrenderers need other PSOs, so they are recreated.
+	* The path is on by default.
+	*
+	* \param[in] pushConstants If true then the material subrenderers push the per object data
+	*
 	*/
-	void VERendererForward::drawOverlay() {
-		if (m_subrenderOverlay == nullptr) return;
+	void VERendererForward::setPushConstants(bool pushConstants) {
+		pushConstants = pushConstants && m_pushConstantsSupported;
+		if (m_pushConstants == pushConstants) return;
+
+		vkDeviceWaitIdle(m_device);
+
+		m_pushConstants = pushConstants;
+		for (auto pSub : m_subrenderers) pSub->recreateResources();
+
+		deleteCmdBuffers();
+	}
 
-		m_overlaySemaphores[m_currentFrame] = m_subrenderOverlay->draw( imageIndex, m_renderFinishedSemaphores[m_currentFrame]);
+
+	/**
+	*
+	* \brief Get the push constant ranges of the material pipeline layouts
+	*
+	* \returns the range of the per object data, or an empty list if the push constant path is off
+	*
+	*/
+	std::vector<VkPushConstantRange> VERendererForward::getPushConstantRanges() {
+		if (!m_pushConstants) return {};
+
+		VkPushConstantRange range = {};
+		range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		range.offset = 0;
+		range.size = sizeof(VEEntity::vePushConstantsPerObject_t);
+		return { range };
 	}
 
 
 	/**
-	* \brief Present the new frame.
+	*
+	* \brief Switch dynamic resolution on or off
+	*
+	* With dynamic resolution, the light passes draw into the upper left corner of an offscreen color map, whose size
+	* is the swapchain extent times the render scale. The render area is then upscaled into the swapchain image with
+	* a bilinear filter, before the overlay is drawn at full resolution. Each frame, the render scale is adapted to the
+	* measured GPU time, so that it stays below the render time budget.
+	* Since the light pass buffers are recorded for another framebuffer, they are recorded again.
+	*
+	* \param[in] dynamicResolution If true then adapt the render scale to the render time budget, else draw at full resolution
+	*
 	*/
-	void VERendererForward::presentFrame() {
+	void VERendererForward::setDynamicResolution(bool dynamicResolution) {
+		if (m_dynamicResolution == dynamicResolution) return;
+
+		vkDeviceWaitIdle(m_device);
 
-		vh::vhBufTransitionImageLayout(m_device, m_graphicsQueue, m_commandPool,				//transition the image layout to 
-			getSwapChainImage(), VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1,		//VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		m_dynamicResolution = dynamicResolution;
+		m_renderScale = dynamicResolution ? m_maxRenderScale : 1.0f;
+		m_renderScaleSettle = 0;
 
+		deleteCmdBuffers();
+	}
+
+
+	/**
+	*
+	* \brief Set the GPU time a frame may take with dynamic resolution
+	*
+	* \param[in] budget The GPU time budget of a frame (s), e.g. 1/60 for 60 Hz
+	*
+	*/
+	void VERendererForward::setRenderTimeBudget(float budget) {
+		m_renderTimeBudget = std::max(budget, 0.0f);
+	}
+
+
+	/**
+	*
+	* \brief Set the range the render scale of dynamic resolution is chosen from
+	*
+	* \param[in] minScale The smallest render scale, at least RENDER_SCALE_STEP
+	* \param[in] maxScale The largest render scale, at most 1
+	*
+	*/
+	void VERendererForward::setRenderScaleRange(float minScale, float maxScale) {
+		m_maxRenderScale = glm::clamp(maxScale, RENDER_SCALE_STEP, 1.0f);
+		m_minRenderScale = glm::clamp(minScale, RENDER_SCALE_STEP, m_maxRenderScale);
+		if (m_dynamicResolution) m_renderScale = glm::clamp(m_renderScale, m_minRenderScale, m_maxRenderScale);
+	}
+
+
+	/**
+	*
+	* \brief Find out whether a light draws its shadow into the cube shadow map
+	*
+	* \param[in] pLight Pointer to the light
+	* \returns true if cube shadows are on and the light is a point light
+	*
+	*/
+	bool VERendererForward::usesCubeShadow(VELight *pLight) {
+		return m_cubeShadows && pLight->getLightType() == VELight::VE_LIGHT_TYPE_POINT;
+	}
+
+
+	/**
+	*
+	* \brief Get the number of light passes
+	*
+	* \returns one pass for each light, or at most one pass if clustered lighting is used
+	*
+	*/
+	uint32_t VERendererForward::getNumLightPasses() {
+		uint32_t numLights = (uint32_t)getSceneManagerPointer()->getLights().size();
+		if (m_clusteredLighting) return std::min(numLights, 1u);
+		return numLights;
+	}
+
+
+	/**
+	*
+	* \brief Assign all lights except the first one to light clusters, and copy them to the cluster buffer
+	*
+	* The view frustum is divided into CLUSTER_DIM_X x CLUSTER_DIM_Y screen tiles and CLUSTER_DIM_Z exponential
+	* depth slices. A point or spot light is added to all clusters that overlap with the bounding box of its reach,
+	* a directional light is added to all clusters. The first light is not added, since it is drawn with shadow
+	* using the light UBO.
+	*
+	*/
+	void VERendererForward::updateClusterBuffer() {
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+
+		glm::mat4 view = glm::inverse(pCamera->getWorldTransform());
+		glm::mat4 proj = pCamera->getProjectionMatrix();
+		float nearPlane = pCamera->m_nearPlane;
+		float farPlane = pCamera->m_farPlane;
+		float logRatio = log(farPlane / nearPlane);
+
+		auto depthSlice = [&](float z) -> uint32_t {
+			if (z <= nearPlane) return 0;
+			float slice = log(z / nearPlane) / logRatio * CLUSTER_DIM_Z;
+			return (uint32_t)glm::clamp(slice, 0.0f, (float)(CLUSTER_DIM_Z - 1));
+		};
+
+		auto screenTile = [](float ndc, uint32_t dim) -> uint32_t {
+			float tile = (ndc * 0.5f + 0.5f) * dim;
+			return (uint32_t)glm::clamp(tile, 0.0f, (float)(dim - 1));
+		};
+
+		for (auto &list : m_clusterLightLists) list.clear();
+
+		//map the buffer, it contains a header, the lights, the clusters and the light indices
+
+		void *data = nullptr;
+		vmaMapMemory(m_vmaAllocator, m_clusterBuffersAllocation[m_frameIndex], &data);
+
+		glm::uvec4 *pDims = (glm::uvec4*)data;
+		glm::vec4 *pParam = (glm::vec4*)(pDims + 1);
+		veClusterLight_t *pLights = (veClusterLight_t*)(pParam + 1);
+		glm::uvec2 *pClusters = (glm::uvec2*)(pLights + MAX_CLUSTER_LIGHTS);
+		uint32_t *pIndices = (uint32_t*)(pClusters + NUM_CLUSTERS);
+
+		uint32_t numLights = 0;
+		for (uint32_t i = 1; i < lights.size() && numLights < MAX_CLUSTER_LIGHTS; i++) {
+			VELight *pLight = lights[i];
+			glm::mat4 W = pLight->getWorldTransform();
+			float reach = pLight->m_param[0];
+
+			uint32_t minX = 0, maxX = CLUSTER_DIM_X - 1;
+			uint32_t minY = 0, maxY = CLUSTER_DIM_Y - 1;
+			uint32_t minZ = 0, maxZ = CLUSTER_DIM_Z - 1;
+
+			if (pLight->getLightType() != VELight::VE_LIGHT_TYPE_DIRECTIONAL) {
+				glm::vec3 centerV = glm::vec3(view * W[3]);
+				if (centerV.z + reach < nearPlane || centerV.z - reach > farPlane) continue;	//outside of the frustum
+
+				minZ = depthSlice(centerV.z - reach);
+				maxZ = depthSlice(centerV.z + reach);
+
+				if (centerV.z - reach > nearPlane) {		//box completely in front of the camera, project its corners
+					glm::vec2 ndcMin(std::numeric_limits<float>::max());
+					glm::vec2 ndcMax(-std::numeric_limits<float>::max());
+					for (uint32_t c = 0; c < 8; c++) {
+						glm::vec3 corner = centerV + reach * glm::vec3(c & 1 ? 1.0f : -1.0f, c & 2 ? 1.0f : -1.0f, c & 4 ? 1.0f : -1.0f);
+						glm::vec4 clip = proj * glm::vec4(corner, 1.0f);
+						glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+						ndcMin = glm::min(ndcMin, ndc);
+						ndcMax = glm::max(ndcMax, ndc);
+					}
+					if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) continue;	//outside of the screen
+
+					minX = screenTile(ndcMin.x, CLUSTER_DIM_X);
+					maxX = screenTile(ndcMax.x, CLUSTER_DIM_X);
+					minY = screenTile(ndcMin.y, CLUSTER_DIM_Y);
+					maxY = screenTile(ndcMax.y, CLUSTER_DIM_Y);
+				}
+			}
+
+			veClusterLight_t &cl = pLights[numLights];
+			glm::vec3 dir = glm::normalize(glm::vec3(W[2]));
+			cl.posRadius = glm::vec4(W[3].x, W[3].y, W[3].z, reach);
+			cl.dirType = glm::vec4(dir, (float)pLight->getLightType());
+			cl.col_ambient = pLight->m_col_ambient;
+			cl.col_diffuse = pLight->m_col_diffuse;
+			cl.col_specular = pLight->m_col_specular;
+
+			for (uint32_t z = minZ; z <= maxZ; z++) {
+				for (uint32_t y = minY; y <= maxY; y++) {
+					for (uint32_t x = minX; x <= maxX; x++) {
+						m_clusterLightLists[(z*CLUSTER_DIM_Y + y)*CLUSTER_DIM_X + x].push_back(numLights);
+					}
+				}
+			}
+			numLights++;
+		}
+
+		//write the clusters and their light index lists
+
+		uint32_t offset = 0;
+		for (uint32_t c = 0; c < NUM_CLUSTERS; c++) {
+			uint32_t count = std::min((uint32_t)m_clusterLightLists[c].size(), MAX_CLUSTER_LIGHT_INDICES - offset);
+			if (count > 0) memcpy(pIndices + offset, m_clusterLightLists[c].data(), count * sizeof(uint32_t));
+			pClusters[c] = glm::uvec2(offset, count);
+			offset += count;
+		}
+
+		*pDims = glm::uvec4(CLUSTER_DIM_X, CLUSTER_DIM_Y, CLUSTER_DIM_Z, numLights);
+		//the shader finds the screen tile from gl_FragCoord, which is in pixels of the render area
+		*pParam = glm::vec4(nearPlane, farPlane, (float)m_renderExtent.width, (float)m_renderExtent.height);
+
+		vmaUnmapMemory(m_vmaAllocator, m_clusterBuffersAllocation[m_frameIndex]);
+	}
+
+
+	/**
+	*
+	* \brief Compute the screen area and the lit entities of all light passes of this frame
+	*
+	* The first light pass draws everything, since it also clears the framebuffer. The following additive passes
+	* of point and spot lights only draw the entities their light can reach, and get a scissor around the
+	* screen projection of the light volume. If the device supports it, they also get the depth range of the
+	* light volume, so that only pixels whose depth is inside of it are shaded. Scissors are snapped outwards to
+	* LIGHT_SCISSOR_GRID pixels, so small movements do not cause the buffers to be recorded again.
+	* The lit entities are only searched again if the light volume or the entity lists have changed. Otherwise
+	* only the entities that have moved or were switched on or off since the last search are tested again.
+	*
+	*/
+	void VERendererForward::updateLightPasses() {
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+		VkRect2D fullScreen = { { 0, 0 }, m_renderExtent };
+
+		//the versions only increase, so their sum changes whenever an entity is added or removed
+		uint64_t entitiesVersion = 0;
+		for (auto pSub : m_subrenderers) {
+			if (pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_OBJECT) entitiesVersion += pSub->getEntitiesVersion();
+		}
+
+		m_lightPasses.resize(getNumLightPasses());
+		for (uint32_t i = 0; i < m_lightPasses.size(); i++) {
+			veLightPass_t &pass = m_lightPasses[i];
+			pass.scissor = fullScreen;
+			pass.minDepth = 0.0f;
+			pass.maxDepth = 1.0f;
+
+			glm::vec3 center;
+			float radius;
+			if (i == 0 || m_clusteredLighting || !lights[i]->getLightVolume(&center, &radius)) {
+				pass.litEntities.clear();
+				pass.culled = false;
+				continue;
+			}
+
+			//entities the light can reach
+			glm::vec4 volume(center, radius);
+			if (!pass.culled || pass.volume != volume || pass.entitiesVersion != entitiesVersion) {
+				pass.litEntities.clear();
+				for (auto pSub : m_subrenderers) {
+					if (pSub->getClass() != VESubrender::VE_SUBRENDERER_CLASS_OBJECT) continue;
+					for (auto pEntity : pSub->getEntities()) {
+						if (pEntity->getDrawEntity() && lights[i]->lightsEntity(pEntity)) pass.litEntities.push_back(pEntity);
+					}
+				}
+				std::sort(pass.litEntities.begin(), pass.litEntities.end());
+			}
+			else if (pass.boundsVersion != VEEntity::s_boundsVersion) {
+				for (auto pSub : m_subrenderers) {
+					if (pSub->getClass() != VESubrender::VE_SUBRENDERER_CLASS_OBJECT) continue;
+					for (auto pEntity : pSub->getEntities()) {
+						if (pEntity->m_boundsVersion <= pass.boundsVersion) continue;
+
+						bool lit = pEntity->getDrawEntity() && lights[i]->lightsEntity(pEntity);
+						auto it = std::lower_bound(pass.litEntities.begin(), pass.litEntities.end(), pEntity);
+						bool listed = it != pass.litEntities.end() && *it == pEntity;
+						if (lit && !listed) pass.litEntities.insert(it, pEntity);
+						if (!lit && listed) pass.litEntities.erase(it);
+					}
+				}
+			}
+			pass.culled = true;
+			pass.volume = volume;
+			pass.entitiesVersion = entitiesVersion;
+			pass.boundsVersion = VEEntity::s_boundsVersion;
+
+			//project the bounding box of the light sphere onto the screen
+			glm::mat4 viewProj = pCamera->m_ubo.proj * pCamera->m_ubo.view;
+			glm::vec3 minNDC(1.0f), maxNDC(-1.0f);
+			bool inside = false;		//camera is (almost) inside the box
+			for (uint32_t k = 0; k < 8; k++) {
+				glm::vec3 corner = center + radius * glm::vec3(k & 1 ? 1.0f : -1.0f, k & 2 ? 1.0f : -1.0f, k & 4 ? 1.0f : -1.0f);
+				glm::vec4 clip = viewProj * glm::vec4(corner, 1.0f);
+				if (clip.w <= pCamera->m_nearPlane) {
+					inside = true;
+					break;
+				}
+				glm::vec3 ndc = glm::vec3(clip.x, clip.y, clip.z) / clip.w;
+				minNDC = glm::min(minNDC, ndc);
+				maxNDC = glm::max(maxNDC, ndc);
+			}
+			if (inside) continue;
+
+			int32_t grid = (int32_t)LIGHT_SCISSOR_GRID;
+			int32_t width = (int32_t)m_renderExtent.width;
+			int32_t height = (int32_t)m_renderExtent.height;
+			int32_t x0 = std::max((int32_t)std::floor((minNDC.x * 0.5f + 0.5f) * width / grid) * grid, 0);
+			int32_t y0 = std::max((int32_t)std::floor((minNDC.y * 0.5f + 0.5f) * height / grid) * grid, 0);
+			int32_t x1 = std::min((int32_t)std::ceil((maxNDC.x * 0.5f + 0.5f) * width / grid) * grid, width);
+			int32_t y1 = std::min((int32_t)std::ceil((maxNDC.y * 0.5f + 0.5f) * height / grid) * grid, height);
+
+			pass.scissor.offset = { std::min(x0, width), std::min(y0, height) };
+			pass.scissor.extent = { (uint32_t)std::max(x1 - pass.scissor.offset.x, 0), (uint32_t)std::max(y1 - pass.scissor.offset.y, 0) };
+
+			if (m_depthBoundsSupported) {
+				pass.minDepth = std::floor(glm::clamp(minNDC.z, 0.0f, 1.0f) * 65536.0f) / 65536.0f;
+				pass.maxDepth = std::ceil(glm::clamp(maxNDC.z, 0.0f, 1.0f) * 65536.0f) / 65536.0f;
+			}
+		}
+	}
+
+
+	/**
+	*
+	* \brief Find out whether a light pass draws an entity
+	*
+	* Is called by the subrenderers while recording, so the lit entities found by updateLightPasses() are drawn
+	* without testing them against the light again.
+	*
+	* \param[in] numPass The number of the light pass
+	* \param[in] pEntity Pointer to the entity
+	* \returns true if the entity is in the lit entities of the pass, or if the pass is not culled
+	*
+	*/
+	bool VERendererForward::passLightsEntity(uint32_t numPass, VEEntity *pEntity) {
+		if (numPass >= m_lightPasses.size() || !m_lightPasses[numPass].culled) return true;
+
+		std::vector<VEEntity*> &litEntities = m_lightPasses[numPass].litEntities;
+		return std::binary_search(litEntities.begin(), litEntities.end(), pEntity);
+	}
+
+
+	/**
+	*
+	* \brief Find out whether the light passes have changed since the current frame was recorded
+	*
+	* \returns true if the screen area or the lit entities of a light pass have changed
+	*
+	*/
+	bool VERendererForward::lightPassesChanged() {
+		return m_lightPasses != m_lightPassesRecorded[m_frameIndex];
+	}
+
+
+	/**
+	*
+	* \brief Set the viewport, scissor and depth bounds of a light pass in a secondary command buffer
+	*
+	* Is called by the light pass subrenderers, whose PSOs have these dynamic states. The viewport is the render area,
+	* which is smaller than the swapchain extent if dynamic resolution is on.
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] numPass The number of the light pass, passes without data get the whole render area
+	*
+	*/
+	void VERendererForward::setLightPassState(VkCommandBuffer commandBuffer, uint32_t numPass) {
+		VkRect2D scissor = { { 0, 0 }, m_renderExtent };
+		float minDepth = 0.0f, maxDepth = 1.0f;
+		if (numPass < m_lightPasses.size()) {		//no copy, the pass holds the list of lit entities
+			scissor = m_lightPasses[numPass].scissor;
+			minDepth = m_lightPasses[numPass].minDepth;
+			maxDepth = m_lightPasses[numPass].maxDepth;
+		}
+
+		VkViewport viewport = { 0.0f, 0.0f, (float)m_renderExtent.width, (float)m_renderExtent.height, 0.0f, 1.0f };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		if (m_depthBoundsSupported) vkCmdSetDepthBounds(commandBuffer, minDepth, maxDepth);
+	}
+
+
+	/**
+	*
+	* \brief Measure the GPU time of the last use of the current frame in flight and adapt the render scale to the budget
+	*
+	* The GPU time is read from the timestamps of the frame's command buffer, whose fence has already been waited for.
+	* Without timestamps, the frame time measured by the engine is used instead. If dynamic resolution is on and the
+	* average time is over the budget, the scale is lowered at once to the step that should meet the budget, since GPU
+	* time grows with the number of pixels. If the time is below RENDER_SCALE_HEADROOM of the budget, the scale is
+	* raised by one step. After a change, the scale is kept for RENDER_SCALE_SETTLE_FRAMES frames plus the number of
+	* frames in flight, until the measured times belong to the new scale. Each frame is added to the history.
+	*
+	*/
+	void VERendererForward::updateRenderScale() {
+		float renderTime = 0.0f;
+		if (m_timestampPool != VK_NULL_HANDLE && m_timestampsWritten[m_frameIndex]) {
+			uint64_t timestamps[2];
+			if (vkGetQueryPoolResults(	m_device, m_timestampPool, 2 * m_frameIndex, 2, sizeof(timestamps), timestamps,
+										sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+				renderTime = (float)(timestamps[1] - timestamps[0]) * m_timestampPeriod * 1.0e-9f;
+			}
+		}
+		else if (m_timestampPool == VK_NULL_HANDLE) {
+			renderTime = getEnginePointer()->getAvgFrameTime();
+		}
+		if (renderTime > 0.0f) m_renderTime = m_renderTime > 0.0f ? vh::vhAverage(renderTime, m_renderTime) : renderTime;
+
+		if (!m_dynamicResolution) {
+			m_renderScale = 1.0f;
+		}
+		else if (m_renderScaleSettle > 0) {
+			m_renderScaleSettle--;
+		}
+		else if (m_renderTime > 0.0f) {
+			float scale = m_renderScale;
+			if (m_renderTime > m_renderTimeBudget) {
+				scale = std::floor(m_renderScale * std::sqrt(m_renderTimeBudget / m_renderTime) / RENDER_SCALE_STEP) * RENDER_SCALE_STEP;
+			}
+			else if (m_renderTime < RENDER_SCALE_HEADROOM * m_renderTimeBudget) {
+				scale = m_renderScale + RENDER_SCALE_STEP;
+			}
+			scale = glm::clamp(scale, m_minRenderScale, m_maxRenderScale);
+
+			if (scale != m_renderScale) {
+				m_renderScale = scale;
+				m_renderScaleSettle = RENDER_SCALE_SETTLE_FRAMES + m_framesInFlight;
+			}
+		}
+
+		m_renderExtent = {	std::max((uint32_t)std::round(m_swapChainExtent.width * m_renderScale), 1u),
+							std::max((uint32_t)std::round(m_swapChainExtent.height * m_renderScale), 1u) };
+
+		m_renderScaleHistory.push_back({ renderTime, m_renderScale });
+		if (m_renderScaleHistory.size() > RENDER_SCALE_HISTORY) m_renderScaleHistory.erase(m_renderScaleHistory.begin());
+	}
+
+
+	/**
+	*
+	* \brief Find out whether the render extent has changed since the current frame was recorded
+	*
+	* \returns true if the light pass buffers of the current frame were recorded with another viewport
+	*
+	*/
+	bool VERendererForward::renderExtentChanged() {
+		return	m_renderExtentRecorded[m_frameIndex].width != m_renderExtent.width ||
+				m_renderExtentRecorded[m_frameIndex].height != m_renderExtent.height;
+	}
+
+
+	/**
+	*
+	* \brief Get the framebuffer the light passes of a swapchain image draw into
+	*
+	* \param[in] imageIndex Index of the swapchain image
+	* \returns the color map framebuffer if dynamic resolution is on, else the framebuffer of the swapchain image
+	*
+	*/
+	VkFramebuffer VERendererForward::getLightFramebuffer(uint32_t imageIndex) {
+		return m_dynamicResolution ? m_colorMapFramebuffer : m_swapChainFramebuffers[imageIndex];
+	}
+
+
+	/**
+	*
+	* \brief Find out whether the current frame in flight must be recorded again
+	*
+	* \returns true if the shadow subrenderer or any light pass subrenderer has outdated secondary command buffers,
+	* if the shadow atlas tiles or the cache atlas tiles have changed, if the screen area or the lit entities
+	* of a light pass have changed, or if the render extent has changed
+	*
+	*/
+	bool VERendererForward::cmdBuffersDirty() {
+		if (m_subrenderShadow != nullptr && m_subrenderShadow->cmdBuffersDirty(m_frameIndex)) return true;
+		if (m_subrenderShadow != nullptr && shadowTilesChanged()) return true;
+		if (m_shadowCacheTilesRecorded[m_frameIndex] != m_shadowCacheTilesVersion) return true;
+		if (lightPassesChanged()) return true;
+		if (renderExtentChanged()) return true;
+		for (auto pSub : m_subrenderers) {
+			if (pSub->cmdBuffersDirty(m_frameIndex)) return true;
+		}
+		return false;
+	}
+
+
+	/**
+	*
+	* \brief Free the outdated secondary command buffers of all light pass subrenderers for the current frame
+	*
+	* The recording jobs allocate their buffers from the per thread command pools of the frame in flight,
+	* and a pool must not be used by two threads at the same time. So all buffers are freed here, before the first job
+	* of the light passes is submitted, and not while the jobs of other subrenderers are already running.
+	*
+	*/
+	void VERendererForward::freeOutdatedCmdBuffers() {
+		for (auto pSub : m_subrenderers) {
+			if (pSub->cmdBuffersDirty(m_frameIndex)) pSub->deleteCmdBuffers(m_frameIndex);
+		}
+	}
+
+
+	/**
+	*
+	* \brief Get the command pool of the calling thread for a frame in flight
+	*
+	* Command pools must not be used by two threads at the same time, thus each recording thread
+	* gets its own pool for each frame in flight. Pools are created the first time a thread asks for one.
+	*
+	* \param[in] frameIndex Index of the frame in flight the recorded buffers are used for
+	* \returns the command pool of this thread
+	*
+	*/
+	VkCommandPool VERendererForward::getThreadCommandPool(uint32_t frameIndex) {
+		std::lock_guard<std::mutex> lock(m_commandPoolsMutex);
+
+		std::thread::id threadId = std::this_thread::get_id();
+		if (m_threadSlots.count(threadId) == 0) {
+			uint32_t slot = (uint32_t)m_threadSlots.size();
+			m_threadSlots[threadId] = slot;
+		}
+		uint32_t slot = m_threadSlots[threadId];
+
+		if (m_commandPoolsThread.size() <= frameIndex) m_commandPoolsThread.resize(frameIndex + 1);
+		std::vector<VkCommandPool> &pools = m_commandPoolsThread[frameIndex];
+		if (pools.size() <= slot) pools.resize(slot + 1, VK_NULL_HANDLE);
+
+		if (pools[slot] == VK_NULL_HANDLE) {
+			VECHECKRESULT(vh::vhCmdCreateCommandPool(m_physicalDevice, m_device, m_surface, &pools[slot]), "Failed to create thread command pool!");
+		}
+		return pools[slot];
+	}
+
+
+	/**
+	*
+	* \brief Create a secondary command buffer and begin recording it for a given render pass
+	*
+	* \param[in] commandPool The command pool of the recording thread
+	* \param[in] renderPass The render pass the buffer will be executed in
+	* \param[in] frameBuffer The framebuffer the render pass will use
+	* \returns the new secondary command buffer, ready for recording
+	*
+	*/
+	VkCommandBuffer VERendererForward::createSecondaryCmdBuffer(VkCommandPool commandPool, VkRenderPass renderPass, VkFramebuffer frameBuffer) {
+		VkCommandBuffer commandBuffer;
+		vh::vhCmdCreateCommandBuffers(	m_device, commandPool,
+										VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+										1, &commandBuffer);
+
+		vh::vhCmdBeginCommandBuffer(m_device, renderPass, 0, frameBuffer, commandBuffer, VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+		return commandBuffer;
+	}
+
+
+	/**
+	*
+	* \brief Record the secondary command buffers of the shadow subrenderer for the current frame
+	*
+	* There is one buffer for each shadow camera of each light, light i and camera j is stored
+	* at index i*NUM_SHADOW_CASCADE + j. It sets the viewport to the atlas tile of the camera. If there are static
+	* shadow casters, this buffer draws only the dynamic casters, and a second list of the same size follows that
+	* draws the static casters into the same atlas tile, from where they are copied into the cache atlas.
+	* A point light using the cube shadow map records only one buffer at index i*NUM_SHADOW_CASCADE, drawing
+	* all casters once into all faces, and no static caster buffers.
+	* Each buffer is recorded by a job of the engine's thread pool, then the cameras get their tiles in the cache atlas.
+	* Nothing is done if the cached buffers are still up to date and no light got new atlas tiles.
+	*
+	* \param[out] futures The futures of the submitted jobs are appended to this list
+	*
+	*/
+	void VERendererForward::recordCmdBuffersShadow(veFrameVector<std::future<void>> &futures) {
+		if (m_subrenderShadow == nullptr) return;
+		m_subrenderShadow->waitForPipelines();		//also used by the depth pre-pass
+		if (!m_subrenderShadow->cmdBuffersDirty(m_frameIndex) && !shadowTilesChanged()) {
+			m_shadowCacheTilesRecorded[m_frameIndex] = m_shadowCacheTilesVersion;
+			return;
+		}
+
+		m_subrenderShadow->deleteCmdBuffers(m_frameIndex);	//no recording job is running yet
+
+		//if there are static casters, they get their own buffers for drawing the cached maps
+		bool hasStaticCasters = false;
+		for (auto object : getSceneManagerPointer()->m_sceneNodes) {
+			if (object.second->getNodeType() != VESceneNode::VE_OBJECT_TYPE_ENTITY) continue;
+			VEEntity *pEntity = (VEEntity*)object.second;
+			if (pEntity->getDrawEntity() && pEntity->getCastsShadow() && pEntity->getStaticShadow()) {
+				hasStaticCasters = true;
+				break;
+			}
+		}
+
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+		std::vector<VESubrender::veSecondaryBuffer_t> &buffers = m_subrenderShadow->getSecondaryBuffers(m_frameIndex);
+		uint32_t numBuffers = (uint32_t)lights.size() * NUM_SHADOW_CASCADE;
+		for (uint32_t k = 0; k < (hasStaticCasters ? 2 * numBuffers : numBuffers); k++) {
+			buffers.push_back({ k, VK_NULL_HANDLE, VK_NULL_HANDLE });
+		}
+
+		m_shadowTilesRecorded[m_frameIndex].clear();
+		for (auto pLight : lights) m_shadowTilesRecorded[m_frameIndex].push_back(pLight->m_shadowTilesVersion);
+
+		uint32_t idx = m_frameIndex;
+		for (uint32_t i = 0; i < getNumLightPasses(); i++) {
+			VELight * pLight = lights[i];
+
+			if (usesCubeShadow(pLight)) {
+				VESubrender::veSecondaryBuffer_t *pBuffer = &buffers[i*NUM_SHADOW_CASCADE];
+
+				futures.push_back(getEnginePointer()->m_threadPool->submit([this, idx, pLight, pBuffer]() {
+					VkCommandPool commandPool = getThreadCommandPool(idx);
+					VkCommandBuffer commandBuffer = createSecondaryCmdBuffer(commandPool, m_renderPassCubeShadow, m_cubeShadowFramebuffer);
+
+					m_subrenderShadow->drawCubeShadow(commandBuffer, idx, pLight);
+
+					vkEndCommandBuffer(commandBuffer);
+					pBuffer->pool = commandPool;
+					pBuffer->buffer = commandBuffer;
+				}));
+				continue;
+			}
+
+			for (uint32_t j = 0; j < pLight->m_shadowCameras.size(); j++) {
+				for (uint32_t s = 0; s < (hasStaticCasters ? 2u : 1u); s++) {
+					VESubrender::veSecondaryBuffer_t *pBuffer = &buffers[s*numBuffers + i*NUM_SHADOW_CASCADE + j];
+					bool staticCasters = s > 0;
+
+					futures.push_back(getEnginePointer()->m_threadPool->submit([this, idx, pLight, j, pBuffer, hasStaticCasters, staticCasters]() {
+						VkCommandPool commandPool = getThreadCommandPool(idx);
+						VkCommandBuffer commandBuffer = createSecondaryCmdBuffer(commandPool, m_renderPassShadow, m_shadowAtlasFramebuffer);
+						vh::vhRenderSetViewport(commandBuffer, pLight->m_shadowTiles[j]);
+
+						if (hasStaticCasters)
+							m_subrenderShadow->drawShadowCasters(commandBuffer, idx, pLight->m_shadowCameras[j], pLight, staticCasters);
+						else
+							m_subrenderShadow->draw(commandBuffer, idx, j, pLight->m_shadowCameras[j], pLight, {});
+
+						vkEndCommandBuffer(commandBuffer);
+						pBuffer->pool = commandPool;
+						pBuffer->buffer = commandBuffer;
+					}));
+				}
+			}
+		}
+
+		m_subrenderShadow->setCmdBuffersRecorded(m_frameIndex);
+
+		updateShadowCacheTiles(hasStaticCasters);
+		m_shadowCacheTilesRecorded[m_frameIndex] = m_shadowCacheTilesVersion;
+	}
+
+
+	/**
+	*
+	* \brief Record the secondary command buffers of a light pass subrenderer for the current frame
+	*
+	* The entity list is cut into chunks of ENTITIES_PER_CMD_BUFFER entities, and each chunk of each light pass
+	* is recorded into its own buffer by a job of the engine's thread pool. Background subrenderers only
+	* draw in the first light pass. If the depth pre-pass is on, object subrenderers additionally record their
+	* chunks with the shadow subrenderer into buffers tagged DEPTH_PREPASS_PASS. Nothing is done if the cached
+	* buffers are still up to date. The outdated buffers must have been freed by freeOutdatedCmdBuffers() before.
+	*
+	* \param[in] pSub Pointer to the subrenderer to record
+	* \param[out] futures The futures of the submitted jobs are appended to this list
+	*
+	*/
+	void VERendererForward::recordCmdBuffersLight(VESubrender *pSub, veFrameVector<std::future<void>> &futures) {
+		if (!pSub->cmdBuffersDirty(m_frameIndex)) return;
+		pSub->waitForPipelines();
+
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+		std::vector<VESubrender::veSecondaryBuffer_t> &buffers = pSub->getSecondaryBuffers(m_frameIndex);
+
+		uint32_t numEntities = pSub->getNumberEntities();
+		uint32_t numChunks = (numEntities + ENTITIES_PER_CMD_BUFFER - 1) / ENTITIES_PER_CMD_BUFFER;
+		uint32_t numPasses = pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_OBJECT ? getNumLightPasses() : std::min(getNumLightPasses(), 1u);
+		bool prepass = m_depthPrepass && numPasses > 0 && m_subrenderShadow != nullptr && pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_OBJECT;
+
+		for (uint32_t i = 0; i < numPasses; i++) {
+			for (uint32_t c = 0; c < numChunks; c++) {
+				buffers.push_back({ i, VK_NULL_HANDLE, VK_NULL_HANDLE });
+			}
+		}
+		if (prepass) {
+			for (uint32_t c = 0; c < numChunks; c++) {
+				buffers.push_back({ DEPTH_PREPASS_PASS, VK_NULL_HANDLE, VK_NULL_HANDLE });
+			}
+		}
+		if (buffers.size() > 0) pSub->prepareDraw();
+
+		uint32_t idx = m_frameIndex;
+		for (uint32_t i = 0; i < numPasses; i++) {
+			VELight * pLight = lights[i];
+
+			for (uint32_t c = 0; c < numChunks; c++) {
+				VESubrender::veSecondaryBuffer_t *pBuffer = &buffers[i*numChunks + c];
+				uint32_t startIdx = c * ENTITIES_PER_CMD_BUFFER;
+
+				futures.push_back(getEnginePointer()->m_threadPool->submit([this, idx, pSub, pCamera, pLight, i, startIdx, pBuffer]() {
+					VkCommandPool commandPool = getThreadCommandPool(idx);
+
+					//the load render pass is compatible with the clear render pass, so one buffer fits both
+					//the swapchain image a frame in flight draws into is unknown here, so its framebuffer is not given
+					VkFramebuffer frameBuffer = m_dynamicResolution ? m_colorMapFramebuffer : VK_NULL_HANDLE;
+					VkCommandBuffer commandBuffer = createSecondaryCmdBuffer(commandPool, m_renderPassClear, frameBuffer);
+
+					pSub->draw(commandBuffer, idx, i, pCamera, pLight, m_descriptorSetsShadow, startIdx, startIdx + ENTITIES_PER_CMD_BUFFER);
+
+					vkEndCommandBuffer(commandBuffer);
+					pBuffer->pool = commandPool;
+					pBuffer->buffer = commandBuffer;
+				}));
+			}
+		}
+
+		for (uint32_t c = 0; prepass && c < numChunks; c++) {
+			VESubrender::veSecondaryBuffer_t *pBuffer = &buffers[numPasses*numChunks + c];
+			uint32_t startIdx = c * ENTITIES_PER_CMD_BUFFER;
+
+			futures.push_back(getEnginePointer()->m_threadPool->submit([this, idx, pSub, pCamera, startIdx, pBuffer]() {
+				VkCommandPool commandPool = getThreadCommandPool(idx);
+				VkCommandBuffer commandBuffer = createSecondaryCmdBuffer(commandPool, m_renderPassDepthPrepass, m_depthPrepassFramebuffer);
+				vh::vhRenderSetViewport(commandBuffer, { { 0, 0 }, m_renderExtent });
+
+				m_subrenderShadow->drawDepthPrepass(commandBuffer, idx, pCamera, pSub->getEntities(), startIdx, startIdx + ENTITIES_PER_CMD_BUFFER);
+
+				vkEndCommandBuffer(commandBuffer);
+				pBuffer->pool = commandPool;
+				pBuffer->buffer = commandBuffer;
+			}));
+		}
+
+		pSub->setCmdBuffersRecorded(m_frameIndex);
+	}
+
+
+	/**
+	*
+	* \brief Invalidate the cached static caster maps of all lights
+	*
+	* Is called whenever a static shadow caster is added, removed, moved, or switched on or off.
+	* The cached maps are drawn again the next time they are used.
+	*
+	*/
+	void VERendererForward::invalidateShadowCache() {
+		m_shadowCacheVersion++;
+	}
+
+
+	/**
+	*
+	* \brief Give the shadow cameras their tiles in the cache atlas
+	*
+	* A camera gets a tile for its time sliced map if it is not refit every frame. Otherwise, it gets a tile for
+	* its cached static casters if there are static casters. The tiles have the size of the atlas tile of the camera,
+	* cameras whose atlas tile size has changed get new tiles. The tiles of lights that are gone, have no shadow pass
+	* or use the cube shadow map are freed. If the cache atlas is full, a camera gets no tile and draws its map in every frame.
+	*
+	* \param[in] hasStaticCasters If false, all tiles of cached static casters are freed
+	*
+	*/
+	void VERendererForward::updateShadowCacheTiles(bool hasStaticCasters) {
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+		auto lightPassesEnd = lights.begin() + getNumLightPasses();
+		auto drawsIntoAtlas = [&](VELight *pLight) {
+			return std::find(lights.begin(), lightPassesEnd, pLight) != lightPassesEnd && !usesCubeShadow(pLight);
+		};
+
+		//give a tile the wanted size, 0 for no tile, and return true if it has changed
+		auto resizeTile = [this](VkRect2D &tile, uint32_t dim) {
+			if (tile.extent.width == dim) return false;
+			if (tile.extent.width > 0) freeShadowCacheTile(tile);
+			tile = { { 0, 0 }, { 0, 0 } };
+			if (dim > 0) allocateShadowCacheTile(dim, tile);
+			return true;
+		};
+
+		for (auto it = m_shadowCaches.begin(); it != m_shadowCaches.end(); ) {
+			if (hasStaticCasters && drawsIntoAtlas(it->first)) {
+				it++;
+				continue;
+			}
+			for (auto &tile : it->second.tiles) resizeTile(tile, 0);
+			it = m_shadowCaches.erase(it);
+		}
+		for (auto it = m_shadowSlices.begin(); it != m_shadowSlices.end(); ) {
+			if (drawsIntoAtlas(it->first)) {
+				it++;
+				continue;
+			}
+			for (auto &tile : it->second.tiles) resizeTile(tile, 0);
+			it = m_shadowSlices.erase(it);
+		}
+
+		for (uint32_t i = 0; i < getNumLightPasses(); i++) {
+			VELight *pLight = lights[i];
+			if (usesCubeShadow(pLight)) continue;
+			uint32_t numCameras = (uint32_t)pLight->m_shadowCameras.size();
+
+			veShadowSlices_t &slices = m_shadowSlices[pLight];
+			slices.tiles.resize(numCameras, { { 0, 0 }, { 0, 0 } });
+			slices.viewProj.resize(numCameras, glm::mat4(0.0f));
+
+			for (uint32_t j = 0; j < numCameras; j++) {
+				uint32_t dim = pLight->getShadowCameraInterval(j) > 1 ? pLight->m_shadowTiles[j].extent.width : 0;
+				if (resizeTile(slices.tiles[j], dim)) slices.viewProj[j] = glm::mat4(0.0f);		//never valid
+			}
+
+			if (hasStaticCasters) {
+				veShadowCache_t &cache = m_shadowCaches[pLight];
+				cache.tiles.resize(numCameras, { { 0, 0 }, { 0, 0 } });
+				cache.viewProj.resize(numCameras, glm::mat4(0.0f));
+				cache.versions.resize(numCameras, 0);
+
+				for (uint32_t j = 0; j < numCameras; j++) {
+					//a time sliced camera draws its static casters together with the dynamic ones
+					uint32_t dim = slices.tiles[j].extent.width > 0 ? 0 : pLight->m_shadowTiles[j].extent.width;
+					if (resizeTile(cache.tiles[j], dim)) cache.versions[j] = 0;		//never valid
+				}
+			}
+		}
+	}
+
+
+	/**
+	*
+	* \brief Take a free square tile of the cache atlas
+	*
+	* The cache atlas is cut into squares of size SHADOW_MAP_DIM. A tile is taken from the smallest free square
+	* that is large enough, which is split into quarters until one quarter has the wanted size.
+	* The other quarters stay free.
+	*
+	* \param[in] dim Size of the tile, a power of 2 not larger than SHADOW_MAP_DIM
+	* \param[out] tile The tile
+	* \returns false if there is no free square large enough
+	*
+	*/
+	bool VERendererForward::allocateShadowCacheTile(uint32_t dim, VkRect2D &tile) {
+		auto it = m_shadowCacheFreeTiles.lower_bound(dim);
+		while (it != m_shadowCacheFreeTiles.end() && it->second.empty()) it++;
+		if (it == m_shadowCacheFreeTiles.end()) return false;
+
+		uint32_t squareDim = it->first;
+		VkOffset2D offset = it->second.back();
+		it->second.pop_back();
+
+		while (squareDim > dim) {
+			squareDim /= 2;
+			std::vector<VkOffset2D> &quarters = m_shadowCacheFreeTiles[squareDim];
+			quarters.push_back({ offset.x + (int32_t)squareDim, offset.y });
+			quarters.push_back({ offset.x, offset.y + (int32_t)squareDim });
+			quarters.push_back({ offset.x + (int32_t)squareDim, offset.y + (int32_t)squareDim });
+		}
+
+		tile = { offset, { dim, dim } };
+		m_shadowCacheTilesVersion++;
+		return true;
+	}
+
+
+	/**
+	*
+	* \brief Give a tile back to the cache atlas
+	*
+	* If the other three quarters of the square the tile was split from are free as well,
+	* they are merged into the square again.
+	*
+	* \param[in] tile The tile, taken by allocateShadowCacheTile()
+	*
+	*/
+	void VERendererForward::freeShadowCacheTile(VkRect2D tile) {
+		VkOffset2D offset = tile.offset;
+		uint32_t dim = tile.extent.width;
+
+		while (dim < SHADOW_MAP_DIM) {
+			int32_t squareDim = 2 * dim;
+			VkOffset2D square = { offset.x - offset.x % squareDim, offset.y - offset.y % squareDim };
+			auto inSquare = [&](const VkOffset2D &quarter) {
+				return	quarter.x >= square.x && quarter.x < square.x + squareDim &&
+						quarter.y >= square.y && quarter.y < square.y + squareDim;
+			};
+
+			std::vector<VkOffset2D> &free = m_shadowCacheFreeTiles[dim];
+			if (std::count_if(free.begin(), free.end(), inSquare) < 3) break;
+			free.erase(std::remove_if(free.begin(), free.end(), inSquare), free.end());
+
+			offset = square;
+			dim = squareDim;
+		}
+
+		m_shadowCacheFreeTiles[dim].push_back(offset);
+		m_shadowCacheTilesVersion++;
+	}
+
+
+	/**
+	*
+	* \brief Find out whether a cached map can be used for a shadow camera
+	*
+	* \param[in] cache The cache of the light
+	* \param[in] pLight Pointer to the light
+	* \param[in] j Index of the shadow camera
+	* \returns true if the map was drawn with the current camera matrices, tile size and static casters
+	*
+	*/
+	bool VERendererForward::shadowCacheValid(veShadowCache_t &cache, VELight *pLight, uint32_t j) {
+		VECamera::veUBOPerCamera_t &ubo = pLight->m_shadowCameras[j]->m_ubo;
+		return	cache.versions[j] == m_shadowCacheVersion && cache.viewProj[j] == ubo.proj * ubo.view &&
+				cache.tiles[j].extent.width == pLight->m_shadowTiles[j].extent.width;
+	}
+
+
+	/**
+	*
+	* \brief Record a command buffer that draws the outdated maps of the cache atlas for the current frame
+	*
+	* A time sliced shadow camera draws all casters in the frames it is refit. A camera with cached static casters
+	* draws them again if its camera, its tile size or a static caster has changed. The casters are drawn into the
+	* atlas tile of the camera, and the tile is copied into the cache atlas. The buffer is submitted together with
+	* the primary buffer of the frame, and before it. So the primary buffer can always copy the maps from the cache
+	* atlas, and does not need to be recorded again when they are drawn. This small buffer is recorded in every frame instead.
+	*
+	* \returns the command buffer, or VK_NULL_HANDLE if no map is drawn in this frame
+	*
+	*/
+	VkCommandBuffer VERendererForward::recordCmdBuffersShadowCache() {
+		if (m_shadowCacheCmdBuffers[m_frameIndex] != VK_NULL_HANDLE) {
+			vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_shadowCacheCmdBuffers[m_frameIndex]);
+			m_shadowCacheCmdBuffers[m_frameIndex] = VK_NULL_HANDLE;
+		}
+		if (m_subrenderShadow == nullptr) return VK_NULL_HANDLE;
+
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+		std::vector<VESubrender::veSecondaryBuffer_t> &shadowBuffers = m_subrenderShadow->getSecondaryBuffers(m_frameIndex);
+		uint32_t numBuffers = (uint32_t)lights.size() * NUM_SHADOW_CASCADE;
+
+		VkClearValue clearValueShadow;
+		clearValueShadow.depthStencil = { 1.0f, 0 };
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		for (uint32_t i = 0; i < getNumLightPasses(); i++) {
+			VELight *pLight = lights[i];
+			auto cache = m_shadowCaches.find(pLight);
+			auto slices = m_shadowSlices.find(pLight);
+
+			for (uint32_t j = 0; j < pLight->m_shadowCameras.size(); j++) {
+				uint32_t idx = i*NUM_SHADOW_CASCADE + j;
+				uint32_t staticIdx = numBuffers + idx;
+				bool hasStatic = staticIdx < shadowBuffers.size() && shadowBuffers[staticIdx].buffer != VK_NULL_HANDLE;
+				VECamera::veUBOPerCamera_t &ubo = pLight->m_shadowCameras[j]->m_ubo;
+
+				VkCommandBuffer casters[2];
+				uint32_t numCasters = 0;
+				VkRect2D cacheTile;
+
+				if (slices != m_shadowSlices.end() && j < slices->second.tiles.size() && slices->second.tiles[j].extent.width > 0) {
+					if (pLight->isShadowCameraStale(j) && slices->second.viewProj[j] == ubo.proj * ubo.view) continue;
+
+					if (idx < shadowBuffers.size() && shadowBuffers[idx].buffer != VK_NULL_HANDLE) casters[numCasters++] = shadowBuffers[idx].buffer;
+					if (hasStatic) casters[numCasters++] = shadowBuffers[staticIdx].buffer;
+					cacheTile = slices->second.tiles[j];
+					slices->second.viewProj[j] = ubo.proj * ubo.view;
+				}
+				else if (hasStatic && cache != m_shadowCaches.end() && j < cache->second.tiles.size() && cache->second.tiles[j].extent.width > 0) {
+					if (shadowCacheValid(cache->second, pLight, j)) continue;
+
+					casters[numCasters++] = shadowBuffers[staticIdx].buffer;
+					cacheTile = cache->second.tiles[j];
+					cache->second.versions[j] = m_shadowCacheVersion;
+					cache->second.viewProj[j] = ubo.proj * ubo.view;
+				}
+				else continue;
+
+				if (commandBuffer == VK_NULL_HANDLE) {
+					vh::vhCmdCreateCommandBuffers(m_device, m_commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, &commandBuffer);
+					vh::vhCmdBeginCommandBuffer(m_device, commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+				}
+
+				VkRect2D tile = pLight->m_shadowTiles[j];
+				vh::vhRenderBeginRenderPass(commandBuffer,
+					m_renderPassShadow,
+					m_shadowAtlasFramebuffer,
+					1, &clearValueShadow,
+					tile,
+					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+				if (numCasters > 0) vkCmdExecuteCommands(commandBuffer, numCasters, casters);
+
+				vkCmdEndRenderPass(commandBuffer);
+
+				vh::vhBufCopyDepthImage(commandBuffer,
+										m_shadowAtlas->m_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, tile.offset,
+										m_shadowCacheAtlas->m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, cacheTile.offset,
+										m_shadowAtlas->m_format, tile.extent);
+			}
+		}
+
+		if (commandBuffer != VK_NULL_HANDLE) {
+			VECHECKRESULT(vkEndCommandBuffer(commandBuffer), "Failed to end shadow cache command buffer!");
+		}
+		m_shadowCacheCmdBuffers[m_frameIndex] = commandBuffer;
+		return commandBuffer;
+	}
+
+
+	/**
+	*
+	* \brief Find out whether a light got new shadow atlas tiles since the shadow buffers of the current frame were recorded
+	*
+	* The recorded buffers set the viewports to the tiles, and the primary buffer renders into them,
+	* so both must be recorded again.
+	*
+	* \returns true if the tiles of a light have changed
+	*
+	*/
+	bool VERendererForward::shadowTilesChanged() {
+		std::vector<VELight*> &lights = getSceneManagerPointer()->getLights();
+		std::vector<uint64_t> &recorded = m_shadowTilesRecorded[m_frameIndex];
+		if (recorded.size() != lights.size()) return true;
+
+		for (uint32_t i = 0; i < lights.size(); i++) {
+			if (recorded[i] != lights[i]->m_shadowTilesVersion) return true;
+		}
+		return false;
+	}
+
+
+	/**
+	*
+	* \brief Record the shadow passes of a light into the current primary command buffer
+	*
+	* For each shadow camera of the light, a shadow render pass is started on the atlas tile of the camera,
+	* that executes the cached secondary buffer of this camera.
+	*
+	* If the camera has a tile in the cache atlas, the atlas tile is not cleared. Instead, the cached map of the static
+	* casters is copied into it, and only the dynamic casters are drawn on top. The cached map is kept up to date by
+	* recordCmdBuffersShadowCache(), so the copy does not depend on whether it has been drawn again. Without a cache tile,
+	* the static and the dynamic casters are both drawn into the cleared tile.
+	*
+	* A point light using the cube shadow map runs a single multiview pass over all faces of the cube shadow map instead.
+	*
+	* A shadow camera that is not refit every frame has a time sliced tile in the cache atlas, which is drawn by
+	* recordCmdBuffersShadowCache() in the frames the camera is refit. It is copied into the atlas in every frame,
+	* so the primary buffer does not depend on whether the camera is stale.
+	*
+	* \param[in] numPass Index of the light whose shadow maps are drawn
+	*
+	*/
+	void VERendererForward::executeCmdBuffersShadow(uint32_t numPass) {
+		VELight * pLight = getSceneManagerPointer()->getLights()[numPass];
+
+		VkClearValue clearValueShadow;		//shadow map should be cleared every time
+		clearValueShadow.depthStencil = { 1.0f, 0 };
+
+		std::vector<VESubrender::veSecondaryBuffer_t> &shadowBuffers = m_subrenderShadow->getSecondaryBuffers(m_frameIndex);
+
+		if (usesCubeShadow(pLight)) {
+			uint32_t idx = numPass*NUM_SHADOW_CASCADE;
+
+			vh::vhRenderBeginRenderPass(m_commandBuffers[m_frameIndex],
+				m_renderPassCubeShadow,
+				m_cubeShadowFramebuffer,
+				1, &clearValueShadow,
+				m_cubeShadowMap->m_extent,
+				VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+			if (idx < shadowBuffers.size() && shadowBuffers[idx].buffer != VK_NULL_HANDLE)
+				vkCmdExecuteCommands(m_commandBuffers[m_frameIndex], 1, &shadowBuffers[idx].buffer);
+
+			vkCmdEndRenderPass(m_commandBuffers[m_frameIndex]);
+			return;
+		}
+		uint32_t numBuffers = (uint32_t)getSceneManagerPointer()->getLights().size() * NUM_SHADOW_CASCADE;
+
+		auto cache = m_shadowCaches.find(pLight);
+		auto slices = m_shadowSlices.find(pLight);
+		for (unsigned j = 0; j < pLight->m_shadowCameras.size(); j++) {
+			VkRect2D tile = pLight->m_shadowTiles[j];
+			uint32_t idx = numPass*NUM_SHADOW_CASCADE + j;
+			uint32_t staticIdx = numBuffers + idx;
+			bool hasStatic = staticIdx < shadowBuffers.size() && shadowBuffers[staticIdx].buffer != VK_NULL_HANDLE;
+			bool cached = hasStatic && cache != m_shadowCaches.end() && j < cache->second.tiles.size() && cache->second.tiles[j].extent.width > 0;
+			bool sliced = slices != m_shadowSlices.end() && j < slices->second.tiles.size() && slices->second.tiles[j].extent.width > 0;
+
+			if (sliced) {		//the last complete map of the camera holds all casters
+				vh::vhBufCopyDepthImage(m_commandBuffers[m_frameIndex], m_shadowCacheAtlas->m_image, slices->second.tiles[j].offset,
+										m_shadowAtlas->m_image, m_shadowAtlas->m_format, tile.extent, tile.offset, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+				//an empty load pass brings the atlas back into the layout for sampling
+				vh::vhRenderBeginRenderPass(m_commandBuffers[m_frameIndex],
+					m_renderPassShadowLoad,
+					m_shadowAtlasFramebuffer,
+					1, &clearValueShadow,
+					tile,
+					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				vkCmdEndRenderPass(m_commandBuffers[m_frameIndex]);
+				continue;
+			}
+
+			if (cached) {
+				vh::vhBufCopyDepthImage(m_commandBuffers[m_frameIndex], m_shadowCacheAtlas->m_image, cache->second.tiles[j].offset,
+										m_shadowAtlas->m_image, m_shadowAtlas->m_format, tile.extent, tile.offset, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			}
+
+			vh::vhRenderBeginRenderPass(m_commandBuffers[m_frameIndex],
+				cached ? m_renderPassShadowLoad : m_renderPassShadow,
+				m_shadowAtlasFramebuffer,
+				1, &clearValueShadow,
+				tile,
+				VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+			if (idx < shadowBuffers.size() && shadowBuffers[idx].buffer != VK_NULL_HANDLE)
+				vkCmdExecuteCommands(m_commandBuffers[m_frameIndex], 1, &shadowBuffers[idx].buffer);
+			if (hasStatic && !cached)
+				vkCmdExecuteCommands(m_commandBuffers[m_frameIndex], 1, &shadowBuffers[staticIdx].buffer);
+
+			vkCmdEndRenderPass(m_commandBuffers[m_frameIndex]);
+		}
+	}
+
+
+	/**
+	* \brief Create a new primary command buffer that executes the cached secondary buffers, then end it
+	*
+	* Only subrenderers whose draw lists have changed since the last recording of this frame in flight record
+	* their secondary buffers again. This is done in parallel by the engine's thread pool.
+	* With dynamic resolution, the light passes draw into the color map, which is then upscaled into the swapchain image.
+	* The passes of the primary buffer are declared to the render graph, which records them with the barriers between them.
+	*/
+	void VERendererForward::recordCmdBuffers() {
+		VECamera *pCamera = getSceneManagerPointer()->getCamera();
+		pCamera->setExtent(getWindowPointer()->getExtent());
+
+		if (m_commandBuffers[m_frameIndex] != VK_NULL_HANDLE) {
+			vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_commandBuffers[m_frameIndex]);
+			m_commandBuffers[m_frameIndex] = VK_NULL_HANDLE;
+		}
+
+		//-----------------------------------------------------------------------------------------
+		//record outdated secondary buffers
+
+		std::chrono::high_resolution_clock::time_point t_now;
+		veFrameVector<std::future<void>> futures;
+
+		t_now = vh::vhTimeNow();
+		recordCmdBuffersShadow(futures);
+		for (auto &f : futures) f.get();
+		m_AvgCmdShadowTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdShadowTime);
+
+		//the object subrenderers record the scissors and lit entities of the light passes
+		if (lightPassesChanged()) {
+			for (auto pSub : m_subrenderers) {
+				if (pSub->getClass() == VESubrender::VE_SUBRENDERER_CLASS_OBJECT) pSub->deleteCmdBuffers(m_frameIndex);
+			}
+			m_lightPassesRecorded[m_frameIndex] = m_lightPasses;
+		}
+
+		//all light pass buffers set their viewport to the render area
+		if (renderExtentChanged()) {
+			for (auto pSub : m_subrenderers) pSub->deleteCmdBuffers(m_frameIndex);
+			m_renderExtentRecorded[m_frameIndex] = m_renderExtent;
+		}
+
+		t_now = vh::vhTimeNow();
+		futures.clear();
+		freeOutdatedCmdBuffers();
+		for (auto pSub : m_subrenderers) recordCmdBuffersLight(pSub, futures);
+		for (auto &f : futures) f.get();
+		m_AvgCmdLightTime = vh::vhAverage(vh::vhTimeDuration(t_now), m_AvgCmdLightTime);
+
+		//-----------------------------------------------------------------------------------------
+		//record the primary buffer
+
+		vh::vhCmdCreateCommandBuffers(	m_device, m_commandPool,
+										VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+										1, &m_commandBuffers[m_frameIndex]);
+
+		vh::vhCmdBeginCommandBuffer(m_device, m_commandBuffers[m_frameIndex], VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
+
+		//the first light pass clears the swapchain image, so its content from the last frame is not needed
+		m_layoutTracker->setState(m_swapChainImages[imageIndex], VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0);
+
+		//the timestamps around the whole buffer measure the GPU time of the frame for dynamic resolution
+		if (m_timestampPool != VK_NULL_HANDLE) {
+			vkCmdResetQueryPool(m_commandBuffers[m_frameIndex], m_timestampPool, 2 * m_frameIndex, 2);
+			vkCmdWriteTimestamp(m_commandBuffers[m_frameIndex], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, 2 * m_frameIndex);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		//set clear values for light passes
+
+		VkClearValue clearValuesLight[2];		//render target and depth buffer should be cleared only first time
+		clearValuesLight[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+		clearValuesLight[1].depthStencil = { 1.0f, 0 };
+
+		//-----------------------------------------------------------------------------------------
+		//declare the passes and the images they use, the render graph orders them and adds the barriers
+
+		m_renderGraph->reset();
+		uint32_t swapChainImage = m_renderGraph->addImage(m_swapChainImages[imageIndex], true);
+		uint32_t colorImage = m_dynamicResolution ? m_renderGraph->addImage(m_colorMap->m_image) : swapChainImage;
+		uint32_t depthImage = m_renderGraph->addImage(m_depthMap->m_image);
+
+		//depth pre-pass, the light passes then keep the depth map, it is culled if there is no light pass
+
+		bool prepass = m_depthPrepass;
+		if (prepass) {
+			uint32_t pass = m_renderGraph->addPass("DepthPrepass", [this, &clearValuesLight](VkCommandBuffer commandBuffer) {
+				vh::vhRenderBeginRenderPass(commandBuffer,
+					m_renderPassDepthPrepass,
+					m_depthPrepassFramebuffer,
+					1, &clearValuesLight[1],
+					m_renderExtent,
+					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+				veFrameVector<VkCommandBuffer> depthBuffers;
+				for (auto pSub : m_subrenderers) {
+					for (auto &sb : pSub->getSecondaryBuffers(m_frameIndex)) {
+						if (sb.numPass == DEPTH_PREPASS_PASS && sb.buffer != VK_NULL_HANDLE) depthBuffers.push_back(sb.buffer);
+					}
+				}
+				if (depthBuffers.size() > 0)
+					vkCmdExecuteCommands(commandBuffer, (uint32_t)depthBuffers.size(), depthBuffers.data());
+
+				vkCmdEndRenderPass(commandBuffer);
+			});
+			m_renderGraph->write(	pass, depthImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+									VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+									VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+		}
+
+		//go through all active lights in the scene, each has its shadow passes and a light pass
+
+		for (uint32_t i = 0; i < getNumLightPasses(); i++) {
+			addShadowPass(i);
+
+			uint32_t pass = m_renderGraph->addPass("Light", [this, i, prepass, &clearValuesLight](VkCommandBuffer commandBuffer) {
+				vh::vhRenderBeginRenderPass(commandBuffer,
+					i > 0 ? m_renderPassLoad : (prepass ? m_renderPassLightClear : m_renderPassClear),
+					getLightFramebuffer(imageIndex),
+					i > 0 ? 0 : 2, clearValuesLight,		//since we blend the images onto each other, do not clear them for passes 2 and further
+					m_renderExtent,
+					VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+				veFrameVector<VkCommandBuffer> lightBuffers;
+				for (auto pSub : m_subrenderers) {
+					for (auto &sb : pSub->getSecondaryBuffers(m_frameIndex)) {
+						if (sb.numPass == i && sb.buffer != VK_NULL_HANDLE) lightBuffers.push_back(sb.buffer);
+					}
+				}
+				if (lightBuffers.size() > 0)
+					vkCmdExecuteCommands(commandBuffer, (uint32_t)lightBuffers.size(), lightBuffers.data());
+
+				vkCmdEndRenderPass(commandBuffer);
+			});
+			readShadowMaps(pass);
+			m_renderGraph->write(	pass, depthImage,
+									i > 0 || prepass ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+									VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+									VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+									VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+			m_renderGraph->write(	pass, colorImage,
+									i > 0 ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+									VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+									VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+									VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+
+		//upscale the render area into the swapchain image, the overlay is then drawn at full resolution
+
+		if (m_dynamicResolution && getNumLightPasses() > 0) {
+			uint32_t pass = m_renderGraph->addPass("Upscale", [this](VkCommandBuffer commandBuffer) {
+				vh::vhBufBlitImage(	commandBuffer,
+									m_colorMap->m_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, { { 0, 0 }, m_renderExtent },
+									m_swapChainImages[imageIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+									{ { 0, 0 }, m_swapChainExtent }, VK_FILTER_LINEAR);
+			});
+			m_renderGraph->read(pass, colorImage, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+			m_renderGraph->write(	pass, swapChainImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+									VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		}
+
+		//-----------------------------------------------------------------------------------------
+		//record the passes
+
+		m_renderGraph->compile();
+		m_renderGraph->execute(m_commandBuffers[m_frameIndex]);
+
+		handOverSwapChainImage();
+
+		if (m_timestampPool != VK_NULL_HANDLE) {
+			vkCmdWriteTimestamp(m_commandBuffers[m_frameIndex], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, 2 * m_frameIndex + 1);
+			m_timestampsWritten[m_frameIndex] = true;
+		}
+
+		vkEndCommandBuffer(m_commandBuffers[m_frameIndex]);
+		m_commandBufferImages[m_frameIndex] = imageIndex;
+	}
+
+
+	/**
+	*
+	* \brief Register a depth image with the layout tracker
+	*
+	* \param[in] image The image
+	* \param[in] format Format of the image, if it has a stencil part, the barriers include it
+	* \param[in] layout The current layout of the image
+	*
+	*/
+	void VERendererForward::registerDepthImage(VkImage image, VkFormat format, VkImageLayout layout) {
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		if (vh::hasStencilComponent(format)) aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		m_layoutTracker->setState(image, aspect, layout, 0, 0);
+	}
+
+
+	/**
+	*
+	* \brief Add the shadow passes of a light to the render graph
+	*
+	* They draw into the shadow atlas, or into the cube shadow map, and leave both in the layout for sampling.
+	* Copies from and to the cache atlas are synchronized by the shadow passes themselves.
+	*
+	* \param[in] numPass Index of the light whose shadow maps are drawn
+	*
+	*/
+	void VERendererForward::addShadowPass(uint32_t numPass) {
+		uint32_t pass = m_renderGraph->addPass("Shadow", [this, numPass](VkCommandBuffer commandBuffer) {
+			executeCmdBuffersShadow(numPass);
+		});
+
+		VkAccessFlags access =	VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+								VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		VkPipelineStageFlags stage =	VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+										VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		m_renderGraph->write(	pass, m_renderGraph->addImage(m_shadowAtlas->m_image), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+								VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, access, stage);
+		m_renderGraph->write(	pass, m_renderGraph->addImage(m_cubeShadowMap->m_image), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+								VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, access, stage);
+	}
+
+
+	/**
+	*
+	* \brief Declare that a pass of the render graph samples the shadow atlas and the cube shadow map
+	*
+	* \param[in] pass Index of the pass
+	*
+	*/
+	void VERendererForward::readShadowMaps(uint32_t pass) {
+		m_renderGraph->read(pass, m_renderGraph->addImage(m_shadowAtlas->m_image), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+							VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		m_renderGraph->read(pass, m_renderGraph->addImage(m_cubeShadowMap->m_image), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+							VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+
+
+	/**
+	*
+	* \brief Record the last transition of the swapchain image into the primary buffer of the frame
+	*
+	* If there is an overlay, it draws into the image as color attachment, and its render pass moves the image into
+	* the present layout. Otherwise the image is moved into the present layout right away. Either way presenting
+	* needs no submission of its own. All barriers collected by the layout
+	* tracker are recorded in one batch.
+	*
+	*/
+	void VERendererForward::handOverSwapChainImage() {
+		if (m_subrenderOverlay != nullptr) {
+			m_layoutTracker->transition(m_swapChainImages[imageIndex], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+										VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+										VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+		else {
+			m_layoutTracker->transition(m_swapChainImages[imageIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 0);
+		}
+		m_layoutTracker->flush(m_commandBuffers[m_frameIndex]);
+	}
+
+
+	/**
+	*
+	* \brief Wait until the GPU is done with the resources of the current frame in flight
+	*
+	* Called by the engine before the scene nodes copy their data into the UBOs of the frame, so the UBOs,
+	* descriptor sets and command buffers of the frame can be changed from now on. The CPU waits only for the
+	* last submission of this frame, later frames may still be in flight. Resources handed to the timeline
+	* are released if the GPU is done with them.
+	*
+	*/
+	void VERendererForward::beginFrame() {
+		m_timeline->wait(m_frameValues[m_frameIndex]);
+		m_timeline->collect();
+
+		m_descriptorAllocator->nextFrame();		//recycle freed sets that are not in flight anymore
+	}
+
+
+	/**
+	* \brief Draw the frame.
+	*
+	*- acquire the next image from the swap chain
+	*- measure the GPU time of the frame's last use and adapt the render scale
+	*- if there is no command buffer yet, it draws into another image, or the scene has changed, record one with the current scene
+	*- record the drawing of the outdated cached shadow maps
+	*- submit both to the queue
+	*/
+	void VERendererForward::drawFrame() {
+		//acquire the next image
+		VkResult result = vkAcquireNextImageKHR(m_device, m_swapChain, std::numeric_limits<uint64_t>::max(),
+												m_imageAvailableSemaphores[m_frameIndex], VK_NULL_HANDLE, &imageIndex);
+
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			recreateSwapchain();
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+			getEnginePointer()->fatalError("Failed to acquire swap chain image!");
+		}
+
+		//make sure the previous frame that used this image is done before drawing into it again
+		m_timeline->wait(m_imageValues[imageIndex]);
+
+		updateRenderScale();
+
+		//the cluster buffer of this frame is written after the render scale is known, so it always fits the render extent
+		if (m_clusteredLighting) {
+			updateClusterBuffer();
+		}
+
+		updateLightPasses();
+
+		if (m_commandBuffers[m_frameIndex] == VK_NULL_HANDLE || m_commandBufferImages[m_frameIndex] != imageIndex || cmdBuffersDirty() ) {
+			recordCmdBuffers();
+		}
+
+		//meshes and textures created since the last frame are copied before this frame on the graphics queue
+		m_uploadManager->flush();
+
+		//submit the command buffers, the cached shadow maps are drawn first
+		VkCommandBuffer commandBuffers[2];
+		uint32_t numCommandBuffers = 0;
+		VkCommandBuffer shadowCacheBuffer = recordCmdBuffersShadowCache();
+		if (shadowCacheBuffer != VK_NULL_HANDLE) commandBuffers[numCommandBuffers++] = shadowCacheBuffer;
+		commandBuffers[numCommandBuffers++] = m_commandBuffers[m_frameIndex];
+
+		m_frameValues[m_frameIndex] = m_timeline->submit(	m_graphicsQueue, numCommandBuffers, commandBuffers,
+															m_imageAvailableSemaphores[m_frameIndex],
+															m_renderFinishedSemaphores[m_frameIndex]);
+		m_imageValues[imageIndex] = m_frameValues[m_frameIndex];
+
+		m_overlaySemaphores[m_frameIndex] = m_renderFinishedSemaphores[m_frameIndex];
+	}
+
+
+	/**
+	* \brief Prepare to creat an overlay, e.g. initialize the next frame
+	*/
+	void VERendererForward::prepareOverlay() {
+		if (m_subrenderOverlay == nullptr) return;
+		m_subrenderOverlay->prepareDraw();
+	}
+
+
+	/**
+	* \brief Draw the overlay into the current frame buffer
+	*/
+	void VERendererForward::drawOverlay() {
+		if (m_subrenderOverlay == nullptr) return;
+
+		m_overlaySemaphores[m_frameIndex] = m_subrenderOverlay->draw( imageIndex, m_renderFinishedSemaphores[m_frameIndex]);
+
+		//the overlay render pass leaves the image in the present layout
+		m_layoutTracker->setState(getSwapChainImage(), VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 0);
+	}
+
+
+	/**
+	*
+	* \brief Present the new frame.
+	*
+	* The image is already in the present layout, moved there either by the frame's command buffer or by the overlay
+	* render pass. Nothing is recorded or submitted, and the CPU never waits.
+	*
+	*/
+	void VERendererForward::presentFrame() {
 		VkResult result = vh::vhRenderPresentResult(m_presentQueue, m_swapChain, imageIndex,	//present it to the swap chain
-													m_overlaySemaphores[m_currentFrame]);
+													m_overlaySemaphores[m_frameIndex]);
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_framebufferResized) {
 			m_framebufferResized = false;
@@ -492,7 +2333,7 @@ namespace ve {
 			getEnginePointer()->fatalError("failed to present swap chain image!");
 		}
 
-		m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;		//count up the current frame number
+		m_frameIndex = (m_frameIndex + 1) % m_framesInFlight;		//count up the current frame number
 	}
 
 }
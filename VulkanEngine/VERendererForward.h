@@ -12,6 +12,23 @@
 #endif
 
 const uint32_t NUM_SHADOW_CASCADE = 6;
+const uint32_t NUM_DIRECTIONAL_CASCADE = 4;									///<Number of shadow cascades of a directional light, at most NUM_SHADOW_CASCADE
+const uint32_t NUM_LIGHT_TYPES = 3;											///<Number of light types, each gets its own material PSO
+const uint32_t ENTITIES_PER_CMD_BUFFER = 128;								///<Max number of entities recorded into one secondary command buffer
+const uint32_t DEPTH_PREPASS_PASS = 0xFFFFFFFF;								///<Pass number of the secondary buffers of the depth pre-pass
+const uint32_t LIGHT_SCISSOR_GRID = 32;										///<Light pass scissors are snapped outwards to this many pixels
+
+const float RENDER_SCALE_STEP = 0.05f;										///<Dynamic resolution changes the render scale in steps of this size
+const float RENDER_SCALE_HEADROOM = 0.85f;									///<The render scale is raised only if the GPU time is below this fraction of the budget
+const uint32_t RENDER_SCALE_SETTLE_FRAMES = 8;								///<Frames to wait after a scale change, until the measured GPU time follows it
+const uint32_t RENDER_SCALE_HISTORY = 120;									///<Number of frames kept in the render scale history
+
+const uint32_t CLUSTER_DIM_X = 16;											///<Number of light clusters in x direction (screen space)
+const uint32_t CLUSTER_DIM_Y = 9;											///<Number of light clusters in y direction (screen space)
+const uint32_t CLUSTER_DIM_Z = 24;											///<Number of light clusters in z direction (exponential depth slices)
+const uint32_t NUM_CLUSTERS = CLUSTER_DIM_X * CLUSTER_DIM_Y * CLUSTER_DIM_Z;	///<Total number of light clusters
+const uint32_t MAX_CLUSTER_LIGHTS = 256;									///<Max number of lights in the cluster buffer
+const uint32_t MAX_CLUSTER_LIGHT_INDICES = 32 * NUM_CLUSTERS;				///<Max number of light references of all clusters
 
 namespace ve {
 
@@ -29,39 +46,183 @@ namespace ve {
 	*/
 	class VERendererForward : public VERenderer {
 
+	public:
+		///Light data that is stored in the cluster buffer, same layout as in clustered.glsl
+		struct veClusterLight_t {
+			glm::vec4 posRadius;		///<xyz: world space position, w: reach of the light
+			glm::vec4 dirType;			///<xyz: world space direction, w: light type
+			glm::vec4 col_ambient;		///<Ambient color
+			glm::vec4 col_diffuse;		///<Diffuse color
+			glm::vec4 col_specular;		///<Specular color
+		};
+
+		///Cached shadow maps holding only the static shadow casters of a light, one tile of the cache atlas per shadow camera
+		struct veShadowCache_t {
+			std::vector<VkRect2D>		tiles;			///<Tiles in the cache atlas, as large as the atlas tiles of the cameras, width 0 if the cache atlas is full
+			std::vector<glm::mat4>		viewProj;		///<Shadow camera matrices the maps were drawn with
+			std::vector<uint64_t>		versions;		///<Static caster version the maps were drawn with, 0 if not drawn yet
+		};
+
+		///Screen area and lit entities of a light pass
+		struct veLightPass_t {
+			VkRect2D				scissor;				///<Screen rectangle covered by the light volume
+			float					minDepth;				///<Smallest depth of the light volume
+			float					maxDepth;				///<Largest depth of the light volume
+			std::vector<VEEntity*>	litEntities;			///<The entities the light can reach, sorted by address
+			bool					culled = false;			///<litEntities were found with the following light volume and versions
+			glm::vec4				volume;					///<Center and radius of the light volume
+			uint64_t				entitiesVersion = 0;	///<Sum of the entity versions of the object subrenderers
+			uint64_t				boundsVersion = 0;		///<Value of VEEntity::s_boundsVersion
+
+			///\returns true if both light passes record the same commands, the culling state is not compared
+			bool operator==(const veLightPass_t &other) const {
+				return	scissor.offset.x == other.scissor.offset.x && scissor.offset.y == other.scissor.offset.y &&
+						scissor.extent.width == other.scissor.extent.width && scissor.extent.height == other.scissor.extent.height &&
+						minDepth == other.minDepth && maxDepth == other.maxDepth && litEntities == other.litEntities;
+			}
+		};
+
+		///One frame of the dynamic resolution controller
+		struct veRenderScaleSample_t {
+			float		renderTime;		///<Measured GPU time of the light passes (s), 0 if not available
+			float		renderScale;	///<Render scale chosen for the frame
+		};
+
+		///Last complete shadow maps of the shadow cameras that are not refit every frame, reused while they are stale
+		struct veShadowSlices_t {
+			std::vector<VkRect2D>		tiles;			///<Tiles in the cache atlas, width 0 for cameras refit every frame or if the cache atlas is full
+			std::vector<glm::mat4>		viewProj;		///<Shadow camera matrices the maps were drawn with
+		};
+
 	protected:
-		std::vector<VkCommandBuffer> m_commandBuffers = {};				///<the main command buffers for recording draw commands
+		std::vector<VkCommandBuffer> m_commandBuffers = {};				///<per frame in flight: the main command buffer for recording draw commands
+		std::vector<uint32_t>		 m_commandBufferImages;				///<per frame in flight: the swapchain image its main command buffer draws into
+
+		std::vector<std::vector<VkCommandPool>> m_commandPoolsThread;	///<per frame in flight: one command pool for each recording thread
+		std::map<std::thread::id, uint32_t>		m_threadSlots;			///<maps a recording thread to its command pool index
+		std::mutex								m_commandPoolsMutex;	///<guards creation of the per thread command pools
 		
 		//per frame render resources
 		VkRenderPass				m_renderPassClear;					///<The first light render pass, clearing the framebuffers
 		VkRenderPass				m_renderPassLoad;					///<The second light render pass - no clearing of framebuffer
+		VkRenderPass				m_renderPassLightClear;				///<The first light render pass, clearing color but keeping the depth map
 
 		std::vector<VkFramebuffer>	m_swapChainFramebuffers;			///<Framebuffers for light pass
 		VETexture *					m_depthMap = nullptr;				///<the image depth map	
-		std::vector<std::vector<VETexture *>>	m_shadowMaps;			///<the shadow maps - a list of map cascades
+		VETexture *					m_shadowAtlas = nullptr;			///<the shadow atlas, holding a tile for each shadow camera of a light
 
 		//per frame render resources for the shadow pass
-		VkRenderPass				 m_renderPassShadow;				///<The shadow render pass 
-		std::vector<std::vector<VkFramebuffer>>	 m_shadowFramebuffers;	///<list of Framebuffers for shadow pass (up to 6)
+		VkRenderPass				 m_renderPassShadow;				///<The shadow render pass, drawing into one tile of the atlas
+		VkFramebuffer				 m_shadowAtlasFramebuffer;			///<Framebuffer for the shadow pass holding the shadow atlas
+		std::vector<std::vector<uint64_t>> m_shadowTilesRecorded;		///<per frame in flight: tile versions of the lights the shadow buffers were recorded with
 		VkDescriptorSetLayout		 m_descriptorSetLayoutShadow;		///<Descriptor set layout for using shadow maps in the light pass
-		std::vector<VkDescriptorSet> m_descriptorSetsShadow;			///<Descriptor sets for usage of shadow maps in the light pass
+		std::vector<VkDescriptorSet> m_descriptorSetsShadow;			///<per frame in flight: descriptor set for usage of shadow maps in the light pass
+
+		//shadow caching
+		VkRenderPass				m_renderPassShadowLoad;				///<Shadow render pass keeping the copied static casters
+		VETexture *					m_shadowCacheAtlas = nullptr;		///<the cache atlas, keeping the cached and time sliced maps of all lights in the transfer source layout
+		std::map<uint32_t, std::vector<VkOffset2D>> m_shadowCacheFreeTiles;	///<Free square tiles of the cache atlas, by size
+		uint64_t					m_shadowCacheTilesVersion = 0;		///<Increased whenever a tile of the cache atlas is allocated or freed
+		std::vector<uint64_t>		m_shadowCacheTilesRecorded;			///<per frame in flight: the cache tiles version the command buffer was recorded with
+		std::vector<VkCommandBuffer> m_shadowCacheCmdBuffers;			///<per frame in flight: draws the outdated maps of the cache atlas, VK_NULL_HANDLE if none
+		std::map<VELight*, veShadowCache_t> m_shadowCaches;				///<Cached static caster maps of each light
+		uint64_t					m_shadowCacheVersion = 1;			///<Increased whenever a static caster changes
+
+		//time sliced shadow cameras
+		std::map<VELight*, veShadowSlices_t> m_shadowSlices;			///<Last complete maps of the time sliced shadow cameras of each light
+
+		//single pass cube shadow maps of point lights
+		bool						m_multiviewSupported = false;		///<the device can draw all faces of a cube map in one multiview pass
+		bool						m_cubeShadows = false;				///<if true, point lights use the cube shadow map instead of the atlas, off by default
+		bool						m_bindlessSupported = false;		///<the device has descriptor indexing for the bindless table
+		bool						m_bindlessTextures = false;			///<if true, material subrenderers take their textures from the bindless table
+		bool						m_pushConstantsSupported = false;	///<the push constant limit of the device holds the per object data
+		bool						m_pushConstants = false;			///<if true, material subrenderers push the material index of each entity, on by default
+		VETexture *					m_cubeShadowMap = nullptr;			///<layered depth map holding the 6 faces of a point light
+		VkRenderPass				m_renderPassCubeShadow;				///<Multiview render pass drawing all 6 faces at once
+		VkFramebuffer				m_cubeShadowFramebuffer;			///<Framebuffer holding the cube shadow map
+
+		//light pass culling
+		bool						m_depthBoundsSupported = false;		///<the device can test the depth bounds of the light volumes
+		std::vector<veLightPass_t>	m_lightPasses;						///<Screen area and lit entities of each light pass in this frame
+		std::vector<std::vector<veLightPass_t>> m_lightPassesRecorded;	///<per frame in flight: the light passes the buffers were recorded with
+
+		//dynamic resolution
+		bool						m_dynamicResolution = false;		///<if true, the light passes draw a scaled render area of the color map, which is upscaled into the swapchain image
+		VETexture *					m_colorMap = nullptr;				///<offscreen color target of the light passes, as large as the swapchain images
+		VkFramebuffer				m_colorMapFramebuffer;				///<Framebuffer for light pass holding the color map and the depth map
+		VkExtent2D					m_renderExtent = { 0, 0 };			///<Extent of the render area the light passes draw into
+		std::vector<VkExtent2D>		m_renderExtentRecorded;				///<per frame in flight: the render extent the buffers were recorded with
+		float						m_renderScale = 1.0f;				///<Current scale of the render area relative to the swapchain extent
+		float						m_minRenderScale = 0.5f;			///<Smallest render scale the controller may choose
+		float						m_maxRenderScale = 1.0f;			///<Largest render scale the controller may choose
+		float						m_renderTimeBudget = 1.0f / 60.0f;	///<GPU time the light passes may take per frame (s)
+		float						m_renderTime = 0.0f;				///<Average measured GPU time of the light passes (s)
+		uint32_t					m_renderScaleSettle = 0;			///<Frames left until the render scale may change again
+		std::vector<veRenderScaleSample_t> m_renderScaleHistory;		///<Measured GPU times and chosen render scales of the last frames
+		VkQueryPool					m_timestampPool = VK_NULL_HANDLE;	///<per frame in flight: two timestamps around the light passes
+		float						m_timestampPeriod = 0.0f;			///<Nanoseconds per timestamp tick, 0 if the device has no timestamps
+		std::vector<bool>			m_timestampsWritten;				///<per frame in flight: the command buffer writes the timestamps
+
+		//depth pre-pass
+		bool						m_depthPrepass = false;				///<if true, fill the depth map once before the light passes
+		bool						m_wireframe = false;				///<if true, objects are drawn as wireframes
+		bool						m_wireframeSupported = false;		///<the device can draw lines instead of filled triangles
+		VkRenderPass				m_renderPassDepthPrepass;			///<The depth only render pass of the depth pre-pass
+		VkFramebuffer				m_depthPrepassFramebuffer;			///<Framebuffer holding only the depth map
+
+		//clustered lighting
+		bool						m_clusteredLighting = false;		///<if true, draw all lights in one pass using light clusters
+		std::vector<VkBuffer>		m_clusterBuffers;					///<per frame in flight: storage buffer holding lights and clusters
+		std::vector<VmaAllocation>	m_clusterBuffersAllocation;			///<VMA information for the cluster buffers
+		std::vector<std::vector<uint32_t>> m_clusterLightLists;			///<CPU side light lists of the clusters, reused every frame
 
-		VkDescriptorPool			m_descriptorPool;					///<Descriptor pool for creating descriptor sets
 		VkDescriptorSetLayout		m_descriptorSetLayoutPerObject;		///<Descriptor set layout for each scene object
 
 		std::vector<VkSemaphore>	m_imageAvailableSemaphores;			///<sem for waiting for the next swapchain image
 		std::vector<VkSemaphore>	m_renderFinishedSemaphores;			///<sem for signalling that rendering done
 		std::vector<VkSemaphore>	m_overlaySemaphores;				///<sem for signalling that rendering done
-		std::vector<VkFence>		m_inFlightFences;					///<fences for halting the next image render until this one is done
-		size_t						m_currentFrame = 0;					///<int for the fences
+		std::vector<uint64_t>		m_frameValues;						///<per frame in flight: timeline value of its last submission, its resources are free when reached
+		std::vector<uint64_t>		m_imageValues;						///<per swapchain image: timeline value of the last submission drawing into it
+		VERenderGraph *				m_renderGraph = nullptr;			///<Orders the passes of the primary buffer and records the barriers between them
+		bool						m_timelineSupported = false;		///<the device has timeline semaphores
 		bool						m_framebufferResized = false;		///<signal that window size is changing
 
 		void createSyncObjects();					//create the sync objects
-		void cleanupSwapChain();					//delete the swapchain
+		virtual void createRenderPasses();			//create the light render passes, they do not depend on the swapchain size
+		virtual void destroyRenderPasses();			//destroy the light render passes
+		virtual void cleanupSwapChain();			//delete the swapchain
+		virtual void createSwapchainResources();	//create depth map and framebuffers for the swapchain
+		virtual void handOverSwapChainImage();		//batch the transition of the swapchain image for the overlay or presenting
+		virtual void registerDepthImage(VkImage image, VkFormat format, VkImageLayout layout);	//tell the layout tracker about a depth image
+		virtual void addShadowPass(uint32_t numPass);	//add the shadow passes of a light to the render graph
+		virtual void readShadowMaps(uint32_t pass);		//declare that a render graph pass samples the shadow maps
 
 		virtual void initRenderer();				//init the renderer
 		virtual void createSubrenderers();			//create the subrenderers
 		virtual void recordCmdBuffers();			//record the command buffers
+		virtual void recordCmdBuffersShadow(veFrameVector<std::future<void>> &futures);						//record the shadow subrenderer in parallel
+		virtual void recordCmdBuffersLight(VESubrender *pSub, veFrameVector<std::future<void>> &futures);	//record a light pass subrenderer in parallel
+		virtual void executeCmdBuffersShadow(uint32_t numPass);												//execute the shadow passes of a light in the primary buffer
+		virtual VkCommandBuffer recordCmdBuffersShadowCache();												//record the drawing of the outdated maps of the cache atlas
+		virtual void updateShadowCacheTiles(bool hasStaticCasters);											//give each shadow camera a tile in the cache atlas
+		virtual bool allocateShadowCacheTile(uint32_t dim, VkRect2D &tile);									//take a free tile of the cache atlas
+		virtual void freeShadowCacheTile(VkRect2D tile);													//give a tile back to the cache atlas
+		virtual bool shadowCacheValid(veShadowCache_t &cache, VELight *pLight, uint32_t j);					//true if a cached map fits the shadow camera
+		virtual bool shadowTilesChanged();			//true if a light got new atlas tiles since the current frame was recorded
+		virtual bool usesCubeShadow(VELight *pLight);	//true if the light draws its shadow into the cube shadow map
+		virtual VkCommandPool getThreadCommandPool(uint32_t frameIndex);									//command pool of the calling thread
+		virtual VkCommandBuffer createSecondaryCmdBuffer(VkCommandPool commandPool, VkRenderPass renderPass, VkFramebuffer frameBuffer);	//create and begin a secondary buffer
+		virtual bool cmdBuffersDirty();				//true if a subrenderer must record the current frame again
+		virtual void freeOutdatedCmdBuffers();		//free the outdated light pass buffers before the recording jobs start
+		virtual uint32_t getNumLightPasses();		//number of light passes (with shadow passes) to record
+		virtual void updateClusterBuffer();			//assign lights to clusters and copy them to the cluster buffer
+		virtual void updateLightPasses();			//compute screen area and lit entities of the light passes
+		virtual bool lightPassesChanged();			//true if the light passes differ from when the current frame was recorded
+		virtual void updateRenderScale();			//measure the GPU time of the light passes and adapt the render scale to the budget
+		virtual bool renderExtentChanged();			//true if the render extent differs from when the current frame was recorded
+		virtual VkFramebuffer getLightFramebuffer(uint32_t imageIndex);	//framebuffer the light passes of an image draw into
+		virtual void beginFrame();					//wait for the fence of the next frame in flight
 		virtual void drawFrame();					//draw one frame
 		virtual void prepareOverlay();				//prepare to draw the overlay
 		virtual void drawOverlay();					//Draw the overlay (GUI)
@@ -78,6 +239,48 @@ namespace ve {
 		///Destructor of class VERendererForward
 		virtual ~VERendererForward() {};
 		virtual void deleteCmdBuffers();
+		virtual void invalidateShadowCache();
+		virtual bool passLightsEntity(uint32_t numPass, VEEntity *pEntity);
+		virtual void setClusteredLighting(bool clustered);
+		///\returns true if all lights are rendered in a single clustered light pass
+		virtual bool getClusteredLighting() { return m_clusteredLighting; };
+		virtual void setDepthPrepass(bool prepass);
+		///\returns true if the depth map is filled by a depth pre-pass before the light passes
+		virtual bool getDepthPrepass() { return m_depthPrepass; };
+		///\returns true if light passes test the depth bounds of the light volume
+		virtual bool getDepthBoundsSupported() { return m_depthBoundsSupported; };
+		virtual void setWireframe(bool wireframe);
+		///\returns true if objects are drawn as wireframes
+		virtual bool getWireframe() { return m_wireframe; };
+		virtual vePipelineKey_t getLightPassPipelineKey(std::vector<std::string> shaderFileNames, VkPipelineLayout pipelineLayout);
+		virtual std::vector<VkPipeline> acquireMaterialPipelines(bool normalMap, VkPipelineLayout pipelineLayout);
+		virtual uint32_t getMaterialPipelineIndex(VELight *pLight);
+		virtual void setLightPassState(VkCommandBuffer commandBuffer, uint32_t numPass);
+		virtual void setDynamicResolution(bool dynamicResolution);
+		///\returns true if the light passes draw a scaled render area that is upscaled into the swapchain image
+		virtual bool getDynamicResolution() { return m_dynamicResolution; };
+		virtual void setRenderTimeBudget(float budget);
+		///\returns the GPU time the light passes may take per frame (s)
+		virtual float getRenderTimeBudget() { return m_renderTimeBudget; };
+		virtual void setRenderScaleRange(float minScale, float maxScale);
+		///\returns the current scale of the render area relative to the swapchain extent
+		virtual float getRenderScale() { return m_renderScale; };
+		///\returns the average measured GPU time of the light passes (s), 0 if the device has no timestamps
+		virtual float getRenderTime() { return m_renderTime; };
+		///\returns the measured GPU times and chosen render scales of the last RENDER_SCALE_HISTORY frames, oldest first
+		virtual std::vector<veRenderScaleSample_t> &getRenderScaleHistory() { return m_renderScaleHistory; };
+		///\returns the extent of the render area the light passes draw into
+		virtual VkExtent2D getRenderExtent() { return m_renderExtent; };
+		virtual void setCubeShadows(bool cubeShadows);
+		///\returns true if point light shadows are drawn into the cube shadow map in a single multiview pass
+		virtual bool getCubeShadows() { return m_cubeShadows; };
+		virtual void setBindlessTextures(bool bindless);
+		///\returns true if material subrenderers take their textures from the bindless table
+		virtual bool getBindlessTextures() { return m_bindlessTextures; };
+		virtual void setPushConstants(bool pushConstants);
+		///\returns true if material subrenderers push the material index for each draw call
+		virtual bool getPushConstants() { return m_pushConstants; };
+		virtual std::vector<VkPushConstantRange> getPushConstantRanges();
 		///\returns the per frame descriptor set layout
 		virtual VkDescriptorSetLayout	getDescriptorSetLayoutPerObject() { return m_descriptorSetLayoutPerObject; };
 		///\returns the shadow descriptor set layout for the shadow
@@ -86,18 +289,22 @@ namespace ve {
 		virtual std::vector<VkDescriptorSet> &getDescriptorSetsShadow() { return m_descriptorSetsShadow; };
 		///\returns pointer to the swap chain framebuffer vector
 		virtual std::vector<VkFramebuffer> &getSwapChainFrameBuffers() { return m_swapChainFramebuffers;  };
-		///\returns the descriptor pool of the per frame descriptors
-		virtual VkDescriptorPool		getDescriptorPool() { return m_descriptorPool; };
 		///\returns the render pass
 		virtual VkRenderPass			getRenderPass() { return m_renderPassClear; };
 		///\returns the shadow render pass
 		virtual VkRenderPass			getRenderPassShadow() { return m_renderPassShadow; };
+		///\returns the multiview render pass of the cube shadow map
+		virtual VkRenderPass			getRenderPassCubeShadow() { return m_renderPassCubeShadow; };
+		///\returns the render pass of the depth pre-pass
+		virtual VkRenderPass			getRenderPassDepthPrepass() { return m_renderPassDepthPrepass; };
 		///\returns the depth map vector
 		VETexture *						getDepthMap() { return m_depthMap; };
-		///\returns a specific depth map from the whole set
-		std::vector<VETexture *>		getShadowMap( uint32_t idx) { return m_shadowMaps[idx]; };
-		///\returns the 2D extent of the shadow map
-		virtual VkExtent2D				getShadowMapExtent() { return m_shadowMaps[0][0]->m_extent; };
+		///\returns the shadow atlas
+		VETexture *						getShadowAtlas() { return m_shadowAtlas; };
+		///\returns the 2D extent of the shadow atlas
+		virtual VkExtent2D				getShadowMapExtent() { return m_shadowAtlas->m_extent; };
+		///\returns the 2D extent of a face of the cube shadow map
+		virtual VkExtent2D				getCubeShadowMapExtent() { return m_cubeShadowMap->m_extent; };
 	};
 
 }
@@ -510,7 +510,7 @@ namespace ve {
 
 		VEEntity *pEntity = createEntity(entityName, entityType, pMesh, pMat, glm::mat4(1.0f), nullptr);
 		pEntity->setTransform(glm::scale(glm::vec3(500.0f, 500.0f, 500.0f)));
-		pEntity->m_castsShadow = false;
+		pEntity->setCastsShadow(false);
 
 		return pEntity;
 	}
@@ -539,7 +539,7 @@ namespace ve {
 		}
 
 		VEEntity *pEntity = createEntity(entityName, VEEntity::VE_ENTITY_TYPE_SKYPLANE, pMesh, pMat, glm::mat4(1.0f), nullptr);
-		pEntity->m_castsShadow = false;
+		pEntity->setCastsShadow(false);
 
 		return pEntity;
 	}
@@ -576,14 +576,14 @@ namespace ve {
 		sp1->multiplyTransform(glm::rotate(glm::mat4(1.0f), -(float)M_PI / 2.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		sp1->multiplyTransform(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, scale / 2.0f)));
 		parent->addChild(sp1);
-		sp1->m_castsShadow = false;
+		sp1->setCastsShadow(false);
 
 		sp1 = getSceneManagerPointer()->createSkyplane(filekey + "/Skyplane2", basedir, texNames[1]);
 		sp1->multiplyTransform(glm::scale(glm::mat4(1.0f), glm::vec3(scale, 1.0f, scale)));
 		sp1->multiplyTransform(glm::rotate(glm::mat4(1.0f), (float)M_PI / 2.0f, glm::vec3(1.0f, 0.0f, 0.0f)));
 		sp1->multiplyTransform(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -scale / 2.0f)));
 		parent->addChild(sp1);
-		sp1->m_castsShadow = false;
+		sp1->setCastsShadow(false);
 
 		sp1 = getSceneManagerPointer()->createSkyplane(filekey + "/Skyplane3", basedir, texNames[2]);
 		sp1->multiplyTransform(glm::scale(glm::mat4(1.0f), glm::vec3(scale, 1.0f, scale)));
@@ -591,7 +591,7 @@ namespace ve {
 		sp1->multiplyTransform(glm::rotate(glm::mat4(1.0f), (float)M_PI, glm::vec3(1.0f, 0.0f, 0.0f)));
 		sp1->multiplyTransform(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, scale / 2.0f, 0.0f)));
 		parent->addChild(sp1);
-		sp1->m_castsShadow = false;
+		sp1->setCastsShadow(false);
 
 		sp1 = getSceneManagerPointer()->createSkyplane(filekey + "/Skyplane4", basedir, texNames[4] );
 		sp1->multiplyTransform(glm::scale(glm::mat4(1.0f), glm::vec3(-scale, 1.0f, -scale)));
@@ -599,7 +599,7 @@ namespace ve {
 		sp1->multiplyTransform(glm::rotate(glm::mat4(1.0f), (float)M_PI / 2.0f, glm::vec3(0.0f, 0.0f, 01.0f)));
 		sp1->multiplyTransform(glm::translate(glm::mat4(1.0f), glm::vec3(scale / 2.0f, 0.0f, 0.0f)));
 		parent->addChild(sp1);
-		sp1->m_castsShadow = false;
+		sp1->setCastsShadow(false);
 
 		sp1 = getSceneManagerPointer()->createSkyplane(filekey + "/Skyplane5", basedir, texNames[5]);
 		sp1->multiplyTransform(glm::scale(glm::mat4(1.0f), glm::vec3(scale, 1.0f, scale)));
@@ -607,7 +607,7 @@ namespace ve {
 		sp1->multiplyTransform(glm::rotate(glm::mat4(1.0f), -(float)M_PI / 2.0f, glm::vec3(0.0f, 0.0f, 1.0f)));
 		sp1->multiplyTransform(glm::translate(glm::mat4(1.0f), glm::vec3(-scale / 2.0f, 0.0f, 0.0f)));
 		parent->addChild(sp1);
-		sp1->m_castsShadow = false;
+		sp1->setCastsShadow(false);
 
 		return parent;
 	}
@@ -622,7 +622,7 @@ namespace ve {
 	*
 	* Makes this nodes and their children to copy their data to the GPU
 	*
-	* \param[in] imageIndex Index of the swapchain image that is currently used.
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	*
 	*/
 	void VESceneManager::updateSceneNodes(uint32_t imageIndex ) {
@@ -734,6 +734,7 @@ namespace ve {
 	*/
 	void  VESceneManager::switchOnLight(VELight * light) {
 		m_lights.push_back(light); 
+		getRendererPointer()->invalidateCmdBuffers();
 	};
 
 
@@ -754,6 +755,23 @@ namespace ve {
 				m_lights.pop_back();							//remove last light
 			}
 		}
+		getRendererPointer()->invalidateCmdBuffers();
+	}
+
+
+	/**
+	*
+	* \brief Set the current camera
+	*
+	* The camera's descriptor sets are recorded into the command buffers, so they have to be recorded again.
+	*
+	* \param[in] cam Pointer to the camera
+	*
+	*/
+	void VESceneManager::setCamera(VECamera *cam) {
+		if (m_camera == cam) return;
+		m_camera = cam;
+		getRendererPointer()->invalidateCmdBuffers();
 	}
 
 
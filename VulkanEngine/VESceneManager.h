@@ -111,11 +111,7 @@ namespace ve {
 
 		///\returns a pointer to the current camera
 		VECamera*		getCamera() { return m_camera; };
-		/**
-		* \brief Set the the current camera
-		* \param[in] cam Pointer to the camera
-		*/
-		void			setCamera( VECamera *cam) { m_camera = cam; };
+		void			setCamera( VECamera *cam);				//Set the current camera
 		///\returns a list with names of the current lights shining on the scene
 		std::vector<VELight*> & getLights() { return m_lights;  };
 		void			switchOnLight(VELight * light);		//Add a light to the m_lights list
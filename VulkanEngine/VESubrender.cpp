@@ -14,36 +14,97 @@ namespace ve {
 	
 
 	/**
-	* \brief If the window size changes then some resources have to be recreated to fit the new size.
+	*
+	* \brief If a renderer setting changes then some resources have to be recreated to fit the new setting.
+	*
+	* The PSOs are only built again if they had been requested before. The resource layout is destroyed only after
+	* its identically defined successor exists, so the freed resource sets are recycled for the new layout.
+	*
 	*/
 	void VESubrender::recreateResources() {
+		bool requested = pipelinesRequested();
+
+		VkDescriptorSetLayout oldLayout = m_descriptorSetLayoutResources;
+		m_descriptorSetLayoutResources = VK_NULL_HANDLE;		//keep closeSubrenderer() from destroying it
 		closeSubrenderer();
 		initSubrenderer();
+
+		if (oldLayout != VK_NULL_HANDLE) {
+			getRendererPointer()->getDescriptorAllocator()->releaseLayout(oldLayout, m_descriptorSetLayoutResources);
+			vkDestroyDescriptorSetLayout(getRendererPointer()->getDevice(), oldLayout, nullptr);
+		}
+		if (requested) requestPipelines();
+	}
+
+
+	/**
+	*
+	* \brief Start building the PSOs of the subrenderer, if this has not been done yet
+	*
+	* The PSOs are created by a job of the engine's thread pool, so the PSOs of several subrenderers
+	* are compiled concurrently. All jobs share the renderer's pipeline cache, which is internally synchronized.
+	*
+	*/
+	void VESubrender::requestPipelines() {
+		if (m_pipelinesBuilt.valid()) return;
+		m_pipelinesBuilt = getEnginePointer()->m_threadPool->submit([this]() { createPipelines(); }).share();
+	}
+
+
+	/**
+	*
+	* \brief Wait until the PSOs of the subrenderer have been built
+	*
+	* Returns at once if the PSOs have not been requested. Must not be called from a job of the thread pool,
+	* since the building job might still wait in the queue behind it.
+	*
+	*/
+	void VESubrender::waitForPipelines() {
+		if (m_pipelinesBuilt.valid()) m_pipelinesBuilt.get();
 	}
 
+
 	/**
 	* \brief Close down the subrenderer and destroy all local resources.
 	*/
 	void VESubrender::closeSubrenderer() {
+		waitForPipelines();
+		m_pipelinesBuilt = std::shared_future<void>();
+
+		deleteCmdBuffers();
+
+		//PSOs and pipeline layouts are shared, the registry destroys them when the last subrenderer releases them
 		for (auto pipeline : m_pipelines) {
-			vkDestroyPipeline(getRendererPointer()->getDevice(), pipeline, nullptr);
+			getRendererPointer()->getPipelineRegistry()->releasePipeline(pipeline);
 		}
-		if (m_pipelineLayout != VK_NULL_HANDLE)
-			vkDestroyPipelineLayout(getRendererPointer()->getDevice(), m_pipelineLayout, nullptr);
+		m_pipelines.clear();
+
+		getRendererPointer()->getPipelineRegistry()->releasePipelineLayout(m_pipelineLayout);
+		m_pipelineLayout = VK_NULL_HANDLE;
 
-		if (m_descriptorSetLayoutResources != VK_NULL_HANDLE)
+		if (m_descriptorSetLayoutResources != VK_NULL_HANDLE) {
+			getRendererPointer()->getDescriptorAllocator()->releaseLayout(m_descriptorSetLayoutResources);
 			vkDestroyDescriptorSetLayout(getRendererPointer()->getDevice(), m_descriptorSetLayoutResources, nullptr);
+		}
+		m_descriptorSetLayoutResources = VK_NULL_HANDLE;
 	}
 
 
 	/**
 	* \brief Bind the subrenderer's pipeline to a commandbuffer
 	*
+	* If the renderer uses clustered lighting and the subrenderer created a clustered variant
+	* in m_pipelines[1], then this variant is bound.
+	*
 	* \param[in] commandBuffer The command buffer to bind the pipeline to
+	* \param[in] pLight The light of the light pass, subrenderers with PSOs per light type choose by it
 	*
 	*/
-	void VESubrender::bindPipeline( VkCommandBuffer commandBuffer ) {
-		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[0]);	//bind the PSO
+	void VESubrender::bindPipeline( VkCommandBuffer commandBuffer, VELight *pLight ) {
+		VkPipeline pipeline = m_pipelines[0];
+		if (m_pipelines.size() > 1 && getRendererPointer()->getClusteredLighting()) pipeline = m_pipelines[1];
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);	//bind the PSO
 	}
 
 
@@ -51,15 +112,15 @@ namespace ve {
 	* \brief Bind per frame descriptor sets to the pipeline layout
 	*
 	* \param[in] commandBuffer The command buffer that is used for recording commands
-	* \param[in] imageIndex The index of the swapchain image that is currently used
+	* \param[in] imageIndex Index of the frame in flight that is currently prepared
 	* \param[in] pCamera Pointer to the current light camera
-	* \param[in] pLight Pointer to the currently used light
+	* \param[in] pLight Pointer to the currently used light, nullptr if only the camera set is needed (G-buffer pass)
 	* \param[in] descriptorSetsShadow Shadow maps that are used for creating shadow
 	*
 	*/
 	void VESubrender::bindDescriptorSetsPerFrame(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
 													VECamera *pCamera, VELight *pLight, 
-													std::vector<VkDescriptorSet> descriptorSetsShadow ) {
+													const std::vector<VkDescriptorSet> &descriptorSetsShadow ) {
 
 		//set 0...cam UBO
 		//set 1...light resources
@@ -67,14 +128,18 @@ namespace ve {
 		//set 3...per object UBO
 		//set 4...additional per object resources
 
-		std::vector<VkDescriptorSet> set =
-			{ pCamera->m_descriptorSetsUBO[imageIndex], pLight->m_descriptorSetsUBO[imageIndex] };
+		VkDescriptorSet sets[3] = { pCamera->m_descriptorSetsUBO[imageIndex] };
+		uint32_t numSets = 1;
+
+		if (pLight != nullptr) {
+			sets[numSets++] = pLight->m_descriptorSetsUBO[imageIndex];
+		}
 
-		if(descriptorSetsShadow.size()>0) {
-			set.push_back(descriptorSetsShadow[imageIndex]);
+		if(pLight != nullptr && descriptorSetsShadow.size()>0) {
+			sets[numSets++] = descriptorSetsShadow[imageIndex];
 		}
 
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, (uint32_t)set.size(), set.data(), 0, nullptr);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, numSets, sets, 0, nullptr);
 	}
 
 
@@ -97,12 +162,31 @@ namespace ve {
 		//set 3...per object UBO
 		//set 4...additional per object resources
 
-		std::vector<VkDescriptorSet> sets = { entity->m_descriptorSetsUBO[imageIndex] };
+		VkDescriptorSet sets[2];
+		uint32_t numSets = 0;
+		sets[numSets++] = entity->m_descriptorSetsUBO[imageIndex];
 		if (entity->m_descriptorSetsResources.size() > 0) {
-			sets.push_back( entity->m_descriptorSetsResources[imageIndex] );
+			sets[numSets++] = entity->m_descriptorSetsResources[imageIndex];
 		}
 
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 3, (uint32_t)sets.size(), sets.data(), 0, nullptr);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 3, numSets, sets, 0, nullptr);
+	}
+
+
+	/**
+	*
+	* \brief Push the per object data of an entity
+	*
+	* Used if m_pushConstants is true, the material index is then read from the push constants instead of the UBO
+	* in set 3. The pipeline layout must contain the range returned by VERendererForward::getPushConstantRanges().
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] entity Pointer to the entity to draw
+	*
+	*/
+	void VESubrender::pushConstantsPerEntity(VkCommandBuffer commandBuffer, VEEntity *entity) {
+		vkCmdPushConstants(	commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT,
+							0, sizeof(VEEntity::vePushConstantsPerObject_t), &entity->m_pushConstants);
 	}
 
 
@@ -123,21 +207,50 @@ namespace ve {
 	void VESubrender::draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
 							uint32_t numPass,
 							VECamera *pCamera, VELight *pLight,
-							std::vector<VkDescriptorSet> descriptorSetsShadow) {
+							const std::vector<VkDescriptorSet> &descriptorSetsShadow) {
+
+		draw(commandBuffer, imageIndex, numPass, pCamera, pLight, descriptorSetsShadow, 0, (uint32_t)m_entities.size());
+	}
 
-		if (m_entities.size() == 0) return;
+
+	/**
+	* \brief Draw a chunk of the associated entities.
+	*
+	* Chunks can be recorded into different command buffers by different threads at the same time,
+	* since only the given command buffer is written to.
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] numPass The number of the light that has been rendered
+	* \param[in] pCamera Pointer to the current light camera
+	* \param[in] pLight Pointer to the current light
+	* \param[in] descriptorSetsShadow The shadow maps to be used.
+	* \param[in] startIdx Index of the first entity to draw
+	* \param[in] endIdx Index after the last entity to draw
+	*
+	*/
+	void VESubrender::draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
+							uint32_t numPass,
+							VECamera *pCamera, VELight *pLight,
+							const std::vector<VkDescriptorSet> &descriptorSetsShadow,
+							uint32_t startIdx, uint32_t endIdx) {
+
+		endIdx = std::min(endIdx, (uint32_t)m_entities.size());
+		if (startIdx >= endIdx) return;
 
 		if (numPass > 0 && getClass() != VE_SUBRENDERER_CLASS_OBJECT) return;
 
-		bindPipeline(commandBuffer);
+		bindPipeline(commandBuffer, pLight);
 
 		setDynamicPipelineState( commandBuffer, numPass );
 
 		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, descriptorSetsShadow );
 
-		//go through all entities and draw them
-		for (auto pEntity : m_entities) {
-			if (pEntity->m_drawEntity ) {
+		//go through all entities of the chunk and draw them, additive light passes skip entities out of reach
+		for (uint32_t i = startIdx; i < endIdx; i++) {
+			VEEntity *pEntity = m_entities[i];
+			if (pEntity->getDrawEntity() && (numPass == 0 || getRendererPointer()->passLightsEntity(numPass, pEntity))) {
+				if (m_pushConstants) pushConstantsPerEntity(commandBuffer, pEntity);	//push the entity's per object data
 				bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity);	//bind the entity's descriptor sets
 				drawEntity(commandBuffer, imageIndex, pEntity);
 			}
@@ -176,7 +289,9 @@ namespace ve {
 	*/
 	void VESubrender::addEntity(VEEntity *pEntity) {
 		m_entities.push_back(pEntity);
+		m_entitiesVersion++;
 		pEntity->m_pSubrenderer = this;
+		getRendererPointer()->invalidateCmdBuffers(this);
 	}
 
 	/**
@@ -184,11 +299,15 @@ namespace ve {
 	* \brief Removes an entity from this subrenderer - does NOT delete it
 	*
 	* Since we use indices and each entity knows its onw index, this is an O(1) operation.
+	* The resource descriptor sets of the entity are given back for recycling.
 	*
 	* \param[in] pEntity Pointer to the entity to be removed
 	*
 	*/
 	void VESubrender::removeEntity(VEEntity *pEntity) {
+		if (m_descriptorSetLayoutResources != VK_NULL_HANDLE) {
+			getRendererPointer()->getDescriptorAllocator()->freeDescriptorSets(m_descriptorSetLayoutResources, pEntity->m_descriptorSetsResources);
+		}
 
 		uint32_t size = (uint32_t)m_entities.size();
 		if (size == 0) return;
@@ -199,6 +318,68 @@ namespace ve {
 				m_entities.pop_back();							//remove the last
 			}
 		}
+		m_entitiesVersion++;
+		getRendererPointer()->invalidateCmdBuffers(this);
+	}
+
+
+	/**
+	*
+	* \brief Mark the cached secondary command buffers of all frames in flight as outdated
+	*
+	* The buffers are not freed here, since they might still be in flight. They are replaced
+	* the next time the renderer records the frame in flight they belong to. The lists grow with the number of
+	* frames in flight, and both always have the same size.
+	*
+	*/
+	void VESubrender::invalidateCmdBuffers() {
+		uint32_t numFrames = getRendererPointer()->getFramesInFlight();
+		if (m_secondaryBuffers.size() < numFrames) m_secondaryBuffers.resize(numFrames);
+		m_secondaryBuffersDirty.assign(m_secondaryBuffers.size(), true);
+	}
+
+
+	/**
+	* \brief Free the cached secondary command buffers of all frames in flight
+	*/
+	void VESubrender::deleteCmdBuffers() {
+		for (uint32_t i = 0; i < m_secondaryBuffers.size(); i++) {
+			deleteCmdBuffers(i);
+		}
+	}
+
+
+	/**
+	*
+	* \brief Free the cached secondary command buffers of one frame in flight and mark them as outdated
+	*
+	* \param[in] frameIndex Index of the frame in flight whose buffers are freed. The caller must make sure that they are not in flight.
+	*
+	*/
+	void VESubrender::deleteCmdBuffers(uint32_t frameIndex) {
+		if (frameIndex >= m_secondaryBuffers.size()) invalidateCmdBuffers();		//the ring of frames in flight was rebuilt
+		if (frameIndex >= m_secondaryBuffers.size()) return;					//not a frame in flight, nothing to free
+
+		for (auto &sb : m_secondaryBuffers[frameIndex]) {
+			if (sb.buffer != VK_NULL_HANDLE)
+				vkFreeCommandBuffers(getRendererPointer()->getDevice(), sb.pool, 1, &sb.buffer);
+		}
+		m_secondaryBuffers[frameIndex].clear();
+		m_secondaryBuffersDirty[frameIndex] = true;
+	}
+
+
+	/**
+	*
+	* \brief Find out whether the secondary command buffers of a frame in flight must be recorded again
+	*
+	* \param[in] frameIndex Index of the frame in flight
+	* \returns true if the draw list changed since the buffers of this frame were recorded
+	*
+	*/
+	bool VESubrender::cmdBuffersDirty(uint32_t frameIndex) {
+		if (frameIndex >= m_secondaryBuffersDirty.size()) return true;
+		return m_secondaryBuffersDirty[frameIndex];
 	}
 }
 
@@ -31,7 +31,9 @@ namespace ve {
 			VE_SUBRENDERER_CLASS_BACKGROUND,					///<Background, draw only once
 			VE_SUBRENDERER_CLASS_OBJECT,						///<Object, draw once for each light
 			VE_SUBRENDERER_CLASS_SHADOW,						///<Shadow renderer
-			VE_SUBRENDERER_CLASS_OVERLAY						///<GUI overlay
+			VE_SUBRENDERER_CLASS_OVERLAY,						///<GUI overlay
+			VE_SUBRENDERER_CLASS_GEOMETRY,						///<Deferred object, draw once into the G-buffer
+			VE_SUBRENDERER_CLASS_LIGHT							///<Deferred screen space light pass, draw once for each light
 		};
 
 		/**
@@ -47,15 +49,30 @@ namespace ve {
 			VE_SUBRENDERER_TYPE_SKYPLANE,					///<Use a skyplane to create a sky box
 			VE_SUBRENDERER_TYPE_TERRAIN_WITH_HEIGHTMAP,		///<A tesselated terrain using a height map
 			VE_SUBRENDERER_TYPE_NUKLEAR,					///<A Nuklear based GUI
-			VE_SUBRENDERER_TYPE_SHADOW						///<Draw entities for the shadow pass
+			VE_SUBRENDERER_TYPE_SHADOW,						///<Draw entities for the shadow pass
+			VE_SUBRENDERER_TYPE_DEFERRED_LIGHT				///<Apply a light to the G-buffer of a deferred renderer
+		};
+
+		///A cached secondary command buffer, together with the pool it was allocated from
+		struct veSecondaryBuffer_t {
+			uint32_t		numPass;		///<Light pass (or shadow camera) this buffer belongs to
+			VkCommandPool	pool;			///<Command pool the buffer was allocated from, pools are per thread
+			VkCommandBuffer	buffer;			///<The secondary command buffer
 		};
 
 	protected:
 		VkDescriptorSetLayout	m_descriptorSetLayoutResources = VK_NULL_HANDLE;	///<Descriptor set 3 : per object additional resources
 		VkPipelineLayout		m_pipelineLayout = VK_NULL_HANDLE;					///<Pipeline layout
 		std::vector<VkPipeline>	m_pipelines;										///<Pipeline for light pass
+		bool					m_pushConstants = false;							///<The material index is pushed instead of being read from the UBO in set 3
 
 		std::vector<VEEntity *> m_entities;											///<List of associated entities
+		uint64_t				m_entitiesVersion = 0;								///<Increased whenever an entity is added or removed
+
+		std::vector<std::vector<veSecondaryBuffer_t>> m_secondaryBuffers;			///<Cached secondary command buffers, one list per frame in flight
+		std::vector<bool>		m_secondaryBuffersDirty;							///<Per frame in flight: the cached buffers must be recorded again
+
+		std::shared_future<void> m_pipelinesBuilt;									///<Thread pool job creating the PSOs, invalid until they are requested
 
 	public:
 		///Constructor of subrender class
@@ -68,16 +85,27 @@ namespace ve {
 		///\returns the type of the subrenderer
 		virtual veSubrenderType getType() = 0;
 
-		///Create descriptor set layout, pipeline layout and PSO
+		///Create descriptor set layout and pipeline layout
 		virtual void	initSubrenderer() {};
+		///Create the PSOs, called by a job of the thread pool - does nothing for the base class
+		virtual void	createPipelines() {};
+		///\returns true if the PSOs are needed right from the start, false if they are built when the first entity arrives
+		virtual bool	pipelinesNeededAtStartup() { return false; };
+		virtual void	requestPipelines();
+		virtual void	waitForPipelines();
+		///\returns true if building the PSOs has been started
+		bool			pipelinesRequested() { return m_pipelinesBuilt.valid(); };
 		virtual void	closeSubrenderer();
 		virtual void	recreateResources();
 
-		virtual void	bindPipeline(VkCommandBuffer commandBuffer);
+		virtual void	bindPipeline(VkCommandBuffer commandBuffer, VELight *pLight = nullptr);
 		virtual void	bindDescriptorSetsPerFrame(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
 													VECamera *pCamera, VELight *pLight,
-													std::vector<VkDescriptorSet> descriptorSetsShadow);
+													const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 		virtual void	bindDescriptorSetsPerEntity(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity);
+		virtual void	pushConstantsPerEntity(VkCommandBuffer commandBuffer, VEEntity *entity);
+		///\returns true if the per object data is pushed for each draw call instead of being read from the UBO
+		bool			getPushConstants() { return m_pushConstants; };
 
 		///Set the dynamic state of the pipeline - does nothing for the base class
 		virtual void	setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass) {};
@@ -85,7 +113,24 @@ namespace ve {
 		//Draw all entities that are managed by this subrenderer
 		virtual void	draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass,
 								VECamera *pCamera, VELight *pLight,
-								std::vector<VkDescriptorSet> descriptorSetsShadow);
+								const std::vector<VkDescriptorSet> &descriptorSetsShadow);
+
+		//Draw a chunk of the entities that are managed by this subrenderer
+		virtual void	draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass,
+								VECamera *pCamera, VELight *pLight,
+								const std::vector<VkDescriptorSet> &descriptorSetsShadow,
+								uint32_t startIdx, uint32_t endIdx);
+
+		///Draw either the static or the dynamic shadow casters - does nothing for the base class
+		virtual void	drawShadowCasters(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
+											VECamera *pCamera, VELight *pLight, bool staticCasters) {};
+
+		///Draw all shadow casters of a point light into all faces of the cube shadow map - does nothing for the base class
+		virtual void	drawCubeShadow(VkCommandBuffer commandBuffer, uint32_t imageIndex, VELight *pLight) {};
+
+		///Draw a chunk of entities of another subrenderer into the depth map - does nothing for the base class
+		virtual void	drawDepthPrepass(	VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera,
+											std::vector<VEEntity*> &entities, uint32_t startIdx, uint32_t endIdx) {};
 
 		///Prepare to perform draw operation
 		virtual void prepareDraw() {};
@@ -98,8 +143,21 @@ namespace ve {
 		
 		virtual void	addEntity( VEEntity *pEntity );
 		virtual void	removeEntity(VEEntity *pEntity);
+
+		virtual void	invalidateCmdBuffers();
+		virtual void	deleteCmdBuffers();
+		virtual void	deleteCmdBuffers(uint32_t frameIndex);
+		virtual bool	cmdBuffersDirty(uint32_t frameIndex);
+		///\returns the cached secondary command buffers of a frame in flight
+		std::vector<veSecondaryBuffer_t> & getSecondaryBuffers(uint32_t frameIndex) { return m_secondaryBuffers[frameIndex]; };
+		///Mark the secondary command buffers of a frame in flight as up to date
+		void			setCmdBuffersRecorded(uint32_t frameIndex) { m_secondaryBuffersDirty[frameIndex] = false; };
 		///\returns the number of entities that this sub renderer manages
 		uint32_t		getNumberEntities() { return (uint32_t)m_entities.size(); };
+		///\returns the list of entities that this sub renderer manages
+		std::vector<VEEntity *> & getEntities() { return m_entities; };
+		///\returns a counter that is increased whenever an entity is added or removed
+		uint64_t		getEntitiesVersion() { return m_entitiesVersion; };
 		
 		///return the layout of the local pipeline
 		VkPipelineLayout getPipelineLayout() { return m_pipelineLayout; };
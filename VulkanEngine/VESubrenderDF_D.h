@@ -0,0 +1,33 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+
+namespace ve {
+
+	/**
+	* \brief Deferred subrenderer that writes entities with one diffuse texture into the G-buffer
+	*/
+	class VESubrenderDF_D : public VESubrenderFW_D {
+	protected:
+
+	public:
+		///Constructor
+		VESubrenderDF_D() {};
+		///Destructor
+		virtual ~VESubrenderDF_D() {};
+
+		///\returns the class of the subrenderer
+		virtual veSubrenderClass getClass() { return VE_SUBRENDERER_CLASS_GEOMETRY; };
+
+		virtual void initSubrenderer();
+		virtual void createPipelines();
+		virtual void setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass);
+	};
+}
+
@@ -0,0 +1,70 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	* \brief Initialize the subrenderer
+	*
+	* Create descriptor set layout and pipeline layout. The layouts are the same as for the forward
+	* subrenderer, so entities are handled the same way. The PSOs are created later by createPipelines().
+	*
+	*/
+	void VESubrenderDF_DN::initSubrenderer() {
+		VESubrender::initSubrenderer();
+
+		vh::vhRenderCreateDescriptorSetLayout(getRendererDeferredPointer()->getDevice(),
+			{ 1,											1 },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,	VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
+			{ VK_SHADER_STAGE_FRAGMENT_BIT,					VK_SHADER_STAGE_FRAGMENT_BIT },
+			&m_descriptorSetLayoutResources);
+
+		VkDescriptorSetLayout perObjectLayout = getRendererDeferredPointer()->getDescriptorSetLayoutPerObject();
+
+		m_pipelineLayout = getRendererDeferredPointer()->getPipelineRegistry()->acquirePipelineLayout(
+			{ perObjectLayout, perObjectLayout,  getRendererDeferredPointer()->getDescriptorSetLayoutShadow(), perObjectLayout, m_descriptorSetLayoutResources });
+	}
+
+
+	/**
+	*
+	* \brief Create the PSOs of the subrenderer
+	*
+	* The PSO writes into the G-buffer maps of the deferred renderer.
+	*
+	*/
+	void VESubrenderDF_DN::createPipelines() {
+		vePipelineKey_t key;
+		key.type = VE_PIPELINE_TYPE_GBUFFER;
+		key.shaderFileNames = { "shader/Forward/DN/vert.spv", "shader/Deferred/DN/frag.spv" };
+		key.pipelineLayout = m_pipelineLayout;
+		key.renderPass = getRendererDeferredPointer()->getRenderPassGeometry();
+		key.numColorAttachments = NUM_GBUFFER_MAPS;
+		key.polygonMode = getRendererDeferredPointer()->getWireframe() ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+		m_pipelines.push_back(getRendererDeferredPointer()->getPipelineRegistry()->acquirePipeline(key));
+	}
+
+
+	/**
+	* \brief Set the viewport and scissor to the whole G-buffer
+	*
+	* The G-buffer is written only once, so there are no blend constants to set.
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] numPass The number of the light pass, not used
+	*
+	*/
+	void VESubrenderDF_DN::setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass) {
+		vh::vhRenderSetViewport(commandBuffer, { { 0, 0 }, getRendererDeferredPointer()->getSwapChainExtent() });
+	}
+}
+
+
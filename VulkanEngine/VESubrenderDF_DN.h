@@ -0,0 +1,33 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+
+namespace ve {
+
+	/**
+	* \brief Deferred subrenderer that writes entities with a diffuse texture and a normal map into the G-buffer
+	*/
+	class VESubrenderDF_DN : public VESubrenderFW_DN {
+	protected:
+
+	public:
+		///Constructor
+		VESubrenderDF_DN() {};
+		///Destructor
+		virtual ~VESubrenderDF_DN() {};
+
+		///\returns the class of the subrenderer
+		virtual veSubrenderClass getClass() { return VE_SUBRENDERER_CLASS_GEOMETRY; };
+
+		virtual void initSubrenderer();
+		virtual void createPipelines();
+		virtual void setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass);
+	};
+}
+
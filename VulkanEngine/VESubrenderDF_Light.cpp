@@ -0,0 +1,81 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	* \brief Initialize the subrenderer
+	*
+	* Create the pipeline layout. Set 3 holds the G-buffer maps instead of the per object UBO. The PSOs are created later by createPipelines().
+	*
+	*/
+	void VESubrenderDF_Light::initSubrenderer() {
+		VESubrender::initSubrenderer();
+
+		VkDescriptorSetLayout perObjectLayout = getRendererDeferredPointer()->getDescriptorSetLayoutPerObject();
+
+		m_pipelineLayout = getRendererDeferredPointer()->getPipelineRegistry()->acquirePipelineLayout(
+			{ perObjectLayout, perObjectLayout, getRendererDeferredPointer()->getDescriptorSetLayoutShadow(), getRendererDeferredPointer()->getDescriptorSetLayoutGBuffer() });
+	}
+
+
+	/**
+	*
+	* \brief Create the PSOs of the subrenderer
+	*
+	*/
+	void VESubrenderDF_Light::createPipelines() {
+		vePipelineKey_t key;
+		key.type = VE_PIPELINE_TYPE_DEFERRED_LIGHT;
+		key.shaderFileNames = { "shader/Deferred/Light/vert.spv", "shader/Deferred/Light/frag.spv" };
+		key.pipelineLayout = m_pipelineLayout;
+		key.renderPass = getRendererDeferredPointer()->getRenderPass();
+		m_pipelines.push_back(getRendererDeferredPointer()->getPipelineRegistry()->acquirePipeline(key));
+	}
+
+
+	/**
+	* \brief Draw the screen space quad of a light
+	*
+	* The quad is computed by the vertex shader from the light UBO, so the recorded commands stay valid
+	* if the camera or the light moves.
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] numPass The number of the light that is rendered
+	* \param[in] pCamera Pointer to the current camera
+	* \param[in] pLight Pointer to the current light
+	* \param[in] descriptorSetsShadow The shadow maps to be used
+	* \param[in] startIdx Not used, the light pass has no entities
+	* \param[in] endIdx Not used, the light pass has no entities
+	*
+	*/
+	void VESubrenderDF_Light::draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass,
+									VECamera *pCamera, VELight *pLight,
+									const std::vector<VkDescriptorSet> &descriptorSetsShadow,
+									uint32_t startIdx, uint32_t endIdx) {
+
+		if (pLight == nullptr) return;
+
+		bindPipeline(commandBuffer);
+		vh::vhRenderSetViewport(commandBuffer, { { 0, 0 }, getRendererDeferredPointer()->getSwapChainExtent() });
+
+		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, descriptorSetsShadow);
+
+		VkDescriptorSet setGBuffer = getRendererDeferredPointer()->getDescriptorSetsGBuffer()[imageIndex];
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 3, 1, &setGBuffer, 0, nullptr);
+
+		vkCmdDraw(commandBuffer, 6, 1, 0, 0);		//two triangles, the vertex shader creates the positions
+	}
+
+}
+
+
@@ -0,0 +1,45 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+
+namespace ve {
+
+	/**
+	* \brief Deferred subrenderer that applies a light to the G-buffer
+	*
+	* The subrenderer has no entities. For each light it draws a screen space quad covering the light's volume,
+	* and adds the light's contribution to all G-buffer pixels inside of it.
+	*
+	*/
+	class VESubrenderDF_Light : public VESubrender {
+	protected:
+
+	public:
+		///Constructor
+		VESubrenderDF_Light() {};
+		///Destructor
+		virtual ~VESubrenderDF_Light() {};
+
+		///\returns the class of the subrenderer
+		virtual veSubrenderClass getClass() { return VE_SUBRENDERER_CLASS_LIGHT; };
+		///\returns the type of the subrenderer
+		virtual veSubrenderType getType() { return VE_SUBRENDERER_TYPE_DEFERRED_LIGHT; };
+
+		virtual void initSubrenderer();
+		virtual void createPipelines();
+		///\returns true, since the PSOs are needed in every frame
+		virtual bool pipelinesNeededAtStartup() { return true; };
+
+		virtual void draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass,
+							VECamera *pCamera, VELight *pLight,
+							const std::vector<VkDescriptorSet> &descriptorSetsShadow,
+							uint32_t startIdx, uint32_t endIdx);
+	};
+}
+
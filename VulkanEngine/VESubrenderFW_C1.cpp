@@ -14,26 +14,44 @@ namespace ve {
 	/**
 	* \brief Initialize the subrenderer
 	*
-	* Create descriptor set layout, pipeline layout and the PSO
+	* Create descriptor set layout and pipeline layout. The PSOs are created later by createPipelines().
 	*
 	*/
 	void VESubrenderFW_C1::initSubrenderer() {
 		VESubrender::initSubrenderer();
 
 		VkDescriptorSetLayout perObjectLayout = getRendererForwardPointer()->getDescriptorSetLayoutPerObject();
-		vh::vhPipeCreateGraphicsPipelineLayout(getRendererForwardPointer()->getDevice(),
-			{ perObjectLayout, perObjectLayout, getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout },
-			{ },
-			&m_pipelineLayout);
-
-		m_pipelines.resize(1);
-		vh::vhPipeCreateGraphicsPipeline(getRendererForwardPointer()->getDevice(),
-			{ "shader/Forward/C1/vert.spv", "shader/Forward/C1/frag.spv" },
-			getRendererForwardPointer()->getSwapChainExtent(),
-			m_pipelineLayout, getRendererForwardPointer()->getRenderPass(),
-			{},
-			&m_pipelines[0]);
+		m_pipelineLayout = getRendererForwardPointer()->getPipelineRegistry()->acquirePipelineLayout(
+			{ perObjectLayout, perObjectLayout, getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout });
+	}
+
+
+	/**
+	*
+	* \brief Create the PSOs of the subrenderer
+	*
+	* If the renderer uses a depth pre-pass, the PSO tests for equal depth and does not write it.
+	* Viewport, scissor and depth bounds are dynamic, they are set for each light pass.
+	*
+	*/
+	void VESubrenderFW_C1::createPipelines() {
+		VEPipelineRegistry *pRegistry = getRendererForwardPointer()->getPipelineRegistry();
 
+		vePipelineKey_t key = getRendererForwardPointer()->getLightPassPipelineKey(
+			{ "shader/Forward/C1/vert.spv", "shader/Forward/C1/frag.spv" }, m_pipelineLayout);
+		m_pipelines.push_back(pRegistry->acquirePipeline(key));
+	}
+
+
+	/**
+	* \brief Set the scissor and depth bounds of the light pass
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] numPass The number of the light pass
+	*
+	*/
+	void VESubrenderFW_C1::setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass) {
+		getRendererForwardPointer()->setLightPassState(commandBuffer, numPass);
 	}
 }
 
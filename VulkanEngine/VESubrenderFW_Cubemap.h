@@ -27,6 +27,8 @@ namespace ve {
 		virtual veSubrenderType getType() { return VE_SUBRENDERER_TYPE_CUBEMAP; };
 
 		virtual void initSubrenderer();
+		virtual void createPipelines();
+		virtual void setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass);
 		virtual void addEntity(VEEntity *pEntity);
 	};
 }
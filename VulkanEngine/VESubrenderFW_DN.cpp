@@ -14,36 +14,65 @@ namespace ve {
 	/**
 	* \brief Initialize the subrenderer
 	*
-	* Create descriptor set layout, pipeline layout and the PSO
+	* Create descriptor set layout and pipeline layout. The PSOs are created later by createPipelines().
+	* With bindless textures, set 4 is the bindless table instead of a descriptor set per entity.
 	*
 	*/
 	void VESubrenderFW_DN::initSubrenderer() {
 
 		VESubrender::initSubrenderer();
 
+		//the texture layout also exists with bindless textures, the freed texture sets of the entities are kept for it
 		vh::vhRenderCreateDescriptorSetLayout(getRendererForwardPointer()->getDevice(),
 			{ 1,											1 },
 			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,	VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER },
 			{ VK_SHADER_STAGE_FRAGMENT_BIT,					VK_SHADER_STAGE_FRAGMENT_BIT },
 			&m_descriptorSetLayoutResources);
 
+		VkDescriptorSetLayout resourceLayout = m_descriptorSetLayoutResources;
+		if (getRendererForwardPointer()->getBindlessTextures()) {
+			resourceLayout = getRendererForwardPointer()->getBindlessTable()->getDescriptorSetLayout();	//textures come from the bindless table
+		}
+
 		VkDescriptorSetLayout perObjectLayout = getRendererForwardPointer()->getDescriptorSetLayoutPerObject();
 
-		vh::vhPipeCreateGraphicsPipelineLayout(getRendererForwardPointer()->getDevice(),
-			{ perObjectLayout, perObjectLayout,  getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout, m_descriptorSetLayoutResources },
-			{ },
-			&m_pipelineLayout);
-
-		m_pipelines.resize(1);
-		vh::vhPipeCreateGraphicsPipeline(getRendererForwardPointer()->getDevice(),
-			{ "shader/Forward/DN/vert.spv", "shader/Forward/DN/frag.spv" },
-			getRendererForwardPointer()->getSwapChainExtent(),
-			m_pipelineLayout, getRendererForwardPointer()->getRenderPass(),
-			{ VK_DYNAMIC_STATE_BLEND_CONSTANTS },
-			&m_pipelines[0]);
+		m_pushConstants = getRendererForwardPointer()->getPushConstants();
+		m_pipelineLayout = getRendererForwardPointer()->getPipelineRegistry()->acquirePipelineLayout(
+			{ perObjectLayout, perObjectLayout,  getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout, resourceLayout },
+			getRendererForwardPointer()->getPushConstantRanges());
+	}
+
+
+	/**
+	*
+	* \brief Create the PSOs of the subrenderer
+	*
+	* The PSOs are specializations of the material uber shader with a normal map, one per light type,
+	* and if the renderer uses clustered lighting, also the clustered variants. If the renderer uses a depth pre-pass,
+	* the PSOs test for equal depth and do not write it. Viewport, scissor and depth bounds are dynamic, they are set
+	* for each light pass.
+	*
+	*/
+	void VESubrenderFW_DN::createPipelines() {
+		m_pipelines = getRendererForwardPointer()->acquireMaterialPipelines(true, m_pipelineLayout);
+	}
+
+
+	/**
+	* \brief Bind the PSO that is specialized for the light of the light pass
+	*
+	* \param[in] commandBuffer The command buffer to bind the pipeline to
+	* \param[in] pLight The light of the light pass
+	*
+	*/
+	void VESubrenderFW_DN::bindPipeline(VkCommandBuffer commandBuffer, VELight *pLight) {
+		VkPipeline pipeline = m_pipelines[getRendererForwardPointer()->getMaterialPipelineIndex(pLight)];
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);	//bind the PSO
 	}
 
 	void VESubrenderFW_DN::setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass) {
+		getRendererForwardPointer()->setLightPassState(commandBuffer, numPass);
+
 		if (numPass == 0) {
 			float blendConstants[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 			vkCmdSetBlendConstants(commandBuffer, blendConstants);
@@ -57,19 +86,19 @@ namespace ve {
 	/**
 	* \brief Add an entity to the subrenderer
 	*
-	* Create a UBO for this entity, a descriptor set per swapchain image, and update the descriptor sets
+	* Create a descriptor set per frame in flight for the textures of the entity, or put its material into the bindless table
 	*
 	*/
 	void VESubrenderFW_DN::addEntity(VEEntity *pEntity) {
 		VESubrender::addEntity(pEntity);
 
 		/*vh::vhBufCreateUniformBuffers(getRendererForwardPointer()->getVmaAllocator(),
-			(uint32_t)getRendererForwardPointer()->getSwapChainNumber(),
+			(uint32_t)getRendererForwardPointer()->getFramesInFlight(),
 			(uint32_t)sizeof(veUBOPerObject),
 			pEntity->m_uniformBuffers, pEntity->m_uniformBuffersAllocation);
 
 		vh::vhRenderCreateDescriptorSets(getRendererForwardPointer()->getDevice(),
-			(uint32_t)getRendererForwardPointer()->getSwapChainNumber(),
+			(uint32_t)getRendererForwardPointer()->getFramesInFlight(),
 			m_descriptorSetLayoutUBO,
 			getRendererForwardPointer()->getDescriptorPool(),
 			pEntity->m_descriptorSetsUBO);
@@ -85,10 +114,32 @@ namespace ve {
 		}
 		*/
 
-		vh::vhRenderCreateDescriptorSets(getRendererForwardPointer()->getDevice(),
-			(uint32_t)getRendererForwardPointer()->getSwapChainNumber(),
+		createEntityResources(pEntity);
+	}
+
+
+	/**
+	*
+	* \brief Create the texture descriptor sets of an entity, or put its material into the bindless table
+	*
+	* This is called again for all entities when the subrenderer is recreated. Entities that already have the
+	* descriptor sets they need keep them. With bindless textures, the sets are given back to the descriptor allocator,
+	* which recycles them once they are not in flight anymore.
+	*
+	* \param[in] pEntity The entity
+	*
+	*/
+	void VESubrenderFW_DN::createEntityResources(VEEntity *pEntity) {
+		if (getRendererForwardPointer()->getBindlessTextures()) {
+			getRendererForwardPointer()->getBindlessTable()->addMaterial(pEntity->m_pMaterial);
+			getRendererPointer()->getDescriptorAllocator()->freeDescriptorSets(m_descriptorSetLayoutResources, pEntity->m_descriptorSetsResources);
+			return;
+		}
+		if (pEntity->m_descriptorSetsResources.size() > 0) return;
+
+		getRendererPointer()->getDescriptorAllocator()->allocateDescriptorSets(
 			m_descriptorSetLayoutResources,
-			getRendererForwardPointer()->getDescriptorPool(),
+			(uint32_t)getRendererForwardPointer()->getFramesInFlight(),
 			pEntity->m_descriptorSetsResources);
 
 		for (uint32_t i = 0; i < pEntity->m_descriptorSetsResources.size(); i++) {
@@ -100,9 +151,38 @@ namespace ve {
 				{ {pEntity->m_pMaterial->mapDiffuse->m_sampler},   {pEntity->m_pMaterial->mapNormal->m_sampler} }	//samplers
 			);
 		}
+	}
 
 
+	/**
+	* \brief Recreate the subrenderer, and the texture resources of its entities if bindless textures have been switched
+	*/
+	void VESubrenderFW_DN::recreateResources() {
+		VESubrender::recreateResources();
+		for (auto pEntity : m_entities) createEntityResources(pEntity);
 	}
-}
 
 
+	/**
+	*
+	* \brief Bind per frame descriptor sets, with bindless textures also the bindless table as set 4
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pCamera Pointer to the current light camera
+	* \param[in] pLight Pointer to the current light
+	* \param[in] descriptorSetsShadow The shadow maps to be used.
+	*
+	*/
+	void VESubrenderFW_DN::bindDescriptorSetsPerFrame(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
+													VECamera *pCamera, VELight *pLight,
+													const std::vector<VkDescriptorSet> &descriptorSetsShadow) {
+
+		VESubrender::bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, descriptorSetsShadow);
+		if (!getRendererForwardPointer()->getBindlessTextures()) return;
+
+		VkDescriptorSet set = getRendererForwardPointer()->getBindlessTable()->getDescriptorSet();
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 4, 1, &set, 0, nullptr);
+	}
+}
+
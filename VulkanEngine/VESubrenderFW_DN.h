@@ -27,8 +27,15 @@ namespace ve {
 		virtual veSubrenderType getType() { return VE_SUBRENDERER_TYPE_DIFFUSEMAP_NORMALMAP; };
 
 		virtual void initSubrenderer();
+		virtual void createPipelines();
+		virtual void bindPipeline(VkCommandBuffer commandBuffer, VELight *pLight = nullptr);
 		virtual void setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass);
 		virtual void addEntity(VEEntity *pEntity);
+		virtual void createEntityResources(VEEntity *pEntity);
+		virtual void recreateResources();
+		virtual void bindDescriptorSetsPerFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex,
+												VECamera *pCamera, VELight *pLight,
+												const std::vector<VkDescriptorSet> &descriptorSetsShadow);
 	};
 }
 
@@ -42,6 +42,17 @@ namespace ve {
 							getRendererForwardPointer()->getDepthMap()->m_format,
 							NK_GLFW3_DEFAULT);
 
+		//the overlay is the last pass drawing into the swapchain image, so its render pass moves the image into the
+		//present layout. Layouts do not change render pass compatibility, so the pipeline and framebuffers stay valid
+		VkRenderPass renderPass;
+		VECHECKRESULT(vh::vhRenderCreateRenderPass(	getRendererPointer()->getDevice(),
+													getRendererForwardPointer()->getSwapChainImageFormat(),
+													getRendererForwardPointer()->getDepthMap()->m_format,
+													VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_LOAD_OP_LOAD,
+													VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, &renderPass), "Failed to create overlay render pass!");
+		vkDestroyRenderPass(getRendererPointer()->getDevice(), glfw.vulkan.render_pass, nullptr);
+		glfw.vulkan.render_pass = renderPass;		//destroyed by nk_glfw3_shutdown()
+
 		// /* Load Fonts: if none of these are loaded a default font will be used  */
 		// /* Load Cursor: if you uncomment cursor loading please hide the cursor */
 		{
@@ -32,7 +32,7 @@ namespace ve {
 		virtual void prepareDraw();
 		virtual void draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass,
 							VECamera *pCamera, VELight *pLight,
-							std::vector<VkDescriptorSet> descriptorSetsShadow) {};
+							const std::vector<VkDescriptorSet> &descriptorSetsShadow) {};
 		virtual VkSemaphore draw(uint32_t imageIndex, VkSemaphore wait_semaphore);
 
 		///\returns the Nuklear context
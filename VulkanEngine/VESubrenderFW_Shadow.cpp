@@ -14,24 +14,62 @@ namespace ve {
 	/**
 	* \brief Initialize the subrenderer
 	*
-	* Create descriptor set layout, pipeline layout and the PSO
+	* Create the pipeline layout. The PSOs are created later by createPipelines().
 	*
 	*/
 	void VESubrenderFW_Shadow::initSubrenderer() {
 		VESubrender::initSubrenderer();
 
 		VkDescriptorSetLayout perObjectLayout = getRendererForwardPointer()->getDescriptorSetLayoutPerObject();
-		vh::vhPipeCreateGraphicsPipelineLayout(getRendererForwardPointer()->getDevice(),
-			{ perObjectLayout, perObjectLayout, getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout },
-			{ },
-			&m_pipelineLayout);
-
-		m_pipelines.resize(1);
-		vh::vhPipeCreateGraphicsShadowPipeline(getRendererForwardPointer()->getDevice(),
-			"shader/Forward/Shadow/vert.spv", 
-			getRendererForwardPointer()->getShadowMapExtent(),
-			m_pipelineLayout, getRendererForwardPointer()->getRenderPassShadow(),
-			&m_pipelines[0]);
+		m_pipelineLayout = getRendererForwardPointer()->getPipelineRegistry()->acquirePipelineLayout(
+			{ perObjectLayout, perObjectLayout, getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout });
+	}
+
+
+	/**
+	*
+	* \brief Create the PSOs of the subrenderer
+	*
+	* The shadow PSO has a dynamic viewport, since it draws into the atlas tile of each shadow camera.
+	* If the renderer uses a depth pre-pass, also create the PSO for the depth pre-pass. If the renderer uses
+	* cube shadow maps, also create the multiview PSO for the cube shadow map.
+	*
+	*/
+	void VESubrenderFW_Shadow::createPipelines() {
+		VEPipelineRegistry *pRegistry = getRendererForwardPointer()->getPipelineRegistry();
+
+		vePipelineKey_t key;
+		key.type = VE_PIPELINE_TYPE_SHADOW;
+		key.shaderFileNames = { "shader/Forward/Shadow/vert.spv" };
+		key.pipelineLayout = m_pipelineLayout;
+		key.renderPass = getRendererForwardPointer()->getRenderPassShadow();
+		m_pipelines.push_back(pRegistry->acquirePipeline(key));
+
+		//the depth pre-pass draws into the render area, which is smaller than the swapchain with dynamic resolution
+		if (getRendererForwardPointer()->getDepthPrepass()) {
+			key.renderPass = getRendererForwardPointer()->getRenderPassDepthPrepass();
+			m_pipelineDepthPrepass = pRegistry->acquirePipeline(key);
+		}
+
+		if (getRendererForwardPointer()->getCubeShadows()) {
+			key.shaderFileNames = { "shader/Forward/Shadow/cube.spv" };
+			key.renderPass = getRendererForwardPointer()->getRenderPassCubeShadow();
+			m_pipelineCube = pRegistry->acquirePipeline(key);
+		}
+	}
+
+
+	/**
+	* \brief Close down the subrenderer and release the depth pre-pass and cube shadow PSOs
+	*/
+	void VESubrenderFW_Shadow::closeSubrenderer() {
+		VESubrender::closeSubrenderer();
+
+		getRendererForwardPointer()->getPipelineRegistry()->releasePipeline(m_pipelineDepthPrepass);
+		m_pipelineDepthPrepass = VK_NULL_HANDLE;
+
+		getRendererForwardPointer()->getPipelineRegistry()->releasePipeline(m_pipelineCube);
+		m_pipelineCube = VK_NULL_HANDLE;
 	}
 
 	/**
@@ -65,9 +103,7 @@ namespace ve {
 		//set 3...per object UBO
 		//set 4...additional per object resources
 
-		std::vector<VkDescriptorSet> sets = { entity->m_descriptorSetsUBO[imageIndex] };
-
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 3, (uint32_t)sets.size(), sets.data(), 0, nullptr);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 3, 1, &entity->m_descriptorSetsUBO[imageIndex], 0, nullptr);
 	}
 
 
@@ -87,7 +123,7 @@ namespace ve {
 	*/
 	void VESubrenderFW_Shadow::draw(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass,
 									VECamera *pCamera, VELight *pLight,
-									std::vector<VkDescriptorSet> descriptorSetsShadow) {
+									const std::vector<VkDescriptorSet> &descriptorSetsShadow) {
 
 		bindPipeline(commandBuffer);
 
@@ -99,12 +135,109 @@ namespace ve {
 			if (pObject->getNodeType() == VESceneNode::VE_OBJECT_TYPE_ENTITY) {
 				VEEntity *pEntity = (VEEntity*)pObject;
 
-				if (pEntity->m_drawEntity && pEntity->m_castsShadow) {
+				if (pEntity->getDrawEntity() && pEntity->getCastsShadow()) {
+					bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity);	//bind the entity's descriptor sets
+					drawEntity(commandBuffer, imageIndex, pEntity);
+				}
+			}
+		}
+	}
+
+
+	/**
+	* \brief Draw either only the static or only the dynamic shadow casters
+	*
+	* Static casters are drawn into the cached shadow maps, dynamic casters on top of a copy of them.
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pCamera Pointer to the current light camera
+	* \param[in] pLight Pointer to the current light
+	* \param[in] staticCasters If true draw the static casters, else the dynamic casters
+	*
+	*/
+	void VESubrenderFW_Shadow::drawShadowCasters(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
+													VECamera *pCamera, VELight *pLight, bool staticCasters) {
+
+		bindPipeline(commandBuffer);
+
+		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, pLight, {});
+
+		for (auto object : getSceneManagerPointer()->m_sceneNodes) {
+			VESceneNode *pObject = object.second;
+			if (pObject->getNodeType() == VESceneNode::VE_OBJECT_TYPE_ENTITY) {
+				VEEntity *pEntity = (VEEntity*)pObject;
+
+				if (pEntity->getDrawEntity() && pEntity->getCastsShadow() && pEntity->getStaticShadow() == staticCasters) {
+					bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity);	//bind the entity's descriptor sets
+					drawEntity(commandBuffer, imageIndex, pEntity);
+				}
+			}
+		}
+	}
+
+
+	/**
+	* \brief Draw all shadow casters of a point light into the cube shadow map
+	*
+	* Each caster is drawn once, the multiview render pass broadcasts it to all 6 faces. The vertex shader
+	* picks the shadow camera of a face from the light UBO, and culls casters whose bounding sphere is
+	* outside of the face.
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pLight Pointer to the point light
+	*
+	*/
+	void VESubrenderFW_Shadow::drawCubeShadow(VkCommandBuffer commandBuffer, uint32_t imageIndex, VELight *pLight) {
+		if (m_pipelineCube == VK_NULL_HANDLE) return;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineCube);
+		vh::vhRenderSetViewport(commandBuffer, { { 0, 0 }, getRendererForwardPointer()->getCubeShadowMapExtent() });
+
+		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pLight->m_shadowCameras[0], pLight, {});
+
+		for (auto object : getSceneManagerPointer()->m_sceneNodes) {
+			VESceneNode *pObject = object.second;
+			if (pObject->getNodeType() == VESceneNode::VE_OBJECT_TYPE_ENTITY) {
+				VEEntity *pEntity = (VEEntity*)pObject;
+
+				if (pEntity->getDrawEntity() && pEntity->getCastsShadow()) {
 					bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity);	//bind the entity's descriptor sets
 					drawEntity(commandBuffer, imageIndex, pEntity);
 				}
 			}
 		}
 	}
-}
 
+
+	/**
+	* \brief Draw a chunk of entities of a light pass subrenderer into the depth map of the depth pre-pass
+	*
+	* \param[in] commandBuffer The command buffer to record into all draw calls
+	* \param[in] imageIndex Index of the current swap chain image
+	* \param[in] pCamera Pointer to the current camera
+	* \param[in] entities The entity list of the light pass subrenderer
+	* \param[in] startIdx Index of the first entity to draw
+	* \param[in] endIdx Index after the last entity to draw
+	*
+	*/
+	void VESubrenderFW_Shadow::drawDepthPrepass(VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera,
+												std::vector<VEEntity*> &entities, uint32_t startIdx, uint32_t endIdx) {
+
+		endIdx = std::min(endIdx, (uint32_t)entities.size());
+		if (startIdx >= endIdx || m_pipelineDepthPrepass == VK_NULL_HANDLE) return;
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineDepthPrepass);
+
+		bindDescriptorSetsPerFrame(commandBuffer, imageIndex, pCamera, nullptr, {});
+
+		for (uint32_t i = startIdx; i < endIdx; i++) {
+			VEEntity *pEntity = entities[i];
+			if (pEntity->getDrawEntity()) {
+				bindDescriptorSetsPerEntity(commandBuffer, imageIndex, pEntity);	//bind the entity's descriptor sets
+				drawEntity(commandBuffer, imageIndex, pEntity);
+			}
+		}
+	}
+}
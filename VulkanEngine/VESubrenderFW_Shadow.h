@@ -14,6 +14,8 @@ namespace ve {
 	*/
 	class VESubrenderFW_Shadow : public VESubrender {
 	protected:
+		VkPipeline	m_pipelineDepthPrepass = VK_NULL_HANDLE;	///<PSO of the depth pre-pass, same shader but the depth pre-pass render pass
+		VkPipeline	m_pipelineCube = VK_NULL_HANDLE;			///<Multiview PSO drawing into all faces of the cube shadow map
 
 	public:
 		///Constructor
@@ -27,12 +29,21 @@ namespace ve {
 		virtual veSubrenderType getType() { return VE_SUBRENDERER_TYPE_SHADOW; };
 
 		virtual void initSubrenderer();
+		virtual void createPipelines();
+		///\returns true, since the PSOs are needed in every frame
+		virtual bool pipelinesNeededAtStartup() { return true; };
+		virtual void closeSubrenderer();
 		virtual void addEntity(VEEntity *pEntity);
 		void bindDescriptorSetsPerEntity(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity);
 		//void bindDescriptorSets(VkCommandBuffer commandBuffer, uint32_t imageIndex, VEEntity *entity);
 		virtual void draw(	VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t numPass,
 							VECamera *pCamera, VELight *pLight,
-							std::vector<VkDescriptorSet> descriptorSetsShadow);
+							const std::vector<VkDescriptorSet> &descriptorSetsShadow);
+		virtual void drawShadowCasters(	VkCommandBuffer commandBuffer, uint32_t imageIndex,
+										VECamera *pCamera, VELight *pLight, bool staticCasters);
+		virtual void drawCubeShadow(VkCommandBuffer commandBuffer, uint32_t imageIndex, VELight *pLight);
+		virtual void drawDepthPrepass(	VkCommandBuffer commandBuffer, uint32_t imageIndex, VECamera *pCamera,
+										std::vector<VEEntity*> &entities, uint32_t startIdx, uint32_t endIdx);
 	};
 }
 
@@ -14,7 +14,7 @@ namespace ve {
 	/**
 	* \brief Initialize the subrenderer
 	*
-	* Create descriptor set layout, pipeline layout and the PSO
+	* Create descriptor set layout and pipeline layout. The PSOs are created later by createPipelines().
 	*
 	*/
 	void VESubrenderFW_Skyplane::initSubrenderer() {
@@ -27,37 +27,40 @@ namespace ve {
 			&m_descriptorSetLayoutResources);
 
 		VkDescriptorSetLayout perObjectLayout = getRendererForwardPointer()->getDescriptorSetLayoutPerObject();
-		vh::vhPipeCreateGraphicsPipelineLayout(getRendererForwardPointer()->getDevice(),
-			{ perObjectLayout, perObjectLayout, getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout, m_descriptorSetLayoutResources },
-			{},
-			&m_pipelineLayout);
-
-		m_pipelines.resize(1);
-		vh::vhPipeCreateGraphicsPipeline(getRendererForwardPointer()->getDevice(),
-			{ "shader/Forward/Skyplane/vert.spv", "shader/Forward/Skyplane/frag.spv" },
-			getRendererForwardPointer()->getSwapChainExtent(),
-			m_pipelineLayout, getRendererForwardPointer()->getRenderPass(),
-			{},
-			&m_pipelines[0]);
+		m_pipelineLayout = getRendererForwardPointer()->getPipelineRegistry()->acquirePipelineLayout(
+			{ perObjectLayout, perObjectLayout, getRendererForwardPointer()->getDescriptorSetLayoutShadow(), perObjectLayout, m_descriptorSetLayoutResources });
+	}
+
 
+	/**
+	*
+	* \brief Create the PSOs of the subrenderer
+	*
+	*/
+	void VESubrenderFW_Skyplane::createPipelines() {
+		vePipelineKey_t key;
+		key.shaderFileNames = { "shader/Forward/Skyplane/vert.spv", "shader/Forward/Skyplane/frag.spv" };
+		key.pipelineLayout = m_pipelineLayout;
+		key.renderPass = getRendererForwardPointer()->getRenderPass();
+		m_pipelines.push_back(getRendererForwardPointer()->getPipelineRegistry()->acquirePipeline(key));
 	}
 
 	/**
 	* \brief Add an entity to the subrenderer
 	*
-	* Create a UBO for this entity, a descriptor set per swapchain image, and update the descriptor sets
+	* Create a UBO for this entity, a descriptor set per frame in flight, and update the descriptor sets
 	*
 	*/
 	void VESubrenderFW_Skyplane::addEntity(VEEntity *pEntity) {
 		VESubrender::addEntity(pEntity);
 
 		/*vh::vhBufCreateUniformBuffers(getRendererForwardPointer()->getVmaAllocator(),
-			(uint32_t)getRendererForwardPointer()->getSwapChainNumber(),
+			(uint32_t)getRendererForwardPointer()->getFramesInFlight(),
 			(uint32_t)sizeof(veUBOPerObject),
 			pEntity->m_uniformBuffers, pEntity->m_uniformBuffersAllocation);
 
 		vh::vhRenderCreateDescriptorSets(getRendererForwardPointer()->getDevice(),
-			(uint32_t)getRendererForwardPointer()->getSwapChainNumber(),
+			(uint32_t)getRendererForwardPointer()->getFramesInFlight(),
 			m_descriptorSetLayoutUBO,
 			getRendererForwardPointer()->getDescriptorPool(),
 			pEntity->m_descriptorSetsUBO);
@@ -72,10 +75,9 @@ namespace ve {
 			);
 		}*/
 
-		vh::vhRenderCreateDescriptorSets(getRendererForwardPointer()->getDevice(),
-			(uint32_t)getRendererForwardPointer()->getSwapChainNumber(),
+		getRendererPointer()->getDescriptorAllocator()->allocateDescriptorSets(
 			m_descriptorSetLayoutResources,
-			getRendererForwardPointer()->getDescriptorPool(),
+			(uint32_t)getRendererForwardPointer()->getFramesInFlight(),
 			pEntity->m_descriptorSetsResources);
 
 		for (uint32_t i = 0; i < pEntity->m_descriptorSetsResources.size(); i++) {
@@ -90,6 +92,15 @@ namespace ve {
 
 
 	}
-}
-
 
+	/**
+	* \brief Set the viewport and scissor to the render area
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] numPass The number of the light pass
+	*
+	*/
+	void VESubrenderFW_Skyplane::setDynamicPipelineState(VkCommandBuffer commandBuffer, uint32_t numPass) {
+		getRendererForwardPointer()->setLightPassState(commandBuffer, numPass);
+	}
+}
@@ -0,0 +1,238 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	*
+	* \brief Create the timeline semaphore, if the device has it
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] timelineSemaphore If true, the device has been created with the timeline semaphore feature
+	*
+	*/
+	VETimeline::VETimeline(VkDevice device, bool timelineSemaphore) : m_device(device) {
+		if (!timelineSemaphore) return;
+
+		VECHECKRESULT(vh::vhCmdCreateTimelineSemaphore(m_device, 0, &m_semaphore), "Failed to create timeline semaphore!");
+		m_vkWaitSemaphores = (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(m_device, "vkWaitSemaphoresKHR");
+		m_vkGetSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(m_device, "vkGetSemaphoreCounterValueKHR");
+	}
+
+
+	/**
+	* \brief Release all remaining resources and destroy the semaphore, the device must be idle
+	*/
+	VETimeline::~VETimeline() {
+		for (auto &release : m_releases) release.release();
+		m_releases.clear();
+
+		for (auto &pending : m_pendingFences) vkDestroyFence(m_device, pending.second, nullptr);
+		for (auto fence : m_freeFences) vkDestroyFence(m_device, fence, nullptr);
+		if (m_semaphore != VK_NULL_HANDLE) vkDestroySemaphore(m_device, m_semaphore, nullptr);
+	}
+
+
+	/**
+	*
+	* \brief Find out which value has been reached, without blocking. The mutex must be locked.
+	*
+	* \returns the largest value that has been reached
+	*
+	*/
+	uint64_t VETimeline::pollCompleted() {
+		if (m_semaphore != VK_NULL_HANDLE) {
+			uint64_t value = 0;
+			if (m_vkGetSemaphoreCounterValue(m_device, m_semaphore, &value) == VK_SUCCESS) {
+				m_lastCompleted = std::max(m_lastCompleted, value);
+			}
+			return m_lastCompleted;
+		}
+
+		while (!m_pendingFences.empty() && vkGetFenceStatus(m_device, m_pendingFences.front().second) == VK_SUCCESS) {
+			m_lastCompleted = m_pendingFences.front().first;
+			m_freeFences.push_back(m_pendingFences.front().second);
+			m_pendingFences.pop_front();
+		}
+		return m_lastCompleted;
+	}
+
+
+	/**
+	*
+	* \brief Submit a command buffer to a queue, and give it the next value
+	*
+	* \param[in] queue The queue
+	* \param[in] commandBuffer The command buffer
+	* \param[in] waitSemaphore A binary semaphore the submission waits for, or VK_NULL_HANDLE
+	* \param[in] signalSemaphore A binary semaphore the submission signals, or VK_NULL_HANDLE
+	* \returns the value of the submission
+	*
+	*/
+	uint64_t VETimeline::submit(VkQueue queue, VkCommandBuffer commandBuffer, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore) {
+		return submit(queue, 1, &commandBuffer, waitSemaphore, signalSemaphore);
+	}
+
+
+	/**
+	*
+	* \brief Submit several command buffers to a queue in one submission, and give it the next value
+	*
+	* \param[in] queue The queue
+	* \param[in] commandBufferCount Number of command buffers
+	* \param[in] pCommandBuffers The command buffers, they are executed in this order
+	* \param[in] waitSemaphore A binary semaphore the submission waits for, or VK_NULL_HANDLE
+	* \param[in] signalSemaphore A binary semaphore the submission signals, or VK_NULL_HANDLE
+	* \returns the value of the submission
+	*
+	*/
+	uint64_t VETimeline::submit(VkQueue queue, uint32_t commandBufferCount, const VkCommandBuffer *pCommandBuffers,
+								VkSemaphore waitSemaphore, VkSemaphore signalSemaphore) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		VkFence fence = VK_NULL_HANDLE;
+		if (m_semaphore == VK_NULL_HANDLE) {
+			if (m_freeFences.empty()) {
+				VkFenceCreateInfo fenceInfo = {};
+				fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+				VECHECKRESULT(vkCreateFence(m_device, &fenceInfo, nullptr, &fence), "Failed to create timeline fence!");
+			}
+			else {
+				fence = m_freeFences.back();
+				m_freeFences.pop_back();
+			}
+		}
+
+		uint64_t value = m_lastSubmitted + 1;
+		VECHECKRESULT(vh::vhCmdSubmitCommandBuffers(m_device, queue, commandBufferCount, pCommandBuffers, waitSemaphore, signalSemaphore,
+													m_semaphore, value, fence), "Failed to submit command buffers!");
+		m_lastSubmitted = value;
+		if (fence != VK_NULL_HANDLE) m_pendingFences.push_back({ value, fence });
+		return value;
+	}
+
+
+	/**
+	*
+	* \brief End a single time command buffer and submit it without waiting for it
+	*
+	* The command buffer is freed by collect() once it is done. Resources the buffer uses, e.g. staging buffers,
+	* can be handed to release() with the returned value.
+	*
+	* \param[in] queue The queue
+	* \param[in] commandPool The pool the buffer has been allocated from, it must only be used by the thread calling collect()
+	* \param[in] commandBuffer The buffer, see vh::vhCmdBeginSingleTimeCommands()
+	* \param[in] waitSemaphore A binary semaphore the submission waits for, or VK_NULL_HANDLE
+	* \param[in] signalSemaphore A binary semaphore the submission signals, or VK_NULL_HANDLE
+	* \returns the value of the submission
+	*
+	*/
+	uint64_t VETimeline::submitSingleTimeCommands(	VkQueue queue, VkCommandPool commandPool, VkCommandBuffer commandBuffer,
+													VkSemaphore waitSemaphore, VkSemaphore signalSemaphore) {
+		VECHECKRESULT(vkEndCommandBuffer(commandBuffer), "Failed to end command buffer!");
+
+		uint64_t value = submit(queue, commandBuffer, waitSemaphore, signalSemaphore);
+		VkDevice device = m_device;
+		release(value, [device, commandPool, commandBuffer]() {
+			vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+		});
+		return value;
+	}
+
+
+	/**
+	*
+	* \brief Find out whether a value has been reached, without blocking
+	*
+	* \param[in] value The value
+	* \returns true if the submission with this value and all earlier ones are done
+	*
+	*/
+	bool VETimeline::isComplete(uint64_t value) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (value <= m_lastCompleted) return true;
+		return pollCompleted() >= value;
+	}
+
+
+	/**
+	*
+	* \brief Wait until a value has been reached
+	*
+	* Without timeline semaphore, the lock is held while waiting, so other threads cannot submit meanwhile.
+	*
+	* \param[in] value The value, values that have not been submitted yet are not waited for
+	*
+	*/
+	void VETimeline::wait(uint64_t value) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		value = std::min(value, m_lastSubmitted);
+		if (value <= m_lastCompleted) return;
+
+		if (m_semaphore != VK_NULL_HANDLE) {
+			VkSemaphore semaphore = m_semaphore;
+			lock.unlock();
+
+			VkSemaphoreWaitInfoKHR waitInfo = {};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &semaphore;
+			waitInfo.pValues = &value;
+			VECHECKRESULT(m_vkWaitSemaphores(m_device, &waitInfo, std::numeric_limits<uint64_t>::max()), "Failed to wait for timeline semaphore!");
+
+			lock.lock();
+			m_lastCompleted = std::max(m_lastCompleted, value);
+			return;
+		}
+
+		for (auto &pending : m_pendingFences) {
+			if (pending.first >= value) {
+				VECHECKRESULT(vkWaitForFences(m_device, 1, &pending.second, VK_TRUE, std::numeric_limits<uint64_t>::max()), "Failed to wait for timeline fence!");
+				break;
+			}
+		}
+		pollCompleted();
+	}
+
+
+	/**
+	*
+	* \brief Release a resource once a value has been reached
+	*
+	* \param[in] value The value of the last submission that uses the resource, usually getLastSubmitted()
+	* \param[in] release Callback releasing the resource, it is called by collect(), or by the destructor
+	*
+	*/
+	void VETimeline::release(uint64_t value, std::function<void()> release) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_releases.push_back({ value, release });
+	}
+
+
+	/**
+	* \brief Release all resources whose value has been reached, without blocking
+	*/
+	void VETimeline::collect() {
+		std::vector<veRelease_t> done;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_releases.empty()) return;
+
+			uint64_t completed = pollCompleted();
+			auto firstPending = std::partition(m_releases.begin(), m_releases.end(),
+				[completed](const veRelease_t &pending) { return pending.value <= completed; });
+			done.assign(std::make_move_iterator(m_releases.begin()), std::make_move_iterator(firstPending));
+			m_releases.erase(m_releases.begin(), firstPending);
+		}
+		for (auto &release : done) release.release();
+	}
+
+}
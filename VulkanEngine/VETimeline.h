@@ -0,0 +1,73 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+namespace ve {
+
+	/**
+	*
+	* \brief Tracks the submissions to the graphics queue by a monotonically increasing value
+	*
+	* Each submission gets the next value, and when the GPU has executed it, the timeline reaches this value.
+	* Since the queue executes its submissions in order, reaching a value also means that all earlier submissions
+	* are done. So CPU code can remember the value of the submission it depends on, and then wait for exactly
+	* this value, or check without blocking whether it has been reached.
+	*
+	* If the device has timeline semaphores, the values are the counter of a single timeline semaphore, which
+	* every submission sets. Otherwise each submission gets a fence from a small pool, and the fences are polled
+	* in submission order.
+	*
+	* Resources that the GPU might still use can be handed over with release(). They are released by collect()
+	* once the value they depend on has been reached. The functions may be called from several threads at the
+	* same time, but submissions to a queue must not happen in parallel.
+	*
+	*/
+	class VETimeline {
+
+	protected:
+		///A callback releasing a resource, and the value it waits for
+		struct veRelease_t {
+			uint64_t				value;		///<The callback runs when this value has been reached
+			std::function<void()>	release;	///<Releases the resource
+		};
+
+		VkDevice		m_device;										///<Vulkan logical device
+		VkSemaphore		m_semaphore = VK_NULL_HANDLE;					///<The timeline semaphore, VK_NULL_HANDLE if the device has none
+		PFN_vkWaitSemaphoresKHR				m_vkWaitSemaphores = nullptr;			///<Extension function waiting for the semaphore
+		PFN_vkGetSemaphoreCounterValueKHR	m_vkGetSemaphoreCounterValue = nullptr;	///<Extension function reading the semaphore
+
+		std::deque<std::pair<uint64_t, VkFence>> m_pendingFences;		///<Without timeline semaphore: the fences of the submissions not known to be done
+		std::vector<VkFence>	m_freeFences;							///<Without timeline semaphore: fences that can be used again
+		std::vector<veRelease_t> m_releases;							///<Resources waiting to be released
+		uint64_t		m_lastSubmitted = 0;							///<Value of the last submission
+		uint64_t		m_lastCompleted = 0;							///<Largest value known to be reached
+		std::mutex		m_mutex;										///<Guards all members
+
+		uint64_t		pollCompleted();
+
+	public:
+		VETimeline(VkDevice device, bool timelineSemaphore);
+		virtual ~VETimeline();
+
+		uint64_t		submit(VkQueue queue, VkCommandBuffer commandBuffer, VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+		uint64_t		submit(	VkQueue queue, uint32_t commandBufferCount, const VkCommandBuffer *pCommandBuffers,
+								VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+		uint64_t		submitSingleTimeCommands(	VkQueue queue, VkCommandPool commandPool, VkCommandBuffer commandBuffer,
+													VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+		bool			isComplete(uint64_t value);
+		void			wait(uint64_t value);
+		void			release(uint64_t value, std::function<void()> release);
+		void			collect();
+
+		///\returns true if the values are the counter of a timeline semaphore
+		bool			hasTimelineSemaphore() { return m_semaphore != VK_NULL_HANDLE; };
+		///\returns the value of the last submission, all resources used so far are free once it is reached
+		uint64_t		getLastSubmitted() { std::lock_guard<std::mutex> lock(m_mutex); return m_lastSubmitted; };
+	};
+
+}
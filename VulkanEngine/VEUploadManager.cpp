@@ -0,0 +1,344 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+
+#include "VEInclude.h"
+
+
+namespace ve {
+
+	/**
+	*
+	* \brief Create the command pools and the staging ring
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] allocator VMA allocator
+	* \param[in] pTimeline Timeline of the graphics queue
+	* \param[in] graphicsQueue The graphics queue
+	* \param[in] graphicsFamily Family of the graphics queue
+	* \param[in] transferQueue A queue of a family without graphics, or VK_NULL_HANDLE to copy on the graphics queue
+	* \param[in] transferFamily Family of the transfer queue
+	*
+	*/
+	VEUploadManager::VEUploadManager(	VkDevice device, VmaAllocator allocator, VETimeline *pTimeline,
+										VkQueue graphicsQueue, uint32_t graphicsFamily, VkQueue transferQueue, uint32_t transferFamily) :
+		m_device(device), m_allocator(allocator), m_pTimeline(pTimeline),
+		m_graphicsQueue(graphicsQueue), m_graphicsFamily(graphicsFamily),
+		m_transferQueue(transferQueue), m_transferFamily(transferFamily) {
+
+		VECHECKRESULT(vh::vhCmdCreateCommandPool(m_device, m_graphicsFamily, &m_graphicsPool), "Failed to create upload command pool!");
+		if (m_transferQueue != VK_NULL_HANDLE) {
+			VECHECKRESULT(vh::vhCmdCreateCommandPool(m_device, m_transferFamily, &m_transferPool), "Failed to create transfer command pool!");
+		}
+
+		VECHECKRESULT(vh::vhBufCreateMappedBuffer(	m_allocator, UPLOAD_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+													&m_ring, &m_ringAllocation, (void**)&m_ringData), "Failed to create staging ring!");
+	}
+
+
+	/**
+	* \brief Free all batches and destroy the ring, uploads that have not been flushed are dropped
+	*/
+	VEUploadManager::~VEUploadManager() {
+		retire(true);
+
+		for (auto &buffer : m_buffers) vmaDestroyBuffer(m_allocator, buffer.first, buffer.second);
+		vmaDestroyBuffer(m_allocator, m_ring, m_ringAllocation);
+
+		if (m_transferPool != VK_NULL_HANDLE) vkDestroyCommandPool(m_device, m_transferPool, nullptr);
+		vkDestroyCommandPool(m_device, m_graphicsPool, nullptr);
+	}
+
+
+	/**
+	*
+	* \brief Copy data into staging memory. The mutex must be locked.
+	*
+	* The data goes into the ring, unless it is larger than the ring. If the ring is full, the oldest batch is
+	* waited for, so this may flush the next batch.
+	*
+	* \param[in] data Pointer to the data
+	* \param[in] size Size of the data in bytes
+	* \param[out] offset Offset of the data in the returned buffer
+	* \returns the staging buffer holding the data
+	*
+	*/
+	VkBuffer VEUploadManager::copyToStaging(const void *data, VkDeviceSize size, VkDeviceSize *offset) {
+		if (size > UPLOAD_RING_SIZE) {
+			VkBuffer buffer;
+			VmaAllocation allocation;
+			void *mappedData;
+			VECHECKRESULT(vh::vhBufCreateMappedBuffer(	m_allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+														&buffer, &allocation, &mappedData), "Failed to create staging buffer!");
+			memcpy(mappedData, data, (size_t)size);
+			m_buffers.push_back({ buffer, allocation });
+			*offset = 0;
+			return buffer;
+		}
+
+		while (true) {
+			uint64_t pos = (m_head + UPLOAD_ALIGNMENT - 1) / UPLOAD_ALIGNMENT * UPLOAD_ALIGNMENT;
+			if (pos % UPLOAD_RING_SIZE + size > UPLOAD_RING_SIZE) {
+				pos = (pos / UPLOAD_RING_SIZE + 1) * UPLOAD_RING_SIZE;		//the data must not wrap around the end
+			}
+
+			if (pos + size - m_tail <= UPLOAD_RING_SIZE) {
+				*offset = pos % UPLOAD_RING_SIZE;
+				memcpy(m_ringData + *offset, data, (size_t)size);
+				m_head = pos + size;
+				return m_ring;
+			}
+
+			//nothing uses the ring anymore, so start at its beginning
+			if (m_batches.empty() && m_bufferUploads.empty() && m_imageUploads.empty()) {
+				m_head = m_tail = 0;
+				continue;
+			}
+
+			//the ring is full, wait for the oldest batch
+			if (m_batches.empty()) flushBatch();
+			m_pTimeline->wait(m_batches.front().value);
+			retire(false);
+		}
+	}
+
+
+	/**
+	*
+	* \brief Record and submit the collected copies. The mutex must be locked.
+	*
+	* \returns the timeline value of the last batch, 0 if there has not been any
+	*
+	*/
+	uint64_t VEUploadManager::flushBatch() {
+		if (m_bufferUploads.empty() && m_imageUploads.empty()) {
+			return m_batches.empty() ? 0 : m_batches.back().value;
+		}
+
+		bool transfer = m_transferQueue != VK_NULL_HANDLE;
+
+		veBatch_t batch = {};
+		batch.ringEnd = m_head;
+		batch.buffers.swap(m_buffers);
+		batch.graphicsCmd = vh::vhCmdBeginSingleTimeCommands(m_device, m_graphicsPool);
+		if (transfer) batch.transferCmd = vh::vhCmdBeginSingleTimeCommands(m_device, m_transferPool);
+		VkCommandBuffer copyCmd = transfer ? batch.transferCmd : batch.graphicsCmd;
+
+		//bring all images into the transfer layout with a single barrier
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		for (auto &upload : m_imageUploads) {
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = upload.dst;
+			barrier.subresourceRange = upload.range;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			imageBarriers.push_back(barrier);
+		}
+		if (!imageBarriers.empty()) {
+			vkCmdPipelineBarrier(	copyCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+									0, nullptr, 0, nullptr, (uint32_t)imageBarriers.size(), imageBarriers.data());
+		}
+
+		for (auto &upload : m_bufferUploads) {
+			vkCmdCopyBuffer(copyCmd, upload.src, upload.dst, 1, &upload.region);
+		}
+		for (auto &upload : m_imageUploads) {
+			vkCmdCopyBufferToImage(	copyCmd, upload.src, upload.dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+									upload.numRegions, &m_regions[upload.firstRegion]);
+		}
+
+		//barriers making the data visible to the graphics queue, with a transfer queue they also hand over the ownership
+		uint32_t srcFamily = transfer ? m_transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		uint32_t dstFamily = transfer ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		VkPipelineStageFlags dstStages = 0;
+
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		for (auto &upload : m_bufferUploads) {
+			VkBufferMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = srcFamily;
+			barrier.dstQueueFamilyIndex = dstFamily;
+			barrier.buffer = upload.dst;
+			barrier.offset = upload.region.dstOffset;
+			barrier.size = upload.region.size;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = upload.access;
+			bufferBarriers.push_back(barrier);
+			dstStages |= upload.stage;
+		}
+
+		imageBarriers.clear();
+		for (auto &upload : m_imageUploads) {
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcQueueFamilyIndex = srcFamily;
+			barrier.dstQueueFamilyIndex = dstFamily;
+			barrier.image = upload.dst;
+			barrier.subresourceRange = upload.range;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			imageBarriers.push_back(barrier);
+			dstStages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		}
+
+		if (!transfer) {
+			vkCmdPipelineBarrier(	batch.graphicsCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStages, 0,
+									0, nullptr, (uint32_t)bufferBarriers.size(), bufferBarriers.data(),
+									(uint32_t)imageBarriers.size(), imageBarriers.data());
+		}
+		else {
+			//release on the transfer queue, the access of the graphics queue does not matter here
+			for (auto &barrier : bufferBarriers) barrier.dstAccessMask = 0;
+			for (auto &barrier : imageBarriers) barrier.dstAccessMask = 0;
+			vkCmdPipelineBarrier(	batch.transferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+									0, nullptr, (uint32_t)bufferBarriers.size(), bufferBarriers.data(),
+									(uint32_t)imageBarriers.size(), imageBarriers.data());
+
+			//acquire on the graphics queue, it starts at the stage the semaphore is waited for, see vh::vhCmdSubmitCommandBuffers()
+			for (uint32_t i = 0; i < bufferBarriers.size(); i++) {
+				bufferBarriers[i].srcAccessMask = 0;
+				bufferBarriers[i].dstAccessMask = m_bufferUploads[i].access;
+			}
+			for (auto &barrier : imageBarriers) {
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			}
+			vkCmdPipelineBarrier(	batch.graphicsCmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, dstStages, 0,
+									0, nullptr, (uint32_t)bufferBarriers.size(), bufferBarriers.data(),
+									(uint32_t)imageBarriers.size(), imageBarriers.data());
+
+			VkSemaphoreCreateInfo semaphoreInfo = {};
+			semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			VECHECKRESULT(vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &batch.semaphore), "Failed to create upload semaphore!");
+
+			VECHECKRESULT(vkEndCommandBuffer(batch.transferCmd), "Failed to end transfer command buffer!");
+			VECHECKRESULT(vh::vhCmdSubmitCommandBuffer(	m_device, m_transferQueue, batch.transferCmd,
+														VK_NULL_HANDLE, batch.semaphore, VK_NULL_HANDLE), "Failed to submit transfer command buffer!");
+		}
+
+		VECHECKRESULT(vkEndCommandBuffer(batch.graphicsCmd), "Failed to end upload command buffer!");
+		batch.value = m_pTimeline->submit(m_graphicsQueue, batch.graphicsCmd, batch.semaphore);
+
+		m_bufferUploads.clear();
+		m_imageUploads.clear();
+		m_regions.clear();
+		m_batches.push_back(std::move(batch));
+		return m_batches.back().value;
+	}
+
+
+	/**
+	*
+	* \brief Free the command buffers, semaphores and ring space of finished batches. The mutex must be locked.
+	*
+	* \param[in] wait If true, wait for all batches, otherwise only free the batches that are done
+	*
+	*/
+	void VEUploadManager::retire(bool wait) {
+		while (!m_batches.empty()) {
+			veBatch_t &batch = m_batches.front();
+			if (wait) m_pTimeline->wait(batch.value);
+			else if (!m_pTimeline->isComplete(batch.value)) break;
+
+			//the graphics submission waited for the transfer submission, so both are done
+			vkFreeCommandBuffers(m_device, m_graphicsPool, 1, &batch.graphicsCmd);
+			if (batch.transferCmd != VK_NULL_HANDLE) vkFreeCommandBuffers(m_device, m_transferPool, 1, &batch.transferCmd);
+			if (batch.semaphore != VK_NULL_HANDLE) vkDestroySemaphore(m_device, batch.semaphore, nullptr);
+			for (auto &buffer : batch.buffers) vmaDestroyBuffer(m_allocator, buffer.first, buffer.second);
+
+			m_tail = batch.ringEnd;
+			m_batches.pop_front();
+		}
+	}
+
+
+	/**
+	*
+	* \brief Copy data into a buffer with the next batch
+	*
+	* \param[in] buffer The destination buffer, must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+	* \param[in] offset Offset in the destination buffer
+	* \param[in] data Pointer to the data, it is copied at once and can be freed afterwards
+	* \param[in] size Size of the data in bytes
+	* \param[in] access Access of the graphics queue to the buffer afterwards, e.g. VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+	* \param[in] stage Pipeline stages of this access, e.g. VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+	*
+	*/
+	void VEUploadManager::uploadBuffer(	VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size,
+										VkAccessFlags access, VkPipelineStageFlags stage) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		VkDeviceSize srcOffset;
+		VkBuffer src = copyToStaging(data, size, &srcOffset);
+		m_bufferUploads.push_back({ src, buffer, { srcOffset, offset, size }, access, stage });
+	}
+
+
+	/**
+	*
+	* \brief Copy data into all layers and miplevels of a color image with the next batch
+	*
+	* Afterwards the image is in layout VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and can be sampled by fragment shaders.
+	*
+	* \param[in] image The destination image, must have been created with VK_IMAGE_USAGE_TRANSFER_DST_BIT, its content is discarded
+	* \param[in] mipLevels Number of miplevels of the image
+	* \param[in] layerCount Number of layers of the image
+	* \param[in] data Pointer to the data, it is copied at once and can be freed afterwards
+	* \param[in] size Size of the data in bytes
+	* \param[in] regions The copy regions, their buffer offsets are offsets in data
+	*
+	*/
+	void VEUploadManager::uploadImage(	VkImage image, uint32_t mipLevels, uint32_t layerCount, const void *data, VkDeviceSize size,
+										std::vector<VkBufferImageCopy> &regions) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		VkDeviceSize srcOffset;
+		VkBuffer src = copyToStaging(data, size, &srcOffset);
+
+		uint32_t firstRegion = (uint32_t)m_regions.size();
+		for (auto region : regions) {
+			region.bufferOffset += srcOffset;
+			m_regions.push_back(region);
+		}
+		m_imageUploads.push_back({	src, image, { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, layerCount },
+									firstRegion, (uint32_t)regions.size() });
+	}
+
+
+	/**
+	*
+	* \brief Submit all uploads collected so far, without waiting for them
+	*
+	* Called by the renderer before each frame, so the frame sees all data uploaded before.
+	*
+	* \returns the timeline value the uploads are done at, 0 if there have not been any
+	*
+	*/
+	uint64_t VEUploadManager::flush() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		retire(false);
+		return flushBatch();
+	}
+
+
+	/**
+	* \brief Submit all uploads collected so far, and wait until all uploads are done
+	*/
+	void VEUploadManager::wait() {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		flushBatch();
+		retire(true);
+	}
+
+}
@@ -0,0 +1,111 @@
+/**
+* The Vienna Vulkan Engine
+*
+* (c) bei Helmut Hlavacs, University of Vienna
+*
+*/
+
+#pragma once
+
+const VkDeviceSize UPLOAD_RING_SIZE = 64 * 1024 * 1024;			///<Size of the persistently mapped staging ring
+const VkDeviceSize UPLOAD_ALIGNMENT = 16;						///<Alignment of the data in the ring, enough for all texel blocks
+
+namespace ve {
+
+	/**
+	*
+	* \brief Copies vertex, index and texture data to device memory, batching all copies into one submission
+	*
+	* The data is copied into a staging ring, a host visible buffer that stays mapped. The copies to the
+	* destination buffers and images are only collected, and flush() records all of them into one command buffer,
+	* with one batch of barriers before and one after the copies. No submission is waited for on the CPU.
+	*
+	* If the device has a queue family with transfer but without graphics queues, usually a DMA engine, the copies
+	* are submitted there. The barriers after the copies then release the buffers and images from the transfer
+	* family, and a second command buffer acquires them for the graphics family. It waits for the copies by a
+	* semaphore. Otherwise the copies and barriers are submitted to the graphics queue directly.
+	*
+	* Either way, the graphics submission gets a value of the renderer timeline. Since the graphics queue executes
+	* in order, all frames submitted after flush() see the uploaded data. The value is also used to free the ring
+	* space of a batch. If the ring is full, the oldest batch is waited for. Data larger than the whole ring is
+	* staged in a temporary buffer instead.
+	*
+	* The functions may be called from several threads at the same time. But since a full ring causes a flush,
+	* uploads must not run while another thread submits to the graphics queue other than through the timeline.
+	*
+	*/
+	class VEUploadManager {
+
+	protected:
+		///Copy from the staging memory to a buffer
+		struct veBufferUpload_t {
+			VkBuffer				src;		///<The staging buffer
+			VkBuffer				dst;		///<The destination buffer
+			VkBufferCopy			region;		///<The copied range
+			VkAccessFlags			access;		///<Access of the graphics queue to the buffer afterwards
+			VkPipelineStageFlags	stage;		///<Pipeline stages of this access
+		};
+
+		///Copy from the staging memory to an image
+		struct veImageUpload_t {
+			VkBuffer				src;			///<The staging buffer
+			VkImage					dst;			///<The destination image, it is in layout VK_IMAGE_LAYOUT_UNDEFINED before
+			VkImageSubresourceRange	range;			///<All subresources of the image
+			uint32_t				firstRegion;	///<Index of the first copy region in m_regions
+			uint32_t				numRegions;		///<Number of copy regions
+		};
+
+		///A batch that has been submitted
+		struct veBatch_t {
+			uint64_t		value;				///<Timeline value of the graphics submission
+			uint64_t		ringEnd;			///<Ring position up to which the batch uses the ring
+			VkCommandBuffer	transferCmd;		///<Copies on the transfer queue, VK_NULL_HANDLE without transfer queue
+			VkCommandBuffer	graphicsCmd;		///<Copies or acquire barriers on the graphics queue
+			VkSemaphore		semaphore;			///<Signaled by the transfer queue, waited for by the graphics queue
+			std::vector<std::pair<VkBuffer, VmaAllocation>> buffers;	///<Temporary staging buffers for data larger than the ring
+		};
+
+		VkDevice		m_device;								///<Vulkan logical device
+		VmaAllocator	m_allocator;							///<VMA allocator
+		VETimeline *	m_pTimeline;							///<Timeline of the graphics queue
+		VkQueue			m_graphicsQueue;						///<The graphics queue
+		uint32_t		m_graphicsFamily;						///<Family of the graphics queue
+		VkQueue			m_transferQueue;						///<The transfer queue, VK_NULL_HANDLE if copies go to the graphics queue
+		uint32_t		m_transferFamily;						///<Family of the transfer queue
+		VkCommandPool	m_graphicsPool = VK_NULL_HANDLE;		///<Pool for the graphics command buffers
+		VkCommandPool	m_transferPool = VK_NULL_HANDLE;		///<Pool for the transfer command buffers
+
+		VkBuffer		m_ring = VK_NULL_HANDLE;				///<The staging ring
+		VmaAllocation	m_ringAllocation = nullptr;				///<VMA allocation of the ring
+		uint8_t *		m_ringData = nullptr;					///<Mapped memory of the ring
+		uint64_t		m_head = 0;								///<Ring position of the next data, the offset in the ring is m_head % UPLOAD_RING_SIZE
+		uint64_t		m_tail = 0;								///<Ring position up to which the ring is free again
+
+		std::vector<veBufferUpload_t>	m_bufferUploads;		///<Buffer copies of the next batch
+		std::vector<veImageUpload_t>	m_imageUploads;			///<Image copies of the next batch
+		std::vector<VkBufferImageCopy>	m_regions;				///<Copy regions of all image copies
+		std::vector<std::pair<VkBuffer, VmaAllocation>> m_buffers;	///<Temporary staging buffers of the next batch
+		std::deque<veBatch_t>	m_batches;						///<Batches that have been submitted and may still run
+		std::mutex				m_mutex;						///<Guards all members
+
+		VkBuffer		copyToStaging(const void *data, VkDeviceSize size, VkDeviceSize *offset);
+		uint64_t		flushBatch();
+		void			retire(bool wait);
+
+	public:
+		VEUploadManager(VkDevice device, VmaAllocator allocator, VETimeline *pTimeline,
+						VkQueue graphicsQueue, uint32_t graphicsFamily, VkQueue transferQueue, uint32_t transferFamily);
+		virtual ~VEUploadManager();
+
+		void			uploadBuffer(	VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size,
+										VkAccessFlags access, VkPipelineStageFlags stage);
+		void			uploadImage(VkImage image, uint32_t mipLevels, uint32_t layerCount, const void *data, VkDeviceSize size,
+									std::vector<VkBufferImageCopy> &regions);
+		uint64_t		flush();
+		void			wait();
+
+		///\returns true if the copies go to a dedicated transfer queue
+		bool			hasTransferQueue() { return m_transferQueue != VK_NULL_HANDLE; };
+	};
+
+}
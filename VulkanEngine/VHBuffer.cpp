@@ -38,6 +38,37 @@ namespace vh {
 	}
 
 
+	/**
+	* \brief Create a Vulkan buffer in host memory that stays mapped for its whole life
+	*
+	* \param[in] allocator VMA allocator
+	* \param[in] size Size of the buffer in bytes
+	* \param[in] usage Buffer usage flags
+	* \param[out] buffer The created buffer
+	* \param[out] allocation The VMA allocation
+	* \param[out] pMappedData Pointer to the mapped memory, valid until the buffer is destroyed
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateMappedBuffer(	VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+										VkBuffer *buffer, VmaAllocation *allocation, void **pMappedData) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VmaAllocationCreateInfo allocInfo = {};
+		allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		VmaAllocationInfo info = {};
+		VHCHECKRESULT( vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, buffer, allocation, &info) );
+		*pMappedData = info.pMappedData;
+		return VK_SUCCESS;
+	}
+
+
 	/**
 	* \brief Copy a buffer from a source buffer to a destination buffer
 	*
@@ -115,16 +146,45 @@ namespace vh {
 									VkCommandPool commandPool, VkExtent2D extent, VkFormat depthFormat,
 									VkImage *depthImage, VmaAllocation *depthImageAllocation, VkImageView * depthImageView) {
 
-		
-		VHCHECKRESULT( vhBufCreateImage(allocator, extent.width, extent.height, 1, 1,
+		return vhBufCreateDepthResources(	device, allocator, graphicsQueue, commandPool, extent, depthFormat, 1,
+											depthImage, depthImageAllocation, depthImageView);
+	}
+
+
+	/**
+	* \brief Create a layered depth image and a view to be used as layered depth map
+	*
+	* If there is more than one layer, the view is a 2D array view, e.g. for rendering all layers
+	* in one multiview render pass, and for sampling them in a shader.
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] allocator VMA allocator
+	* \param[in] graphicsQueue Device queue for submitting commands
+	* \param[in] commandPool Command pool for allocating command bbuffers
+	* \param[in] extent Extent of each layer
+	* \param[in] depthFormat Depth image format to be used for depth map
+	* \param[in] layerCount Number of layers
+	* \param[out] depthImage Depth image to be used as depth map
+	* \param[out] depthImageAllocation VMA allocation info
+	* \param[out] depthImageView View of the depth image
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateDepthResources(	VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue,
+									VkCommandPool commandPool, VkExtent2D extent, VkFormat depthFormat, uint32_t layerCount,
+									VkImage *depthImage, VmaAllocation *depthImageAllocation, VkImageView * depthImageView) {
+
+		VHCHECKRESULT( vhBufCreateImage(allocator, extent.width, extent.height, 1, layerCount,
 										depthFormat, VK_IMAGE_TILING_OPTIMAL,
-										VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0,
+										VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+										VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, 0,
 										depthImage, depthImageAllocation) );
 
-		VHCHECKRESULT( vhBufCreateImageView(device, *depthImage, depthFormat, VK_IMAGE_VIEW_TYPE_2D, 1, VK_IMAGE_ASPECT_DEPTH_BIT, depthImageView) );
+		VkImageViewType viewType = layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+		VHCHECKRESULT( vhBufCreateImageView(device, *depthImage, depthFormat, viewType, layerCount, VK_IMAGE_ASPECT_DEPTH_BIT, depthImageView) );
 
 		return vhBufTransitionImageLayout(	device, graphicsQueue, commandPool, 
-											*depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1,
+											*depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1, layerCount,
 											VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 	}
 
@@ -315,6 +375,220 @@ namespace vh {
 
 
 
+	//-------------------------------------------------------------------------------------------------------
+	/**
+	* \brief Record a copy of a rectangle of a depth image into a rectangle of another depth image
+	*
+	* The source image must be in layout VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL. The destination image is transitioned
+	* from dstLayout to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL. If dstLayout is VK_IMAGE_LAYOUT_UNDEFINED,
+	* its former content is discarded, otherwise the parts outside of the rectangle are kept.
+	* Only the depth aspect is copied.
+	*
+	* \param[in] commandBuffer Command buffer to record the copy into
+	* \param[in] srcImage The source image
+	* \param[in] srcOffset Position of the rectangle in the source image
+	* \param[in] dstImage The destination image
+	* \param[in] format Depth format of both images
+	* \param[in] extent Extent of the copied rectangle
+	* \param[in] dstOffset Position of the rectangle in the destination image
+	* \param[in] dstLayout Current layout of the destination image
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCopyDepthImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkOffset2D srcOffset, VkImage dstImage, VkFormat format,
+								VkExtent2D extent, VkOffset2D dstOffset, VkImageLayout dstLayout) {
+
+		//the destination might still be sampled or drawn by previous passes
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = dstLayout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = dstImage;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+		if (hasStencilComponent(format)) {
+			barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+		barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(	commandBuffer,
+								VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+								VK_PIPELINE_STAGE_TRANSFER_BIT,
+								0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkImageCopy region = {};
+		region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+		region.srcOffset = { srcOffset.x, srcOffset.y, 0 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+		region.dstOffset = { dstOffset.x, dstOffset.y, 0 };
+		region.extent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImage(	commandBuffer,
+						srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						1, &region);
+
+		return VK_SUCCESS;
+	}
+
+
+	//-------------------------------------------------------------------------------------------------------
+	/**
+	* \brief Record a copy of a rectangle of a depth image into a rectangle of another depth image
+	*
+	* Both images are transitioned into transfer layouts for the copy, and back into their given layouts afterwards,
+	* so the parts outside of the rectangles are kept. Only the depth aspect is copied.
+	*
+	* \param[in] commandBuffer Command buffer to record the copy into
+	* \param[in] srcImage The source image
+	* \param[in] srcLayout Current layout of the source image, must not be VK_IMAGE_LAYOUT_UNDEFINED
+	* \param[in] srcOffset Position of the rectangle in the source image
+	* \param[in] dstImage The destination image
+	* \param[in] dstLayout Current layout of the destination image, must not be VK_IMAGE_LAYOUT_UNDEFINED
+	* \param[in] dstOffset Position of the rectangle in the destination image
+	* \param[in] format Depth format of both images
+	* \param[in] extent Extent of the copied rectangle
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCopyDepthImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcLayout, VkOffset2D srcOffset,
+								VkImage dstImage, VkImageLayout dstLayout, VkOffset2D dstOffset, VkFormat format, VkExtent2D extent) {
+
+		VkImageSubresourceRange range = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+		if (hasStencilComponent(format)) {
+			range.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+		}
+
+		//the images might still be sampled, drawn or copied by previous commands
+		std::array<VkImageMemoryBarrier, 2> barriers = {};
+		for (auto &barrier : barriers) {
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.subresourceRange = range;
+			barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		}
+		barriers[0].image = srcImage;
+		barriers[0].oldLayout = srcLayout;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barriers[1].image = dstImage;
+		barriers[1].oldLayout = dstLayout;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(	commandBuffer,
+								VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+								VK_PIPELINE_STAGE_TRANSFER_BIT,
+								0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+		VkImageCopy region = {};
+		region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+		region.srcOffset = { srcOffset.x, srcOffset.y, 0 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+		region.dstOffset = { dstOffset.x, dstOffset.y, 0 };
+		region.extent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImage(	commandBuffer,
+						srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						1, &region);
+
+		//back into the given layouts
+		for (auto &barrier : barriers) {
+			std::swap(barrier.oldLayout, barrier.newLayout);
+			barrier.srcAccessMask = barrier.dstAccessMask;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+									VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		}
+
+		vkCmdPipelineBarrier(	commandBuffer,
+								VK_PIPELINE_STAGE_TRANSFER_BIT,
+								VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+								0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+		return VK_SUCCESS;
+	}
+
+
+	//-------------------------------------------------------------------------------------------------------
+	/**
+	* \brief Record a scaled copy of a rectangle of a color image into a rectangle of another color image
+	*
+	* The source is transitioned into a transfer layout for the blit and back into its given layout afterwards.
+	* The destination is transitioned from its old layout, which may be VK_IMAGE_LAYOUT_UNDEFINED if its content
+	* is not needed, into a transfer layout and then into its new layout.
+	*
+	* \param[in] commandBuffer Command buffer to record the blit into
+	* \param[in] srcImage The source image
+	* \param[in] srcLayout Current layout of the source image
+	* \param[in] srcRect The rectangle of the source image to read
+	* \param[in] dstImage The destination image
+	* \param[in] dstOldLayout Current layout of the destination image
+	* \param[in] dstNewLayout Layout of the destination image after the blit
+	* \param[in] dstRect The rectangle of the destination image to write
+	* \param[in] filter Filter to use if the rectangles have different sizes
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcLayout, VkRect2D srcRect,
+							VkImage dstImage, VkImageLayout dstOldLayout, VkImageLayout dstNewLayout, VkRect2D dstRect, VkFilter filter) {
+
+		//the source has just been drawn, the destination might still be read by the presentation engine
+		std::array<VkImageMemoryBarrier, 2> barriers = {};
+		for (auto &barrier : barriers) {
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		}
+		barriers[0].image = srcImage;
+		barriers[0].oldLayout = srcLayout;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barriers[1].image = dstImage;
+		barriers[1].oldLayout = dstOldLayout;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].srcAccessMask = 0;
+		barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(	commandBuffer,
+								VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+								0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+		VkImageBlit region = {};
+		region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.srcOffsets[0] = { srcRect.offset.x, srcRect.offset.y, 0 };
+		region.srcOffsets[1] = { srcRect.offset.x + (int32_t)srcRect.extent.width, srcRect.offset.y + (int32_t)srcRect.extent.height, 1 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.dstOffsets[0] = { dstRect.offset.x, dstRect.offset.y, 0 };
+		region.dstOffsets[1] = { dstRect.offset.x + (int32_t)dstRect.extent.width, dstRect.offset.y + (int32_t)dstRect.extent.height, 1 };
+
+		vkCmdBlitImage(	commandBuffer,
+						srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						1, &region, filter);
+
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].newLayout = srcLayout;
+		barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].newLayout = dstNewLayout;
+		barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barriers[1].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		vkCmdPipelineBarrier(	commandBuffer,
+								VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+								0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+		return VK_SUCCESS;
+	}
+
+
 	//-------------------------------------------------------------------------------------------------------
 	//
 	/**
@@ -451,10 +725,10 @@ namespace vh {
 		}
 		else if (oldLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL  && newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
 			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
 			sourceStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;		//later submissions may copy from it without waiting for the queue
 		}
 		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL  && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL ) {
 			barrier.srcAccessMask = 0;
@@ -464,11 +738,11 @@ namespace vh {
 			destinationStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
 		}
 		else if (oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL  && newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
-			barrier.srcAccessMask = 0;
+			barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;		//the overlay writes are not waited for on the CPU anymore
 			barrier.dstAccessMask = 0;
 
-			sourceStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			sourceStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			destinationStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
 		}
 		else {
 			return VK_INCOMPLETE;
@@ -490,6 +764,56 @@ namespace vh {
 
 	//texture image VMA
 
+	/**
+	* \brief Load multiple files into one pixel array, e.g. for the layers of a texture array
+	*
+	* \param[in] basedir Directoy the files are in
+	* \param[in] texNames List of file names holding the textures (should have same resolution)
+	* \param[out] pixels RGBA pixels of all files, one after the other
+	* \param[out] regions One copy region for each file, its buffer offset is the offset in pixels, its layer the index of the file
+	* \param[out] extent The extent of the first file
+	* \returns VK_SUCCESS, or VK_INCOMPLETE if a file could not be loaded
+	*
+	*/
+	VkResult vhBufLoadTextureImage(	std::string basedir, std::vector<std::string> texNames,
+									std::vector<uint8_t> &pixels, std::vector<VkBufferImageCopy> &regions, VkExtent2D *extent) {
+		pixels.clear();
+		regions.clear();
+
+		for (uint32_t i = 0; i < texNames.size(); i++) {
+			std::string filename = basedir + "/" + texNames[i];
+			int texWidth, texHeight, texChannels;
+			stbi_uc* data = stbi_load(filename.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+
+			if (data == nullptr) {
+				return VK_INCOMPLETE;
+			}
+
+			VkBufferImageCopy region = {};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = 0;
+			region.imageSubresource.baseArrayLayer = i;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent.width = texWidth;
+			region.imageExtent.height = texHeight;
+			region.imageExtent.depth = 1;
+			region.bufferOffset = pixels.size();
+			regions.push_back(region);
+
+			size_t imageSize = (size_t)texWidth * texHeight * 4;
+			pixels.insert(pixels.end(), data, data + imageSize);
+			stbi_image_free(data);
+
+			if (i == 0) {
+				extent->width = texWidth;
+				extent->height = texHeight;
+			}
+		}
+
+		return VK_SUCCESS;
+	}
+
+
 	/**
 	* \brief Create a texture image from multiple files
 	*
@@ -510,31 +834,12 @@ namespace vh {
 								std::string basedir, std::vector<std::string> texNames, VkImageCreateFlags flags,
 								VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent) {
 
-		struct image_data {
-			VkDeviceSize imageSize = 0;
-			stbi_uc* pixels;
-			int texWidth, texHeight, texChannels;
-		};
-
-		std::vector<image_data> imageData;
-		imageData.resize(texNames.size());
-		VkDeviceSize imageSize = 0;
-
-		for (uint32_t i = 0; i < texNames.size(); i++) {
-			std::string filename = basedir + "/" + texNames[i];
-			imageData[i].pixels = stbi_load(filename.c_str(), &imageData[i].texWidth, &imageData[i].texHeight, &imageData[i].texChannels, STBI_rgb_alpha);
-
-			if (imageData[i].pixels == nullptr) {
-				return VK_INCOMPLETE;
-			}
-
-			imageData[i].imageSize += imageData[i].texWidth * imageData[i].texHeight * 4;
-			imageSize += imageData[i].imageSize;
+		std::vector<uint8_t> pixels;
+		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		VHCHECKRESULT( vhBufLoadTextureImage(basedir, texNames, pixels, bufferCopyRegions, extent) );
 
-			if (!imageData[i].pixels) {
-				return VK_INCOMPLETE;
-			}
-		}
+		VkDeviceSize imageSize = pixels.size();
+		uint32_t mipLevels = 1;
 
 		VkBuffer stagingBuffer;
 		VmaAllocation stagingBufferAllocation;
@@ -542,62 +847,29 @@ namespace vh {
 											VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY,
 											&stagingBuffer, &stagingBufferAllocation ) );
 
-		gli::byte* mappedData;
-		gli::byte* memPointer;
-		VHCHECKRESULT( vmaMapMemory(allocator, stagingBufferAllocation, (void**)&mappedData) );
-		memPointer = mappedData;
-		for ( auto image : imageData ) {
-			memcpy(memPointer, image.pixels, static_cast<size_t>(image.imageSize));
-			memPointer += image.imageSize;
-			stbi_image_free(image.pixels);
-		}
+		void* mappedData;
+		VHCHECKRESULT( vmaMapMemory(allocator, stagingBufferAllocation, &mappedData) );
+		memcpy(mappedData, pixels.data(), static_cast<size_t>(imageSize));
 		vmaUnmapMemory(allocator, stagingBufferAllocation);
 
-		// Setup buffer copy regions for each face including all of it's miplevels
-		std::vector<VkBufferImageCopy> bufferCopyRegions;
-		uint32_t offset = 0, mipLevels=1;
-
-		for (uint32_t face = 0; face < imageData.size(); face++)
-		{
-			for (uint32_t level = 0; level < mipLevels; level++)
-			{
-				VkBufferImageCopy bufferCopyRegion = {};
-				bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				bufferCopyRegion.imageSubresource.mipLevel = level;
-				bufferCopyRegion.imageSubresource.baseArrayLayer = face;
-				bufferCopyRegion.imageSubresource.layerCount = 1;
-				bufferCopyRegion.imageExtent.width = imageData[face].texWidth;
-				bufferCopyRegion.imageExtent.height = imageData[face].texHeight;
-				bufferCopyRegion.imageExtent.depth = 1;
-				bufferCopyRegion.bufferOffset = offset;
-
-				bufferCopyRegions.push_back(bufferCopyRegion);
-
-				// Increase offset into staging buffer for next level / face
-				offset += (uint32_t)imageData[face].imageSize;
-			}
-		}
-
-
-		VHCHECKRESULT( vhBufCreateImage(allocator, imageData[0].texWidth, imageData[0].texHeight, 1, (uint32_t)imageData.size(),
+		VHCHECKRESULT( vhBufCreateImage(allocator, extent->width, extent->height, 1, (uint32_t)texNames.size(),
 										VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
 										VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 										flags, textureImage, textureImageAllocation ) );
 
 		VHCHECKRESULT(	vhBufTransitionImageLayout(	device, graphicsQueue, commandPool, *textureImage,
 													VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 
-													(uint32_t)imageData.size(),
+													(uint32_t)texNames.size(),
 													VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL ) );
 
 		VHCHECKRESULT( vhBufCopyBufferToImage(	device, graphicsQueue, commandPool, stagingBuffer,
 												*textureImage, bufferCopyRegions,
-												static_cast<uint32_t>(imageData[0].texWidth), 
-												static_cast<uint32_t>(imageData[0].texHeight) ));
+												extent->width, extent->height ));
 
 		VHCHECKRESULT( vhBufTransitionImageLayout(device, graphicsQueue, commandPool, *textureImage,
 												VK_FORMAT_R8G8B8A8_UNORM, 
 												VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 
-												(uint32_t)imageData.size(),
+												(uint32_t)texNames.size(),
 												VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
 												VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ) );
 
@@ -608,25 +880,18 @@ namespace vh {
 
 
 	/**
-	* \brief Create an image that is also a cubemap
+	* \brief Find the Vulkan format and the copy regions of a GLI cubemap
 	*
-	* \param[in] device Logical Vulkan device
-	* \param[in] allocator VMA allocator
-	* \param[in] graphicsQueue Device queue for submitting commands
-	* \param[in] commandPool Command pool for allocating command bbuffers
 	* \param[in] texCube The GLI cubemap information
-	* \param[out] textureImage The new image
-	* \param[out] textureImageAllocation VMA allocation information
-	* \param[out] pFormat The image format (fixed)
-	* \returns VK_SUCCESS or a Vulkan error code
+	* \param[out] regions One copy region for each face and miplevel, its buffer offset is the offset in texCube.data()
+	* \param[out] pFormat The image format
+	* \returns VK_SUCCESS, or VK_INCOMPLETE if the cubemap holds no data
 	*
 	*/
-	VkResult vhBufCreateTexturecubeImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool,
-									gli::texture_cube &texCube, VkImage *textureImage, VmaAllocation *textureImageAllocation, 
-									VkFormat *pFormat) {
-
-		VkDeviceSize imageSize = texCube.size();
-		void *pixels = texCube.data();
+	VkResult vhBufGetTexturecubeRegions(gli::texture_cube &texCube, std::vector<VkBufferImageCopy> &regions, VkFormat *pFormat) {
+		if (texCube.data() == nullptr) {
+			return VK_INCOMPLETE;
+		}
 
 		*pFormat = VK_FORMAT_R8G8B8A8_UNORM;
 		gli::texture::format_type type = texCube.format();
@@ -652,33 +917,10 @@ namespace vh {
 			break;
 		}
 
-		if (!pixels) {
-			throw std::runtime_error("failed to load texture cube image!");
-		}
-
-		uint32_t texWidth  = texCube.extent().x;
-		uint32_t texHeight = texCube.extent().y;
-		uint32_t mipLevels = (uint32_t)texCube.levels();
-
-		VkBuffer stagingBuffer;
-		VmaAllocation stagingBufferAllocation;
-		VHCHECKRESULT( vhBufCreateBuffer(	allocator, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-											VMA_MEMORY_USAGE_CPU_ONLY, &stagingBuffer, &stagingBufferAllocation ) );
-
-		void* mappedData;
-		vmaMapMemory(allocator, stagingBufferAllocation, &mappedData);
-		memcpy(mappedData, pixels, static_cast<size_t>(imageSize));
-		vmaUnmapMemory(allocator, stagingBufferAllocation);
-
-		VHCHECKRESULT( vhBufCreateImage(allocator, texWidth, texHeight, mipLevels, 6, *pFormat,
-										VK_IMAGE_TILING_OPTIMAL,
-										VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-										VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
-										textureImage, textureImageAllocation ) );
-
 		// Setup buffer copy regions for each face including all of it's miplevels
-		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		regions.clear();
 		uint32_t offset = 0;
+		uint32_t mipLevels = (uint32_t)texCube.levels();
 
 		for (uint32_t face = 0; face < 6; face++)
 		{
@@ -694,13 +936,63 @@ namespace vh {
 				bufferCopyRegion.imageExtent.depth = 1;
 				bufferCopyRegion.bufferOffset = offset;
 
-				bufferCopyRegions.push_back(bufferCopyRegion);
+				regions.push_back(bufferCopyRegion);
 
 				// Increase offset into staging buffer for next level / face
 				offset += (uint32_t)texCube[face][level].size();
 			}
 		}
 
+		return VK_SUCCESS;
+	}
+
+
+	/**
+	* \brief Create an image that is also a cubemap
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] allocator VMA allocator
+	* \param[in] graphicsQueue Device queue for submitting commands
+	* \param[in] commandPool Command pool for allocating command bbuffers
+	* \param[in] texCube The GLI cubemap information
+	* \param[out] textureImage The new image
+	* \param[out] textureImageAllocation VMA allocation information
+	* \param[out] pFormat The image format (fixed)
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateTexturecubeImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool,
+									gli::texture_cube &texCube, VkImage *textureImage, VmaAllocation *textureImageAllocation, 
+									VkFormat *pFormat) {
+
+		std::vector<VkBufferImageCopy> bufferCopyRegions;
+		if (vhBufGetTexturecubeRegions(texCube, bufferCopyRegions, pFormat) != VK_SUCCESS) {
+			throw std::runtime_error("failed to load texture cube image!");
+		}
+
+		VkDeviceSize imageSize = texCube.size();
+		void *pixels = texCube.data();
+
+		uint32_t texWidth  = texCube.extent().x;
+		uint32_t texHeight = texCube.extent().y;
+		uint32_t mipLevels = (uint32_t)texCube.levels();
+
+		VkBuffer stagingBuffer;
+		VmaAllocation stagingBufferAllocation;
+		VHCHECKRESULT( vhBufCreateBuffer(	allocator, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+											VMA_MEMORY_USAGE_CPU_ONLY, &stagingBuffer, &stagingBufferAllocation ) );
+
+		void* mappedData;
+		vmaMapMemory(allocator, stagingBufferAllocation, &mappedData);
+		memcpy(mappedData, pixels, static_cast<size_t>(imageSize));
+		vmaUnmapMemory(allocator, stagingBufferAllocation);
+
+		VHCHECKRESULT( vhBufCreateImage(allocator, texWidth, texHeight, mipLevels, 6, *pFormat,
+										VK_IMAGE_TILING_OPTIMAL,
+										VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+										VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
+										textureImage, textureImageAllocation ) );
+
 		VHCHECKRESULT( vhBufTransitionImageLayout(	device, graphicsQueue, commandPool, *textureImage,
 													*pFormat, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, 6,
 													VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
@@ -749,6 +1041,65 @@ namespace vh {
 	}
 
 
+	/**
+	* \brief Create an image sampler for reading render targets in shaders
+	*
+	* Render targets like G-buffer maps have no mipmaps and are read per texel, so the sampler
+	* clamps to the edge and does not use anisotropic filtering.
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] filter Filter for magnification and minification
+	* \param[out] textureSampler The new sampler
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateTextureSampler(VkDevice device, VkFilter filter, VkSampler *textureSampler) {
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = filter;
+		samplerInfo.minFilter = filter;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.anisotropyEnable = VK_FALSE;
+		samplerInfo.maxAnisotropy = 1;
+		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		samplerInfo.unnormalizedCoordinates = VK_FALSE;
+		samplerInfo.compareEnable = VK_FALSE;
+		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+
+		return vkCreateSampler(device, &samplerInfo, nullptr, textureSampler);
+	}
+
+
+	/**
+	* \brief Create a single framebuffer from an arbitrary list of attachments
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] attachments Image views of the attachments, in the order of the render pass attachments
+	* \param[in] renderPass Render pass to be used in
+	* \param[in] extent Extent of the attachments
+	* \param[out] frameBuffer The resulting frame buffer
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhBufCreateFramebuffer(VkDevice device, std::vector<VkImageView> attachments,
+									VkRenderPass renderPass, VkExtent2D extent, VkFramebuffer *frameBuffer) {
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		framebufferInfo.pAttachments = attachments.data();
+		framebufferInfo.width = extent.width;
+		framebufferInfo.height = extent.height;
+		framebufferInfo.layers = 1;
+
+		return vkCreateFramebuffer(device, &framebufferInfo, nullptr, frameBuffer);
+	}
+
+
 	/**
 	* \brief Create framebuffers (color + depth), one for each swap chain image
 	*
@@ -33,6 +33,26 @@ namespace vh {
 		return vkCreateCommandPool(device, &poolInfo, nullptr, commandPool);
 	}
 
+
+	/**
+	*
+	* \brief Create a new command pool for a given queue family, its command buffers are short lived
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] queueFamilyIndex The command buffers can only be submitted to queues of this family
+	* \param[out] commandPool New command pool for allocating command buffers
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhCmdCreateCommandPool(VkDevice device, uint32_t queueFamilyIndex, VkCommandPool *commandPool) {
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+		return vkCreateCommandPool(device, &poolInfo, nullptr, commandPool);
+	}
+
 	//-------------------------------------------------------------------------------------------------------
 
 	/**
@@ -82,6 +102,37 @@ namespace vh {
 	}
 
 
+	/**
+	*
+	* \brief Start a secondary command buffer that continues a render pass
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] renderPass The render pass the secondary buffer will be executed in
+	* \param[in] subpass The subpass within the render pass
+	* \param[in] frameBuffer The framebuffer that is used, or VK_NULL_HANDLE if not known
+	* \param[in] commandBuffer The secondary command buffer to start
+	* \param[in] usageFlags Flags telling how the buffer will be used, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT is always added
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhCmdBeginCommandBuffer(	VkDevice device, VkRenderPass renderPass, uint32_t subpass, VkFramebuffer frameBuffer,
+										VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags usageFlags) {
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = renderPass;
+		inheritanceInfo.subpass = subpass;
+		inheritanceInfo.framebuffer = frameBuffer;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = usageFlags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		return vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	}
+
+
 	/**
 	*
 	* \brief Submit a command buffer to a queue
@@ -129,6 +180,95 @@ namespace vh {
 	}
 
 
+	/**
+	*
+	* \brief Submit command buffers to a queue, and set a timeline semaphore to a new value when they are done
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] queue The queue the buffers are sent to
+	* \param[in] commandBufferCount Number of command buffers
+	* \param[in] pCommandBuffers The command buffers that are sent to the queue, they are executed in this order
+	* \param[in] waitSemaphore A binary semaphore to wait for before submitting, or VK_NULL_HANDLE
+	* \param[in] signalSemaphore Signal this binary semaphore after buffer is done, or VK_NULL_HANDLE
+	* \param[in] timelineSemaphore Set this timeline semaphore to timelineValue after buffer is done, or VK_NULL_HANDLE
+	* \param[in] timelineValue The new value of the timeline semaphore, must be larger than all values submitted before
+	* \param[in] waitFence Signal to this fence after buffer is done, or VK_NULL_HANDLE
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhCmdSubmitCommandBuffers(	VkDevice device, VkQueue queue,
+										uint32_t commandBufferCount, const VkCommandBuffer *pCommandBuffers,
+										VkSemaphore waitSemaphore,
+										VkSemaphore signalSemaphore,
+										VkSemaphore timelineSemaphore, uint64_t timelineValue,
+										VkFence waitFence) {
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+		VkSemaphore waitSemaphores[] = { waitSemaphore };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		if (waitSemaphore != VK_NULL_HANDLE) {
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = waitSemaphores;
+			submitInfo.pWaitDstStageMask = waitStages;
+		}
+
+		submitInfo.commandBufferCount = commandBufferCount;
+		submitInfo.pCommandBuffers = pCommandBuffers;
+
+		//the values of binary semaphores are ignored
+		VkSemaphore signalSemaphores[2];
+		uint64_t signalValues[2] = { 0, 0 };
+		if (signalSemaphore != VK_NULL_HANDLE) {
+			signalSemaphores[submitInfo.signalSemaphoreCount++] = signalSemaphore;
+		}
+		if (timelineSemaphore != VK_NULL_HANDLE) {
+			signalValues[submitInfo.signalSemaphoreCount] = timelineValue;
+			signalSemaphores[submitInfo.signalSemaphoreCount++] = timelineSemaphore;
+		}
+		submitInfo.pSignalSemaphores = signalSemaphores;
+
+		VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+		timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+		timelineInfo.pSignalSemaphoreValues = signalValues;
+		if (timelineSemaphore != VK_NULL_HANDLE) submitInfo.pNext = &timelineInfo;
+
+		if (waitFence != VK_NULL_HANDLE) {
+			vkResetFences(device, 1, &waitFence);
+		}
+
+		return vkQueueSubmit(queue, 1, &submitInfo, waitFence);
+	}
+
+
+	/**
+	*
+	* \brief Create a timeline semaphore
+	*
+	* The device must have been created with the timelineSemaphore feature, see vhDevQueryTimelineSemaphore().
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] initialValue Start value of the semaphore
+	* \param[out] semaphore The new semaphore
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhCmdCreateTimelineSemaphore(VkDevice device, uint64_t initialValue, VkSemaphore *semaphore) {
+		VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		typeInfo.initialValue = initialValue;
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		return vkCreateSemaphore(device, &semaphoreInfo, nullptr, semaphore);
+	}
+
+
 	/**
 	*
 	* \brief Begin submitting a single time command
@@ -180,7 +320,9 @@ namespace vh {
 
 	/**
 	*
-	* \brief End recording into a single time command buffer and submit it
+	* \brief End recording into a single time command buffer, submit it and wait until it is done
+	*
+	* A fence is waited for instead of the whole queue, so work that other threads submit meanwhile does not delay the caller.
 	*
 	* \param[in] device Logical Vulkan device
 	* \param[in] graphicsQueue Queue to submit the buffer to
@@ -218,13 +360,21 @@ namespace vh {
 			submitInfo.pSignalSemaphores = signalSemaphores;
 		}
 
-		if (waitFence != VK_NULL_HANDLE) {
-			vkResetFences(device, 1, &waitFence);
+		//without a fence of the caller, a temporary one tells when the buffer is done
+		VkFence fence = waitFence;
+		if (fence == VK_NULL_HANDLE) {
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VHCHECKRESULT( vkCreateFence(device, &fenceInfo, nullptr, &fence) );
+		}
+		else {
+			vkResetFences(device, 1, &fence);
 		}
 
-		VHCHECKRESULT( vkQueueSubmit(graphicsQueue, 1, &submitInfo, waitFence) );
-		VHCHECKRESULT( vkQueueWaitIdle(graphicsQueue) );
+		VHCHECKRESULT( vkQueueSubmit(graphicsQueue, 1, &submitInfo, fence) );
+		VHCHECKRESULT( vkWaitForFences(device, 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max()) );
 
+		if (fence != waitFence) vkDestroyFence(device, fence, nullptr);
 		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
 
 		return VK_SUCCESS;
@@ -106,7 +106,7 @@ namespace vh {
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = VK_API_VERSION_1_1;		//multiview and the features2 queries are core in 1.1
 
 		VkInstanceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -128,7 +128,8 @@ namespace vh {
 	*
 	* \param[in] device A physical device
 	* \param[in] surface The surface of a window
-	* \returns a structure containing queue family indices of suitable families
+	* \returns a structure containing queue family indices of suitable families. The transfer family is only set if
+	* there is a family without graphics, preferably also without compute, which usually means a DMA engine.
 	*
 	*/
 	QueueFamilyIndices vhDevFindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface ) {
@@ -164,6 +165,15 @@ namespace vh {
 			i++;
 		}
 
+		for (i = 0; i < (int)queueFamilies.size(); i++) {
+			VkQueueFlags flags = queueFamilies[i].queueFlags;
+			if (queueFamilies[i].queueCount == 0 || (flags & VK_QUEUE_TRANSFER_BIT) == 0 || (flags & VK_QUEUE_GRAPHICS_BIT) != 0) continue;
+
+			if (indices.transferFamily < 0 || (flags & VK_QUEUE_COMPUTE_BIT) == 0) {
+				indices.transferFamily = i;
+			}
+		}
+
 		return indices;
 	}
 
@@ -339,6 +349,118 @@ namespace vh {
 	}
 
 
+	//-------------------------------------------------------------------------------------------------------
+	/**
+	*
+	* \brief Find out whether a physical device can render into several layers in one multiview render pass
+	*
+	* \param[in] physicalDevice The physical device
+	* \param[out] multiview VK_TRUE if the device supports Vulkan 1.1 and the multiview feature
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhDevQueryMultiview(VkPhysicalDevice physicalDevice, VkBool32 *multiview) {
+		*multiview = VK_FALSE;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		if (properties.apiVersion < VK_API_VERSION_1_1) return VK_SUCCESS;
+
+		VkPhysicalDeviceMultiviewFeatures multiviewFeatures = {};
+		multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &multiviewFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+		*multiview = multiviewFeatures.multiview;
+		return VK_SUCCESS;
+	}
+
+
+	//-------------------------------------------------------------------------------------------------------
+	/**
+	*
+	* \brief Find out whether a physical device can hold a large array of textures that is updated while it is in use
+	*
+	* This needs VK_EXT_descriptor_indexing with partially bound arrays of combined image samplers, which can be updated
+	* after they have been bound. Also the array must fit into the update after bind limits of a descriptor set.
+	*
+	* \param[in] physicalDevice The physical device
+	* \param[in] numImages Length of the texture array
+	* \param[out] descriptorIndexing VK_TRUE if the device can hold the texture array
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhDevQueryDescriptorIndexing(VkPhysicalDevice physicalDevice, uint32_t numImages, VkBool32 *descriptorIndexing) {
+		*descriptorIndexing = VK_FALSE;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		if (properties.apiVersion < VK_API_VERSION_1_1) return VK_SUCCESS;
+		if (!checkDeviceExtensionSupport(physicalDevice, { VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME })) return VK_SUCCESS;
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &indexingFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = {};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &indexingProperties;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+		*descriptorIndexing =	indexingFeatures.descriptorBindingPartiallyBound &&
+								indexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+								indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages >= numImages &&
+								indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers >= numImages &&
+								indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages >= numImages &&
+								indexingProperties.maxDescriptorSetUpdateAfterBindSamplers >= numImages ? VK_TRUE : VK_FALSE;
+		return VK_SUCCESS;
+	}
+
+
+	//-------------------------------------------------------------------------------------------------------
+	/**
+	*
+	* \brief Find out whether a physical device has timeline semaphores
+	*
+	* A timeline semaphore holds a 64 bit counter that submissions set to increasing values, and that the CPU can read
+	* and wait for. This needs VK_KHR_timeline_semaphore and its timelineSemaphore feature.
+	*
+	* \param[in] physicalDevice The physical device
+	* \param[out] timelineSemaphore VK_TRUE if the device has timeline semaphores
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhDevQueryTimelineSemaphore(VkPhysicalDevice physicalDevice, VkBool32 *timelineSemaphore) {
+		*timelineSemaphore = VK_FALSE;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		if (properties.apiVersion < VK_API_VERSION_1_1) return VK_SUCCESS;
+		if (!checkDeviceExtensionSupport(physicalDevice, { VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME })) return VK_SUCCESS;
+
+		VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &timelineFeatures;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+		*timelineSemaphore = timelineFeatures.timelineSemaphore;
+		return VK_SUCCESS;
+	}
+
+
 	//-------------------------------------------------------------------------------------------------------
 	/**
 	*
@@ -358,10 +480,39 @@ namespace vh {
 									std::vector<const char*> requiredDeviceExtensions, 
 									std::vector<const char*> requiredValidationLayers, 
 									VkDevice *device, VkQueue *graphicsQueue, VkQueue *presentQueue) {
+
+		return vhDevCreateLogicalDevice(physicalDevice, surface, requiredDeviceExtensions, requiredValidationLayers,
+										nullptr, device, graphicsQueue, presentQueue);
+	}
+
+
+	//-------------------------------------------------------------------------------------------------------
+	/**
+	*
+	* \brief Create a logical device with additional features and according queues
+	*
+	* \param[in] physicalDevice The physical device
+	* \param[in] surface Window surface
+	* \param[in] requiredDeviceExtensions List of required device extensions
+	* \param[in] requiredValidationLayers List of required validation layers
+	* \param[in] pNextFeatures Chain of feature structures to enable, e.g. VkPhysicalDeviceMultiviewFeatures,
+	* VkPhysicalDeviceDescriptorIndexingFeaturesEXT or VkPhysicalDeviceTimelineSemaphoreFeaturesKHR, or nullptr
+	* \param[out] device The new logical device
+	* \param[out] graphicsQueue A graphics queue into the device
+	* \param[out] presentQueue A present queue into the device
+	* \param[out] transferQueue If not nullptr, a queue of the transfer family, or VK_NULL_HANDLE if the device has no such family
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhDevCreateLogicalDevice(	VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
+									std::vector<const char*> requiredDeviceExtensions,
+									std::vector<const char*> requiredValidationLayers, const void *pNextFeatures,
+									VkDevice *device, VkQueue *graphicsQueue, VkQueue *presentQueue, VkQueue *transferQueue) {
 		QueueFamilyIndices indices = vhDevFindQueueFamilies(physicalDevice, surface);
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<int> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+		if (transferQueue != nullptr && indices.transferFamily >= 0) uniqueQueueFamilies.insert(indices.transferFamily);
 
 		float queuePriority = 1.0f;
 		for (int queueFamily : uniqueQueueFamilies) {
@@ -373,7 +524,12 @@ namespace vh {
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures = {};
+		deviceFeatures.depthBounds = supportedFeatures.depthBounds;		//optional, used for culling light passes
+		deviceFeatures.fillModeNonSolid = supportedFeatures.fillModeNonSolid;	//optional, used for wireframe PSOs
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
 		deviceFeatures.textureCompressionBC = VK_TRUE;
 		deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
@@ -383,6 +539,7 @@ namespace vh {
 
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = pNextFeatures;
 
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -400,6 +557,11 @@ namespace vh {
 		vkGetDeviceQueue(*device, indices.graphicsFamily, 0, graphicsQueue);
 		vkGetDeviceQueue(*device, indices.presentFamily, 0, presentQueue);
 
+		if (transferQueue != nullptr) {
+			*transferQueue = VK_NULL_HANDLE;
+			if (indices.transferFamily >= 0) vkGetDeviceQueue(*device, indices.transferFamily, 0, transferQueue);
+		}
+
 		return VK_SUCCESS;
 	}
 }
@@ -21,6 +21,13 @@
 #include <map>
 #include <unordered_map>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <deque>
+#include <functional>
+#include <new>
+#include <type_traits>
 #include <random>
 #include <cmath>
 
@@ -58,6 +65,7 @@ namespace vh {
 	struct QueueFamilyIndices {
 		int graphicsFamily = -1;	///<Index of graphics family
 		int presentFamily = -1;		///<Index of present family
+		int transferFamily = -1;	///<Index of a family with transfer but without graphics queues, -1 if there is none
 
 		///\returns true if the structure is filled completely
 		bool isComplete() {
@@ -152,6 +160,9 @@ namespace vh {
 	QueueFamilyIndices vhDevFindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
 	VkFormat vhDevFindSupportedFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 	VkFormat vhDevFindDepthFormat(VkPhysicalDevice physicalDevice);
+	VkResult vhDevQueryMultiview(VkPhysicalDevice physicalDevice, VkBool32 *multiview);
+	VkResult vhDevQueryDescriptorIndexing(VkPhysicalDevice physicalDevice, uint32_t numImages, VkBool32 *descriptorIndexing);
+	VkResult vhDevQueryTimelineSemaphore(VkPhysicalDevice physicalDevice, VkBool32 *timelineSemaphore);
 
 
 	//--------------------------------------------------------------------------------------------------------------------------------
@@ -160,6 +171,10 @@ namespace vh {
 										std::vector<const char*> requiredDeviceExtensions,
 										std::vector<const char*> requiredValidationLayers, 
 										VkDevice *device, VkQueue *graphicsQueue, VkQueue *presentQueue);
+	VkResult vhDevCreateLogicalDevice(	VkPhysicalDevice physicalDevice, VkSurfaceKHR surface,
+										std::vector<const char*> requiredDeviceExtensions,
+										std::vector<const char*> requiredValidationLayers, const void *pNextFeatures,
+										VkDevice *device, VkQueue *graphicsQueue, VkQueue *presentQueue, VkQueue *transferQueue = nullptr);
 
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//swapchain
@@ -174,11 +189,17 @@ namespace vh {
 	//buffer
 	VkResult vhBufCreateBuffer( VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags usage,
 								VmaMemoryUsage vmaUsage, VkBuffer *buffer, VmaAllocation *allocation);
+	VkResult vhBufCreateMappedBuffer(	VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+										VkBuffer *buffer, VmaAllocation *allocation, void **pMappedData);
 	VkResult vhBufCopyBuffer(	VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 	VkResult vhBufCreateImageView(VkDevice device, VkImage image, VkFormat format, VkImageViewType viewtype, uint32_t layerCount, VkImageAspectFlags aspectFlags, VkImageView *imageView);
+	bool	 hasStencilComponent(VkFormat format);
 	VkResult vhBufCreateDepthResources(	VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue,
 										VkCommandPool commandPool, VkExtent2D swapChainExtent, VkFormat depthFormat,
 										VkImage *depthImage, VmaAllocation *depthImageAllocation, VkImageView * depthImageView);
+	VkResult vhBufCreateDepthResources(	VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue,
+										VkCommandPool commandPool, VkExtent2D extent, VkFormat depthFormat, uint32_t layerCount,
+										VkImage *depthImage, VmaAllocation *depthImageAllocation, VkImageView * depthImageView);
 	VkResult vhBufCreateImage(	VmaAllocator allocator, uint32_t width, uint32_t height,
 								uint32_t miplevels, uint32_t arrayLayers,
 								VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkImageCreateFlags flags,
@@ -195,18 +216,30 @@ namespace vh {
 	VkResult vhBufCopyImageToBuffer(VkDevice device, VkQueue queue, VkCommandPool commandPool,
 									VkImage image, VkBuffer buffer, std::vector<VkBufferImageCopy> &regions,
 									uint32_t width, uint32_t height);
+	VkResult vhBufCopyDepthImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcLayout, VkOffset2D srcOffset,
+								VkImage dstImage, VkImageLayout dstLayout, VkOffset2D dstOffset, VkFormat format, VkExtent2D extent);
+	VkResult vhBufCopyDepthImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkOffset2D srcOffset, VkImage dstImage, VkFormat format,
+									VkExtent2D extent, VkOffset2D dstOffset, VkImageLayout dstLayout);
+	VkResult vhBufBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcLayout, VkRect2D srcRect,
+							VkImage dstImage, VkImageLayout dstOldLayout, VkImageLayout dstNewLayout, VkRect2D dstRect, VkFilter filter);
 	VkResult vhBufTransitionImageLayout(VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool,
 									VkImage image, VkFormat format, VkImageAspectFlagBits aspect, uint32_t miplevels, uint32_t layerCount,
 									VkImageLayout oldLayout, VkImageLayout newLayout);
 	VkResult vhBufTransitionImageLayout(VkDevice device, VkQueue graphicsQueue, VkCommandBuffer commandBuffer,
 									VkImage image, VkFormat format, VkImageAspectFlagBits aspect, uint32_t miplevels, uint32_t layerCount,
 									VkImageLayout oldLayout, VkImageLayout newLayout);
+	VkResult vhBufLoadTextureImage(	std::string basedir, std::vector<std::string> texNames,
+									std::vector<uint8_t> &pixels, std::vector<VkBufferImageCopy> &regions, VkExtent2D *extent);
 	VkResult vhBufCreateTextureImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, std::string basedir, std::vector<std::string> names, VkImageCreateFlags flags, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkExtent2D *extent);
+	VkResult vhBufGetTexturecubeRegions(gli::texture_cube &texCube, std::vector<VkBufferImageCopy> &regions, VkFormat *pFormat);
 	VkResult vhBufCreateTexturecubeImage(VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue, VkCommandPool commandPool, gli::texture_cube &cube, VkImage *textureImage, VmaAllocation *textureImageAllocation, VkFormat *pformat);
 	VkResult vhBufCreateTextureSampler(VkDevice device, VkSampler *textureSampler);
+	VkResult vhBufCreateTextureSampler(VkDevice device, VkFilter filter, VkSampler *textureSampler);
 	VkResult vhBufCreateFramebuffers(VkDevice device, std::vector<VkImageView> imageViews,
 									std::vector<VkImageView> depthImageViews, VkRenderPass renderPass, VkExtent2D extent,
 									std::vector<VkFramebuffer> &frameBuffers);
+	VkResult vhBufCreateFramebuffer(VkDevice device, std::vector<VkImageView> attachments,
+									VkRenderPass renderPass, VkExtent2D extent, VkFramebuffer *frameBuffer);
 	VkResult vhBufCopySwapChainImageToHost(	VkDevice device, VmaAllocator allocator, VkQueue graphicsQueue,
 											VkCommandPool commandPool, VkImage image, VkImageAspectFlagBits aspect, gli::byte *bufferData,
 											uint32_t width, uint32_t height, uint32_t imageSize);
@@ -229,12 +262,30 @@ namespace vh {
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//rendering
 	VkResult vhRenderCreateRenderPass( VkDevice device, VkFormat swapChainImageFormat, VkFormat depthFormat, VkAttachmentLoadOp loadOp, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPass(	VkDevice device, VkFormat swapChainImageFormat, VkFormat depthFormat,
+										VkAttachmentLoadOp colorLoadOp, VkAttachmentLoadOp depthLoadOp, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPass(	VkDevice device, VkFormat swapChainImageFormat, VkFormat depthFormat,
+										VkAttachmentLoadOp colorLoadOp, VkAttachmentLoadOp depthLoadOp,
+										VkImageLayout finalLayout, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPassGBuffer(VkDevice device, std::vector<VkFormat> colorFormats, VkFormat depthFormat, VkRenderPass *renderPass);
 	VkResult vhRenderCreateRenderPassShadow( VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPassShadow( VkDevice device, VkFormat depthFormat, VkAttachmentLoadOp loadOp,
+											 VkImageLayout finalLayout, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPassShadow( VkDevice device, VkFormat depthFormat, VkAttachmentLoadOp loadOp,
+											 VkImageLayout initialLayout, VkImageLayout finalLayout, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPassDepth( VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass);
+	VkResult vhRenderCreateRenderPassShadowMultiview( VkDevice device, VkFormat depthFormat, uint32_t viewMask, VkRenderPass *renderPass);
 
 	VkResult vhRenderCreateDescriptorSetLayout(	VkDevice device, std::vector<uint32_t> counts, std::vector<VkDescriptorType> types,
 											std::vector<VkShaderStageFlags> stageFlags, VkDescriptorSetLayout * descriptorSetLayout);
+	VkResult vhRenderCreateDescriptorSetLayout(	VkDevice device, std::vector<uint32_t> counts, std::vector<VkDescriptorType> types,
+											std::vector<VkShaderStageFlags> stageFlags, std::vector<VkDescriptorBindingFlagsEXT> bindingFlags,
+											VkDescriptorSetLayout * descriptorSetLayout);
 	VkResult vhRenderCreateDescriptorPool(	VkDevice device, std::vector<VkDescriptorType> types,
 											std::vector<uint32_t> numberDesc, VkDescriptorPool * descriptorPool);
+	VkResult vhRenderCreateDescriptorPool(	VkDevice device, std::vector<VkDescriptorType> types,
+											std::vector<uint32_t> numberDesc, uint32_t maxSets, VkDescriptorPoolCreateFlags flags,
+											VkDescriptorPool * descriptorPool);
 	VkResult vhRenderCreateDescriptorSets(	VkDevice device, uint32_t numberDesc,
 											VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool descriptorPool,
 											std::vector<VkDescriptorSet> & descriptorSets);
@@ -243,19 +294,52 @@ namespace vh {
 										std::vector<uint32_t> bufferRanges,
 										std::vector<std::vector<VkImageView>> textureImageViews,
 										std::vector<std::vector<VkSampler>> textureSamplers);
+	VkResult vhRenderUpdateDescriptorSetBuffer(VkDevice device, VkDescriptorSet descriptorSet, uint32_t binding,
+										VkDescriptorType type, VkBuffer buffer, VkDeviceSize range);
+	VkResult vhRenderUpdateDescriptorSetImage(VkDevice device, VkDescriptorSet descriptorSet, uint32_t binding,
+										VkImageView imageView, VkSampler sampler);
+	VkResult vhRenderUpdateDescriptorSetImage(VkDevice device, VkDescriptorSet descriptorSet, uint32_t binding, uint32_t arrayElement,
+										VkImageView imageView, VkSampler sampler);
 	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer, VkExtent2D extent);
 	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer,
 									std::vector<VkClearValue> &clearValues, VkExtent2D extent);
+	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer,
+									std::vector<VkClearValue> &clearValues, VkExtent2D extent, VkSubpassContents subpassContents);
+	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer,
+									std::vector<VkClearValue> &clearValues, VkRect2D renderArea, VkSubpassContents subpassContents);
+	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer,
+									uint32_t clearValueCount, const VkClearValue *pClearValues, VkExtent2D extent, VkSubpassContents subpassContents);
+	VkResult vhRenderBeginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer,
+									uint32_t clearValueCount, const VkClearValue *pClearValues, VkRect2D renderArea, VkSubpassContents subpassContents);
+	VkResult vhRenderSetViewport(VkCommandBuffer commandBuffer, VkRect2D rect);
 	VkResult vhRenderPresentResult(	VkQueue presentQueue, VkSwapchainKHR swapChain,
 									uint32_t imageIndex, VkSemaphore signalSemaphore);
 
+	VkResult vhPipeCreatePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, std::string fileName, VkPipelineCache *pipelineCache);
+	VkResult vhPipeSavePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, VkPipelineCache pipelineCache, std::string fileName);
 	VkResult vhPipeCreateGraphicsPipelineLayout(VkDevice device, std::vector<VkDescriptorSetLayout> descriptorSetLayouts, std::vector<VkPushConstantRange> pushConstantRanges, VkPipelineLayout *pipelineLayout);
-	VkResult vhPipeCreateGraphicsPipeline(	VkDevice device, std::vector<std::string> shaderFileNames,
-											VkExtent2D swapChainExtent, VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+	VkResult vhPipeCreateGraphicsPipeline(	VkDevice device, VkPipelineCache pipelineCache, std::vector<std::string> shaderFileNames,
+											VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
 											std::vector<VkDynamicState> dynamicStates, VkPipeline *graphicsPipeline);
-	VkResult vhPipeCreateGraphicsShadowPipeline(VkDevice device, std::string verShaderFilename,
-												VkExtent2D shadowMapExtent, VkPipelineLayout pipelineLayout,
+	VkResult vhPipeCreateGraphicsPipeline(	VkDevice device, VkPipelineCache pipelineCache, std::vector<std::string> shaderFileNames,
+											VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+											std::vector<VkDynamicState> dynamicStates, VkCompareOp depthCompareOp, VkBool32 depthWriteEnable,
+											VkCullModeFlags cullMode, VkPolygonMode polygonMode, std::vector<uint32_t> specializationConstants,
+											VkPipeline *graphicsPipeline);
+	VkResult vhPipeCreateGraphicsShadowPipeline(VkDevice device, VkPipelineCache pipelineCache, std::string verShaderFilename,
+												VkPipelineLayout pipelineLayout,
 												VkRenderPass renderPass, VkPipeline *graphicsPipeline);
+	VkResult vhPipeCreateGraphicsShadowPipeline(VkDevice device, VkPipelineCache pipelineCache, std::string verShaderFilename,
+												VkPipelineLayout pipelineLayout,
+												VkRenderPass renderPass, std::vector<VkDynamicState> dynamicStates,
+												VkPipeline *graphicsPipeline);
+	VkResult vhPipeCreateGraphicsGBufferPipeline(	VkDevice device, VkPipelineCache pipelineCache, std::vector<std::string> shaderFileNames,
+													VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+													uint32_t numColorAttachments, VkCullModeFlags cullMode, VkPolygonMode polygonMode,
+													VkPipeline *graphicsPipeline);
+	VkResult vhPipeCreateGraphicsLightPipeline(	VkDevice device, VkPipelineCache pipelineCache, std::vector<std::string> shaderFileNames,
+												VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+												VkPipeline *graphicsPipeline);
 
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//file
@@ -264,13 +348,21 @@ namespace vh {
 	//--------------------------------------------------------------------------------------------------------------------------------
 	//command
 	VkResult vhCmdCreateCommandPool(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, VkCommandPool *commandPool);
+	VkResult vhCmdCreateCommandPool(VkDevice device, uint32_t queueFamilyIndex, VkCommandPool *commandPool);
 
 	VkResult vhCmdCreateCommandBuffers(	VkDevice device, VkCommandPool commandPool,
 										VkCommandBufferLevel level, uint32_t count, VkCommandBuffer *pBuffers);
 	VkResult vhCmdBeginCommandBuffer(	VkDevice device, VkCommandBuffer commandBuffer,
 										VkCommandBufferUsageFlagBits usageFlags);
+	VkResult vhCmdBeginCommandBuffer(	VkDevice device, VkRenderPass renderPass, uint32_t subpass, VkFramebuffer frameBuffer,
+										VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags usageFlags);
 	VkResult vhCmdSubmitCommandBuffer(	VkDevice device, VkQueue graphicsQueue, VkCommandBuffer commandBuffer,
 										VkSemaphore waitSemaphore, VkSemaphore signalSemaphore, VkFence waitFence);
+	VkResult vhCmdSubmitCommandBuffers(	VkDevice device, VkQueue graphicsQueue,
+										uint32_t commandBufferCount, const VkCommandBuffer *pCommandBuffers,
+										VkSemaphore waitSemaphore, VkSemaphore signalSemaphore,
+										VkSemaphore timelineSemaphore, uint64_t timelineValue, VkFence waitFence);
+	VkResult vhCmdCreateTimelineSemaphore(VkDevice device, uint64_t initialValue, VkSemaphore *semaphore);
 	VkCommandBuffer vhCmdBeginSingleTimeCommands(VkDevice device, VkCommandPool commandPool);
 	VkResult vhCmdEndSingleTimeCommands(VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool, VkCommandBuffer commandBuffer);
 	VkResult vhCmdEndSingleTimeCommands(VkDevice device, VkQueue graphicsQueue, VkCommandPool commandPool, VkCommandBuffer commandBuffer,
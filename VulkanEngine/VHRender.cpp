@@ -29,30 +29,84 @@ namespace vh {
 									VkAttachmentLoadOp loadOp,
 									VkRenderPass *renderPass) {
 
+		return vhRenderCreateRenderPass(device, swapChainImageFormat, depthFormat, loadOp, loadOp, renderPass);
+	}
+
+
+	/**
+	*
+	* \brief Create a render pass for a light pass, with different load operations for color and depth
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] swapChainImageFormat The swap chain image format
+	* \param[in] depthFormat The depth map image format
+	* \param[in] colorLoadOp What to do with the color attachment when starting the render pass
+	* \param[in] depthLoadOp What to do with the depth attachment when starting the render pass
+	* \param[out] renderPass The new render pass
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateRenderPass(	VkDevice device,
+										VkFormat swapChainImageFormat,
+										VkFormat depthFormat,
+										VkAttachmentLoadOp colorLoadOp,
+										VkAttachmentLoadOp depthLoadOp,
+										VkRenderPass *renderPass) {
+
+		return vhRenderCreateRenderPass(device, swapChainImageFormat, depthFormat, colorLoadOp, depthLoadOp,
+										VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, renderPass);
+	}
+
+
+	/**
+	*
+	* \brief Create a render pass for a light pass or an overlay, with a given final layout of the color attachment
+	*
+	* If the render pass is the last one drawing into a swapchain image, the final layout can be
+	* VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, so that no extra barrier is needed before presenting.
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] swapChainImageFormat The swap chain image format
+	* \param[in] depthFormat The depth map image format
+	* \param[in] colorLoadOp What to do with the color attachment when starting the render pass
+	* \param[in] depthLoadOp What to do with the depth attachment when starting the render pass
+	* \param[in] finalLayout Either VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL or VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+	* \param[out] renderPass The new render pass
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateRenderPass(	VkDevice device,
+										VkFormat swapChainImageFormat,
+										VkFormat depthFormat,
+										VkAttachmentLoadOp colorLoadOp,
+										VkAttachmentLoadOp depthLoadOp,
+										VkImageLayout finalLayout,
+										VkRenderPass *renderPass) {
+
 		VkAttachmentDescription colorAttachment = {};
 		colorAttachment.format = swapChainImageFormat;
 		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachment.loadOp = loadOp;
+		colorAttachment.loadOp = colorLoadOp;
 		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		
 		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+		if (colorLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
 			colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		}
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		colorAttachment.finalLayout = finalLayout;
 
 		VkAttachmentDescription depthAttachment = {};
 		depthAttachment.format = depthFormat;
 		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = loadOp; 
+		depthAttachment.loadOp = depthLoadOp; 
 		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; 
 		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
 		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+		if (depthLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
 			depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 		}
 		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -105,16 +159,62 @@ namespace vh {
 	*
 	*/
 	VkResult vhRenderCreateRenderPassShadow(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass) {
+		return vhRenderCreateRenderPassShadow(device, depthFormat, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, renderPass);
+	}
+
+
+	/**
+	*
+	* \brief Create a render pass for a shadow pass, or for drawing a cached shadow map
+	*
+	* If the depth is loaded, then it must have been copied into the shadow map before, i.e. the map must be
+	* in layout VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL. If the final layout is VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	* then the map is a cache that is copied into other shadow maps after the render pass.
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] depthFormat The depth map image format
+	* \param[in] loadOp Either VK_ATTACHMENT_LOAD_OP_CLEAR or VK_ATTACHMENT_LOAD_OP_LOAD
+	* \param[in] finalLayout Either VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL or VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+	* \param[out] renderPass The new render pass
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateRenderPassShadow(VkDevice device, VkFormat depthFormat, VkAttachmentLoadOp loadOp,
+											VkImageLayout finalLayout, VkRenderPass *renderPass) {
+		VkImageLayout initialLayout = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		return vhRenderCreateRenderPassShadow(device, depthFormat, loadOp, initialLayout, finalLayout, renderPass);
+	}
+
+
+	/**
+	*
+	* \brief Create a render pass for a shadow pass with a given initial layout of the shadow map
+	*
+	* If the initial layout is VK_IMAGE_LAYOUT_UNDEFINED, the whole map is discarded. If the map is a shadow atlas,
+	* where only the render area is cleared and drawn, the initial layout must be
+	* VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL so that the other parts of the atlas are kept.
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] depthFormat The depth map image format
+	* \param[in] loadOp Either VK_ATTACHMENT_LOAD_OP_CLEAR or VK_ATTACHMENT_LOAD_OP_LOAD
+	* \param[in] initialLayout VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, or VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL if the depth is loaded
+	* \param[in] finalLayout Either VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL or VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+	* \param[out] renderPass The new render pass
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateRenderPassShadow(VkDevice device, VkFormat depthFormat, VkAttachmentLoadOp loadOp,
+											VkImageLayout initialLayout, VkImageLayout finalLayout, VkRenderPass *renderPass) {
 
 		VkAttachmentDescription attachmentDescription{};
 		attachmentDescription.format = depthFormat;
 		attachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
-		attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;							// Clear depth at beginning of the render pass
+		attachmentDescription.loadOp = loadOp;												// Clear depth at beginning of the render pass, or keep the copied depth
 		attachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;						// We will read from depth, so it's important to store the depth attachment results
 		attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		attachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;					// We don't care about initial layout of the attachment
-		attachmentDescription.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;		// Attachment will be transitioned to shader read at render pass end
+		attachmentDescription.initialLayout = initialLayout;								// Undefined, or keep the atlas, or the depth has just been copied into the attachment
+		attachmentDescription.finalLayout = finalLayout;									// Attachment will be transitioned to shader read or copy source at render pass end
 
 		VkAttachmentReference depthReference = {};
 		depthReference.attachment = 0;
@@ -135,6 +235,12 @@ namespace vh {
 		dependencies[0].srcAccessMask = 0;
 		dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+		if (initialLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {		//wait for the copy
+			dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			dependencies[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			dependencies[0].dependencyFlags = 0;
+		}
 
 		dependencies[1].srcSubpass = 0;
 		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
@@ -143,6 +249,15 @@ namespace vh {
 		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+		if (finalLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {	//the map is copied afterwards
+			dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			dependencies[1].dependencyFlags = 0;
+		}
+		if (initialLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {	//atlas tiles are sampled anywhere, not only in the same region
+			dependencies[0].dependencyFlags = 0;
+			dependencies[1].dependencyFlags = 0;
+		}
 
 		VkRenderPassCreateInfo renderPassCreateInfo = {};
 		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -157,6 +272,238 @@ namespace vh {
 	}
 
 
+	/**
+	*
+	* \brief Create a multiview render pass for drawing several shadow maps at once
+	*
+	* The depth attachment is a layered image, and each draw is broadcast to all layers in the view mask.
+	* The vertex shader selects the shadow camera of a layer using gl_ViewIndex. All layers are cleared
+	* and can be sampled afterwards.
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] depthFormat The depth map image format
+	* \param[in] viewMask Bit mask of the layers to draw into, e.g. 0x3F for the 6 faces of a cube
+	* \param[out] renderPass The new render pass
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateRenderPassShadowMultiview(VkDevice device, VkFormat depthFormat, uint32_t viewMask, VkRenderPass *renderPass) {
+
+		VkAttachmentDescription attachmentDescription{};
+		attachmentDescription.format = depthFormat;
+		attachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachmentDescription.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkAttachmentReference depthReference = {};
+		depthReference.attachment = 0;
+		depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 0;
+		subpass.pDepthStencilAttachment = &depthReference;
+
+		//the maps are sampled anywhere by the following light pass, so the dependencies are not by region
+		std::array<VkSubpassDependency, 2> dependencies;
+
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dependencyFlags = 0;
+
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		dependencies[1].dependencyFlags = 0;
+
+		VkRenderPassMultiviewCreateInfo multiviewInfo = {};
+		multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+		multiviewInfo.subpassCount = 1;
+		multiviewInfo.pViewMasks = &viewMask;
+
+		VkRenderPassCreateInfo renderPassCreateInfo = {};
+		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassCreateInfo.pNext = &multiviewInfo;
+		renderPassCreateInfo.attachmentCount = 1;
+		renderPassCreateInfo.pAttachments = &attachmentDescription;
+		renderPassCreateInfo.subpassCount = 1;
+		renderPassCreateInfo.pSubpasses = &subpass;
+		renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassCreateInfo.pDependencies = dependencies.data();
+
+		return vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, renderPass);
+	}
+
+
+	/**
+	*
+	* \brief Create a render pass for a depth pre-pass
+	*
+	* Like the shadow render pass, but the depth map stays a depth attachment, since the following light passes
+	* test against it.
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] depthFormat The depth map image format
+	* \param[out] renderPass The new render pass
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateRenderPassDepth(VkDevice device, VkFormat depthFormat, VkRenderPass *renderPass) {
+
+		VkAttachmentDescription attachmentDescription{};
+		attachmentDescription.format = depthFormat;
+		attachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthReference = {};
+		depthReference.attachment = 0;
+		depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 0;
+		subpass.pDepthStencilAttachment = &depthReference;
+
+		std::array<VkSubpassDependency, 2> dependencies;
+
+		//the light passes of the previous frame must be done with the depth map
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		//the light passes test against the depth map
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		VkRenderPassCreateInfo renderPassCreateInfo = {};
+		renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassCreateInfo.attachmentCount = 1;
+		renderPassCreateInfo.pAttachments = &attachmentDescription;
+		renderPassCreateInfo.subpassCount = 1;
+		renderPassCreateInfo.pSubpasses = &subpass;
+		renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassCreateInfo.pDependencies = dependencies.data();
+
+		return vkCreateRenderPass(device, &renderPassCreateInfo, nullptr, renderPass);
+	}
+
+
+	/**
+	*
+	* \brief Create a render pass for the geometry pass of a deferred renderer
+	*
+	* The color attachments are transitioned to shader read at the end of the render pass, so the following
+	* light passes can read them. The depth attachment stays a depth attachment, since the light passes use it for depth testing.
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] colorFormats The formats of the G-buffer maps, one color attachment for each
+	* \param[in] depthFormat The depth map image format
+	* \param[out] renderPass The new render pass
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateRenderPassGBuffer(VkDevice device, std::vector<VkFormat> colorFormats, VkFormat depthFormat, VkRenderPass *renderPass) {
+
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorAttachmentRefs;
+
+		for (uint32_t i = 0; i < colorFormats.size(); i++) {
+			VkAttachmentDescription colorAttachment = {};
+			colorAttachment.format = colorFormats[i];
+			colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			attachments.push_back(colorAttachment);
+
+			VkAttachmentReference colorAttachmentRef = {};
+			colorAttachmentRef.attachment = i;
+			colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			colorAttachmentRefs.push_back(colorAttachmentRef);
+		}
+
+		VkAttachmentDescription depthAttachment = {};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		attachments.push_back(depthAttachment);
+
+		VkAttachmentReference depthAttachmentRef = {};
+		depthAttachmentRef.attachment = (uint32_t)colorFormats.size();
+		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = (uint32_t)colorAttachmentRefs.size();
+		subpass.pColorAttachments = colorAttachmentRefs.data();
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		std::array<VkSubpassDependency, 2> dependencies;
+
+		//the light passes of the previous frame must be done with reading the G-buffer and writing depth
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dependencyFlags = 0;
+
+		//the light passes read the G-buffer in the fragment shader and test against the depth
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dependencyFlags = 0;
+
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = (uint32_t)attachments.size();
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = (uint32_t)dependencies.size();
+		renderPassInfo.pDependencies = dependencies.data();
+
+		return vkCreateRenderPass(device, &renderPassInfo, nullptr, renderPass);
+	}
+
+
 	/**
 	*
 	* \brief Create a descriptor layout
@@ -194,6 +541,57 @@ namespace vh {
 		return vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, descriptorSetLayout);
 	}
 
+	/**
+	*
+	* \brief Create a descriptor layout with descriptor indexing flags for its bindings
+	*
+	* If a binding can be updated after it has been bound, then sets of this layout must come from a
+	* pool created with VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT.
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] counts The number of images in an array
+	* \param[in] types Contains the resource types for the increasing bindings
+	* \param[in] stageFlags Denotes in which stages they should be used
+	* \param[in] bindingFlags Descriptor indexing flags of the bindings, e.g. VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+	* \param[out] descriptorSetLayout The new descriptor set layout
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateDescriptorSetLayout(	VkDevice device,
+											std::vector<uint32_t> counts,
+											std::vector<VkDescriptorType> types,
+											std::vector<VkShaderStageFlags> stageFlags,
+											std::vector<VkDescriptorBindingFlagsEXT> bindingFlags,
+											VkDescriptorSetLayout * descriptorSetLayout) {
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		bindings.resize(types.size());
+
+		VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
+		for (uint32_t i = 0; i < types.size(); i++) {
+			bindings[i].binding = i;
+			bindings[i].descriptorCount = counts[i];
+			bindings[i].descriptorType = types[i];
+			bindings[i].pImmutableSamplers = nullptr;
+			bindings[i].stageFlags = stageFlags[i];
+			if (bindingFlags[i] & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT) layoutFlags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = layoutFlags;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		return vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, descriptorSetLayout);
+	}
+
 	/**
 	*
 	* \brief Create a descriptor pool
@@ -226,6 +624,43 @@ namespace vh {
 		return vkCreateDescriptorPool(device, &poolInfo, nullptr, descriptorPool);
 	}
 
+	/**
+	*
+	* \brief Create a descriptor pool with a given number of sets and flags
+	*
+	* \param[in] device The logical Vulkan device
+	* \param[in] types Contains the resource types in the pool
+	* \param[in] numberDesc Denotes how many of them are in the pool
+	* \param[in] maxSets Max number of sets drawn from the pool
+	* \param[in] flags Pool flags, e.g. VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT
+	* \param[out] descriptorPool The new descriptor pool
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderCreateDescriptorPool(	VkDevice device,
+										std::vector<VkDescriptorType> types,
+										std::vector<uint32_t> numberDesc,
+										uint32_t maxSets,
+										VkDescriptorPoolCreateFlags flags,
+										VkDescriptorPool * descriptorPool) {
+		std::vector<VkDescriptorPoolSize> poolSizes = {};
+		poolSizes.resize(types.size());
+
+		for (uint32_t i = 0; i < types.size(); i++) {
+			poolSizes[i].type = types[i];
+			poolSizes[i].descriptorCount = numberDesc[i];
+		}
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = flags;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = maxSets;
+
+		return vkCreateDescriptorPool(device, &poolInfo, nullptr, descriptorPool);
+	}
+
 	/**
 	*
 	* \brief Create a number of descriptor sets, one for each frame in the swapchain
@@ -326,6 +761,92 @@ namespace vh {
 		return VK_SUCCESS;
 	}
 
+	/**
+	*
+	* \brief Update a single buffer binding of a descriptor set
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] descriptorSet The descriptor set to be updated
+	* \param[in] binding The binding within the set
+	* \param[in] type Descriptor type, e.g. VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+	* \param[in] buffer The buffer to be bound
+	* \param[in] range Size of the buffer range that is accessible
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderUpdateDescriptorSetBuffer(VkDevice device, VkDescriptorSet descriptorSet, uint32_t binding,
+										VkDescriptorType type, VkBuffer buffer, VkDeviceSize range) {
+
+		VkDescriptorBufferInfo bufferInfo = {};
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = 0;
+		bufferInfo.range = range;
+
+		VkWriteDescriptorSet descriptorWrite = {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = descriptorSet;
+		descriptorWrite.dstBinding = binding;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.descriptorType = type;
+		descriptorWrite.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+		return VK_SUCCESS;
+	}
+
+	/**
+	*
+	* \brief Update a single combined image sampler of a descriptor set
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] descriptorSet The descriptor set to update
+	* \param[in] binding The binding of the image in the set
+	* \param[in] imageView The image view, its image must be in layout VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when sampled
+	* \param[in] sampler The sampler
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderUpdateDescriptorSetImage(VkDevice device, VkDescriptorSet descriptorSet, uint32_t binding,
+										VkImageView imageView, VkSampler sampler) {
+
+		return vhRenderUpdateDescriptorSetImage(device, descriptorSet, binding, 0, imageView, sampler);
+	}
+
+	/**
+	*
+	* \brief Update a single combined image sampler in an array of a descriptor set
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] descriptorSet The descriptor set to update
+	* \param[in] binding The binding of the image array in the set
+	* \param[in] arrayElement Index of the image in the array
+	* \param[in] imageView The image view, its image must be in layout VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when sampled
+	* \param[in] sampler The sampler
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderUpdateDescriptorSetImage(VkDevice device, VkDescriptorSet descriptorSet, uint32_t binding, uint32_t arrayElement,
+										VkImageView imageView, VkSampler sampler) {
+
+		VkDescriptorImageInfo imageInfo = {};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = sampler;
+
+		VkWriteDescriptorSet descriptorWrite = {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = descriptorSet;
+		descriptorWrite.dstBinding = binding;
+		descriptorWrite.dstArrayElement = arrayElement;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+		return VK_SUCCESS;
+	}
+
 	/**
 	*
 	* \brief Start rendering in a command buffer
@@ -372,18 +893,148 @@ namespace vh {
 									std::vector<VkClearValue> &clearValues,
 									VkExtent2D extent) {
 
+		return vhRenderBeginRenderPass(commandBuffer, renderPass, frameBuffer, clearValues, extent, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+
+	/**
+	*
+	* \brief Start rendering in a command buffer
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] renderPass The render pass that should be begun
+	* \param[in] frameBuffer The framebuffer for the render pass
+	* \param[in] clearValues A list of clear values to clear render targets
+	* \param[in] extent Extent of the framebuffer images
+	* \param[in] subpassContents Record draw commands inline or execute secondary command buffers
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderBeginRenderPass(	VkCommandBuffer commandBuffer,
+									VkRenderPass renderPass,
+									VkFramebuffer frameBuffer,
+									std::vector<VkClearValue> &clearValues,
+									VkExtent2D extent,
+									VkSubpassContents subpassContents) {
+
+		VkRect2D renderArea = {};
+		renderArea.offset = { 0, 0 };
+		renderArea.extent = extent;
+		return vhRenderBeginRenderPass(commandBuffer, renderPass, frameBuffer, clearValues, renderArea, subpassContents);
+	}
+
+
+	/**
+	*
+	* \brief Start rendering into a part of the framebuffer
+	*
+	* Only the render area is cleared, loaded and stored, e.g. a single tile of a shadow atlas.
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] renderPass The render pass that should be begun
+	* \param[in] frameBuffer The framebuffer for the render pass
+	* \param[in] clearValues A list of clear values to clear render targets
+	* \param[in] renderArea The part of the framebuffer images that is rendered
+	* \param[in] subpassContents Record draw commands inline or execute secondary command buffers
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderBeginRenderPass(	VkCommandBuffer commandBuffer,
+									VkRenderPass renderPass,
+									VkFramebuffer frameBuffer,
+									std::vector<VkClearValue> &clearValues,
+									VkRect2D renderArea,
+									VkSubpassContents subpassContents) {
+
+		return vhRenderBeginRenderPass(	commandBuffer, renderPass, frameBuffer, (uint32_t)clearValues.size(),
+										clearValues.size() > 0 ? clearValues.data() : nullptr, renderArea, subpassContents);
+	}
+
+
+	/**
+	*
+	* \brief Start rendering in a command buffer, with clear values from an array
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] renderPass The render pass that should be begun
+	* \param[in] frameBuffer The framebuffer for the render pass
+	* \param[in] clearValueCount Number of clear values
+	* \param[in] pClearValues Array of clear values to clear render targets, or nullptr
+	* \param[in] extent Extent of the framebuffer images
+	* \param[in] subpassContents Record draw commands inline or execute secondary command buffers
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderBeginRenderPass(	VkCommandBuffer commandBuffer,
+									VkRenderPass renderPass,
+									VkFramebuffer frameBuffer,
+									uint32_t clearValueCount,
+									const VkClearValue *pClearValues,
+									VkExtent2D extent,
+									VkSubpassContents subpassContents) {
+
+		VkRect2D renderArea = {};
+		renderArea.offset = { 0, 0 };
+		renderArea.extent = extent;
+		return vhRenderBeginRenderPass(commandBuffer, renderPass, frameBuffer, clearValueCount, pClearValues, renderArea, subpassContents);
+	}
+
+
+	/**
+	*
+	* \brief Start rendering into a part of the framebuffer, with clear values from an array
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] renderPass The render pass that should be begun
+	* \param[in] frameBuffer The framebuffer for the render pass
+	* \param[in] clearValueCount Number of clear values
+	* \param[in] pClearValues Array of clear values to clear render targets, or nullptr
+	* \param[in] renderArea The part of the framebuffer images that is rendered
+	* \param[in] subpassContents Record draw commands inline or execute secondary command buffers
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderBeginRenderPass(	VkCommandBuffer commandBuffer,
+									VkRenderPass renderPass,
+									VkFramebuffer frameBuffer,
+									uint32_t clearValueCount,
+									const VkClearValue *pClearValues,
+									VkRect2D renderArea,
+									VkSubpassContents subpassContents) {
+
 		VkRenderPassBeginInfo renderPassInfo = {};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassInfo.renderPass = renderPass;
 		renderPassInfo.framebuffer = frameBuffer;
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = extent;
+		renderPassInfo.renderArea = renderArea;
+		renderPassInfo.clearValueCount = clearValueCount;
+		renderPassInfo.pClearValues = pClearValues;
 
-		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		if(clearValues.size()>0)
-			renderPassInfo.pClearValues = clearValues.data();
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, subpassContents);
+		return VK_SUCCESS;
+	}
+
+
+	/**
+	*
+	* \brief Set the dynamic viewport and scissor of a pipeline to a rectangle
+	*
+	* \param[in] commandBuffer The command buffer to record into
+	* \param[in] rect The rectangle to draw into
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhRenderSetViewport(VkCommandBuffer commandBuffer, VkRect2D rect) {
+		VkViewport viewport = {};
+		viewport.x = (float)rect.offset.x;
+		viewport.y = (float)rect.offset.y;
+		viewport.width = (float)rect.extent.width;
+		viewport.height = (float)rect.extent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &rect);
 		return VK_SUCCESS;
 	}
 
@@ -445,6 +1096,130 @@ namespace vh {
 		return shaderModule;
 	}
 
+	///Header in front of the pipeline cache data in a cache file, identifies the device and driver that wrote it
+	struct vhPipelineCacheHeader_t {
+		uint32_t	magic;								///<Always VH_PIPELINE_CACHE_MAGIC
+		uint32_t	vendorID;							///<Vendor ID of the physical device
+		uint32_t	deviceID;							///<Device ID of the physical device
+		uint32_t	driverVersion;						///<Driver version of the physical device
+		uint8_t		pipelineCacheUUID[VK_UUID_SIZE];	///<Pipeline cache UUID of the physical device
+		uint64_t	dataSize;							///<Number of bytes of cache data following the header
+	};
+
+	const uint32_t VH_PIPELINE_CACHE_MAGIC = 0x43505656;	///<"VVPC"
+
+
+	/**
+	*
+	* \brief Create a pipeline cache, filled with the data of a cache file if there is one
+	*
+	* The file content is only used if it was written by the same device with the same driver, i.e. vendor ID,
+	* device ID, driver version and pipeline cache UUID must match. Otherwise, or if the file is missing or broken,
+	* the cache starts empty.
+	*
+	* \param[in] physicalDevice Physical Vulkan device
+	* \param[in] device Logical Vulkan device
+	* \param[in] fileName Name of the cache file
+	* \param[out] pipelineCache The new pipeline cache
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhPipeCreatePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, std::string fileName, VkPipelineCache *pipelineCache) {
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		std::vector<char> data;
+		std::ifstream file(fileName, std::ios::ate | std::ios::binary);
+		if (file.is_open()) {
+			size_t fileSize = (size_t)file.tellg();
+			vhPipelineCacheHeader_t header = {};
+
+			if (fileSize >= sizeof(header)) {
+				file.seekg(0);
+				file.read((char*)&header, sizeof(header));
+
+				if (file &&	header.magic == VH_PIPELINE_CACHE_MAGIC &&
+							header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+							header.driverVersion == properties.driverVersion &&
+							memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+							header.dataSize == fileSize - sizeof(header)) {
+					data.resize((size_t)header.dataSize);
+					file.read(data.data(), data.size());
+					if (!file) data.clear();
+				}
+			}
+			file.close();
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo = {};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = data.size();
+		cacheInfo.pInitialData = data.size() > 0 ? data.data() : nullptr;
+
+		if (vkCreatePipelineCache(device, &cacheInfo, nullptr, pipelineCache) == VK_SUCCESS) return VK_SUCCESS;
+
+		//the driver rejected the data, start with an empty cache
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		return vkCreatePipelineCache(device, &cacheInfo, nullptr, pipelineCache);
+	}
+
+
+	/**
+	*
+	* \brief Write the content of a pipeline cache into a cache file
+	*
+	* The data is first written into a temporary file, which then replaces the cache file. So a crash or a full disk
+	* never leaves a partly written cache file behind.
+	*
+	* \param[in] physicalDevice Physical Vulkan device
+	* \param[in] device Logical Vulkan device
+	* \param[in] pipelineCache The pipeline cache to save
+	* \param[in] fileName Name of the cache file
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhPipeSavePipelineCache(VkPhysicalDevice physicalDevice, VkDevice device, VkPipelineCache pipelineCache, std::string fileName) {
+		size_t dataSize = 0;
+		VHCHECKRESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr));
+		std::vector<char> data(dataSize);
+		VHCHECKRESULT(vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()));
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		vhPipelineCacheHeader_t header = {};
+		header.magic = VH_PIPELINE_CACHE_MAGIC;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = dataSize;
+
+		std::string tmpFileName = fileName + ".tmp";
+		std::ofstream file(tmpFileName, std::ios::trunc | std::ios::binary);
+		if (!file.is_open()) return VK_INCOMPLETE;
+
+		file.write((char*)&header, sizeof(header));
+		file.write(data.data(), dataSize);
+		file.close();
+		if (!file) {
+			std::remove(tmpFileName.c_str());
+			return VK_INCOMPLETE;
+		}
+
+		//rename replaces the old file on POSIX systems, on Windows the old file must be removed first
+		if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+			std::remove(fileName.c_str());
+			if (std::rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+				std::remove(tmpFileName.c_str());
+				return VK_INCOMPLETE;
+			}
+		}
+		return VK_SUCCESS;
+	}
+
+
 	/**
 	*
 	* \brief Create a pipeline layout for drawing a light pass
@@ -469,33 +1244,89 @@ namespace vh {
 			pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 		}
 
-		return vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, pipelineLayout);
+		return vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, pipelineLayout);
+	}
+
+
+
+	/**
+	*
+	* \brief Create a pipeline state object (PSO) for a light pass
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] pipelineCache Pipeline cache to create the PSO with, or VK_NULL_HANDLE
+	* \param[in] shaderFileNames List of filenames for the shaders: vertex, fragment, geometry, tess control, tess eval
+	* \param[in] pipelineLayout Pipeline layout
+	* \param[in] renderPass Renderpass to be used
+	* \param[in] dynamicStates List of dynamic states that can be changed during usage of the pipeline
+	* \param[out] graphicsPipeline The new PSO
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhPipeCreateGraphicsPipeline(	VkDevice device,
+											VkPipelineCache pipelineCache,
+											std::vector<std::string> shaderFileNames, 
+											VkPipelineLayout pipelineLayout,
+											VkRenderPass renderPass,
+											std::vector<VkDynamicState> dynamicStates,
+											VkPipeline *graphicsPipeline) {
+
+		return vhPipeCreateGraphicsPipeline(device, pipelineCache, shaderFileNames, pipelineLayout, renderPass,
+											dynamicStates, VK_COMPARE_OP_LESS_OR_EQUAL, VK_TRUE,
+											VK_CULL_MODE_BACK_BIT, VK_POLYGON_MODE_FILL, {}, graphicsPipeline);
 	}
 
 
-
 	/**
 	*
-	* \brief Create a pipeline state object (PSO) for a light pass
+	* \brief Create a pipeline state object (PSO) for a light pass, with a given depth test and rasterization
+	*
+	* After a depth pre-pass, light passes use VK_COMPARE_OP_EQUAL without depth writes, so only the
+	* visible surface of each pixel is shaded. VK_CULL_MODE_NONE draws two-sided geometry, VK_POLYGON_MODE_LINE
+	* draws wireframes and needs the fillModeNonSolid device feature.
+	* The specialization constants are given to all shader stages, value i is the constant with constant_id i.
+	* This way one shader module yields many PSOs, each compiled without the branches it does not need.
 	*
 	* \param[in] device Logical Vulkan device
+	* \param[in] pipelineCache Pipeline cache to create the PSO with, or VK_NULL_HANDLE
 	* \param[in] shaderFileNames List of filenames for the shaders: vertex, fragment, geometry, tess control, tess eval
-	* \param[in] swapChainExtent Swapchain extent
 	* \param[in] pipelineLayout Pipeline layout
 	* \param[in] renderPass Renderpass to be used
 	* \param[in] dynamicStates List of dynamic states that can be changed during usage of the pipeline
+	* \param[in] depthCompareOp Depth compare operation
+	* \param[in] depthWriteEnable If VK_TRUE then depth values are written
+	* \param[in] cullMode Faces that are culled
+	* \param[in] polygonMode Fill the triangles or draw their edges
+	* \param[in] specializationConstants Values of the specialization constants 0, 1, ..., can be empty
 	* \param[out] graphicsPipeline The new PSO
 	* \returns VK_SUCCESS or a Vulkan error code
 	*
 	*/
 	VkResult vhPipeCreateGraphicsPipeline(	VkDevice device,
+											VkPipelineCache pipelineCache,
 											std::vector<std::string> shaderFileNames, 
-											VkExtent2D swapChainExtent,
 											VkPipelineLayout pipelineLayout,
 											VkRenderPass renderPass,
 											std::vector<VkDynamicState> dynamicStates,
+											VkCompareOp depthCompareOp,
+											VkBool32 depthWriteEnable,
+											VkCullModeFlags cullMode,
+											VkPolygonMode polygonMode,
+											std::vector<uint32_t> specializationConstants,
 											VkPipeline *graphicsPipeline) {
 
+		std::vector<VkSpecializationMapEntry> specializationEntries;
+		for (uint32_t i = 0; i < (uint32_t)specializationConstants.size(); i++) {
+			specializationEntries.push_back({ i, i * (uint32_t)sizeof(uint32_t), sizeof(uint32_t) });
+		}
+
+		VkSpecializationInfo specializationInfo = {};
+		specializationInfo.mapEntryCount = (uint32_t)specializationEntries.size();
+		specializationInfo.pMapEntries = specializationEntries.data();
+		specializationInfo.dataSize = specializationConstants.size() * sizeof(uint32_t);
+		specializationInfo.pData = specializationConstants.data();
+		VkSpecializationInfo *pSpecializationInfo = specializationConstants.empty() ? nullptr : &specializationInfo;
+
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages; 
 
 		auto vertShaderCode = vhFileRead(shaderFileNames[0]);
@@ -507,6 +1338,7 @@ namespace vh {
 		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
 		vertShaderStageInfo.module = vertShaderModule;
 		vertShaderStageInfo.pName = "main";
+		vertShaderStageInfo.pSpecializationInfo = pSpecializationInfo;
 
 		shaderStages.push_back(vertShaderStageInfo);
 
@@ -521,6 +1353,7 @@ namespace vh {
 			fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 			fragShaderStageInfo.module = fragShaderModule;
 			fragShaderStageInfo.pName = "main";
+			fragShaderStageInfo.pSpecializationInfo = pSpecializationInfo;
 
 			shaderStages.push_back(fragShaderStageInfo);
 		}
@@ -541,32 +1374,19 @@ namespace vh {
 		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)swapChainExtent.width;
-		viewport.height = (float)swapChainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChainExtent;
-
+		//viewport and scissor are dynamic, so the PSO does not depend on the size of the framebuffer
 		VkPipelineViewportStateCreateInfo viewportState = {};
 		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
 		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
 
 		VkPipelineRasterizationStateCreateInfo rasterizer = {};
 		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 		rasterizer.depthClampEnable = VK_FALSE;
 		rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.polygonMode = polygonMode;
 		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+		rasterizer.cullMode = cullMode;
 		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 		rasterizer.depthBiasEnable = VK_FALSE;
 
@@ -578,9 +1398,12 @@ namespace vh {
 		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
 		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 		depthStencil.depthTestEnable = VK_TRUE;
-		depthStencil.depthWriteEnable = VK_TRUE;
-		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		depthStencil.depthWriteEnable = depthWriteEnable;
+		depthStencil.depthCompareOp = depthCompareOp;
 		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		if (std::find(dynamicStates.begin(), dynamicStates.end(), VK_DYNAMIC_STATE_DEPTH_BOUNDS) != dynamicStates.end()) {
+			depthStencil.depthBoundsTestEnable = VK_TRUE;		//dynamic depth bounds are only set if they are tested
+		}
 		depthStencil.stencilTestEnable = VK_FALSE;
 
 		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
@@ -601,6 +1424,10 @@ namespace vh {
 		colorBlending.blendConstants[2] = 0.0f;
 		colorBlending.blendConstants[3] = 0.0f;
 
+		for (VkDynamicState state : { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR }) {
+			if (std::find(dynamicStates.begin(), dynamicStates.end(), state) == dynamicStates.end()) dynamicStates.push_back(state);
+		}
+
 		VkPipelineDynamicStateCreateInfo dynamicState = {};
 		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 		dynamicState.dynamicStateCount = (uint32_t)dynamicStates.size();
@@ -627,7 +1454,7 @@ namespace vh {
 		pipelineInfo.subpass = 0;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		VHCHECKRESULT( vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, graphicsPipeline) );
+		VHCHECKRESULT( vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, graphicsPipeline) );
 
 		if(fragShaderModule != VK_NULL_HANDLE )
 			vkDestroyShaderModule(device, fragShaderModule, nullptr);
@@ -644,19 +1471,47 @@ namespace vh {
 	* \brief Create a pipeline state object (PSO) for a shadow pass
 	*
 	* \param[in] device Logical Vulkan device
+	* \param[in] pipelineCache Pipeline cache to create the PSO with, or VK_NULL_HANDLE
+	* \param[in] verShaderFilename Name of the vetex shader file
+	* \param[in] pipelineLayout Pipeline layout
+	* \param[in] renderPass Renderpass to be used
+	* \param[out] graphicsPipeline The new PSO
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhPipeCreateGraphicsShadowPipeline(VkDevice device,
+												VkPipelineCache pipelineCache,
+												std::string verShaderFilename,
+												VkPipelineLayout pipelineLayout,
+												VkRenderPass renderPass,
+												VkPipeline *graphicsPipeline) {
+
+		return vhPipeCreateGraphicsShadowPipeline(device, pipelineCache, verShaderFilename, pipelineLayout, renderPass, {}, graphicsPipeline);
+	}
+
+
+	/**
+	*
+	* \brief Create a pipeline state object (PSO) for a shadow pass with dynamic states
+	*
+	* Since viewport and scissor are dynamic, the same PSO can draw into any tile of a shadow atlas.
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] pipelineCache Pipeline cache to create the PSO with, or VK_NULL_HANDLE
 	* \param[in] verShaderFilename Name of the vetex shader file
-	* \param[in] shadowMapExtent Swapchain extent
 	* \param[in] pipelineLayout Pipeline layout
 	* \param[in] renderPass Renderpass to be used
+	* \param[in] dynamicStates List of dynamic states that can be changed during usage of the pipeline
 	* \param[out] graphicsPipeline The new PSO
 	* \returns VK_SUCCESS or a Vulkan error code
 	*
 	*/
 	VkResult vhPipeCreateGraphicsShadowPipeline(VkDevice device,
+												VkPipelineCache pipelineCache,
 												std::string verShaderFilename,
-												VkExtent2D shadowMapExtent,
 												VkPipelineLayout pipelineLayout,
 												VkRenderPass renderPass,
+												std::vector<VkDynamicState> dynamicStates,
 												VkPipeline *graphicsPipeline) {
 
 		auto vertShaderCode = vhFileRead(verShaderFilename);
@@ -687,24 +1542,11 @@ namespace vh {
 		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 		inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)shadowMapExtent.width;
-		viewport.height = (float)shadowMapExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		VkRect2D scissor = {};
-		scissor.offset = { 0, 0 };
-		scissor.extent = shadowMapExtent;
-
+		//viewport and scissor are dynamic, so the PSO does not depend on the size of the framebuffer
 		VkPipelineViewportStateCreateInfo viewportState = {};
 		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
 		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
 
 		VkPipelineRasterizationStateCreateInfo rasterizer = {};
 		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -744,6 +1586,17 @@ namespace vh {
 		colorBlending.blendConstants[2] = 0.0f;
 		colorBlending.blendConstants[3] = 0.0f;
 
+		for (VkDynamicState state : { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR }) {
+			if (std::find(dynamicStates.begin(), dynamicStates.end(), state) == dynamicStates.end()) dynamicStates.push_back(state);
+		}
+
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = (uint32_t)dynamicStates.size();
+		if (dynamicStates.size() > 0) {
+			dynamicState.pDynamicStates = dynamicStates.data();
+		}
+
 		VkGraphicsPipelineCreateInfo pipelineInfo = {};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineInfo.stageCount = 1;
@@ -755,13 +1608,273 @@ namespace vh {
 		pipelineInfo.pMultisampleState = &multisampling;
 		pipelineInfo.pDepthStencilState = &depthStencil;
 		pipelineInfo.pColorBlendState = &colorBlending;
+		if (dynamicStates.size() > 0) {
+			pipelineInfo.pDynamicState = &dynamicState;
+		}
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.renderPass = renderPass;
+		pipelineInfo.subpass = 0;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		VHCHECKRESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, graphicsPipeline ) );
+
+		vkDestroyShaderModule(device, vertShaderModule, nullptr);
+		return VK_SUCCESS;
+	}
+
+
+	/**
+	*
+	* \brief Create a pipeline state object (PSO) for the geometry pass of a deferred renderer
+	*
+	* Like a light pass PSO, but writing into several G-buffer maps without blending.
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] pipelineCache Pipeline cache to create the PSO with, or VK_NULL_HANDLE
+	* \param[in] shaderFileNames List of filenames for the shaders: vertex, fragment
+	* \param[in] pipelineLayout Pipeline layout
+	* \param[in] renderPass Renderpass to be used
+	* \param[in] numColorAttachments Number of G-buffer maps the fragment shader writes to
+	* \param[in] cullMode Faces that are culled
+	* \param[in] polygonMode Fill the triangles or draw their edges
+	* \param[out] graphicsPipeline The new PSO
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhPipeCreateGraphicsGBufferPipeline(	VkDevice device,
+													VkPipelineCache pipelineCache,
+													std::vector<std::string> shaderFileNames,
+													VkPipelineLayout pipelineLayout,
+													VkRenderPass renderPass,
+													uint32_t numColorAttachments,
+													VkCullModeFlags cullMode,
+													VkPolygonMode polygonMode,
+													VkPipeline *graphicsPipeline) {
+
+		auto vertShaderCode = vhFileRead(shaderFileNames[0]);
+		auto fragShaderCode = vhFileRead(shaderFileNames[1]);
+
+		VkShaderModule vertShaderModule = vhPipeCreateShaderModule(device, vertShaderCode);
+		VkShaderModule fragShaderModule = vhPipeCreateShaderModule(device, fragShaderCode);
+
+		VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shaderStages[0].module = vertShaderModule;
+		shaderStages[0].pName = "main";
+		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shaderStages[1].module = fragShaderModule;
+		shaderStages[1].pName = "main";
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+		auto bindingDescription = vhVertex::getBindingDescription();
+		auto attributeDescriptions = vhVertex::getAttributeDescriptions();
+
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+		vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		//viewport and scissor are dynamic, so the PSO does not depend on the size of the framebuffer
+		VkPipelineViewportStateCreateInfo viewportState = {};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.scissorCount = 1;
+
+		VkPipelineRasterizationStateCreateInfo rasterizer = {};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = polygonMode;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = cullMode;
+		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizer.depthBiasEnable = VK_FALSE;
+
+		VkPipelineMultisampleStateCreateInfo multisampling = {};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = VK_TRUE;
+		depthStencil.depthWriteEnable = VK_TRUE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.stencilTestEnable = VK_FALSE;
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = VK_FALSE;
+		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(numColorAttachments, colorBlendAttachment);
+
+		VkPipelineColorBlendStateCreateInfo colorBlending = {};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = numColorAttachments;
+		colorBlending.pAttachments = colorBlendAttachments.data();
+
+		std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = (uint32_t)dynamicStates.size();
+		dynamicState.pDynamicStates = dynamicStates.data();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = shaderStages;
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.layout = pipelineLayout;
+		pipelineInfo.renderPass = renderPass;
+		pipelineInfo.subpass = 0;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+		VHCHECKRESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, graphicsPipeline));
+
+		vkDestroyShaderModule(device, fragShaderModule, nullptr);
+		vkDestroyShaderModule(device, vertShaderModule, nullptr);
+		return VK_SUCCESS;
+	}
+
+
+	/**
+	*
+	* \brief Create a pipeline state object (PSO) for a screen space light pass of a deferred renderer
+	*
+	* The vertex shader creates its screen space quad from gl_VertexIndex, so there is no vertex input.
+	* Light is added onto the framebuffer. The quad is tested against the depth of the geometry pass with
+	* VK_COMPARE_OP_GREATER_OR_EQUAL, so only surfaces in front of the quad are lit, and depth is not written.
+	*
+	* \param[in] device Logical Vulkan device
+	* \param[in] pipelineCache Pipeline cache to create the PSO with, or VK_NULL_HANDLE
+	* \param[in] shaderFileNames List of filenames for the shaders: vertex, fragment
+	* \param[in] pipelineLayout Pipeline layout
+	* \param[in] renderPass Renderpass to be used
+	* \param[out] graphicsPipeline The new PSO
+	* \returns VK_SUCCESS or a Vulkan error code
+	*
+	*/
+	VkResult vhPipeCreateGraphicsLightPipeline(	VkDevice device,
+												VkPipelineCache pipelineCache,
+												std::vector<std::string> shaderFileNames,
+												VkPipelineLayout pipelineLayout,
+												VkRenderPass renderPass,
+												VkPipeline *graphicsPipeline) {
+
+		auto vertShaderCode = vhFileRead(shaderFileNames[0]);
+		auto fragShaderCode = vhFileRead(shaderFileNames[1]);
+
+		VkShaderModule vertShaderModule = vhPipeCreateShaderModule(device, vertShaderCode);
+		VkShaderModule fragShaderModule = vhPipeCreateShaderModule(device, fragShaderCode);
+
+		VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shaderStages[0].module = vertShaderModule;
+		shaderStages[0].pName = "main";
+		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shaderStages[1].module = fragShaderModule;
+		shaderStages[1].pName = "main";
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		//viewport and scissor are dynamic, so the PSO does not depend on the size of the framebuffer
+		VkPipelineViewportStateCreateInfo viewportState = {};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.scissorCount = 1;
+
+		VkPipelineRasterizationStateCreateInfo rasterizer = {};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = VK_CULL_MODE_NONE;
+		rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizer.depthBiasEnable = VK_FALSE;
+
+		VkPipelineMultisampleStateCreateInfo multisampling = {};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = VK_TRUE;
+		depthStencil.depthWriteEnable = VK_FALSE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.stencilTestEnable = VK_FALSE;
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		VkPipelineColorBlendStateCreateInfo colorBlending = {};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = 1;
+		colorBlending.pAttachments = &colorBlendAttachment;
+
+		std::vector<VkDynamicState> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = (uint32_t)dynamicStates.size();
+		dynamicState.pDynamicStates = dynamicStates.data();
+
+		VkGraphicsPipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = shaderStages;
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
 		pipelineInfo.layout = pipelineLayout;
 		pipelineInfo.renderPass = renderPass;
 		pipelineInfo.subpass = 0;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		VHCHECKRESULT(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, graphicsPipeline ) );
+		VHCHECKRESULT(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, graphicsPipeline));
 
+		vkDestroyShaderModule(device, fragShaderModule, nullptr);
 		vkDestroyShaderModule(device, vertShaderModule, nullptr);
 		return VK_SUCCESS;
 	}
@@ -118,7 +118,8 @@ namespace vh {
 		createInfo.imageColorSpace = surfaceFormat.colorSpace;
 		createInfo.imageExtent = swapextent;
 		createInfo.imageArrayLayers = 1;
-		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT; //need for copying to host
+		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |	//need for copying to host
+								VK_IMAGE_USAGE_TRANSFER_DST_BIT;										//need for upscaling the render area
 
 		QueueFamilyIndices indices = vhDevFindQueueFamilies(physicalDevice, surface);
 		uint32_t queueFamilyIndices[] = { (uint32_t)indices.graphicsFamily, (uint32_t)indices.presentFamily };
@@ -0,0 +1,45 @@
+# Compiles the shaders of the engine with glslangValidator from the Vulkan SDK.
+# The commands are taken from the compile_shaders.bat of each shader directory, so the batch files stay the only
+# list of shader variants. The SPIR-V files are written next to their sources, where the engine loads them from.
+# A directory is compiled again if one of its sources, its batch file, or one of the shared .glsl includes changes.
+
+find_program(GLSLANG_VALIDATOR glslangValidator HINTS $ENV{VULKAN_SDK}/bin $ENV{VULKAN_SDK}/Bin)
+
+function(ve_compile_shaders target shader_root)
+    if(NOT GLSLANG_VALIDATOR)
+        message(WARNING "glslangValidator not found, the SPIR-V files in ${shader_root} are not compiled")
+        return()
+    endif()
+
+    file(GLOB_RECURSE batch_files "${shader_root}/*/compile_shaders.bat")
+    file(GLOB common_sources "${shader_root}/*/*.glsl")
+    set(stamps)
+
+    foreach(batch_file ${batch_files})
+        get_filename_component(dir ${batch_file} DIRECTORY)
+        file(RELATIVE_PATH name ${shader_root} ${dir})
+        string(REPLACE "/" "_" stamp_name ${name})
+        set(stamp ${CMAKE_CURRENT_BINARY_DIR}/shaders_${stamp_name}.stamp)
+        file(GLOB sources "${dir}/*.vert" "${dir}/*.frag" "${dir}/*.glsl")
+
+        set(commands)
+        file(STRINGS ${batch_file} lines REGEX "^glslangValidator")
+        foreach(line ${lines})
+            string(REGEX REPLACE "^glslangValidator(\\.exe)?" "" arguments "${line}")
+            separate_arguments(arguments UNIX_COMMAND "${arguments}")
+            list(APPEND commands COMMAND ${GLSLANG_VALIDATOR} ${arguments})
+        endforeach()
+
+        add_custom_command(OUTPUT ${stamp}
+            ${commands}
+            COMMAND ${CMAKE_COMMAND} -E touch ${stamp}
+            WORKING_DIRECTORY ${dir}
+            DEPENDS ${batch_file} ${sources} ${common_sources}
+            COMMENT "Compiling shaders in ${name}"
+            VERBATIM)
+        list(APPEND stamps ${stamp})
+    endforeach()
+
+    add_custom_target(${target}_shaders DEPENDS ${stamps})
+    add_dependencies(${target} ${target}_shaders)
+endfunction()
@@ -0,0 +1,29 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../Forward/common_defines.glsl"
+
+layout(location = 0) in vec3 fragPosW;
+layout(location = 1) in vec3 fragNormalW;
+layout(location = 2) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out vec4 outMaterial;
+layout(location = 3) out vec4 outPosition;
+
+layout(set = 3, binding = 0) uniform objectUBO_t {
+    objectData_t data;
+} objectUBO;
+
+layout(set = 4, binding = 0) uniform sampler2D texSampler;
+
+void main() {
+    vec4 texParam = objectUBO.data.param;
+
+    outAlbedo   = vec4( texture(texSampler, (fragTexCoord + texParam.zw)*texParam.xy ).xyz, 1.0 );
+    outNormal   = vec4( normalize( fragNormalW ), 0.0 );
+    outMaterial = vec4( 1.0, 0.0, 0.0, 0.0 );       //x...specular strength
+    outPosition = vec4( fragPosW, 1.0 );            //w...there is geometry in this pixel
+}
@@ -0,0 +1,41 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../Forward/common_defines.glsl"
+
+layout(location = 0) in vec3 fragPosW;
+layout(location = 1) in vec3 fragNormalW;
+layout(location = 2) in vec3 fragTangentW;
+layout(location = 3) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormal;
+layout(location = 2) out vec4 outMaterial;
+layout(location = 3) out vec4 outPosition;
+
+layout(set = 3, binding = 0) uniform objectUBO_t {
+    objectData_t data;
+} objectUBO;
+
+layout(set = 4, binding = 0) uniform sampler2D texSampler;
+layout(set = 4, binding = 1) uniform sampler2D normalSampler;
+
+
+void main() {
+    vec4 texParam = objectUBO.data.param;
+
+    //TBN matrix
+    vec3 N        = normalize( fragNormalW );
+    vec3 T        = normalize( fragTangentW );
+    T             = normalize( T - dot(T, N)*N );
+    vec3 B        = normalize( cross( T, N ) );
+    mat3 TBN      = mat3(T,B,N);
+    vec3 mapnorm  = normalize( texture(normalSampler, (fragTexCoord + texParam.zw)*texParam.xy).xyz*2.0 - 1.0 );
+    vec3 normal   = normalize( TBN * mapnorm );
+
+    outAlbedo   = vec4( texture(texSampler, (fragTexCoord + texParam.zw)*texParam.xy).xyz, 1.0 );
+    outNormal   = vec4( normal, 0.0 );
+    outMaterial = vec4( 1.0, 0.0, 0.0, 0.0 );       //x...specular strength
+    outPosition = vec4( fragPosW, 1.0 );            //w...there is geometry in this pixel
+}
@@ -0,0 +1,3 @@
+glslangValidator.exe -V shader.vert
+glslangValidator.exe -V shader.frag
+pause
@@ -0,0 +1,102 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../Forward/common_defines.glsl"
+#include "../../Forward/light.glsl"
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform cameraUBO_t {
+    cameraData_t data;
+} cameraUBO;
+
+layout(set = 1, binding = 0) uniform lightUBO_t {
+    lightData_t data;
+} lightUBO;
+
+layout(set = 2, binding = 0) uniform sampler2D shadowMap;
+layout(set = 2, binding = 2) uniform sampler2DArray cubeShadowMap;
+
+layout(set = 3, binding = 0) uniform sampler2D gAlbedo;
+layout(set = 3, binding = 1) uniform sampler2D gNormal;
+layout(set = 3, binding = 2) uniform sampler2D gMaterial;
+layout(set = 3, binding = 3) uniform sampler2D gPosition;
+
+void main() {
+
+    //read the G-buffer
+    ivec2 texel    = ivec2( gl_FragCoord.xy );
+    vec4 posW      = texelFetch( gPosition, texel, 0 );
+    if( posW.w == 0.0 ) discard;                    //no geometry in this pixel
+
+    vec3 fragPosW    = posW.xyz;
+    vec3 fragNormalW = texelFetch( gNormal, texel, 0 ).xyz;
+    vec3 fragColor   = texelFetch( gAlbedo, texel, 0 ).xyz;
+    vec4 material    = texelFetch( gMaterial, texel, 0 );
+
+    //fragment coordinates of the surface, as they were in the geometry pass
+    vec4 fragH     = cameraUBO.data.camProj * cameraUBO.data.camView * vec4( fragPosW, 1.0 );
+    vec4 fragCoord = vec4( gl_FragCoord.xy, fragH.z / fragH.w, 1.0 / fragH.w );
+
+    //parameters
+    vec3 camPosW    = cameraUBO.data.camModel[3].xyz;
+    int  lightType  = lightUBO.data.itype[0];
+    vec3 lightPosW  = lightUBO.data.lightModel[3].xyz;
+    vec3 lightDirW  = normalize( lightUBO.data.lightModel[2].xyz );
+    vec4 lightParam = lightUBO.data.param;
+
+    //colors
+    vec3 ambcol  = lightUBO.data.col_ambient.xyz;
+    vec3 diffcol = lightUBO.data.col_diffuse.xyz;
+    vec3 speccol = lightUBO.data.col_specular.xyz * material.x;
+
+    vec3 result = ambcol * fragColor;
+    int sIdx = 0;
+    cameraData_t s = lightUBO.data.shadowCameras[0];
+    float shadowFactor = 1.0;
+
+    if( lightType == LIGHT_DIR ) {
+        sIdx = shadowIdxDirectional(cameraUBO.data.param,
+                                    fragCoord,
+                                    lightUBO.data.shadowCameras[0].param[3],
+                                    lightUBO.data.shadowCameras[1].param[3],
+                                    lightUBO.data.shadowCameras[2].param[3]);
+        sIdx = shadowIdxCovered( sIdx, fragPosW, lightUBO.data.shadowCameras );
+
+        s = lightUBO.data.shadowCameras[sIdx];
+        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
+
+        result +=   dirlight( lightType, camPosW,
+                              lightDirW, lightParam, shadowFactor,
+                              ambcol, diffcol, speccol,
+                              fragPosW, fragNormalW, fragColor);
+    }
+
+    if( lightType == LIGHT_POINT ) {
+
+        sIdx = shadowIdxPoint( lightPosW, fragPosW );
+        s = lightUBO.data.shadowCameras[sIdx];
+        if( lightUBO.data.itype[1] == 1 )       //all faces are in the cube shadow map
+            shadowFactor = shadowFuncLayer(fragPosW, s.camView, s.camProj, cubeShadowMap, sIdx );
+        else
+            shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
+
+        result +=   pointlight( lightType, camPosW,
+                                lightPosW, lightParam, shadowFactor,
+                                ambcol, diffcol, speccol,
+                                fragPosW, fragNormalW, fragColor);
+    }
+
+    if( lightType == LIGHT_SPOT ) {
+
+        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
+
+        result +=  spotlight( lightType, camPosW,
+                              lightPosW, lightDirW, lightParam, shadowFactor,
+                              ambcol, diffcol, speccol,
+                              fragPosW, fragNormalW, fragColor);
+    }
+
+    outColor = vec4( result, 1.0 );
+}
@@ -0,0 +1,66 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../../Forward/common_defines.glsl"
+
+layout(set = 0, binding = 0) uniform cameraUBO_t {
+    cameraData_t data;
+} cameraUBO;
+
+layout(set = 1, binding = 0) uniform lightUBO_t {
+    lightData_t data;
+} lightUBO;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+//two triangles covering [0,1]x[0,1]
+vec2 quad[6] = vec2[]( vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+                       vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0) );
+
+//create a screen space quad that covers the volume of the light
+//its depth is the far end of the volume, so depth testing with GREATER_OR_EQUAL
+//leaves only pixels whose surface is in front of the far end
+void main() {
+    int   lightType = lightUBO.data.itype[0];
+    float reach     = lightUBO.data.param[0];
+    float nearPlane = cameraUBO.data.param[0];
+    mat4  camView   = cameraUBO.data.camView;
+    mat4  camProj   = cameraUBO.data.camProj;
+
+    vec2  ndcMin = vec2(-1.0, -1.0);
+    vec2  ndcMax = vec2( 1.0,  1.0);
+    float depth  = 1.0;
+
+    if( lightType != LIGHT_DIR ) {
+        vec3 centerV = (camView * lightUBO.data.lightModel[3]).xyz;
+
+        if( centerV.z + reach < nearPlane ) {           //volume is behind the camera, degenerate the quad
+            ndcMin = vec2(2.0, 2.0);
+            ndcMax = ndcMin;
+        }
+        else {
+            vec4 farH = camProj * vec4( centerV.xy, centerV.z + reach, 1.0 );
+            depth = clamp( farH.z / farH.w, 0.0, 1.0 );
+
+            if( centerV.z - reach > nearPlane ) {       //box completely in front of the camera, project its corners
+                ndcMin = vec2( 1.0e30);
+                ndcMax = vec2(-1.0e30);
+                for( int c = 0; c < 8; c++ ) {
+                    vec3 corner = centerV + reach * vec3( (c & 1) != 0 ? 1.0 : -1.0,
+                                                         (c & 2) != 0 ? 1.0 : -1.0,
+                                                         (c & 4) != 0 ? 1.0 : -1.0 );
+                    vec4 clip = camProj * vec4( corner, 1.0 );
+                    ndcMin = min( ndcMin, clip.xy / clip.w );
+                    ndcMax = max( ndcMax, clip.xy / clip.w );
+                }
+                ndcMin = clamp( ndcMin, -1.0, 1.0 );
+                ndcMax = clamp( ndcMax, -1.0, 1.0 );
+            }
+        }
+    }
+
+    gl_Position = vec4( mix( ndcMin, ndcMax, quad[gl_VertexIndex] ), depth, 1.0 );
+}
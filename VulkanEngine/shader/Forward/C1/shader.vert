@@ -19,6 +19,7 @@ layout(location = 0) out vec4 fragColor;
 out gl_PerVertex {
     vec4 gl_Position;
 };
+invariant gl_Position;
 
 
 void main() {
@@ -1,5 +1,6 @@
 glslangValidator.exe -V shader.vert
 glslangValidator.exe -DALL -V shader.frag
+glslangValidator.exe -DALL -DCLUSTERED -o frag_clustered.spv -V shader.frag
 rem glslangValidator.exe -DSPOT  -o frag_SPOT.spv -V shader.frag
 rem glslangValidator.exe -DDIR   -o frag_DIR.spv -V shader.frag
 rem glslangValidator.exe -DPOINT -o frag_POINT.spv -V shader.frag
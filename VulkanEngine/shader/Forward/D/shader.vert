@@ -24,6 +24,7 @@ layout(location = 2) out vec2 fragTexCoord;
 out gl_PerVertex {
     vec4 gl_Position;
 };
+invariant gl_Position;
 
 void main() {
     gl_Position    = cameraUBO.data.camProj        * cameraUBO.data.camView * objectUBO.data.model * vec4(inPositionL, 1.0);
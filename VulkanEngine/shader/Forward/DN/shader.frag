@@ -5,6 +5,10 @@
 #include "../common_defines.glsl"
 #include "../light.glsl"
 
+#ifdef CLUSTERED
+#include "../clustered.glsl"
+#endif
+
 layout(location = 0) in vec3 fragPosW;
 layout(location = 1) in vec3 fragNormalW;
 layout(location = 2) in vec3 fragTangentW;
@@ -20,7 +24,8 @@ layout(set = 1, binding = 0) uniform lightUBO_t {
     lightData_t data;
 } lightUBO;
 
-layout(set = 2, binding = 0) uniform sampler2D shadowMap[NUM_SHADOW_CASCADE];
+layout(set = 2, binding = 0) uniform sampler2D shadowMap;
+layout(set = 2, binding = 2) uniform sampler2DArray cubeShadowMap;
 
 layout(set = 3, binding = 0) uniform objectUBO_t {
     objectData_t data;
@@ -67,9 +72,10 @@ void main() {
                                     lightUBO.data.shadowCameras[0].param[3],
                                     lightUBO.data.shadowCameras[1].param[3],
                                     lightUBO.data.shadowCameras[2].param[3]);
+        sIdx = shadowIdxCovered( sIdx, fragPosW, lightUBO.data.shadowCameras );
 
         s = lightUBO.data.shadowCameras[sIdx];
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx] );
+        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
 
         result +=   dirlight( lightType, camPosW,
                               lightDirW, lightParam, shadowFactor,
@@ -82,7 +88,10 @@ void main() {
 
         sIdx = shadowIdxPoint( lightPosW, fragPosW );
         s = lightUBO.data.shadowCameras[sIdx];
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx] );
+        if( lightUBO.data.itype[1] == 1 )       //all faces are in the cube shadow map
+            shadowFactor = shadowFuncLayer(fragPosW, s.camView, s.camProj, cubeShadowMap, sIdx );
+        else
+            shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
 
         result +=   pointlight( lightType, camPosW,
                                 lightPosW, lightParam, shadowFactor,
@@ -92,7 +101,7 @@ void main() {
 
     if( lightType == LIGHT_SPOT ) {
 
-        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap[sIdx] );
+        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
 
         result +=  spotlight( lightType, camPosW,
                               lightPosW, lightDirW, lightParam, shadowFactor,
@@ -100,5 +109,10 @@ void main() {
                               fragPosW, fragNormalW, fragColor);
     }
 
+#ifdef CLUSTERED
+    result += clusterLights( camPosW, cameraUBO.data.camView, gl_FragCoord,
+                             fragPosW, fragNormalW, fragColor );
+#endif
+
     outColor = vec4( result, 1.0 );
 }
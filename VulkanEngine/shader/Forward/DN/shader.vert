@@ -25,6 +25,7 @@ layout(location = 3) out vec2 fragTexCoord;
 out gl_PerVertex {
     vec4 gl_Position;
 };
+invariant gl_Position;
 
 
 void main() {
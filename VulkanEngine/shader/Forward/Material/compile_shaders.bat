@@ -0,0 +1,6 @@
+glslangValidator.exe -V shader.vert
+glslangValidator.exe -V shader.frag
+glslangValidator.exe -DPUSH_CONSTANTS -o frag_push.spv -V shader.frag
+glslangValidator.exe -DBINDLESS -o frag_bindless.spv -V shader.frag
+glslangValidator.exe -DBINDLESS -DPUSH_CONSTANTS -o frag_bindless_push.spv -V shader.frag
+pause
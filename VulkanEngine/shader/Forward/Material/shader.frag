@@ -0,0 +1,134 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : enable
+
+#include "../common_defines.glsl"
+#include "../light.glsl"
+#include "../clustered.glsl"
+#include "../object.glsl"
+
+//material shader for all textured objects, the features are specialization constants
+//each PSO is specialized for one combination, so the branches below are resolved when the PSO is created
+layout(constant_id = 0) const bool NORMAL_MAP = false;     //the material has a normal map in set 4 binding 1
+layout(constant_id = 1) const int  LIGHT_TYPE = LIGHT_DIR; //type of the light of this light pass
+layout(constant_id = 2) const int  NUM_CASCADES = 4;       //number of shadow cascades of a directional light
+layout(constant_id = 3) const bool CLUSTERED = false;      //also add the lights of the cluster of the fragment
+
+layout(location = 0) in vec3 fragPosW;
+layout(location = 1) in vec3 fragNormalW;
+layout(location = 2) in vec3 fragTangentW;
+layout(location = 3) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform cameraUBO_t {
+    cameraData_t data;
+} cameraUBO;
+
+layout(set = 1, binding = 0) uniform lightUBO_t {
+    lightData_t data;
+} lightUBO;
+
+layout(set = 2, binding = 0) uniform sampler2D shadowMap;
+layout(set = 2, binding = 2) uniform sampler2DArray cubeShadowMap;
+
+#ifdef BINDLESS
+//all textures and materials are in the bindless table, the material index is the same for the whole draw call
+#define MAX_BINDLESS_TEXTURES 4096
+
+struct materialData_t {
+  uvec4 textures;           //x...diffuse, y...normal, z...bump, w...height map
+};
+
+layout(set = 4, binding = 0) uniform sampler2D textures[MAX_BINDLESS_TEXTURES];
+
+layout(std430, set = 4, binding = 1) readonly buffer materialBuffer_t {
+    materialData_t materials[];
+} materialBuffer;
+
+#define texSampler    textures[ materialBuffer.materials[ objectMaterial() ].textures.x ]
+#define normalSampler textures[ materialBuffer.materials[ objectMaterial() ].textures.y ]
+#else
+layout(set = 4, binding = 0) uniform sampler2D texSampler;
+layout(set = 4, binding = 1) uniform sampler2D normalSampler;
+#endif
+
+
+void main() {
+
+    //parameters
+    vec3 camPosW    = cameraUBO.data.camModel[3].xyz;
+    vec3 lightPosW  = lightUBO.data.lightModel[3].xyz;
+    vec3 lightDirW  = normalize( lightUBO.data.lightModel[2].xyz );
+    vec4 lightParam = lightUBO.data.param;
+    vec4 texParam   = objectParam();
+    vec2 texCoord   = (fragTexCoord + texParam.zw)*texParam.xy;
+
+    vec3 normal = fragNormalW;
+    if( NORMAL_MAP ) {
+        //TBN matrix
+        vec3 N        = normalize( fragNormalW );
+        vec3 T        = normalize( fragTangentW );
+        T             = normalize( T - dot(T, N)*N );
+        vec3 B        = normalize( cross( T, N ) );
+        mat3 TBN      = mat3(T,B,N);
+        vec3 mapnorm  = normalize( texture(normalSampler, texCoord).xyz*2.0 - 1.0 );
+        normal        = normalize( TBN * mapnorm );
+    }
+
+    //colors
+    vec3 ambcol  = lightUBO.data.col_ambient.xyz;
+    vec3 diffcol = lightUBO.data.col_diffuse.xyz;
+    vec3 speccol = lightUBO.data.col_specular.xyz;
+    vec3 fragColor = texture(texSampler, texCoord).xyz;
+
+    vec3 result = ambcol * fragColor;
+    int sIdx = 0;
+    cameraData_t s = lightUBO.data.shadowCameras[0];
+    float shadowFactor = 1.0;
+
+    if( LIGHT_TYPE == LIGHT_DIR ) {
+        sIdx = shadowIdxCascades( cameraUBO.data.param, gl_FragCoord, lightUBO.data.shadowCameras, NUM_CASCADES );
+        sIdx = shadowIdxCoveredCascades( sIdx, fragPosW, lightUBO.data.shadowCameras, NUM_CASCADES );
+
+        s = lightUBO.data.shadowCameras[sIdx];
+        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
+
+        result +=   dirlight( LIGHT_TYPE, camPosW,
+                              lightDirW, lightParam, shadowFactor,
+                              ambcol, diffcol, speccol,
+                              fragPosW, normal, fragColor);
+    }
+
+    if( LIGHT_TYPE == LIGHT_POINT ) {
+
+        sIdx = shadowIdxPoint( lightPosW, fragPosW );
+        s = lightUBO.data.shadowCameras[sIdx];
+        if( lightUBO.data.itype[1] == 1 )       //all faces are in the cube shadow map
+            shadowFactor = shadowFuncLayer(fragPosW, s.camView, s.camProj, cubeShadowMap, sIdx );
+        else
+            shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
+
+        result +=   pointlight( LIGHT_TYPE, camPosW,
+                                lightPosW, lightParam, shadowFactor,
+                                ambcol, diffcol, speccol,
+                                fragPosW, normal, fragColor);
+    }
+
+    if( LIGHT_TYPE == LIGHT_SPOT ) {
+
+        shadowFactor = shadowFunc(fragPosW, s.camView, s.camProj, shadowMap, lightUBO.data.shadowTiles[sIdx] );
+
+        result +=  spotlight( LIGHT_TYPE, camPosW,
+                              lightPosW, lightDirW, lightParam, shadowFactor,
+                              ambcol, diffcol, speccol,
+                              fragPosW, normal, fragColor);
+    }
+
+    if( CLUSTERED ) {
+        result += clusterLights( camPosW, cameraUBO.data.camView, gl_FragCoord,
+                                 fragPosW, normal, fragColor );
+    }
+
+    outColor = vec4( result, 1.0 );
+}
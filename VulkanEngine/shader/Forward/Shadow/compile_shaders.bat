@@ -1,2 +1,3 @@
 glslangValidator.exe -V shader.vert
+glslangValidator.exe --target-env vulkan1.1 -V cube.vert -o cube.spv
 pause
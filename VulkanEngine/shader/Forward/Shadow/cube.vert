@@ -0,0 +1,55 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_multiview : enable
+
+#include "../common_defines.glsl"
+
+//draws a point light shadow caster into all 6 faces of the cube shadow map at once
+//gl_ViewIndex is the face that is currently drawn
+
+layout(set = 1, binding = 0) uniform lightUBO_t {
+    lightData_t data;
+} lightUBO;
+
+layout(set = 3, binding = 0) uniform objectUBO_t {
+    objectData_t data;
+} objectUBO;
+
+layout(location = 0) in vec3 inPositionL;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+invariant gl_Position;
+
+
+//true if the bounding sphere of the object is completely outside of the frustum of a face
+bool outsideFace( cameraData_t face ) {
+    mat4 model  = objectUBO.data.model;
+    vec4 sphere = objectUBO.data.boundingSphere;
+
+    float scale  = max( length(model[0].xyz), max( length(model[1].xyz), length(model[2].xyz) ) );
+    float radius = sphere.w * scale;
+    vec3  c      = (face.camView * model * vec4(sphere.xyz, 1.0)).xyz;      //camera looks along +z
+
+    float t = 1.0 / abs(face.camProj[0][0]);                                //tan of half the fov
+    float r = radius * sqrt( 1.0 + t*t );                                   //distance to the side planes
+
+    return  c.z + radius < 0.0 ||
+            c.x - r > c.z*t || -c.x - r > c.z*t ||
+            c.y - r > c.z*t || -c.y - r > c.z*t;
+}
+
+
+void main() {
+    cameraData_t face = lightUBO.data.shadowCameras[gl_ViewIndex];
+
+    if( outsideFace( face ) ) {
+        gl_Position = vec4( 2.0, 2.0, 2.0, 1.0 );           //outside of the clip volume, the triangle is discarded
+        return;
+    }
+
+    gl_Position = face.camProj * face.camView * objectUBO.data.model * vec4(inPositionL, 1.0);
+}
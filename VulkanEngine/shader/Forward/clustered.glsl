@@ -0,0 +1,71 @@
+//clustered forward lighting
+//lights are assigned to view space clusters on the CPU, see VERendererForward::updateClusterBuffer()
+//the first light is not in the buffer, it is drawn with shadow using the light UBO
+
+#define CLUSTER_DIM_X 16
+#define CLUSTER_DIM_Y 9
+#define CLUSTER_DIM_Z 24
+#define MAX_CLUSTER_LIGHTS 256
+
+struct clusterLight_t {
+  vec4 posRadius;     //xyz: world space position, w: reach
+  vec4 dirType;       //xyz: world space direction, w: light type
+  vec4 col_ambient;
+  vec4 col_diffuse;
+  vec4 col_specular;
+};
+
+layout(std430, set = 2, binding = 1) readonly buffer clusterBuffer_t {
+  uvec4 dims;         //number of clusters in x, y, z - w: number of lights
+  vec4  param;        //near plane, far plane, framebuffer width, framebuffer height
+  clusterLight_t lights[MAX_CLUSTER_LIGHTS];
+  uvec2 clusters[CLUSTER_DIM_X*CLUSTER_DIM_Y*CLUSTER_DIM_Z];   //offset into indices, number of lights
+  uint  indices[];
+} clusterBuffer;
+
+
+uint clusterIdx( vec4 fragCoord, vec3 fragPosV ) {
+  float nearPlane = clusterBuffer.param[0];
+  float farPlane  = clusterBuffer.param[1];
+
+  uint x = uint( clamp( fragCoord.x / clusterBuffer.param[2] * CLUSTER_DIM_X, 0, CLUSTER_DIM_X - 1 ) );
+  uint y = uint( clamp( fragCoord.y / clusterBuffer.param[3] * CLUSTER_DIM_Y, 0, CLUSTER_DIM_Y - 1 ) );
+  float slice = log( max( fragPosV.z, nearPlane ) / nearPlane ) / log( farPlane / nearPlane ) * CLUSTER_DIM_Z;
+  uint z = uint( clamp( slice, 0, CLUSTER_DIM_Z - 1 ) );
+
+  return (z*CLUSTER_DIM_Y + y)*CLUSTER_DIM_X + x;
+}
+
+
+vec3 clusterLights( vec3 camposW, mat4 camView, vec4 fragCoord,
+                    vec3 fragposW, vec3 fragnormalW, vec3 fragcolor ) {
+
+    vec3 fragposV = (camView * vec4( fragposW, 1.0 )).xyz;
+    uvec2 cluster = clusterBuffer.clusters[ clusterIdx( fragCoord, fragposV ) ];
+
+    vec3 result = vec3(0,0,0);
+    for( uint i = 0; i < cluster.y; i++ ) {
+        clusterLight_t l = clusterBuffer.lights[ clusterBuffer.indices[ cluster.x + i ] ];
+
+        int  lightType   = int( l.dirType.w );
+        vec4 lightParam  = vec4( l.posRadius.w, 1.0, 1.0, 1.0 );
+        vec3 lightPosW   = l.posRadius.xyz;
+        vec3 lightDirW   = l.dirType.xyz;
+
+        result += dirlight(   lightType, camposW,
+                              lightDirW, lightParam, 1.0,
+                              l.col_ambient.xyz, l.col_diffuse.xyz, l.col_specular.xyz,
+                              fragposW, fragnormalW, fragcolor);
+
+        result += pointlight( lightType, camposW,
+                              lightPosW, lightParam, 1.0,
+                              l.col_ambient.xyz, l.col_diffuse.xyz, l.col_specular.xyz,
+                              fragposW, fragnormalW, fragcolor);
+
+        result += spotlight(  lightType, camposW,
+                              lightPosW, lightDirW, lightParam, 1.0,
+                              l.col_ambient.xyz, l.col_diffuse.xyz, l.col_specular.xyz,
+                              fragposW, fragnormalW, fragcolor);
+    }
+    return result;
+}
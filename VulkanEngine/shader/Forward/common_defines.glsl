@@ -25,6 +25,7 @@ struct lightData_t {
   vec4  col_specular;
   vec4  param;
   cameraData_t shadowCameras[NUM_SHADOW_CASCADE];
+  vec4  shadowTiles[NUM_SHADOW_CASCADE];    //atlas tile of each shadow camera: xy...uv offset, zw...uv scale
 };
 
 struct objectData_t {
@@ -32,4 +33,11 @@ struct objectData_t {
   mat4 modelInvTrans;
   vec4 color;
   vec4 param;
+  vec4 boundingSphere;      //xyz...center of the mesh bounding sphere in local space, w...radius
+  uvec4 material;           //x...index of the material in the bindless table
+};
+
+//per object data that is pushed for each draw call, it changes only when the object gets another material
+struct objectPushData_t {
+  uvec4 material;           //x...index of the material in the bindless table
 };
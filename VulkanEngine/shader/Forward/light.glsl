@@ -17,6 +17,40 @@ int shadowIdxDirectional( vec4 camParam, vec4 fragCoord, float z1, float z2, flo
 }
 
 
+//same as shadowIdxDirectional, for any number of cascades, the split depth of cascade i is in param[3] of its camera
+//if numCascades is a specialization constant, the loop is unrolled
+int shadowIdxCascades( vec4 camParam, vec4 fragCoord, cameraData_t shadowCameras[NUM_SHADOW_CASCADE], int numCascades ) {
+  int sIdx = 0;
+  float z = ( fragCoord.z / fragCoord.w ) / ( camParam[1] - camParam[0] );
+
+  for( int i = 1; i < numCascades; i++ ) {
+    if( z >= shadowCameras[i-1].param[3] ) sIdx = i;
+  }
+  return sIdx;
+}
+
+
+//same as shadowIdxCovered, for any number of cascades
+int shadowIdxCoveredCascades( int sIdx, vec3 fragPosW, cameraData_t shadowCameras[NUM_SHADOW_CASCADE], int numCascades ) {
+  for( ; sIdx < numCascades - 1; sIdx++ ) {
+    vec4 fragPosH = shadowCameras[sIdx].camProj * shadowCameras[sIdx].camView * vec4(fragPosW, 1);
+    if( all( lessThan( abs( fragPosH.xy / fragPosH.w ), vec2(1.0) ) ) ) break;
+  }
+  return sIdx;
+}
+
+
+//reproject the fragment into a cascade, and move on to the next cascade if it is not covered
+//this can happen if a cascade is refit only every few frames, and the camera has moved since then
+int shadowIdxCovered( int sIdx, vec3 fragPosW, cameraData_t shadowCameras[NUM_SHADOW_CASCADE] ) {
+  for( ; sIdx < 3; sIdx++ ) {
+    vec4 fragPosH = shadowCameras[sIdx].camProj * shadowCameras[sIdx].camView * vec4(fragPosW, 1);
+    if( all( lessThan( abs( fragPosH.xy / fragPosH.w ), vec2(1.0) ) ) ) break;
+  }
+  return sIdx;
+}
+
+
 int shadowIdxSpot( vec4 fragPosW, mat4 shadowCamView, mat4 shadowCamProj, float z1, float z2, float z3 ) {
   return 0;
 }
@@ -43,7 +77,52 @@ int shadowIdxPoint( vec3 lightPosW, vec3 fragPosW) {
 
 
 
-float shadowFactor(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2D shadowMap, vec2 offset ) {
+float shadowFactor(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2D shadowMap, vec4 tile, vec2 offset ) {
+
+    vec4 fragposH = shadowProj * shadowView * vec4(fragposW,1);
+    fragposH /= fragposH.w;                 //homogeneous coords are in [-1,1]
+
+    fragposH.x = fragposH.x / 2.0 + 0.5;     //translate to [0,1]
+    fragposH.y = fragposH.y / 2.0 + 0.5;     //translate to [0,1]
+
+    //map into the tile of the shadow atlas, stay half a texel away from the neighboring tiles
+    vec2 border = 0.5 / (tile.zw * vec2(textureSize(shadowMap, 0)));
+    vec2 uv = tile.xy + clamp( fragposH.xy + offset, border, 1.0 - border ) * tile.zw;
+
+    float bias = 0.0001;
+    float visibility = 1.0;
+    if ( length( texture( shadowMap, uv ).rgb)  <  fragposH.z - bias ) {
+        visibility = 0.2;
+    }
+    return visibility;
+}
+
+
+float shadowFunc(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2D shadowMap, vec4 tile ) {
+
+    vec2 texDim = tile.zw * vec2(textureSize(shadowMap, 0));     //size of the tile in texels
+    float scale = 1.2;
+    float dx = scale * 1.0 / texDim.x;
+    float dy = scale * 1.0 / texDim.y;
+
+    float factor = 0.0;
+    float sum = 0;
+    int range = 1;
+    float weight = 1;
+
+    for (int x = -range; x <= range; x++) {
+        for (int y = -range; y <= range; y++) {
+            weight = 1.0;
+            factor += weight*shadowFactor( fragposW, shadowView, shadowProj, shadowMap, tile, vec2(dx*x, dy*y) );
+            sum += weight;
+        }
+    }
+    return factor / sum;
+}
+
+
+//shadow test in one layer of a layered shadow map, e.g. a face of the cube shadow map of a point light
+float shadowFactorLayer(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2DArray shadowMap, int layer, vec2 offset ) {
 
     vec4 fragposH = shadowProj * shadowView * vec4(fragposW,1);
     fragposH /= fragposH.w;                 //homogeneous coords are in [-1,1]
@@ -53,19 +132,19 @@ float shadowFactor(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2D
 
     float bias = 0.0001;
     float visibility = 1.0;
-    if ( length( texture( shadowMap, fragposH.xy + offset ).rgb)  <  fragposH.z - bias ) {
+    if ( length( texture( shadowMap, vec3(fragposH.xy + offset, float(layer)) ).rgb)  <  fragposH.z - bias ) {
         visibility = 0.2;
     }
     return visibility;
 }
 
 
-float shadowFunc(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2D shadowMap ) {
+float shadowFuncLayer(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2DArray shadowMap, int layer ) {
 
-    ivec2 texDim = textureSize(shadowMap, 0);
+    vec2 texDim = vec2(textureSize(shadowMap, 0).xy);
     float scale = 1.2;
-    float dx = scale * 1.0 / float(texDim.x);
-    float dy = scale * 1.0 / float(texDim.y);
+    float dx = scale * 1.0 / texDim.x;
+    float dy = scale * 1.0 / texDim.y;
 
     float factor = 0.0;
     float sum = 0;
@@ -75,7 +154,7 @@ float shadowFunc(  vec3 fragposW, mat4 shadowView, mat4 shadowProj, sampler2D sh
     for (int x = -range; x <= range; x++) {
         for (int y = -range; y <= range; y++) {
             weight = 1.0;
-            factor += weight*shadowFactor( fragposW, shadowView, shadowProj, shadowMap, vec2(dx*x, dy*y) );
+            factor += weight*shadowFactorLayer( fragposW, shadowView, shadowProj, shadowMap, layer, vec2(dx*x, dy*y) );
             sum += weight;
         }
     }
@@ -123,6 +202,7 @@ vec3 pointlight(  int lightType, vec3 camposW,
     //start light calculations
     vec3 lightVectorW = fragposW - lightposW;
     float distance = length(lightVectorW);
+    if( distance > lightparam[0] ) return vec3(0,0,0);      //out of reach, the light pass culls such objects
     float strength = clamp( 1 - distance / lightparam[0], 0, 1);
 
     lightVectorW = normalize(lightVectorW);
@@ -156,6 +236,7 @@ vec3 spotlight( int lightType, vec3 camposW,
     float strength = clamp( 1 - distance / lightparam[0], 0, 1);
 
     lightVectorW = normalize(lightVectorW);
+    if( distance > lightparam[0] || dot( lightVectorW, lightdirW) < 0.0 ) return vec3(0,0,0);   //out of reach, the light pass culls such objects
     float spotFactor = pow( max( dot( lightVectorW, lightdirW), 0.0), 10.0);
 
     //diffuse
@@ -0,0 +1,25 @@
+//per object data of the material shaders, read from the UBO in set 3
+//if PUSH_CONSTANTS is defined, the material index is pushed for each draw call instead
+
+layout(set = 3, binding = 0) uniform objectUBO_t {
+    objectData_t data;
+} objectUBO;
+
+mat4 objectModel()          { return objectUBO.data.model; }
+mat4 objectModelInvTrans()  { return objectUBO.data.modelInvTrans; }
+vec4 objectColor()          { return objectUBO.data.color; }
+vec4 objectParam()          { return objectUBO.data.param; }
+
+#ifdef PUSH_CONSTANTS
+
+layout(push_constant) uniform objectPC_t {
+    objectPushData_t data;
+} objectPC;
+
+uint objectMaterial()       { return objectPC.data.material.x; }
+
+#else
+
+uint objectMaterial()       { return objectUBO.data.material.x; }
+
+#endif